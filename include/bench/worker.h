@@ -107,6 +107,8 @@ public:
                 new_table.columns.column_length_array[i] = ast->create_table_sql->columns[i].col_length;
                 new_table.columns.column_type_array[i] = ast->create_table_sql->columns[i].value_type;
                 new_table.columns.column_index_type_array[i] = IndexType::NONE_INDEX;   // no use
+                new_table.columns.column_option_array[i] = ast->create_table_sql->columns[i].option;
+                new_table.columns.column_element_type_array[i] = ast->create_table_sql->columns[i].element_type;
                 // new_table.columns.column_storage_address_array[i]
             }
             executing_sql_response = op->CreateTable(user_session->cached_db, &new_table);
@@ -114,6 +116,13 @@ public:
             return;
         }
 
+        // CREATE INDEX
+        if (ast->GetType() == CREATE_INDEX_NODE)
+        {
+            executing_sql_response = op->CreateIndex(user_session->cached_db, ast->create_index_sql);
+            return;
+        }
+
         // INSERT
         if (ast->GetType() == INSERT_INTO_TABLE_NODE)
         {   
@@ -37,6 +37,7 @@ namespace tiny_v_dbms {
     #define DEFAULT_TABLE_FOLDER "tables"                       // this folder will store all data about tables , it is under "db_name"(DB_FOLDER_NAME) folder
     #define DEFAULT_TABLE_NAME "default_table"                 // the name of default db table file, each db has one default_table to store all tables header information in db
     #define TABLE_FILE_SUFFIX ".tvdbb"                         // the suffix of table header file
+    #define TABLE_HEADER_VERSION 1                             // layout of a table header, stored as a negative number before the table name. Headers without it are version 0, which have no column options or element types
    
     #define DEFAULT_TABLE_COLUMN_NAME_ONE "db_names"            // the default column name of default table, this table only has one column, to store all db name sin this system
     #define DEFAULT_TABLE_COLUMN_NAME_TWO "tables_names"         // the default column name of default table, used in user's db.
@@ -44,6 +45,8 @@ namespace tiny_v_dbms {
     #define DEFAULT_TABLE_DATA_FOLDER "data"                  // this folder will store all exact data of this db, it is under "tables"(DEFAULT_TABLE_FOLDER) folder
     #define DEFAULT_TABLE_DATA_FILE_NAME "default_table"        // the name of default db table data file
     #define TABLE_DATA_FILE_SUFFIX ".data"                      // the suffix of table data file
+    #define INDEX_FILE_SUFFIX ".index"                         // the suffix of persisted vector index file, next to the table data file
+    #define BLOCK_DIRECTORY_FILE_SUFFIX ".dir"                  // the suffix of block directory file of a table, next to the table header file
 
     #define DEFAULT_TABLE_LOG_FOLDER "log"
     #define DEFAULT_TABLE_LOG_FILE_NAME "default_table"
@@ -53,11 +56,25 @@ namespace tiny_v_dbms {
     #define MEMORY_SIZE 10737418239 / 4             // the size of the memory, any memory using need to acquire space here, 10737418239 byte (1g) / 4 = 256 mb
     #define SLOT_AMOUNT 10737418239 / 4 / 4096      // the amount of slots on buffer pool
     #define BLOCK_SIZE 4096                         // the size of one block is 4096 byte (4kb)
+    #define BLOCK_ALIGNMENT 64                      // block memory in buffer pool begins at a multiple of 64 byte (one cache line)
+    #define FILE_DESCRIPTOR_CACHE_CAPACITY 256     // files kept opened for reading and writing blocks, the least recently used one is closed when more are opened
+    #define ASYNC_READ_QUEUE_DEPTH 64              // reads of blocks submitted to one io_uring ring at the same time
+    #define ASYNC_READ_THREAD_AMOUNT 4             // threads reading blocks of batches when io_uring is not supported
+    #define READ_AHEAD_MIN_DEPTH 4                 // blocks of a chain read ahead when a scan begins or jumps back
+    #define READ_AHEAD_MAX_DEPTH 128               // most blocks of a chain read ahead by a scan
+    #define VECTOR_ALIGNMENT 32                     // records of vector columns are padded to a multiple of 32 byte, so each record in a block is 32 byte aligned
     #define LOG_MANAGER_INSRANCE_AMOUNT 4096        // the log manager amount, it should as same as block amout in memory_management
+    #define PINNED_TAIL_TABLE_AMOUNT 64            // tables whose last blocks of columns stay pinned for inserting, the least recently inserted one is unpinned when more are inserted into
+    #define SEARCH_BATCH_BLOCK_AMOUNT 256           // blocks pinned together by one vector search, they are scanned by all threads then released
+    #define FILTERED_SEARCH_SCAN_SELECTIVITY 0.05  // a filtered vector search scans the records passing the filter instead of the index, if they are fewer than this ratio
+    #define RANGE_SEARCH_BATCH_SIZE 1024           // results of a range vector search are emitted by batches of this amount
+    #define BATCH_SEARCH_QUERY_TILE 64             // queries compared together with one tile of vectors by a batch vector search
+    #define BATCH_SEARCH_VECTOR_TILE 128           // vectors decoded into one tile by a batch vector search, the tile is reused by all queries
 
 
     // config about meta data toe
     #define BASE_VECTOR Vector<int, double>     // basic vector, LENGTH_TYPE is int, DATA_TYPE is double
+    #define BASE_VECTOR_VIEW VectorView<int, double>  // non-owning view of a BASE_VECTOR, such as a record in a block
 
     // config about default data type
     #define default_length_size int             // use int as the default type of length.
@@ -76,7 +93,9 @@ namespace tiny_v_dbms {
     #define FLOAT_LENGTH sizeof(float)
     #define RAW_LENGTH 50
 
-    enum column_index_type {NONE, FLAT};
+    enum column_index_type {NONE, FLAT, HNSW, IVF_FLAT, PQ, IVF_PQ, SQ8, SQ4, DISKANN};
+    enum column_option {COLUMN_OPTION_NONE = 0, COLUMN_OPTION_NORMALIZE = 1};     // bit flags of a column, NORMALIZE means vectors are l2 normalized on insert
+    enum vector_element_type {ELEMENT_FP64, ELEMENT_FP32, ELEMENT_FP16, ELEMENT_BF16, ELEMENT_INT8};    // storage type of each dimension of a vector column
 
     // config about client and server
 
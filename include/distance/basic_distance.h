@@ -7,17 +7,30 @@
 #ifndef VDBMS_DISTANCE_BASIC_DISTANCE_H_
 #define VDBMS_DISTANCE_BASIC_DISTANCE_H_
 
+#include <stdexcept>
+#include <type_traits>
+
 #include "../config.h"
 #include "../meta/vector.h"
+#include "../meta/vector_view.h"
+#include "kernel/kernel_dispatcher.h"
 
 namespace tiny_v_dbms {
 
-template<typename DATA_TYPE>
+// VECTOR_TYPE is the type of vectors calculated, such as BASE_VECTOR or BinaryVector. Candidates of batch 
+// functions are arrays of VECTOR_TYPE::element_type, and stride is count by element. Vectors can also be 
+// calculated as VectorView, such as records read in place from a pinned block, then no vector is allocated.
+template<typename DATA_TYPE, typename VECTOR_TYPE = BASE_VECTOR>
 class BasicDistance {
 
 public: 
+  typedef typename VECTOR_TYPE::element_type ELEMENT_TYPE;
+  typedef VectorView<default_length_size, ELEMENT_TYPE> VIEW_TYPE;
+
   BasicDistance() {
     this->cal_function = DefaultCalFunction;
+    this->view_cal_function = DefaultViewCalFunction;
+    this->batch_cal_function = DefaultBatchCalFunction;
   }
 
   /**
@@ -25,37 +38,151 @@ public:
   * @param first_vector first vector.
   * @param second_vector second vector.
   */
-  DATA_TYPE Cal(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+  DATA_TYPE Cal(VECTOR_TYPE & first_vector, VECTOR_TYPE & second_vector) {
     return this->cal_function(first_vector, second_vector);
   }
 
+  /**
+  * @brief The entrance to calculate distance between two views, no data is copied.
+  * @param first_view first vector.
+  * @param second_view second vector.
+  */
+  DATA_TYPE Cal(const VIEW_TYPE & first_view, const VIEW_TYPE & second_view) {
+    return this->view_cal_function(first_view, second_view);
+  }
+
+  /**
+  * @brief Same as above, the query is a vector, such as the vector given by a sql.
+  */
+  DATA_TYPE Cal(VECTOR_TYPE & query, const VIEW_TYPE & view) {
+    return this->view_cal_function(query.GetView(), view);
+  }
+
+  /**
+  * @brief The entrance to calculate distances between one query and a contiguous run of vectors, 
+  * such as the records of a vector column's DataBlock. No vector object is built for the candidates.
+  * @param query query vector.
+  * @param vectors the first candidate, candidates are stored one besides another.
+  * @param vector_amount amount of candidates.
+  * @param vector_stride distance between the begin of two neighbor candidates, count by element.
+  * @param results output array, must has vector_amount space.
+  */
+  void CalBatch(VECTOR_TYPE & query, const ELEMENT_TYPE* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+    this->batch_cal_function(query, vectors, vector_amount, vector_stride, results);
+  }
+
+  /**
+  * @brief Same as above, candidates are stored without gap.
+  */
+  void CalBatch(VECTOR_TYPE & query, const ELEMENT_TYPE* vectors, default_long_int vector_amount, DATA_TYPE* results) {
+    this->batch_cal_function(query, vectors, vector_amount, query.GetDataLength(), results);
+  }
+
   /**
   * @brief Set the cal function, open to children class.
   * @param cal_function calculate function.
   */
-  void SetCalFunction(DATA_TYPE (*cal_function)(BASE_VECTOR & first, BASE_VECTOR & left)) {
+  void SetCalFunction(DATA_TYPE (*cal_function)(VECTOR_TYPE & first, VECTOR_TYPE & left)) {
     this->cal_function = cal_function;
   }
 
+  /**
+  * @brief Set the cal function of views, open to children class.
+  * @param view_cal_function calculate function.
+  */
+  void SetViewCalFunction(DATA_TYPE (*view_cal_function)(const VIEW_TYPE & first, const VIEW_TYPE & second)) {
+    this->view_cal_function = view_cal_function;
+  }
+
+  /**
+  * @brief Set the batch cal function, open to children class.
+  * @param batch_cal_function calculate function for one query and many vectors.
+  */
+  void SetBatchCalFunction(void (*batch_cal_function)(VECTOR_TYPE & query, const ELEMENT_TYPE* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results)) {
+    this->batch_cal_function = batch_cal_function;
+  }
+
   /**
   * @brief The default function to calculate the distance between two vectors. Add up the differences in each digit.
   * @param first_vector first vector.
   * @param second_vector second vector.
   */
-  static DATA_TYPE DefaultCalFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+  static DATA_TYPE DefaultCalFunction(VECTOR_TYPE & first_vector, VECTOR_TYPE & second_vector) {
 
     assert(first_vector.GetLength() == second_vector.GetLength());
 
     DATA_TYPE result = 0;
-    for (DATA_TYPE i = 0; i < first_vector.GetLength(); i++) {
+    for (default_length_size i = 0; i < first_vector.GetLength(); i++) {
       result += (first_vector.Get(i) - second_vector.Get(i));
     }
 
     return result;
   }
 
+  /**
+  * @brief Same as DefaultCalFunction, but calculate on views.
+  */
+  static DATA_TYPE DefaultViewCalFunction(const VIEW_TYPE & first_view, const VIEW_TYPE & second_view) {
+
+    assert(first_view.GetLength() == second_view.GetLength());
+
+    DATA_TYPE result = 0;
+    for (default_length_size i = 0; i < first_view.GetLength(); i++) {
+      result += (first_view.Get(i) - second_view.Get(i));
+    }
+
+    return result;
+  }
+
+  /**
+  * @brief The default batch function, same as calling DefaultCalFunction on each candidate. Only vectors storing 
+  * one item in each element can use it, other vector types must set their own batch function.
+  */
+  static void DefaultBatchCalFunction(VECTOR_TYPE & query, const ELEMENT_TYPE* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+    if (query.GetDataLength() != query.GetLength()) {
+      throw std::runtime_error("default batch distance function can not be used on this vector type");
+    }
+    const ELEMENT_TYPE* query_data = query.GetData();
+    for (default_long_int row = 0; row < vector_amount; row++) {
+      const ELEMENT_TYPE* vector = vectors + row * vector_stride;
+      DATA_TYPE result = 0;
+      for (default_length_size i = 0; i < query.GetLength(); i++) {
+        result += (query_data[i] - vector[i]);
+      }
+      results[row] = result;
+    }
+  }
+
+protected:
+
+  /**
+  * @brief Run a batch kernel and store the results as DATA_TYPE. When the kernel result type is DATA_TYPE the kernel 
+  * writes into results directly, or the results are converted by a small buffer on stack.
+  */
+  template<typename KERNEL_RESULT_TYPE>
+  static void RunBatchKernel(
+    void (*kernel)(const ELEMENT_TYPE*, const ELEMENT_TYPE*, default_length_size, default_long_int, default_length_size, KERNEL_RESULT_TYPE*), 
+    VECTOR_TYPE & query, const ELEMENT_TYPE* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+    if constexpr (std::is_same<DATA_TYPE, KERNEL_RESULT_TYPE>::value) {
+      kernel(query.GetData(), vectors, query.GetDataLength(), vector_amount, vector_stride, results);
+    }
+    else {
+      const default_long_int buffer_size = 64;
+      KERNEL_RESULT_TYPE buffer[buffer_size];
+      for (default_long_int begin = 0; begin < vector_amount; begin += buffer_size) {
+        default_long_int amount = vector_amount - begin < buffer_size ? vector_amount - begin : buffer_size;
+        kernel(query.GetData(), vectors + begin * vector_stride, query.GetDataLength(), amount, vector_stride, buffer);
+        for (default_long_int i = 0; i < amount; i++) {
+          results[begin + i] = (DATA_TYPE) buffer[i];
+        }
+      }
+    }
+  }
+
 private:
-  DATA_TYPE (*cal_function)(BASE_VECTOR & first, BASE_VECTOR & left); // pointer, store the function to calculate the distance between two vectors
+  DATA_TYPE (*cal_function)(VECTOR_TYPE & first, VECTOR_TYPE & left); // pointer, store the function to calculate the distance between two vectors
+  DATA_TYPE (*view_cal_function)(const VIEW_TYPE & first, const VIEW_TYPE & second); // pointer, store the function to calculate the distance between two views
+  void (*batch_cal_function)(VECTOR_TYPE & query, const ELEMENT_TYPE* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results); // pointer, store the function to calculate distances between one query and many vectors
 
 }; 
 
@@ -0,0 +1,116 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : cosine_distance.h
+// since : 2024-09-05
+// desc  : Cosine distance, 1 - cos(first, second). For vectors stored in a column
+// with the NORMALIZE option, use CosineDistance(true), the distance is only an
+// inner product and no norm of candidates is calculated.
+#ifndef VDBMS_DISTANCE_COSINE_DISTANCE_H_
+#define VDBMS_DISTANCE_COSINE_DISTANCE_H_
+
+#include <cmath>
+#include "basic_distance.h"
+#include "kernel/kernel_dispatcher.h"
+#include "../utils/vector_normalize_util.h"
+
+namespace tiny_v_dbms {
+
+template<typename DATA_TYPE>
+class CosineDistance : public BasicDistance<DATA_TYPE> {
+
+public:
+
+    CosineDistance() {
+        this->SetCalFunction(CosineDistanceFunction);
+        this->SetViewCalFunction(CosineDistanceViewFunction);
+        this->SetBatchCalFunction(CosineDistanceBatchFunction);
+    }
+
+    /**
+    * @param normalized true if the vectors calculated are l2 normalized, such as vectors from a NORMALIZE column.
+    */
+    explicit CosineDistance(bool normalized) : CosineDistance() {
+        if (normalized) {
+            this->SetCalFunction(NormalizedCosineDistanceFunction);
+            this->SetViewCalFunction(NormalizedCosineDistanceViewFunction);
+            this->SetBatchCalFunction(NormalizedCosineDistanceBatchFunction);
+        }
+    }
+
+    /**
+    * @brief The function to calculate the cosine distance between two vectors. The distance of a zero vector is 1.
+    * @param first_vector first vector.
+    * @param second_vector second vector.
+    */
+    static DATA_TYPE CosineDistanceFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return CosineDistanceViewFunction(first_vector.GetView(), second_vector.GetView());
+    }
+
+    /**
+    * @brief Same as above, but calculate on views.
+    */
+    static DATA_TYPE CosineDistanceViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
+
+        assert(first_view.GetLength() == second_view.GetLength());
+
+        const DistanceKernelTable& kernels = KernelDispatcher::GetKernels();
+        default_length_size length = first_view.GetLength();
+        double product = kernels.inner_product(first_view.GetData(), second_view.GetData(), length);
+        double norm_product = std::sqrt(kernels.inner_product(first_view.GetData(), first_view.GetData(), length) 
+            * kernels.inner_product(second_view.GetData(), second_view.GetData(), length));
+        if (norm_product == 0) {
+            return 1;
+        }
+        return 1 - product / norm_product;
+    }
+
+    /**
+    * @brief Calculate the cosine distances between one query and a contiguous run of vectors, the norm of query is calculated once.
+    */
+    static void CosineDistanceBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        const DistanceKernelTable& kernels = KernelDispatcher::GetKernels();
+        default_length_size length = query.GetLength();
+        double query_norm = VectorNormalizeUtil::Norm(query.GetData(), length);
+        for (default_long_int row = 0; row < vector_amount; row++) {
+            const double* vector = vectors + row * vector_stride;
+            double norm_product = query_norm * std::sqrt(kernels.inner_product(vector, vector, length));
+            if (norm_product == 0) {
+                results[row] = 1;
+                continue;
+            }
+            results[row] = 1 - kernels.inner_product(query.GetData(), vector, length) / norm_product;
+        }
+    }
+
+    /**
+    * @brief The function to calculate the cosine distance between two l2 normalized vectors.
+    */
+    static DATA_TYPE NormalizedCosineDistanceFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return NormalizedCosineDistanceViewFunction(first_vector.GetView(), second_vector.GetView());
+    }
+
+    static DATA_TYPE NormalizedCosineDistanceViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
+
+        assert(first_view.GetLength() == second_view.GetLength());
+
+        return 1 - KernelDispatcher::GetKernels().inner_product(first_view.GetData(), second_view.GetData(), first_view.GetLength());
+    }
+
+    /**
+    * @brief Calculate the cosine distances between one query and a run of l2 normalized vectors.
+    * The query is not required to be normalized, its norm is calculated once for the whole run.
+    */
+    static void NormalizedCosineDistanceBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        double query_norm = VectorNormalizeUtil::Norm(query.GetData(), query.GetLength());
+        BasicDistance<DATA_TYPE>::RunBatchKernel(KernelDispatcher::GetKernels().inner_product_batch, query, vectors, vector_amount, vector_stride, results);
+        for (default_long_int i = 0; i < vector_amount; i++) {
+            results[i] = query_norm == 0 ? 1 : 1 - results[i] / query_norm;
+        }
+    }
+
+};
+
+}
+#endif // VDBMS_DISTANCE_COSINE_DISTANCE_H_
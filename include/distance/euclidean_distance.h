@@ -8,6 +8,8 @@
 
 #include <cmath>
 #include "basic_distance.h"
+#include "kernel/kernel_dispatcher.h"
+#include "kernel/fixed_dimension_kernel.h"
 
 namespace tiny_v_dbms {
 
@@ -18,29 +20,101 @@ public:
 
     EuclideanDistance() {
         this->SetCalFunction(EuclideanDistanceFunction);
+        this->SetViewCalFunction(EuclideanDistanceViewFunction);
+        this->SetBatchCalFunction(EuclideanDistanceBatchFunction);
+    }
+
+    /**
+    * @brief Use the kernels specialized on the dimension if it has, such as the declared length of a vector column.
+    * @param dimension length of all vectors calculated by this object.
+    */
+    explicit EuclideanDistance(default_length_size dimension) : EuclideanDistance() {
+        DimensionKernelRegistry::VisitDimension(dimension, [this](auto fixed_dimension) {
+            this->template UseFixedDimension<decltype(fixed_dimension)::value>();
+        });
     }
 
     /**
     * @brief The function to calculate the Euclidean distance between two vectors. 
+    * The squared distance is calculated by the simd kernel chosen at startup.
     * @param first_vector first vector.
     * @param second_vector second vector.
     */
     static DATA_TYPE EuclideanDistanceFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return EuclideanDistanceViewFunction(first_vector.GetView(), second_vector.GetView());
+    }
 
-        assert(first_vector.GetLength() == second_vector.GetLength());
+    /**
+    * @brief Same as above, but calculate on views.
+    */
+    static DATA_TYPE EuclideanDistanceViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
 
-        DATA_TYPE result = 0;
-        for (DATA_TYPE i = 0; i < first_vector.GetLength(); i++) {
+        assert(first_view.GetLength() == second_view.GetLength());
 
-            DATA_TYPE part_result = (first_vector.Get(i) - second_vector.Get(i));
-            part_result *= part_result;
+        double result = KernelDispatcher::GetKernels().l2_sqr(first_view.GetData(), second_view.GetData(), first_view.GetLength());
+    
+        return sqrt(result);
+    }
 
-            result += part_result;
+    /**
+    * @brief Calculate the Euclidean distances between one query and a contiguous run of vectors.
+    * The kernel is fetched once for the whole run, not once for each candidate.
+    */
+    static void EuclideanDistanceBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        BasicDistance<DATA_TYPE>::RunBatchKernel(KernelDispatcher::GetKernels().l2_sqr_batch, query, vectors, vector_amount, vector_stride, results);
+        for (default_long_int i = 0; i < vector_amount; i++) {
+            results[i] = sqrt(results[i]);
         }
-    
+    }
+
+    /**
+    * @brief Same as above, but all vectors must have DIM elements.
+    */
+    template<default_length_size DIM>
+    static DATA_TYPE FixedEuclideanDistanceFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return FixedEuclideanDistanceViewFunction<DIM>(first_vector.GetView(), second_vector.GetView());
+    }
+
+    template<default_length_size DIM>
+    static DATA_TYPE FixedEuclideanDistanceViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
+
+        assert(first_view.GetLength() == DIM && second_view.GetLength() == DIM);
+
+        double result = FixedDimensionKernel<DIM>::GetKernels().l2_sqr(first_view.GetData(), second_view.GetData(), DIM);
         return sqrt(result);
     }
-    
+
+    template<default_length_size DIM>
+    static void FixedEuclideanDistanceBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        assert(query.GetLength() == DIM);
+
+        BasicDistance<DATA_TYPE>::RunBatchKernel(FixedDimensionKernel<DIM>::GetKernels().l2_sqr_batch, query, vectors, vector_amount, vector_stride, results);
+        for (default_long_int i = 0; i < vector_amount; i++) {
+            results[i] = sqrt(results[i]);
+        }
+    }
+
+protected:
+
+    template<default_length_size DIM>
+    void UseFixedDimension() {
+        this->SetCalFunction(FixedEuclideanDistanceFunction<DIM>);
+        this->SetViewCalFunction(FixedEuclideanDistanceViewFunction<DIM>);
+        this->SetBatchCalFunction(FixedEuclideanDistanceBatchFunction<DIM>);
+    }
+};
+
+// EuclideanDistance variant of a compile-time dimension
+template<typename DATA_TYPE, default_length_size DIM>
+class FixedEuclideanDistance : public EuclideanDistance<DATA_TYPE> {
+
+public:
+
+    FixedEuclideanDistance() {
+        this->template UseFixedDimension<DIM>();
+    }
 };
 
 }
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : hamming_distance.h
+// since : 2024-09-06
+// desc  : Hamming distance of packed binary vectors, the amount of different bits.
+// Used as the first pass on binary quantized embeddings, the small candidate set
+// is then reranked on the full vectors.
+#ifndef VDBMS_DISTANCE_HAMMING_DISTANCE_H_
+#define VDBMS_DISTANCE_HAMMING_DISTANCE_H_
+
+#include "basic_distance.h"
+#include "kernel/kernel_dispatcher.h"
+#include "../meta/binary_vector.h"
+
+namespace tiny_v_dbms {
+
+template<typename DATA_TYPE>
+class HammingDistance : public BasicDistance<DATA_TYPE, BinaryVector> {
+
+public:
+
+    HammingDistance() {
+        this->SetCalFunction(HammingDistanceFunction);
+        this->SetViewCalFunction(HammingDistanceViewFunction);
+        this->SetBatchCalFunction(HammingDistanceBatchFunction);
+    }
+
+    /**
+    * @brief The function to calculate the Hamming distance between two binary vectors.
+    * The bits are counted by the popcount kernel chosen at startup.
+    * @param first_vector first vector.
+    * @param second_vector second vector.
+    */
+    static DATA_TYPE HammingDistanceFunction(BinaryVector & first_vector, BinaryVector & second_vector) {
+
+        assert(first_vector.GetLength() == second_vector.GetLength());
+
+        return HammingDistanceViewFunction(first_vector.GetView(), second_vector.GetView());
+    }
+
+    /**
+    * @brief Same as above, but calculate on views of packed words, the length of views is count by word.
+    */
+    static DATA_TYPE HammingDistanceViewFunction(const VectorView<default_length_size, uint64_t> & first_view, const VectorView<default_length_size, uint64_t> & second_view) {
+
+        assert(first_view.GetLength() == second_view.GetLength());
+
+        return KernelDispatcher::GetKernels().hamming(first_view.GetData(), second_view.GetData(), first_view.GetLength());
+    }
+
+    /**
+    * @brief Calculate the Hamming distances between one query and a contiguous run of packed vectors, stride is count by word.
+    */
+    static void HammingDistanceBatchFunction(BinaryVector & query, const uint64_t* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        BasicDistance<DATA_TYPE, BinaryVector>::RunBatchKernel(KernelDispatcher::GetKernels().hamming_batch, query, vectors, vector_amount, vector_stride, results);
+    }
+
+};
+
+}
+#endif // VDBMS_DISTANCE_HAMMING_DISTANCE_H_
@@ -7,6 +7,8 @@
 #define VDBMS_DISTANCE_INNER_PRODUCT_H_
 
 #include "basic_distance.h"
+#include "kernel/kernel_dispatcher.h"
+#include "kernel/fixed_dimension_kernel.h"
 
 namespace tiny_v_dbms {
 
@@ -17,25 +19,91 @@ public:
 
     InnerProduct() {
         this->SetCalFunction(InnerProductFunction);
+        this->SetViewCalFunction(InnerProductViewFunction);
+        this->SetBatchCalFunction(InnerProductBatchFunction);
+    }
+
+    /**
+    * @brief Use the kernels specialized on the dimension if it has, such as the declared length of a vector column.
+    * @param dimension length of all vectors calculated by this object.
+    */
+    explicit InnerProduct(default_length_size dimension) : InnerProduct() {
+        DimensionKernelRegistry::VisitDimension(dimension, [this](auto fixed_dimension) {
+            this->template UseFixedDimension<decltype(fixed_dimension)::value>();
+        });
     }
 
     /**
     * @brief The function to calculate the inner product distance between two vectors. 
+    * The product is calculated by the simd kernel chosen at startup.
     * @param first_vector first vector.
     * @param second_vector second vector.
     */
     static DATA_TYPE InnerProductFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return InnerProductViewFunction(first_vector.GetView(), second_vector.GetView());
+    }
+
+    /**
+    * @brief Same as above, but calculate on views.
+    */
+    static DATA_TYPE InnerProductViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
+
+        assert(first_view.GetLength() == second_view.GetLength());
+
+        return KernelDispatcher::GetKernels().inner_product(first_view.GetData(), second_view.GetData(), first_view.GetLength());
+    }
+
+    /**
+    * @brief Calculate the inner products between one query and a contiguous run of vectors.
+    */
+    static void InnerProductBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        BasicDistance<DATA_TYPE>::RunBatchKernel(KernelDispatcher::GetKernels().inner_product_batch, query, vectors, vector_amount, vector_stride, results);
+    }
+
+    /**
+    * @brief Same as above, but all vectors must have DIM elements.
+    */
+    template<default_length_size DIM>
+    static DATA_TYPE FixedInnerProductFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return FixedInnerProductViewFunction<DIM>(first_vector.GetView(), second_vector.GetView());
+    }
+
+    template<default_length_size DIM>
+    static DATA_TYPE FixedInnerProductViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
+
+        assert(first_view.GetLength() == DIM && second_view.GetLength() == DIM);
+
+        return FixedDimensionKernel<DIM>::GetKernels().inner_product(first_view.GetData(), second_view.GetData(), DIM);
+    }
+
+    template<default_length_size DIM>
+    static void FixedInnerProductBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        assert(query.GetLength() == DIM);
 
-        assert(first_vector.GetLength() == second_vector.GetLength());
+        BasicDistance<DATA_TYPE>::RunBatchKernel(FixedDimensionKernel<DIM>::GetKernels().inner_product_batch, query, vectors, vector_amount, vector_stride, results);
+    }
+
+protected:
+
+    template<default_length_size DIM>
+    void UseFixedDimension() {
+        this->SetCalFunction(FixedInnerProductFunction<DIM>);
+        this->SetViewCalFunction(FixedInnerProductViewFunction<DIM>);
+        this->SetBatchCalFunction(FixedInnerProductBatchFunction<DIM>);
+    }
+};
+
+// InnerProduct variant of a compile-time dimension
+template<typename DATA_TYPE, default_length_size DIM>
+class FixedInnerProduct : public InnerProduct<DATA_TYPE> {
+
+public:
 
-        DATA_TYPE result = 0;
-        for (DATA_TYPE i = 0; i < first_vector.GetLength(); i++) {
-            result += (first_vector.Get(i) * second_vector.Get(i));
-        }
-    
-        return result;
+    FixedInnerProduct() {
+        this->template UseFixedDimension<DIM>();
     }
-    
 };
 
 }
@@ -0,0 +1,525 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : element_kernel.h
+// since : 2024-09-07
+// desc  : Mixed precision distance kernels, compare a fp32 query with vectors
+// stored as fp32, fp16, bf16 or int8 (see element_type.h). Stored values are
+// widened to fp32 in registers and accumulated in fp32, so narrow storage only
+// reduces the bytes read, not the precision of the sum. The kernels of each
+// element type are chosen once by ElementKernelDispatcher.
+
+#ifndef VDBMS_DISTANCE_KERNEL_ELEMENT_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_ELEMENT_KERNEL_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "../../config.h"
+#include "../../meta/element_type.h"
+#include "../../utils/cpu_feature_util.h"
+#include "simd_kernel.h"
+
+namespace tiny_v_dbms {
+
+// query is fp32, stored is the raw bytes of one stored vector
+typedef double (*ElementKernelFunction)(const float* query, const char* stored, default_length_size length);
+typedef double (*ElementEarlyAbandonKernelFunction)(const float* query, const char* stored, default_length_size length, double threshold);
+// stride is count by byte
+typedef void (*ElementBatchKernelFunction)(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results);
+
+struct ElementKernelTable
+{
+    vector_element_type element_type;
+    SimdLevel level;
+    ElementKernelFunction l2_sqr;
+    ElementKernelFunction inner_product;
+    ElementBatchKernelFunction l2_sqr_batch;
+    ElementBatchKernelFunction inner_product_batch;
+    ElementEarlyAbandonKernelFunction l2_sqr_early_abandon;     // stop when larger than the k-th best
+};
+
+template<vector_element_type TYPE>
+class ScalarElementKernel
+{
+
+public:
+
+    // read the i-th stored value as fp32
+    static inline float Load(const char* stored, default_length_size i)
+    {
+        if constexpr (TYPE == ELEMENT_FP64)
+        {
+            double value;
+            memcpy(&value, stored + i * sizeof(double), sizeof(double));
+            return (float) value;
+        }
+        else if constexpr (TYPE == ELEMENT_FP32)
+        {
+            float value;
+            memcpy(&value, stored + i * sizeof(float), sizeof(float));
+            return value;
+        }
+        else if constexpr (TYPE == ELEMENT_FP16)
+        {
+            uint16_t value;
+            memcpy(&value, stored + i * sizeof(uint16_t), sizeof(uint16_t));
+            return ElementTypeUtil::HalfToFloat(value);
+        }
+        else if constexpr (TYPE == ELEMENT_BF16)
+        {
+            uint16_t value;
+            memcpy(&value, stored + i * sizeof(uint16_t), sizeof(uint16_t));
+            return ElementTypeUtil::BFloat16ToFloat(value);
+        }
+        else
+        {
+            return (float) (int8_t) stored[i];
+        }
+    }
+
+    static double L2Sqr(const float* query, const char* stored, default_length_size length)
+    {
+        float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        default_length_size i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            float diff0 = query[i] - Load(stored, i);
+            float diff1 = query[i + 1] - Load(stored, i + 1);
+            float diff2 = query[i + 2] - Load(stored, i + 2);
+            float diff3 = query[i + 3] - Load(stored, i + 3);
+            sum0 += diff0 * diff0;
+            sum1 += diff1 * diff1;
+            sum2 += diff2 * diff2;
+            sum3 += diff3 * diff3;
+        }
+        for (; i < length; i++)
+        {
+            float diff = query[i] - Load(stored, i);
+            sum0 += diff * diff;
+        }
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    /**
+     * @brief Squared euclidean distance, the partial sum is checked every 32 elements and returned once it is larger
+     * than threshold.
+     * @return The exact distance if it is not larger than threshold, else a partial sum larger than threshold.
+     */
+    static double L2SqrEarlyAbandon(const float* query, const char* stored, default_length_size length, double threshold)
+    {
+        float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        default_length_size i = 0;
+        while (i + 4 <= length)
+        {
+            default_length_size check_end = i + 32 < length ? i + 32 : length;
+            for (; i + 4 <= check_end; i += 4)
+            {
+                float diff0 = query[i] - Load(stored, i);
+                float diff1 = query[i + 1] - Load(stored, i + 1);
+                float diff2 = query[i + 2] - Load(stored, i + 2);
+                float diff3 = query[i + 3] - Load(stored, i + 3);
+                sum0 += diff0 * diff0;
+                sum1 += diff1 * diff1;
+                sum2 += diff2 * diff2;
+                sum3 += diff3 * diff3;
+            }
+            double partial = (sum0 + sum1) + (sum2 + sum3);
+            if (partial > threshold)
+            {
+                return partial;
+            }
+        }
+        for (; i < length; i++)
+        {
+            float diff = query[i] - Load(stored, i);
+            sum0 += diff * diff;
+        }
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    static double InnerProduct(const float* query, const char* stored, default_length_size length)
+    {
+        float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        default_length_size i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            sum0 += query[i] * Load(stored, i);
+            sum1 += query[i + 1] * Load(stored, i + 1);
+            sum2 += query[i + 2] * Load(stored, i + 2);
+            sum3 += query[i + 3] * Load(stored, i + 3);
+        }
+        for (; i < length; i++)
+        {
+            sum0 += query[i] * Load(stored, i);
+        }
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    static void L2SqrBatch(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, stored + row * vector_stride, length);
+        }
+    }
+
+    static void InnerProductBatch(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, stored + row * vector_stride, length);
+        }
+    }
+};
+
+#ifdef VDBMS_X86_SIMD
+
+// fp64 storage is not widened, so it has no simd element kernel, use DistanceKernelTable instead
+template<vector_element_type TYPE>
+class Avx2ElementKernel
+{
+
+    static_assert(TYPE != ELEMENT_FP64, "fp64 storage uses the double kernels");
+
+public:
+
+    // load 8 stored values as fp32
+    __attribute__((target("avx2,fma,f16c")))
+    static inline __m256 Load8(const char* stored)
+    {
+        if constexpr (TYPE == ELEMENT_FP32)
+        {
+            return _mm256_loadu_ps((const float*) stored);
+        }
+        else if constexpr (TYPE == ELEMENT_FP16)
+        {
+            return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) stored));
+        }
+        else if constexpr (TYPE == ELEMENT_BF16)
+        {
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) stored)), 16));
+        }
+        else
+        {
+            return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*) stored)));
+        }
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    static double L2Sqr(const float* query, const char* stored, default_length_size length)
+    {
+        const default_length_size element_size = ElementSize();
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        default_length_size i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            __m256 diff0 = _mm256_sub_ps(_mm256_loadu_ps(query + i), Load8(stored + i * element_size));
+            __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(query + i + 8), Load8(stored + (i + 8) * element_size));
+            sum0 = _mm256_fmadd_ps(diff0, diff0, sum0);
+            sum1 = _mm256_fmadd_ps(diff1, diff1, sum1);
+        }
+        double result = HorizontalSum(_mm256_add_ps(sum0, sum1));
+        return result + ScalarElementKernel<TYPE>::L2Sqr(query + i, stored + i * element_size, length - i);
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    static double L2SqrEarlyAbandon(const float* query, const char* stored, default_length_size length, double threshold)
+    {
+        const default_length_size element_size = ElementSize();
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        default_length_size i = 0;
+        while (i + 16 <= length)
+        {
+            default_length_size check_end = i + 64 < length ? i + 64 : length;
+            for (; i + 16 <= check_end; i += 16)
+            {
+                __m256 diff0 = _mm256_sub_ps(_mm256_loadu_ps(query + i), Load8(stored + i * element_size));
+                __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(query + i + 8), Load8(stored + (i + 8) * element_size));
+                sum0 = _mm256_fmadd_ps(diff0, diff0, sum0);
+                sum1 = _mm256_fmadd_ps(diff1, diff1, sum1);
+            }
+            double partial = HorizontalSum(_mm256_add_ps(sum0, sum1));
+            if (partial > threshold)
+            {
+                return partial;
+            }
+        }
+        double result = HorizontalSum(_mm256_add_ps(sum0, sum1));
+        return result + ScalarElementKernel<TYPE>::L2Sqr(query + i, stored + i * element_size, length - i);
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    static double InnerProduct(const float* query, const char* stored, default_length_size length)
+    {
+        const default_length_size element_size = ElementSize();
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        default_length_size i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), Load8(stored + i * element_size), sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i + 8), Load8(stored + (i + 8) * element_size), sum1);
+        }
+        double result = HorizontalSum(_mm256_add_ps(sum0, sum1));
+        return result + ScalarElementKernel<TYPE>::InnerProduct(query + i, stored + i * element_size, length - i);
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    static void L2SqrBatch(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, stored + row * vector_stride, length);
+        }
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    static void InnerProductBatch(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, stored + row * vector_stride, length);
+        }
+    }
+
+private:
+
+    static constexpr default_length_size ElementSize()
+    {
+        return TYPE == ELEMENT_FP32 ? 4 : (TYPE == ELEMENT_INT8 ? 1 : 2);
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    static double HorizontalSum(__m256 sum)
+    {
+        __m128 low = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        low = _mm_add_ps(low, _mm_movehl_ps(low, low));
+        low = _mm_add_ss(low, _mm_shuffle_ps(low, low, 1));
+        return _mm_cvtss_f32(low);
+    }
+};
+
+template<vector_element_type TYPE>
+class Avx512ElementKernel
+{
+
+    static_assert(TYPE != ELEMENT_FP64, "fp64 storage uses the double kernels");
+
+public:
+
+    // load 16 stored values as fp32, use the zero masked intrinsics, gcc 12 reports false uninitialized warnings on the plain ones
+    __attribute__((target("avx512f")))
+    static inline __m512 Load16(const char* stored)
+    {
+        const __mmask16 all = 0xFFFF;
+        if constexpr (TYPE == ELEMENT_FP32)
+        {
+            return _mm512_loadu_ps((const float*) stored);
+        }
+        else if constexpr (TYPE == ELEMENT_FP16)
+        {
+            return _mm512_maskz_cvtph_ps(all, _mm256_loadu_si256((const __m256i*) stored));
+        }
+        else if constexpr (TYPE == ELEMENT_BF16)
+        {
+            __m512i widened = _mm512_maskz_cvtepu16_epi32(all, _mm256_loadu_si256((const __m256i*) stored));
+            return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(all, widened, 16));
+        }
+        else
+        {
+            return _mm512_maskz_cvtepi32_ps(all, _mm512_maskz_cvtepi8_epi32(all, _mm_loadu_si128((const __m128i*) stored)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static double L2Sqr(const float* query, const char* stored, default_length_size length)
+    {
+        const default_length_size element_size = ElementSize();
+        __m512 sum0 = _mm512_setzero_ps();
+        __m512 sum1 = _mm512_setzero_ps();
+        default_length_size i = 0;
+        for (; i + 32 <= length; i += 32)
+        {
+            __m512 diff0 = _mm512_sub_ps(_mm512_loadu_ps(query + i), Load16(stored + i * element_size));
+            __m512 diff1 = _mm512_sub_ps(_mm512_loadu_ps(query + i + 16), Load16(stored + (i + 16) * element_size));
+            sum0 = _mm512_fmadd_ps(diff0, diff0, sum0);
+            sum1 = _mm512_fmadd_ps(diff1, diff1, sum1);
+        }
+        double result = HorizontalSum(_mm512_add_ps(sum0, sum1));
+        return result + ScalarElementKernel<TYPE>::L2Sqr(query + i, stored + i * element_size, length - i);
+    }
+
+    __attribute__((target("avx512f")))
+    static double L2SqrEarlyAbandon(const float* query, const char* stored, default_length_size length, double threshold)
+    {
+        const default_length_size element_size = ElementSize();
+        __m512 sum0 = _mm512_setzero_ps();
+        __m512 sum1 = _mm512_setzero_ps();
+        default_length_size i = 0;
+        while (i + 32 <= length)
+        {
+            default_length_size check_end = i + 64 < length ? i + 64 : length;
+            for (; i + 32 <= check_end; i += 32)
+            {
+                __m512 diff0 = _mm512_sub_ps(_mm512_loadu_ps(query + i), Load16(stored + i * element_size));
+                __m512 diff1 = _mm512_sub_ps(_mm512_loadu_ps(query + i + 16), Load16(stored + (i + 16) * element_size));
+                sum0 = _mm512_fmadd_ps(diff0, diff0, sum0);
+                sum1 = _mm512_fmadd_ps(diff1, diff1, sum1);
+            }
+            double partial = HorizontalSum(_mm512_add_ps(sum0, sum1));
+            if (partial > threshold)
+            {
+                return partial;
+            }
+        }
+        double result = HorizontalSum(_mm512_add_ps(sum0, sum1));
+        return result + ScalarElementKernel<TYPE>::L2Sqr(query + i, stored + i * element_size, length - i);
+    }
+
+    __attribute__((target("avx512f")))
+    static double InnerProduct(const float* query, const char* stored, default_length_size length)
+    {
+        const default_length_size element_size = ElementSize();
+        __m512 sum0 = _mm512_setzero_ps();
+        __m512 sum1 = _mm512_setzero_ps();
+        default_length_size i = 0;
+        for (; i + 32 <= length; i += 32)
+        {
+            sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), Load16(stored + i * element_size), sum0);
+            sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(query + i + 16), Load16(stored + (i + 16) * element_size), sum1);
+        }
+        double result = HorizontalSum(_mm512_add_ps(sum0, sum1));
+        return result + ScalarElementKernel<TYPE>::InnerProduct(query + i, stored + i * element_size, length - i);
+    }
+
+    __attribute__((target("avx512f")))
+    static void L2SqrBatch(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, stored + row * vector_stride, length);
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static void InnerProductBatch(const float* query, const char* stored, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, stored + row * vector_stride, length);
+        }
+    }
+
+private:
+
+    static constexpr default_length_size ElementSize()
+    {
+        return TYPE == ELEMENT_FP32 ? 4 : (TYPE == ELEMENT_INT8 ? 1 : 2);
+    }
+
+    __attribute__((target("avx512f")))
+    static double HorizontalSum(__m512 sum)
+    {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, sum);
+        float result = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            result += lanes[i];
+        }
+        return result;
+    }
+};
+
+#endif // VDBMS_X86_SIMD
+
+class ElementKernelDispatcher
+{
+
+public:
+
+    /**
+     * @brief Get the kernels of the element type chosen for the running cpu.
+     * @return The kernel table, built only once.
+     */
+    static const ElementKernelTable& GetKernels(vector_element_type element_type)
+    {
+        static ElementKernelTable tables[] = {
+            BuildKernelTable(ELEMENT_FP64, CpuFeatureUtil::GetSimdLevel()),
+            BuildKernelTable(ELEMENT_FP32, CpuFeatureUtil::GetSimdLevel()),
+            BuildKernelTable(ELEMENT_FP16, CpuFeatureUtil::GetSimdLevel()),
+            BuildKernelTable(ELEMENT_BF16, CpuFeatureUtil::GetSimdLevel()),
+            BuildKernelTable(ELEMENT_INT8, CpuFeatureUtil::GetSimdLevel())
+        };
+        return tables[element_type];
+    }
+
+    /**
+     * @brief Build a kernel table of the element type, the level must be supported by cpu.
+     */
+    static ElementKernelTable BuildKernelTable(vector_element_type element_type, SimdLevel level)
+    {
+        switch (element_type)
+        {
+            case ELEMENT_FP64:
+                return BuildTypedKernelTable<ELEMENT_FP64>(level);
+            case ELEMENT_FP32:
+                return BuildTypedKernelTable<ELEMENT_FP32>(level);
+            case ELEMENT_FP16:
+                return BuildTypedKernelTable<ELEMENT_FP16>(level);
+            case ELEMENT_BF16:
+                return BuildTypedKernelTable<ELEMENT_BF16>(level);
+            case ELEMENT_INT8:
+                return BuildTypedKernelTable<ELEMENT_INT8>(level);
+            default:
+                throw std::runtime_error("unknown vector element type");
+        }
+    }
+
+private:
+
+    template<vector_element_type TYPE>
+    static ElementKernelTable BuildTypedKernelTable(SimdLevel level)
+    {
+        ElementKernelTable table;
+        table.element_type = TYPE;
+        table.level = SCALAR_LEVEL;
+        table.l2_sqr = ScalarElementKernel<TYPE>::L2Sqr;
+        table.inner_product = ScalarElementKernel<TYPE>::InnerProduct;
+        table.l2_sqr_batch = ScalarElementKernel<TYPE>::L2SqrBatch;
+        table.inner_product_batch = ScalarElementKernel<TYPE>::InnerProductBatch;
+        table.l2_sqr_early_abandon = ScalarElementKernel<TYPE>::L2SqrEarlyAbandon;
+
+#ifdef VDBMS_X86_SIMD
+        if constexpr (TYPE != ELEMENT_FP64)
+        {
+            if (level == AVX512_LEVEL)
+            {
+                table.level = AVX512_LEVEL;
+                table.l2_sqr = Avx512ElementKernel<TYPE>::L2Sqr;
+                table.inner_product = Avx512ElementKernel<TYPE>::InnerProduct;
+                table.l2_sqr_batch = Avx512ElementKernel<TYPE>::L2SqrBatch;
+                table.inner_product_batch = Avx512ElementKernel<TYPE>::InnerProductBatch;
+                table.l2_sqr_early_abandon = Avx512ElementKernel<TYPE>::L2SqrEarlyAbandon;
+            }
+            else if (level == AVX2_LEVEL && CpuFeatureUtil::GetFeature().f16c)
+            {
+                table.level = AVX2_LEVEL;
+                table.l2_sqr = Avx2ElementKernel<TYPE>::L2Sqr;
+                table.inner_product = Avx2ElementKernel<TYPE>::InnerProduct;
+                table.l2_sqr_batch = Avx2ElementKernel<TYPE>::L2SqrBatch;
+                table.inner_product_batch = Avx2ElementKernel<TYPE>::InnerProductBatch;
+                table.l2_sqr_early_abandon = Avx2ElementKernel<TYPE>::L2SqrEarlyAbandon;
+            }
+        }
+#endif
+
+        return table;
+    }
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_ELEMENT_KERNEL_H_
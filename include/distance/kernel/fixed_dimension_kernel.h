@@ -0,0 +1,273 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : fixed_dimension_kernel.h
+// since : 2024-09-03
+// desc  : Distance kernels specialized on a compile-time dimension. Embeddings
+// used by us only have a few widths (96, 128, 384, 768, 1536), all of them are
+// multiples of 32, so the kernels have a constant trip count and no tail loop,
+// and the compiler can fully unroll them. DimensionKernelRegistry chooses the
+// kernels from the declared length of a column, and falls back to the generic
+// kernels for other lengths.
+
+#ifndef VDBMS_DISTANCE_KERNEL_FIXED_DIMENSION_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_FIXED_DIMENSION_KERNEL_H_
+
+#include <type_traits>
+
+#include "../../config.h"
+#include "kernel_dispatcher.h"
+
+namespace tiny_v_dbms {
+
+template<default_length_size DIM>
+class FixedDimensionKernel
+{
+
+    static_assert(DIM > 0 && DIM % 32 == 0, "fixed dimension kernel needs a dimension which is a multiple of 32");
+
+public:
+
+    /**
+     * @brief Get the kernels of this dimension chosen for the running cpu.
+     * @return The kernel table, built only once.
+     */
+    static const DistanceKernelTable& GetKernels()
+    {
+        static DistanceKernelTable table = BuildKernelTable(CpuFeatureUtil::GetSimdLevel());
+        return table;
+    }
+
+    /**
+     * @brief Build a kernel table of this dimension, levels without a fixed kernel use the generic ones.
+     * @param level simd level, must be supported by cpu.
+     * @return The kernel table.
+     */
+    static DistanceKernelTable BuildKernelTable(SimdLevel level)
+    {
+        DistanceKernelTable table = KernelDispatcher::BuildKernelTable(level);
+        table.dimension = DIM;
+
+#ifdef VDBMS_X86_SIMD
+        switch (level)
+        {
+            case AVX512_LEVEL:
+                table.l2_sqr = L2SqrAvx512;
+                table.inner_product = InnerProductAvx512;
+                table.l2_sqr_batch = L2SqrBatchAvx512;
+                table.inner_product_batch = InnerProductBatchAvx512;
+                break;
+            case AVX2_LEVEL:
+                table.l2_sqr = L2SqrAvx2;
+                table.inner_product = InnerProductAvx2;
+                table.l2_sqr_batch = L2SqrBatchAvx2;
+                table.inner_product_batch = InnerProductBatchAvx2;
+                break;
+            default:
+                break;
+        }
+#endif
+
+        return table;
+    }
+
+#ifdef VDBMS_X86_SIMD
+
+    // length is not used, the kernels keep the signature of DistanceKernelFunction to be stored in the table
+    __attribute__((target("avx2,fma")))
+    static double L2SqrAvx2(const double* first, const double* second, default_length_size)
+    {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        __m256d sum2 = _mm256_setzero_pd();
+        __m256d sum3 = _mm256_setzero_pd();
+        for (default_length_size i = 0; i < DIM; i += 16)
+        {
+            __m256d diff0 = _mm256_sub_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i));
+            __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 4), _mm256_loadu_pd(second + i + 4));
+            __m256d diff2 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 8), _mm256_loadu_pd(second + i + 8));
+            __m256d diff3 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 12), _mm256_loadu_pd(second + i + 12));
+            sum0 = _mm256_fmadd_pd(diff0, diff0, sum0);
+            sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+            sum2 = _mm256_fmadd_pd(diff2, diff2, sum2);
+            sum3 = _mm256_fmadd_pd(diff3, diff3, sum3);
+        }
+        return HorizontalSumAvx2(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+    }
+
+    __attribute__((target("avx2,fma")))
+    static double InnerProductAvx2(const double* first, const double* second, default_length_size)
+    {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        __m256d sum2 = _mm256_setzero_pd();
+        __m256d sum3 = _mm256_setzero_pd();
+        for (default_length_size i = 0; i < DIM; i += 16)
+        {
+            sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i), sum0);
+            sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i + 4), _mm256_loadu_pd(second + i + 4), sum1);
+            sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i + 8), _mm256_loadu_pd(second + i + 8), sum2);
+            sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i + 12), _mm256_loadu_pd(second + i + 12), sum3);
+        }
+        return HorizontalSumAvx2(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+    }
+
+    __attribute__((target("avx2,fma")))
+    static void L2SqrBatchAvx2(const double* query, const double* vectors, default_length_size, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2SqrAvx2(query, vectors + row * vector_stride, DIM);
+        }
+    }
+
+    __attribute__((target("avx2,fma")))
+    static void InnerProductBatchAvx2(const double* query, const double* vectors, default_length_size, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProductAvx2(query, vectors + row * vector_stride, DIM);
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static double L2SqrAvx512(const double* first, const double* second, default_length_size)
+    {
+        __m512d sum0 = _mm512_setzero_pd();
+        __m512d sum1 = _mm512_setzero_pd();
+        __m512d sum2 = _mm512_setzero_pd();
+        __m512d sum3 = _mm512_setzero_pd();
+        for (default_length_size i = 0; i < DIM; i += 32)
+        {
+            __m512d diff0 = _mm512_sub_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i));
+            __m512d diff1 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 8), _mm512_loadu_pd(second + i + 8));
+            __m512d diff2 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 16), _mm512_loadu_pd(second + i + 16));
+            __m512d diff3 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 24), _mm512_loadu_pd(second + i + 24));
+            sum0 = _mm512_fmadd_pd(diff0, diff0, sum0);
+            sum1 = _mm512_fmadd_pd(diff1, diff1, sum1);
+            sum2 = _mm512_fmadd_pd(diff2, diff2, sum2);
+            sum3 = _mm512_fmadd_pd(diff3, diff3, sum3);
+        }
+        return HorizontalSumAvx512(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3)));
+    }
+
+    __attribute__((target("avx512f")))
+    static double InnerProductAvx512(const double* first, const double* second, default_length_size)
+    {
+        __m512d sum0 = _mm512_setzero_pd();
+        __m512d sum1 = _mm512_setzero_pd();
+        __m512d sum2 = _mm512_setzero_pd();
+        __m512d sum3 = _mm512_setzero_pd();
+        for (default_length_size i = 0; i < DIM; i += 32)
+        {
+            sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i), sum0);
+            sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i + 8), _mm512_loadu_pd(second + i + 8), sum1);
+            sum2 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i + 16), _mm512_loadu_pd(second + i + 16), sum2);
+            sum3 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i + 24), _mm512_loadu_pd(second + i + 24), sum3);
+        }
+        return HorizontalSumAvx512(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3)));
+    }
+
+    __attribute__((target("avx512f")))
+    static void L2SqrBatchAvx512(const double* query, const double* vectors, default_length_size, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2SqrAvx512(query, vectors + row * vector_stride, DIM);
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static void InnerProductBatchAvx512(const double* query, const double* vectors, default_length_size, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProductAvx512(query, vectors + row * vector_stride, DIM);
+        }
+    }
+
+private:
+
+    __attribute__((target("avx2,fma")))
+    static double HorizontalSumAvx2(__m256d sum)
+    {
+        __m128d low = _mm256_castpd256_pd128(sum);
+        __m128d high = _mm256_extractf128_pd(sum, 1);
+        low = _mm_add_pd(low, high);
+        return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+    }
+
+    __attribute__((target("avx512f")))
+    static double HorizontalSumAvx512(__m512d sum)
+    {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, sum);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+#endif // VDBMS_X86_SIMD
+};
+
+class DimensionKernelRegistry
+{
+
+public:
+
+    /**
+     * @brief Call visitor with the dimension as a std::integral_constant if it has specialized kernels, so the caller
+     * can use FixedDimensionKernel or other templates of it. This is the only list of specialized dimensions.
+     * @param dimension declared length of the vector column.
+     * @param visitor called as visitor(std::integral_constant<default_length_size, DIM>()).
+     * @return false if the dimension is not specialized, visitor is not called.
+     */
+    template<typename VISITOR>
+    static bool VisitDimension(default_length_size dimension, VISITOR&& visitor)
+    {
+        switch (dimension)
+        {
+            case 96:
+                visitor(std::integral_constant<default_length_size, 96>());
+                return true;
+            case 128:
+                visitor(std::integral_constant<default_length_size, 128>());
+                return true;
+            case 384:
+                visitor(std::integral_constant<default_length_size, 384>());
+                return true;
+            case 768:
+                visitor(std::integral_constant<default_length_size, 768>());
+                return true;
+            case 1536:
+                visitor(std::integral_constant<default_length_size, 1536>());
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Check if the dimension has specialized kernels.
+     * @param dimension declared length of the vector column.
+     */
+    static bool IsSpecialized(default_length_size dimension)
+    {
+        return VisitDimension(dimension, [](auto) {});
+    }
+
+    /**
+     * @brief Get the kernels for vectors of the dimension, the generic kernels are returned if the dimension is not specialized.
+     * @param dimension declared length of the vector column.
+     * @return The kernel table.
+     */
+    static const DistanceKernelTable& GetKernels(default_length_size dimension)
+    {
+        const DistanceKernelTable* table = &KernelDispatcher::GetKernels();
+        VisitDimension(dimension, [&table](auto fixed_dimension) {
+            table = &FixedDimensionKernel<decltype(fixed_dimension)::value>::GetKernels();
+        });
+        return *table;
+    }
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_FIXED_DIMENSION_KERNEL_H_
@@ -0,0 +1,220 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : gemm_kernel.h
+// since : 2024-09-10
+// desc  : Squared euclidean distances between a tile of queries and a tile of
+// vectors, computed like a blocked matrix multiply. The micro kernel keeps the
+// sums of 6 queries x 2 vectors in registers (15 of the 16 avx2 registers with
+// the loaded values), so each loaded element of a vector is used by 6 queries
+// and each loaded element of a query by 2 vectors, instead of one load per
+// multiply when queries are compared one by one. Differences
+// are squared directly rather than expanding |q|^2 + |x|^2 - 2qx, so results
+// have the same precision as the fp32 element kernels. The kernel is chosen at
+// runtime like the distance kernels.
+
+#ifndef VDBMS_DISTANCE_KERNEL_GEMM_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_GEMM_KERNEL_H_
+
+#include "../../config.h"
+#include "../../utils/cpu_feature_util.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace tiny_v_dbms {
+
+/**
+ * @brief Squared euclidean distances of every pair of a query tile and a vector tile.
+ * @param queries query_amount queries of length floats, stored one after another.
+ * @param vectors vector_amount vectors of length floats.
+ * @param vector_stride distance between the begin of two neighbor vectors, count by float.
+ * @param results distance of query q and vector v is stored at results[q * vector_amount + v].
+ */
+typedef void (*L2SqrTileKernelFunction)(const float* queries, default_amount_type query_amount, const float* vectors, default_long_int vector_amount,
+    default_length_size vector_stride, default_length_size length, float* results);
+
+class GemmKernel
+{
+
+public:
+
+    static constexpr default_amount_type QUERY_BLOCK = 6;      // queries of one micro kernel
+    static constexpr default_long_int VECTOR_BLOCK = 2;        // vectors of one micro kernel
+
+    /**
+     * @brief Get the kernel chosen for the running cpu.
+     */
+    static L2SqrTileKernelFunction GetKernel()
+    {
+        static L2SqrTileKernelFunction kernel = ChooseKernel(CpuFeatureUtil::GetSimdLevel());
+        return kernel;
+    }
+
+    /**
+     * @brief Choose the kernel of a simd level, the level must be supported by cpu.
+     */
+    static L2SqrTileKernelFunction ChooseKernel(SimdLevel level)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (level >= AVX2_LEVEL)
+        {
+            return L2SqrTileAvx2;
+        }
+#endif
+        return L2SqrTileScalar;
+    }
+
+    static void L2SqrTileScalar(const float* queries, default_amount_type query_amount, const float* vectors, default_long_int vector_amount,
+        default_length_size vector_stride, default_length_size length, float* results)
+    {
+        default_amount_type q = 0;
+        for (; q + QUERY_BLOCK <= query_amount; q += QUERY_BLOCK)
+        {
+            default_long_int v = 0;
+            for (; v + VECTOR_BLOCK <= vector_amount; v += VECTOR_BLOCK)
+            {
+                MicroKernelScalar<QUERY_BLOCK, VECTOR_BLOCK>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+            for (; v < vector_amount; v++)
+            {
+                MicroKernelScalar<QUERY_BLOCK, 1>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+        }
+        for (; q < query_amount; q++)
+        {
+            for (default_long_int v = 0; v < vector_amount; v++)
+            {
+                MicroKernelScalar<1, 1>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    __attribute__((target("avx2,fma")))
+    static void L2SqrTileAvx2(const float* queries, default_amount_type query_amount, const float* vectors, default_long_int vector_amount,
+        default_length_size vector_stride, default_length_size length, float* results)
+    {
+        default_amount_type q = 0;
+        for (; q + QUERY_BLOCK <= query_amount; q += QUERY_BLOCK)
+        {
+            default_long_int v = 0;
+            for (; v + VECTOR_BLOCK <= vector_amount; v += VECTOR_BLOCK)
+            {
+                MicroKernelAvx2<QUERY_BLOCK, VECTOR_BLOCK>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+            for (; v < vector_amount; v++)
+            {
+                MicroKernelAvx2<QUERY_BLOCK, 1>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+        }
+        for (; q < query_amount; q++)
+        {
+            default_long_int v = 0;
+            for (; v + VECTOR_BLOCK <= vector_amount; v += VECTOR_BLOCK)
+            {
+                MicroKernelAvx2<1, VECTOR_BLOCK>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+            for (; v < vector_amount; v++)
+            {
+                MicroKernelAvx2<1, 1>(queries + q * length, vectors + v * vector_stride, vector_stride, length, results + q * vector_amount + v, vector_amount);
+            }
+        }
+    }
+
+#endif
+
+private:
+
+    template <int QB, int VB>
+    static inline void MicroKernelScalar(const float* queries, const float* vectors, default_length_size vector_stride, default_length_size length,
+        float* results, default_long_int result_stride)
+    {
+        float sums[QB][VB] = {};
+        for (default_length_size d = 0; d < length; d++)
+        {
+            for (int i = 0; i < QB; i++)
+            {
+                float query_value = queries[i * length + d];
+                for (int j = 0; j < VB; j++)
+                {
+                    float diff = query_value - vectors[j * vector_stride + d];
+                    sums[i][j] += diff * diff;
+                }
+            }
+        }
+        for (int i = 0; i < QB; i++)
+        {
+            for (int j = 0; j < VB; j++)
+            {
+                results[i * result_stride + j] = sums[i][j];
+            }
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    // 8 dimensions per loop, QB x VB sums are kept in registers, the tail of dimensions is added by scalar
+    template <int QB, int VB>
+    __attribute__((target("avx2,fma")))
+    static inline void MicroKernelAvx2(const float* queries, const float* vectors, default_length_size vector_stride, default_length_size length,
+        float* results, default_long_int result_stride)
+    {
+        __m256 sums[QB][VB];
+#pragma GCC unroll 6
+        for (int i = 0; i < QB; i++)
+        {
+#pragma GCC unroll 2
+            for (int j = 0; j < VB; j++)
+            {
+                sums[i][j] = _mm256_setzero_ps();
+            }
+        }
+
+        default_length_size d = 0;
+        for (; d + 8 <= length; d += 8)
+        {
+            __m256 vector_values[VB];
+#pragma GCC unroll 2
+            for (int j = 0; j < VB; j++)
+            {
+                vector_values[j] = _mm256_loadu_ps(vectors + j * vector_stride + d);
+            }
+#pragma GCC unroll 6
+            for (int i = 0; i < QB; i++)
+            {
+                __m256 query_value = _mm256_loadu_ps(queries + i * length + d);
+#pragma GCC unroll 2
+                for (int j = 0; j < VB; j++)
+                {
+                    __m256 diff = _mm256_sub_ps(query_value, vector_values[j]);
+                    sums[i][j] = _mm256_fmadd_ps(diff, diff, sums[i][j]);
+                }
+            }
+        }
+
+        for (int i = 0; i < QB; i++)
+        {
+            for (int j = 0; j < VB; j++)
+            {
+                __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sums[i][j]), _mm256_extractf128_ps(sums[i][j], 1));
+                sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+                sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+                float result = _mm_cvtss_f32(sum);
+                for (default_length_size tail = d; tail < length; tail++)
+                {
+                    float diff = queries[i * length + tail] - vectors[j * vector_stride + tail];
+                    result += diff * diff;
+                }
+                results[i * result_stride + j] = result;
+            }
+        }
+    }
+
+#endif
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_GEMM_KERNEL_H_
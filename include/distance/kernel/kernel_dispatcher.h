@@ -0,0 +1,121 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : kernel_dispatcher.h
+// since : 2024-09-02
+// desc  : Choose the fastest distance kernels supported by the running cpu. The
+// kernels are chosen once using cpuid and stored in a table of function pointers,
+// so calculating one distance only cost one indirect call.
+
+#ifndef VDBMS_DISTANCE_KERNEL_KERNEL_DISPATCHER_H_
+#define VDBMS_DISTANCE_KERNEL_KERNEL_DISPATCHER_H_
+
+#include "../../config.h"
+#include "../../utils/cpu_feature_util.h"
+#include "scalar_kernel.h"
+#include "simd_kernel.h"
+
+namespace tiny_v_dbms {
+
+typedef double (*DistanceKernelFunction)(const double* first, const double* second, default_length_size length);
+typedef double (*DistanceEarlyAbandonKernelFunction)(const double* first, const double* second, default_length_size length, double threshold);
+typedef default_length_size (*HammingKernelFunction)(const uint64_t* first, const uint64_t* second, default_length_size word_length);
+typedef void (*HammingBatchKernelFunction)(const uint64_t* query, const uint64_t* vectors, default_length_size word_length, default_long_int vector_amount, default_length_size vector_stride, default_length_size* results);
+typedef void (*DistanceBatchKernelFunction)(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results);
+
+struct DistanceKernelTable
+{
+    SimdLevel level;
+    default_length_size dimension;                      // 0 if the kernels work on any length
+    DistanceKernelFunction l2_sqr;
+    DistanceKernelFunction inner_product;
+    DistanceBatchKernelFunction l2_sqr_batch;            // one query to many vectors
+    DistanceBatchKernelFunction inner_product_batch;
+    DistanceEarlyAbandonKernelFunction l2_sqr_early_abandon;    // stop when larger than the k-th best
+    HammingKernelFunction hamming;                      // packed binary vectors
+    HammingBatchKernelFunction hamming_batch;
+};
+
+class KernelDispatcher
+{
+
+public:
+
+    /**
+     * @brief Get the kernels chosen for the running cpu.
+     * @return The kernel table, built only once.
+     */
+    static const DistanceKernelTable& GetKernels()
+    {
+        static DistanceKernelTable table = BuildKernelTable(CpuFeatureUtil::GetSimdLevel());
+        return table;
+    }
+
+    /**
+     * @brief Build a kernel table using the input simd level, the level must be supported by cpu.
+     * @param level simd level.
+     * @return The kernel table.
+     */
+    static DistanceKernelTable BuildKernelTable(SimdLevel level)
+    {
+        DistanceKernelTable table;
+        table.level = SCALAR_LEVEL;
+        table.dimension = 0;
+        table.l2_sqr = ScalarKernel::L2Sqr;
+        table.inner_product = ScalarKernel::InnerProduct;
+        table.l2_sqr_batch = ScalarKernel::L2SqrBatch;
+        table.inner_product_batch = ScalarKernel::InnerProductBatch;
+        table.l2_sqr_early_abandon = ScalarKernel::L2SqrEarlyAbandon;
+        table.hamming = ScalarKernel::Hamming;
+        table.hamming_batch = ScalarKernel::HammingBatch;
+
+#ifdef VDBMS_X86_SIMD
+        switch (level)
+        {
+            case AVX512_LEVEL:
+                table.level = AVX512_LEVEL;
+                table.l2_sqr = Avx512Kernel::L2Sqr;
+                table.inner_product = Avx512Kernel::InnerProduct;
+                table.l2_sqr_batch = Avx512Kernel::L2SqrBatch;
+                table.inner_product_batch = Avx512Kernel::InnerProductBatch;
+                table.l2_sqr_early_abandon = Avx512Kernel::L2SqrEarlyAbandon;
+                break;
+            case AVX2_LEVEL:
+                table.level = AVX2_LEVEL;
+                table.l2_sqr = Avx2Kernel::L2Sqr;
+                table.inner_product = Avx2Kernel::InnerProduct;
+                table.l2_sqr_batch = Avx2Kernel::L2SqrBatch;
+                table.inner_product_batch = Avx2Kernel::InnerProductBatch;
+                table.l2_sqr_early_abandon = Avx2Kernel::L2SqrEarlyAbandon;
+                break;
+            case SSE_LEVEL:
+                table.level = SSE_LEVEL;
+                table.l2_sqr = SseKernel::L2Sqr;
+                table.inner_product = SseKernel::InnerProduct;
+                table.l2_sqr_batch = SseKernel::L2SqrBatch;
+                table.inner_product_batch = SseKernel::InnerProductBatch;
+                break;
+            default:
+                break;
+        }
+
+        // hamming kernels depend on popcount instructions, not on the simd level only
+        const CpuFeature& feature = CpuFeatureUtil::GetFeature();
+        if (level >= SSE_LEVEL && feature.popcnt)
+        {
+            table.hamming = PopcntKernel::Hamming;
+            table.hamming_batch = PopcntKernel::HammingBatch;
+        }
+        if (level == AVX512_LEVEL && feature.avx512vpopcntdq)
+        {
+            table.hamming = Avx512Kernel::Hamming;
+            table.hamming_batch = Avx512Kernel::HammingBatch;
+        }
+#endif
+
+        return table;
+    }
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_KERNEL_DISPATCHER_H_
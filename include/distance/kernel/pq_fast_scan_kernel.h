@@ -0,0 +1,226 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : pq_fast_scan_kernel.h
+// since : 2024-09-10
+// desc  : Fast scan kernels of 4-bit product quantization codes. Codes of 32
+// vectors are packed into one block: for each sub quantizer, 16 bytes hold the
+// code of vector i in the low nibble of byte i and the code of vector i + 16 in
+// the high nibble. The lookup table of a sub quantizer is quantized to 16 bytes,
+// which is exactly one register, so the distances of 16 vectors are looked up
+// by one pshufb instead of 16 loads. The kernel is chosen at runtime like the
+// distance kernels, the scalar kernel gives the same results.
+
+#ifndef VDBMS_DISTANCE_KERNEL_PQ_FAST_SCAN_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_PQ_FAST_SCAN_KERNEL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../../config.h"
+#include "../../utils/cpu_feature_util.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace tiny_v_dbms {
+
+/**
+ * @brief Scan one block of 32 codes.
+ * @param block packed codes of the block, 16 * m bytes.
+ * @param table quantized lookup table, 16 * m bytes.
+ * @param m amount of sub quantizers.
+ * @param results quantized distances of 32 vectors, saturated at 65535.
+ */
+typedef void (*PqFastScanKernelFunction)(const uint8_t* block, const uint8_t* table, default_amount_type m, uint16_t* results);
+
+// lookup table of a query quantized to bytes, distance = bias + quantized distance / scale
+struct QuantizedDistanceTable
+{
+    std::vector<uint8_t> table;
+    float scale;
+    float bias;
+};
+
+class PqFastScanKernel
+{
+
+public:
+
+    static constexpr default_long_int BLOCK_VECTOR_AMOUNT = 32;
+    static constexpr default_amount_type KSUB = 16;
+
+    // bytes of one packed block
+    static default_length_size GetBlockLength(default_amount_type m)
+    {
+        return BLOCK_VECTOR_AMOUNT / 2 * m;
+    }
+
+    /**
+     * @brief Put the code of the position-th vector of a block into the block.
+     * @param code m codes of one byte, each is less than 16.
+     */
+    static void PackCode(const uint8_t* code, default_amount_type m, default_long_int position, uint8_t* block)
+    {
+        default_long_int byte = position % (BLOCK_VECTOR_AMOUNT / 2);
+        bool high = position >= BLOCK_VECTOR_AMOUNT / 2;
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            uint8_t& packed = block[j * KSUB + byte];
+            packed = high ? (packed & 0x0f) | (code[j] << 4) : (packed & 0xf0) | code[j];
+        }
+    }
+
+    /**
+     * @brief Quantize a float lookup table of m * 16 items. Each sub table is shifted by its minimum, then all
+     * are scaled by one factor, so that every item fits a byte.
+     */
+    static void QuantizeTable(const float* table, default_amount_type m, QuantizedDistanceTable& result)
+    {
+        float max_range = 0;
+        result.bias = 0;
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            const float* sub_table = table + j * KSUB;
+            float min_value = *std::min_element(sub_table, sub_table + KSUB);
+            max_range = std::max(max_range, *std::max_element(sub_table, sub_table + KSUB) - min_value);
+            result.bias += min_value;
+        }
+        result.scale = max_range > 0 ? 255.0f / max_range : 1.0f;
+
+        result.table.resize((size_t) m * KSUB);
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            const float* sub_table = table + j * KSUB;
+            float min_value = *std::min_element(sub_table, sub_table + KSUB);
+            for (default_amount_type c = 0; c < KSUB; c++)
+            {
+                result.table[j * KSUB + c] = (uint8_t) std::min(255.0f, std::round((sub_table[c] - min_value) * result.scale));
+            }
+        }
+    }
+
+    /**
+     * @brief Get the kernel chosen for the running cpu.
+     */
+    static PqFastScanKernelFunction GetKernel()
+    {
+        static PqFastScanKernelFunction kernel = ChooseKernel(CpuFeatureUtil::GetSimdLevel());
+        return kernel;
+    }
+
+    /**
+     * @brief Choose the kernel of a simd level, the level must be supported by cpu.
+     */
+    static PqFastScanKernelFunction ChooseKernel(SimdLevel level)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (level >= AVX2_LEVEL)
+        {
+            return ScanBlockAvx2;
+        }
+        if (level >= SSE_LEVEL && CpuFeatureUtil::GetFeature().ssse3)
+        {
+            return ScanBlockSsse3;
+        }
+#endif
+        return ScanBlockScalar;
+    }
+
+    static void ScanBlockScalar(const uint8_t* block, const uint8_t* table, default_amount_type m, uint16_t* results)
+    {
+        uint32_t sums[BLOCK_VECTOR_AMOUNT] = {0};
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            const uint8_t* codes = block + j * KSUB;
+            const uint8_t* sub_table = table + j * KSUB;
+            for (default_long_int i = 0; i < BLOCK_VECTOR_AMOUNT / 2; i++)
+            {
+                sums[i] += sub_table[codes[i] & 0x0f];
+                sums[i + BLOCK_VECTOR_AMOUNT / 2] += sub_table[codes[i] >> 4];
+            }
+        }
+        for (default_long_int i = 0; i < BLOCK_VECTOR_AMOUNT; i++)
+        {
+            results[i] = (uint16_t) std::min<uint32_t>(sums[i], 65535);
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    // one sub quantizer per loop, 16 lookups by one pshufb
+    __attribute__((target("ssse3")))
+    static void ScanBlockSsse3(const uint8_t* block, const uint8_t* table, default_amount_type m, uint16_t* results)
+    {
+        const __m128i low_mask = _mm_set1_epi8(0x0f);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;     // vectors 0-7, 8-15, 16-23, 24-31
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            __m128i codes = _mm_loadu_si128((const __m128i*) (block + j * KSUB));
+            __m128i sub_table = _mm_loadu_si128((const __m128i*) (table + j * KSUB));
+            __m128i low = _mm_shuffle_epi8(sub_table, _mm_and_si128(codes, low_mask));
+            __m128i high = _mm_shuffle_epi8(sub_table, _mm_and_si128(_mm_srli_epi16(codes, 4), low_mask));
+            sum0 = _mm_adds_epu16(sum0, _mm_unpacklo_epi8(low, zero));
+            sum1 = _mm_adds_epu16(sum1, _mm_unpackhi_epi8(low, zero));
+            sum2 = _mm_adds_epu16(sum2, _mm_unpacklo_epi8(high, zero));
+            sum3 = _mm_adds_epu16(sum3, _mm_unpackhi_epi8(high, zero));
+        }
+        _mm_storeu_si128((__m128i*) results, sum0);
+        _mm_storeu_si128((__m128i*) (results + 8), sum1);
+        _mm_storeu_si128((__m128i*) (results + 16), sum2);
+        _mm_storeu_si128((__m128i*) (results + 24), sum3);
+    }
+
+    // two sub quantizers per loop, one in each 128 bit lane, lanes are added at the end
+    __attribute__((target("avx2")))
+    static void ScanBlockAvx2(const uint8_t* block, const uint8_t* table, default_amount_type m, uint16_t* results)
+    {
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+        default_amount_type j = 0;
+        for (; j + 2 <= m; j += 2)
+        {
+            __m256i codes = _mm256_loadu_si256((const __m256i*) (block + j * KSUB));
+            __m256i sub_tables = _mm256_loadu_si256((const __m256i*) (table + j * KSUB));
+            __m256i low = _mm256_shuffle_epi8(sub_tables, _mm256_and_si256(codes, low_mask));
+            __m256i high = _mm256_shuffle_epi8(sub_tables, _mm256_and_si256(_mm256_srli_epi16(codes, 4), low_mask));
+            sum0 = _mm256_adds_epu16(sum0, _mm256_unpacklo_epi8(low, zero));
+            sum1 = _mm256_adds_epu16(sum1, _mm256_unpackhi_epi8(low, zero));
+            sum2 = _mm256_adds_epu16(sum2, _mm256_unpacklo_epi8(high, zero));
+            sum3 = _mm256_adds_epu16(sum3, _mm256_unpackhi_epi8(high, zero));
+        }
+
+        __m128i lane_sum0 = _mm_adds_epu16(_mm256_castsi256_si128(sum0), _mm256_extracti128_si256(sum0, 1));
+        __m128i lane_sum1 = _mm_adds_epu16(_mm256_castsi256_si128(sum1), _mm256_extracti128_si256(sum1, 1));
+        __m128i lane_sum2 = _mm_adds_epu16(_mm256_castsi256_si128(sum2), _mm256_extracti128_si256(sum2, 1));
+        __m128i lane_sum3 = _mm_adds_epu16(_mm256_castsi256_si128(sum3), _mm256_extracti128_si256(sum3, 1));
+        if (j < m)
+        {
+            // the last sub quantizer of an odd m
+            const __m128i low_mask_128 = _mm_set1_epi8(0x0f);
+            const __m128i zero_128 = _mm_setzero_si128();
+            __m128i codes = _mm_loadu_si128((const __m128i*) (block + j * KSUB));
+            __m128i sub_table = _mm_loadu_si128((const __m128i*) (table + j * KSUB));
+            __m128i low = _mm_shuffle_epi8(sub_table, _mm_and_si128(codes, low_mask_128));
+            __m128i high = _mm_shuffle_epi8(sub_table, _mm_and_si128(_mm_srli_epi16(codes, 4), low_mask_128));
+            lane_sum0 = _mm_adds_epu16(lane_sum0, _mm_unpacklo_epi8(low, zero_128));
+            lane_sum1 = _mm_adds_epu16(lane_sum1, _mm_unpackhi_epi8(low, zero_128));
+            lane_sum2 = _mm_adds_epu16(lane_sum2, _mm_unpacklo_epi8(high, zero_128));
+            lane_sum3 = _mm_adds_epu16(lane_sum3, _mm_unpackhi_epi8(high, zero_128));
+        }
+        _mm_storeu_si128((__m128i*) results, lane_sum0);
+        _mm_storeu_si128((__m128i*) (results + 8), lane_sum1);
+        _mm_storeu_si128((__m128i*) (results + 16), lane_sum2);
+        _mm_storeu_si128((__m128i*) (results + 24), lane_sum3);
+    }
+
+#endif
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_PQ_FAST_SCAN_KERNEL_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : scalar_kernel.h
+// since : 2024-09-02
+// desc  : Portable distance kernels, work on raw data pointers. They are used
+// when the cpu has no supported simd instruction set, and also as the tail
+// loop of simd kernels.
+
+#ifndef VDBMS_DISTANCE_KERNEL_SCALAR_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_SCALAR_KERNEL_H_
+
+#include <cstdint>
+
+#include "../../config.h"
+
+namespace tiny_v_dbms {
+
+class ScalarKernel
+{
+
+public:
+
+    /**
+     * @brief Squared euclidean distance of two arrays, not sqrt.
+     * @param first first array.
+     * @param second second array.
+     * @param length length of both arrays.
+     */
+    static double L2Sqr(const double* first, const double* second, default_length_size length)
+    {
+        // use 4 accumulators to break the dependency between adds
+        double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        default_length_size i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            double diff0 = first[i] - second[i];
+            double diff1 = first[i + 1] - second[i + 1];
+            double diff2 = first[i + 2] - second[i + 2];
+            double diff3 = first[i + 3] - second[i + 3];
+            sum0 += diff0 * diff0;
+            sum1 += diff1 * diff1;
+            sum2 += diff2 * diff2;
+            sum3 += diff3 * diff3;
+        }
+        for (; i < length; i++)
+        {
+            double diff = first[i] - second[i];
+            sum0 += diff * diff;
+        }
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    /**
+     * @brief Squared euclidean distance which stops once the partial sum is larger than threshold.
+     * The partial sum is checked every 32 elements, so the cost of checking is small.
+     * @param first first array.
+     * @param second second array.
+     * @param length length of both arrays.
+     * @param threshold the current k-th best distance, use infinity to calculate the full distance.
+     * @return The exact distance if it is not larger than threshold, else a partial sum larger than threshold.
+     */
+    static double L2SqrEarlyAbandon(const double* first, const double* second, default_length_size length, double threshold)
+    {
+        double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        default_length_size i = 0;
+        while (i + 4 <= length)
+        {
+            default_length_size check_end = i + 32 < length ? i + 32 : length;
+            for (; i + 4 <= check_end; i += 4)
+            {
+                double diff0 = first[i] - second[i];
+                double diff1 = first[i + 1] - second[i + 1];
+                double diff2 = first[i + 2] - second[i + 2];
+                double diff3 = first[i + 3] - second[i + 3];
+                sum0 += diff0 * diff0;
+                sum1 += diff1 * diff1;
+                sum2 += diff2 * diff2;
+                sum3 += diff3 * diff3;
+            }
+            double partial = (sum0 + sum1) + (sum2 + sum3);
+            if (partial > threshold)
+            {
+                return partial;
+            }
+        }
+        for (; i < length; i++)
+        {
+            double diff = first[i] - second[i];
+            sum0 += diff * diff;
+        }
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    /**
+     * @brief Inner product of two arrays.
+     * @param first first array.
+     * @param second second array.
+     * @param length length of both arrays.
+     */
+    static double InnerProduct(const double* first, const double* second, default_length_size length)
+    {
+        double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        default_length_size i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            sum0 += first[i] * second[i];
+            sum1 += first[i + 1] * second[i + 1];
+            sum2 += first[i + 2] * second[i + 2];
+            sum3 += first[i + 3] * second[i + 3];
+        }
+        for (; i < length; i++)
+        {
+            sum0 += first[i] * second[i];
+        }
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    /**
+     * @brief Squared euclidean distances between one query and a contiguous run of vectors.
+     * @param query query array.
+     * @param vectors the first vector of the run, vectors are stored one besides another.
+     * @param length length of query and each vector.
+     * @param vector_amount amount of vectors in the run.
+     * @param vector_stride distance between the begin of two neighbor vectors, count by element.
+     * @param results output array, must has vector_amount space.
+     */
+    static void L2SqrBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, vectors + row * vector_stride, length);
+        }
+    }
+
+    /**
+     * @brief Inner products between one query and a contiguous run of vectors, params are same as L2SqrBatch.
+     */
+    static void InnerProductBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, vectors + row * vector_stride, length);
+        }
+    }
+
+    /**
+     * @brief Hamming distance of two packed binary arrays, the amount of different bits.
+     * @param first first array.
+     * @param second second array.
+     * @param word_length amount of 64 bit words of both arrays.
+     */
+    static default_length_size Hamming(const uint64_t* first, const uint64_t* second, default_length_size word_length)
+    {
+        default_length_size result = 0;
+        for (default_length_size i = 0; i < word_length; i++)
+        {
+            result += __builtin_popcountll(first[i] ^ second[i]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Hamming distances between one query and a contiguous run of packed binary vectors, stride is count by word.
+     */
+    static void HammingBatch(const uint64_t* query, const uint64_t* vectors, default_length_size word_length, default_long_int vector_amount, default_length_size vector_stride, default_length_size* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = Hamming(query, vectors + row * vector_stride, word_length);
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_SCALAR_KERNEL_H_
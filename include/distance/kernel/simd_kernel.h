@@ -0,0 +1,516 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : simd_kernel.h
+// since : 2024-09-02
+// desc  : Distance kernels using sse2, avx2 and avx512 instructions. Each kernel
+// is compiled with its own target attribute, so the whole project not need to be
+// built with -mavx2, and the kernel used is chosen at runtime by KernelDispatcher.
+// Never call these kernels directly, the cpu may not support them.
+
+#ifndef VDBMS_DISTANCE_KERNEL_SIMD_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_SIMD_KERNEL_H_
+
+#include "../../config.h"
+#include "scalar_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VDBMS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace tiny_v_dbms {
+
+#ifdef VDBMS_X86_SIMD
+
+// hamming kernels using the popcnt instruction, without it __builtin_popcountll is a slow bit trick
+class PopcntKernel
+{
+
+public:
+
+    __attribute__((target("popcnt")))
+    static default_length_size Hamming(const uint64_t* first, const uint64_t* second, default_length_size word_length)
+    {
+        default_length_size result0 = 0, result1 = 0;
+        default_length_size i = 0;
+        for (; i + 2 <= word_length; i += 2)
+        {
+            result0 += __builtin_popcountll(first[i] ^ second[i]);
+            result1 += __builtin_popcountll(first[i + 1] ^ second[i + 1]);
+        }
+        if (i < word_length)
+        {
+            result0 += __builtin_popcountll(first[i] ^ second[i]);
+        }
+        return result0 + result1;
+    }
+
+    __attribute__((target("popcnt")))
+    static void HammingBatch(const uint64_t* query, const uint64_t* vectors, default_length_size word_length, default_long_int vector_amount, default_length_size vector_stride, default_length_size* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = Hamming(query, vectors + row * vector_stride, word_length);
+        }
+    }
+};
+
+class SseKernel
+{
+
+public:
+
+    __attribute__((target("sse2")))
+    static double L2Sqr(const double* first, const double* second, default_length_size length)
+    {
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        default_length_size i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            __m128d diff0 = _mm_sub_pd(_mm_loadu_pd(first + i), _mm_loadu_pd(second + i));
+            __m128d diff1 = _mm_sub_pd(_mm_loadu_pd(first + i + 2), _mm_loadu_pd(second + i + 2));
+            sum0 = _mm_add_pd(sum0, _mm_mul_pd(diff0, diff0));
+            sum1 = _mm_add_pd(sum1, _mm_mul_pd(diff1, diff1));
+        }
+        double result = HorizontalSum(_mm_add_pd(sum0, sum1));
+        return result + ScalarKernel::L2Sqr(first + i, second + i, length - i);
+    }
+
+    __attribute__((target("sse2")))
+    static double InnerProduct(const double* first, const double* second, default_length_size length)
+    {
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        default_length_size i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(first + i), _mm_loadu_pd(second + i)));
+            sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(first + i + 2), _mm_loadu_pd(second + i + 2)));
+        }
+        double result = HorizontalSum(_mm_add_pd(sum0, sum1));
+        return result + ScalarKernel::InnerProduct(first + i, second + i, length - i);
+    }
+
+    __attribute__((target("sse2")))
+    static void L2SqrBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, vectors + row * vector_stride, length);
+        }
+    }
+
+    __attribute__((target("sse2")))
+    static void InnerProductBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, vectors + row * vector_stride, length);
+        }
+    }
+
+private:
+
+    __attribute__((target("sse2")))
+    static double HorizontalSum(__m128d sum)
+    {
+        return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+    }
+};
+
+class Avx2Kernel
+{
+
+public:
+
+    __attribute__((target("avx2,fma")))
+    static double L2Sqr(const double* first, const double* second, default_length_size length)
+    {
+        // 4 accumulators, 16 doubles per loop, hide the latency of fma
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        __m256d sum2 = _mm256_setzero_pd();
+        __m256d sum3 = _mm256_setzero_pd();
+        default_length_size i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            __m256d diff0 = _mm256_sub_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i));
+            __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 4), _mm256_loadu_pd(second + i + 4));
+            __m256d diff2 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 8), _mm256_loadu_pd(second + i + 8));
+            __m256d diff3 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 12), _mm256_loadu_pd(second + i + 12));
+            sum0 = _mm256_fmadd_pd(diff0, diff0, sum0);
+            sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+            sum2 = _mm256_fmadd_pd(diff2, diff2, sum2);
+            sum3 = _mm256_fmadd_pd(diff3, diff3, sum3);
+        }
+        for (; i + 4 <= length; i += 4)
+        {
+            __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i));
+            sum0 = _mm256_fmadd_pd(diff, diff, sum0);
+        }
+        double result = HorizontalSum(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+        return result + ScalarKernel::L2Sqr(first + i, second + i, length - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    static double InnerProduct(const double* first, const double* second, default_length_size length)
+    {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        __m256d sum2 = _mm256_setzero_pd();
+        __m256d sum3 = _mm256_setzero_pd();
+        default_length_size i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i), sum0);
+            sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i + 4), _mm256_loadu_pd(second + i + 4), sum1);
+            sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i + 8), _mm256_loadu_pd(second + i + 8), sum2);
+            sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i + 12), _mm256_loadu_pd(second + i + 12), sum3);
+        }
+        for (; i + 4 <= length; i += 4)
+        {
+            sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i), sum0);
+        }
+        double result = HorizontalSum(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+        return result + ScalarKernel::InnerProduct(first + i, second + i, length - i);
+    }
+
+    /**
+     * @brief Squared euclidean distance which stops once the partial sum is larger than threshold, checked every 32 elements.
+     */
+    __attribute__((target("avx2,fma")))
+    static double L2SqrEarlyAbandon(const double* first, const double* second, default_length_size length, double threshold)
+    {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        default_length_size i = 0;
+        while (i + 8 <= length)
+        {
+            default_length_size check_end = i + 32 < length ? i + 32 : length;
+            for (; i + 8 <= check_end; i += 8)
+            {
+                __m256d diff0 = _mm256_sub_pd(_mm256_loadu_pd(first + i), _mm256_loadu_pd(second + i));
+                __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(first + i + 4), _mm256_loadu_pd(second + i + 4));
+                sum0 = _mm256_fmadd_pd(diff0, diff0, sum0);
+                sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+            }
+            double partial = HorizontalSum(_mm256_add_pd(sum0, sum1));
+            if (partial > threshold)
+            {
+                return partial;
+            }
+        }
+        double result = HorizontalSum(_mm256_add_pd(sum0, sum1));
+        return result + ScalarKernel::L2Sqr(first + i, second + i, length - i);
+    }
+
+    /**
+     * @brief Squared euclidean distances between one query and a run of vectors.
+     * Compare the query with 4 vectors in one pass, so each query load is shared by 4 vectors.
+     */
+    __attribute__((target("avx2,fma")))
+    static void L2SqrBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        default_long_int row = 0;
+        for (; row + 4 <= vector_amount; row += 4)
+        {
+            const double* vector0 = vectors + row * vector_stride;
+            const double* vector1 = vector0 + vector_stride;
+            const double* vector2 = vector1 + vector_stride;
+            const double* vector3 = vector2 + vector_stride;
+            __m256d sum0 = _mm256_setzero_pd();
+            __m256d sum1 = _mm256_setzero_pd();
+            __m256d sum2 = _mm256_setzero_pd();
+            __m256d sum3 = _mm256_setzero_pd();
+            default_length_size i = 0;
+            for (; i + 4 <= length; i += 4)
+            {
+                __m256d query_part = _mm256_loadu_pd(query + i);
+                __m256d diff0 = _mm256_sub_pd(query_part, _mm256_loadu_pd(vector0 + i));
+                __m256d diff1 = _mm256_sub_pd(query_part, _mm256_loadu_pd(vector1 + i));
+                __m256d diff2 = _mm256_sub_pd(query_part, _mm256_loadu_pd(vector2 + i));
+                __m256d diff3 = _mm256_sub_pd(query_part, _mm256_loadu_pd(vector3 + i));
+                sum0 = _mm256_fmadd_pd(diff0, diff0, sum0);
+                sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+                sum2 = _mm256_fmadd_pd(diff2, diff2, sum2);
+                sum3 = _mm256_fmadd_pd(diff3, diff3, sum3);
+            }
+            results[row] = HorizontalSum(sum0) + ScalarKernel::L2Sqr(query + i, vector0 + i, length - i);
+            results[row + 1] = HorizontalSum(sum1) + ScalarKernel::L2Sqr(query + i, vector1 + i, length - i);
+            results[row + 2] = HorizontalSum(sum2) + ScalarKernel::L2Sqr(query + i, vector2 + i, length - i);
+            results[row + 3] = HorizontalSum(sum3) + ScalarKernel::L2Sqr(query + i, vector3 + i, length - i);
+        }
+        for (; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, vectors + row * vector_stride, length);
+        }
+    }
+
+    /**
+     * @brief Inner products between one query and a run of vectors, 4 vectors in one pass.
+     */
+    __attribute__((target("avx2,fma")))
+    static void InnerProductBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        default_long_int row = 0;
+        for (; row + 4 <= vector_amount; row += 4)
+        {
+            const double* vector0 = vectors + row * vector_stride;
+            const double* vector1 = vector0 + vector_stride;
+            const double* vector2 = vector1 + vector_stride;
+            const double* vector3 = vector2 + vector_stride;
+            __m256d sum0 = _mm256_setzero_pd();
+            __m256d sum1 = _mm256_setzero_pd();
+            __m256d sum2 = _mm256_setzero_pd();
+            __m256d sum3 = _mm256_setzero_pd();
+            default_length_size i = 0;
+            for (; i + 4 <= length; i += 4)
+            {
+                __m256d query_part = _mm256_loadu_pd(query + i);
+                sum0 = _mm256_fmadd_pd(query_part, _mm256_loadu_pd(vector0 + i), sum0);
+                sum1 = _mm256_fmadd_pd(query_part, _mm256_loadu_pd(vector1 + i), sum1);
+                sum2 = _mm256_fmadd_pd(query_part, _mm256_loadu_pd(vector2 + i), sum2);
+                sum3 = _mm256_fmadd_pd(query_part, _mm256_loadu_pd(vector3 + i), sum3);
+            }
+            results[row] = HorizontalSum(sum0) + ScalarKernel::InnerProduct(query + i, vector0 + i, length - i);
+            results[row + 1] = HorizontalSum(sum1) + ScalarKernel::InnerProduct(query + i, vector1 + i, length - i);
+            results[row + 2] = HorizontalSum(sum2) + ScalarKernel::InnerProduct(query + i, vector2 + i, length - i);
+            results[row + 3] = HorizontalSum(sum3) + ScalarKernel::InnerProduct(query + i, vector3 + i, length - i);
+        }
+        for (; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, vectors + row * vector_stride, length);
+        }
+    }
+
+private:
+
+    __attribute__((target("avx2,fma")))
+    static double HorizontalSum(__m256d sum)
+    {
+        __m128d low = _mm256_castpd256_pd128(sum);
+        __m128d high = _mm256_extractf128_pd(sum, 1);
+        low = _mm_add_pd(low, high);
+        return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+    }
+};
+
+class Avx512Kernel
+{
+
+public:
+
+    __attribute__((target("avx512f")))
+    static double L2Sqr(const double* first, const double* second, default_length_size length)
+    {
+        __m512d sum0 = _mm512_setzero_pd();
+        __m512d sum1 = _mm512_setzero_pd();
+        __m512d sum2 = _mm512_setzero_pd();
+        __m512d sum3 = _mm512_setzero_pd();
+        default_length_size i = 0;
+        for (; i + 32 <= length; i += 32)
+        {
+            __m512d diff0 = _mm512_sub_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i));
+            __m512d diff1 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 8), _mm512_loadu_pd(second + i + 8));
+            __m512d diff2 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 16), _mm512_loadu_pd(second + i + 16));
+            __m512d diff3 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 24), _mm512_loadu_pd(second + i + 24));
+            sum0 = _mm512_fmadd_pd(diff0, diff0, sum0);
+            sum1 = _mm512_fmadd_pd(diff1, diff1, sum1);
+            sum2 = _mm512_fmadd_pd(diff2, diff2, sum2);
+            sum3 = _mm512_fmadd_pd(diff3, diff3, sum3);
+        }
+        for (; i + 8 <= length; i += 8)
+        {
+            __m512d diff = _mm512_sub_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i));
+            sum0 = _mm512_fmadd_pd(diff, diff, sum0);
+        }
+        // the tail is loaded with mask, so no scalar loop is needed
+        if (i < length)
+        {
+            __mmask8 mask = (__mmask8)((1u << (length - i)) - 1);
+            __m512d diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, first + i), _mm512_maskz_loadu_pd(mask, second + i));
+            sum1 = _mm512_fmadd_pd(diff, diff, sum1);
+        }
+        return HorizontalSum(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3)));
+    }
+
+    __attribute__((target("avx512f")))
+    static double InnerProduct(const double* first, const double* second, default_length_size length)
+    {
+        __m512d sum0 = _mm512_setzero_pd();
+        __m512d sum1 = _mm512_setzero_pd();
+        __m512d sum2 = _mm512_setzero_pd();
+        __m512d sum3 = _mm512_setzero_pd();
+        default_length_size i = 0;
+        for (; i + 32 <= length; i += 32)
+        {
+            sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i), sum0);
+            sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i + 8), _mm512_loadu_pd(second + i + 8), sum1);
+            sum2 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i + 16), _mm512_loadu_pd(second + i + 16), sum2);
+            sum3 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i + 24), _mm512_loadu_pd(second + i + 24), sum3);
+        }
+        for (; i + 8 <= length; i += 8)
+        {
+            sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i), sum0);
+        }
+        if (i < length)
+        {
+            __mmask8 mask = (__mmask8)((1u << (length - i)) - 1);
+            sum1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, first + i), _mm512_maskz_loadu_pd(mask, second + i), sum1);
+        }
+        return HorizontalSum(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3)));
+    }
+
+    /**
+     * @brief Squared euclidean distance which stops once the partial sum is larger than threshold, checked every 64 elements.
+     */
+    __attribute__((target("avx512f")))
+    static double L2SqrEarlyAbandon(const double* first, const double* second, default_length_size length, double threshold)
+    {
+        __m512d sum0 = _mm512_setzero_pd();
+        __m512d sum1 = _mm512_setzero_pd();
+        default_length_size i = 0;
+        while (i + 16 <= length)
+        {
+            default_length_size check_end = i + 64 < length ? i + 64 : length;
+            for (; i + 16 <= check_end; i += 16)
+            {
+                __m512d diff0 = _mm512_sub_pd(_mm512_loadu_pd(first + i), _mm512_loadu_pd(second + i));
+                __m512d diff1 = _mm512_sub_pd(_mm512_loadu_pd(first + i + 8), _mm512_loadu_pd(second + i + 8));
+                sum0 = _mm512_fmadd_pd(diff0, diff0, sum0);
+                sum1 = _mm512_fmadd_pd(diff1, diff1, sum1);
+            }
+            double partial = HorizontalSum(_mm512_add_pd(sum0, sum1));
+            if (partial > threshold)
+            {
+                return partial;
+            }
+        }
+        double result = HorizontalSum(_mm512_add_pd(sum0, sum1));
+        return result + ScalarKernel::L2Sqr(first + i, second + i, length - i);
+    }
+
+    /**
+     * @brief Squared euclidean distances between one query and a run of vectors.
+     * Compare the query with 4 vectors in one pass, so each query load is shared by 4 vectors.
+     */
+    __attribute__((target("avx512f")))
+    static void L2SqrBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        default_long_int row = 0;
+        for (; row + 4 <= vector_amount; row += 4)
+        {
+            const double* vector0 = vectors + row * vector_stride;
+            const double* vector1 = vector0 + vector_stride;
+            const double* vector2 = vector1 + vector_stride;
+            const double* vector3 = vector2 + vector_stride;
+            __m512d sum0 = _mm512_setzero_pd();
+            __m512d sum1 = _mm512_setzero_pd();
+            __m512d sum2 = _mm512_setzero_pd();
+            __m512d sum3 = _mm512_setzero_pd();
+            for (default_length_size i = 0; i < length; i += 8)
+            {
+                __mmask8 mask = length - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (length - i)) - 1);
+                __m512d query_part = _mm512_maskz_loadu_pd(mask, query + i);
+                __m512d diff0 = _mm512_sub_pd(query_part, _mm512_maskz_loadu_pd(mask, vector0 + i));
+                __m512d diff1 = _mm512_sub_pd(query_part, _mm512_maskz_loadu_pd(mask, vector1 + i));
+                __m512d diff2 = _mm512_sub_pd(query_part, _mm512_maskz_loadu_pd(mask, vector2 + i));
+                __m512d diff3 = _mm512_sub_pd(query_part, _mm512_maskz_loadu_pd(mask, vector3 + i));
+                sum0 = _mm512_fmadd_pd(diff0, diff0, sum0);
+                sum1 = _mm512_fmadd_pd(diff1, diff1, sum1);
+                sum2 = _mm512_fmadd_pd(diff2, diff2, sum2);
+                sum3 = _mm512_fmadd_pd(diff3, diff3, sum3);
+            }
+            results[row] = HorizontalSum(sum0);
+            results[row + 1] = HorizontalSum(sum1);
+            results[row + 2] = HorizontalSum(sum2);
+            results[row + 3] = HorizontalSum(sum3);
+        }
+        for (; row < vector_amount; row++)
+        {
+            results[row] = L2Sqr(query, vectors + row * vector_stride, length);
+        }
+    }
+
+    /**
+     * @brief Inner products between one query and a run of vectors, 4 vectors in one pass.
+     */
+    __attribute__((target("avx512f")))
+    static void InnerProductBatch(const double* query, const double* vectors, default_length_size length, default_long_int vector_amount, default_length_size vector_stride, double* results)
+    {
+        default_long_int row = 0;
+        for (; row + 4 <= vector_amount; row += 4)
+        {
+            const double* vector0 = vectors + row * vector_stride;
+            const double* vector1 = vector0 + vector_stride;
+            const double* vector2 = vector1 + vector_stride;
+            const double* vector3 = vector2 + vector_stride;
+            __m512d sum0 = _mm512_setzero_pd();
+            __m512d sum1 = _mm512_setzero_pd();
+            __m512d sum2 = _mm512_setzero_pd();
+            __m512d sum3 = _mm512_setzero_pd();
+            for (default_length_size i = 0; i < length; i += 8)
+            {
+                __mmask8 mask = length - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (length - i)) - 1);
+                __m512d query_part = _mm512_maskz_loadu_pd(mask, query + i);
+                sum0 = _mm512_fmadd_pd(query_part, _mm512_maskz_loadu_pd(mask, vector0 + i), sum0);
+                sum1 = _mm512_fmadd_pd(query_part, _mm512_maskz_loadu_pd(mask, vector1 + i), sum1);
+                sum2 = _mm512_fmadd_pd(query_part, _mm512_maskz_loadu_pd(mask, vector2 + i), sum2);
+                sum3 = _mm512_fmadd_pd(query_part, _mm512_maskz_loadu_pd(mask, vector3 + i), sum3);
+            }
+            results[row] = HorizontalSum(sum0);
+            results[row + 1] = HorizontalSum(sum1);
+            results[row + 2] = HorizontalSum(sum2);
+            results[row + 3] = HorizontalSum(sum3);
+        }
+        for (; row < vector_amount; row++)
+        {
+            results[row] = InnerProduct(query, vectors + row * vector_stride, length);
+        }
+    }
+
+    /**
+     * @brief Hamming distance using vpopcntq, 8 words in one instruction. Needs avx512vpopcntdq besides avx512f.
+     */
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static default_length_size Hamming(const uint64_t* first, const uint64_t* second, default_length_size word_length)
+    {
+        __m512i sum = _mm512_setzero_si512();
+        for (default_length_size i = 0; i < word_length; i += 8)
+        {
+            __mmask8 mask = word_length - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (word_length - i)) - 1);
+            __m512i diff = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, first + i), _mm512_maskz_loadu_epi64(mask, second + i));
+            sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(diff));
+        }
+        alignas(64) uint64_t lanes[8];
+        _mm512_store_si512((__m512i*) lanes, sum);
+        return (default_length_size) (((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])));
+    }
+
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void HammingBatch(const uint64_t* query, const uint64_t* vectors, default_length_size word_length, default_long_int vector_amount, default_length_size vector_stride, default_length_size* results)
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            results[row] = Hamming(query, vectors + row * vector_stride, word_length);
+        }
+    }
+
+private:
+
+    // not use _mm512_reduce_add_pd, gcc 12 reports a false uninitialized warning on it
+    __attribute__((target("avx512f")))
+    static double HorizontalSum(__m512d sum)
+    {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, sum);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+};
+
+#endif // VDBMS_X86_SIMD
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_SIMD_KERNEL_H_
@@ -0,0 +1,273 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : sq_kernel.h
+// since : 2024-09-10
+// desc  : Integer dot product kernels of scalar quantization codes. Codes are
+// unsigned (0..255 of sq8, 0..15 of sq4, two codes in one byte), the query is
+// quantized to int8. Both are widened to int16 and multiplied and added in
+// pairs by pmaddwd into int32 lanes, so no product can saturate. The kernels
+// are chosen at runtime like the distance kernels.
+
+#ifndef VDBMS_DISTANCE_KERNEL_SQ_KERNEL_H_
+#define VDBMS_DISTANCE_KERNEL_SQ_KERNEL_H_
+
+#include <cstdint>
+
+#include "../../config.h"
+#include "../../utils/cpu_feature_util.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace tiny_v_dbms {
+
+/**
+ * @brief Dot products between one int8 query and a run of sq8 codes.
+ * @param codes the first code.
+ * @param code_stride distance between the begin of two neighbor codes, count by byte.
+ * @param amount amount of codes.
+ * @param query int8 query, has length items.
+ * @param length amount of dimensions.
+ * @param results output array, has amount space.
+ */
+typedef void (*Sq8DotBatchFunction)(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query, default_length_size length, int32_t* results);
+
+/**
+ * @brief Dot products between one int8 query and a run of sq4 codes, byte i of a code holds dimension 2i in its low
+ * nibble and 2i + 1 in its high nibble.
+ * @param query_low query items of even dimensions, has byte_length items.
+ * @param query_high query items of odd dimensions, has byte_length items.
+ * @param byte_length bytes of one code.
+ */
+typedef void (*Sq4DotBatchFunction)(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query_low, const int8_t* query_high,
+    default_length_size byte_length, int32_t* results);
+
+struct SqKernelTable
+{
+    SimdLevel level;
+    Sq8DotBatchFunction sq8_dot_batch;
+    Sq4DotBatchFunction sq4_dot_batch;
+};
+
+class SqKernel
+{
+
+public:
+
+    /**
+     * @brief Get the kernels chosen for the running cpu.
+     * @return The kernel table, built only once.
+     */
+    static const SqKernelTable& GetKernels()
+    {
+        static SqKernelTable table = BuildKernelTable(CpuFeatureUtil::GetSimdLevel());
+        return table;
+    }
+
+    /**
+     * @brief Build a kernel table using the input simd level, the level must be supported by cpu.
+     */
+    static SqKernelTable BuildKernelTable(SimdLevel level)
+    {
+        SqKernelTable table;
+        table.level = SCALAR_LEVEL;
+        table.sq8_dot_batch = Sq8DotBatchScalar;
+        table.sq4_dot_batch = Sq4DotBatchScalar;
+#if defined(__x86_64__) || defined(__i386__)
+        if (level >= AVX2_LEVEL)
+        {
+            table.level = AVX2_LEVEL;
+            table.sq8_dot_batch = Sq8DotBatchAvx2;
+            table.sq4_dot_batch = Sq4DotBatchAvx2;
+        }
+        else if (level >= SSE_LEVEL)
+        {
+            table.level = SSE_LEVEL;
+            table.sq8_dot_batch = Sq8DotBatchSse;
+            table.sq4_dot_batch = Sq4DotBatchSse;
+        }
+#endif
+        return table;
+    }
+
+    static int32_t Sq8DotScalar(const uint8_t* code, const int8_t* query, default_length_size length)
+    {
+        int32_t result = 0;
+        for (default_length_size i = 0; i < length; i++)
+        {
+            result += (int32_t) code[i] * query[i];
+        }
+        return result;
+    }
+
+    static int32_t Sq4DotScalar(const uint8_t* code, const int8_t* query_low, const int8_t* query_high, default_length_size byte_length)
+    {
+        int32_t result = 0;
+        for (default_length_size i = 0; i < byte_length; i++)
+        {
+            result += (int32_t) (code[i] & 0x0f) * query_low[i] + (int32_t) (code[i] >> 4) * query_high[i];
+        }
+        return result;
+    }
+
+    static void Sq8DotBatchScalar(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query, default_length_size length, int32_t* results)
+    {
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            results[row] = Sq8DotScalar(codes + row * code_stride, query, length);
+        }
+    }
+
+    static void Sq4DotBatchScalar(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query_low, const int8_t* query_high,
+        default_length_size byte_length, int32_t* results)
+    {
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            results[row] = Sq4DotScalar(codes + row * code_stride, query_low, query_high, byte_length);
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    // 16 dimensions per loop, sse2 has no cvtepi8, int8 is widened by unpacking into the high byte and shifting
+    __attribute__((target("sse2")))
+    static int32_t Sq8DotSse(const uint8_t* code, const int8_t* query, default_length_size length)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum = zero;
+        default_length_size i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i codes = _mm_loadu_si128((const __m128i*) (code + i));
+            __m128i queries = _mm_loadu_si128((const __m128i*) (query + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(codes, zero), _mm_srai_epi16(_mm_unpacklo_epi8(queries, queries), 8)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(codes, zero), _mm_srai_epi16(_mm_unpackhi_epi8(queries, queries), 8)));
+        }
+        return HorizontalSum(sum) + Sq8DotScalar(code + i, query + i, length - i);
+    }
+
+    __attribute__((target("sse2")))
+    static int32_t Sq4DotSse(const uint8_t* code, const int8_t* query_low, const int8_t* query_high, default_length_size byte_length)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i low_mask = _mm_set1_epi8(0x0f);
+        __m128i sum = zero;
+        default_length_size i = 0;
+        for (; i + 16 <= byte_length; i += 16)
+        {
+            __m128i codes = _mm_loadu_si128((const __m128i*) (code + i));
+            __m128i low = _mm_and_si128(codes, low_mask);
+            __m128i high = _mm_and_si128(_mm_srli_epi16(codes, 4), low_mask);
+            __m128i queries_low = _mm_loadu_si128((const __m128i*) (query_low + i));
+            __m128i queries_high = _mm_loadu_si128((const __m128i*) (query_high + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(low, zero), _mm_srai_epi16(_mm_unpacklo_epi8(queries_low, queries_low), 8)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(low, zero), _mm_srai_epi16(_mm_unpackhi_epi8(queries_low, queries_low), 8)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(high, zero), _mm_srai_epi16(_mm_unpacklo_epi8(queries_high, queries_high), 8)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(high, zero), _mm_srai_epi16(_mm_unpackhi_epi8(queries_high, queries_high), 8)));
+        }
+        return HorizontalSum(sum) + Sq4DotScalar(code + i, query_low + i, query_high + i, byte_length - i);
+    }
+
+    __attribute__((target("sse2")))
+    static void Sq8DotBatchSse(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query, default_length_size length, int32_t* results)
+    {
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            results[row] = Sq8DotSse(codes + row * code_stride, query, length);
+        }
+    }
+
+    __attribute__((target("sse2")))
+    static void Sq4DotBatchSse(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query_low, const int8_t* query_high,
+        default_length_size byte_length, int32_t* results)
+    {
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            results[row] = Sq4DotSse(codes + row * code_stride, query_low, query_high, byte_length);
+        }
+    }
+
+    // 32 dimensions per loop, two accumulators
+    __attribute__((target("avx2")))
+    static int32_t Sq8DotAvx2(const uint8_t* code, const int8_t* query, default_length_size length)
+    {
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        default_length_size i = 0;
+        for (; i + 32 <= length; i += 32)
+        {
+            __m128i codes0 = _mm_loadu_si128((const __m128i*) (code + i));
+            __m128i codes1 = _mm_loadu_si128((const __m128i*) (code + i + 16));
+            __m128i queries0 = _mm_loadu_si128((const __m128i*) (query + i));
+            __m128i queries1 = _mm_loadu_si128((const __m128i*) (query + i + 16));
+            sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_cvtepu8_epi16(codes0), _mm256_cvtepi8_epi16(queries0)));
+            sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_cvtepu8_epi16(codes1), _mm256_cvtepi8_epi16(queries1)));
+        }
+        return HorizontalSum(_mm256_add_epi32(sum0, sum1)) + Sq8DotScalar(code + i, query + i, length - i);
+    }
+
+    __attribute__((target("avx2")))
+    static int32_t Sq4DotAvx2(const uint8_t* code, const int8_t* query_low, const int8_t* query_high, default_length_size byte_length)
+    {
+        const __m128i low_mask = _mm_set1_epi8(0x0f);
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        default_length_size i = 0;
+        for (; i + 16 <= byte_length; i += 16)
+        {
+            __m128i codes = _mm_loadu_si128((const __m128i*) (code + i));
+            __m128i low = _mm_and_si128(codes, low_mask);
+            __m128i high = _mm_and_si128(_mm_srli_epi16(codes, 4), low_mask);
+            __m128i queries_low = _mm_loadu_si128((const __m128i*) (query_low + i));
+            __m128i queries_high = _mm_loadu_si128((const __m128i*) (query_high + i));
+            sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_cvtepu8_epi16(low), _mm256_cvtepi8_epi16(queries_low)));
+            sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_cvtepu8_epi16(high), _mm256_cvtepi8_epi16(queries_high)));
+        }
+        return HorizontalSum(_mm256_add_epi32(sum0, sum1)) + Sq4DotScalar(code + i, query_low + i, query_high + i, byte_length - i);
+    }
+
+    __attribute__((target("avx2")))
+    static void Sq8DotBatchAvx2(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query, default_length_size length, int32_t* results)
+    {
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            results[row] = Sq8DotAvx2(codes + row * code_stride, query, length);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static void Sq4DotBatchAvx2(const uint8_t* codes, default_length_size code_stride, default_long_int amount, const int8_t* query_low, const int8_t* query_high,
+        default_length_size byte_length, int32_t* results)
+    {
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            results[row] = Sq4DotAvx2(codes + row * code_stride, query_low, query_high, byte_length);
+        }
+    }
+
+private:
+
+    __attribute__((target("sse2")))
+    static int32_t HorizontalSum(__m128i sum)
+    {
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+    __attribute__((target("avx2")))
+    static int32_t HorizontalSum(__m256i sum)
+    {
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(half);
+    }
+
+#endif
+};
+
+}
+
+#endif // VDBMS_DISTANCE_KERNEL_SQ_KERNEL_H_
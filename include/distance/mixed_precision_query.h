@@ -0,0 +1,116 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : mixed_precision_query.h
+// since : 2024-09-07
+// desc  : A query compared with vectors stored in any element type. The query
+// is converted to fp32 once, then each stored vector is read directly from its
+// bytes by the element kernels, no stored vector is decoded into a new array.
+// fp64 storage keeps using the double kernels, so it loses no precision.
+#ifndef VDBMS_DISTANCE_MIXED_PRECISION_QUERY_H_
+#define VDBMS_DISTANCE_MIXED_PRECISION_QUERY_H_
+
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "kernel/element_kernel.h"
+#include "kernel/fixed_dimension_kernel.h"
+
+namespace tiny_v_dbms {
+
+class MixedPrecisionQuery {
+
+public:
+
+    /**
+    * @param query query data.
+    * @param length length of query and stored vectors.
+    * @param storage_type element type of stored vectors.
+    */
+    MixedPrecisionQuery(const double* query, default_length_size length, vector_element_type storage_type)
+        : query(query, query + length),
+        query_fp32(query, query + length),
+        length(length),
+        storage_type(storage_type),
+        kernels(DimensionKernelRegistry::GetKernels(length)),
+        element_kernels(ElementKernelDispatcher::GetKernels(storage_type)) {
+    }
+
+    // squared euclidean distance to one stored vector
+    double L2Sqr(const char* stored) const {
+        if (storage_type == ELEMENT_FP64) {
+            return kernels.l2_sqr(query.data(), (const double*) stored, length);
+        }
+        return element_kernels.l2_sqr(query_fp32.data(), stored, length);
+    }
+
+    /**
+    * @brief Squared euclidean distance which may stop once it is larger than threshold.
+    * @return The exact distance if it is not larger than threshold, else a partial sum larger than threshold.
+    */
+    double L2SqrWithThreshold(const char* stored, double threshold) const {
+        if (storage_type == ELEMENT_FP64) {
+            return kernels.l2_sqr_early_abandon(query.data(), (const double*) stored, length, threshold);
+        }
+        return element_kernels.l2_sqr_early_abandon(query_fp32.data(), stored, length, threshold);
+    }
+
+    double InnerProduct(const char* stored) const {
+        if (storage_type == ELEMENT_FP64) {
+            return kernels.inner_product(query.data(), (const double*) stored, length);
+        }
+        return element_kernels.inner_product(query_fp32.data(), stored, length);
+    }
+
+    /**
+    * @brief Squared euclidean distances to a contiguous run of stored vectors.
+    * @param stored the first stored vector.
+    * @param vector_amount amount of stored vectors.
+    * @param vector_stride distance between the begin of two neighbor stored vectors, count by byte.
+    * @param results output array, must has vector_amount space.
+    */
+    void L2SqrBatch(const char* stored, default_long_int vector_amount, default_length_size vector_stride, double* results) const {
+        if (storage_type == ELEMENT_FP64) {
+            kernels.l2_sqr_batch(query.data(), (const double*) stored, length, vector_amount, vector_stride / sizeof(double), results);
+            return;
+        }
+        element_kernels.l2_sqr_batch(query_fp32.data(), stored, length, vector_amount, vector_stride, results);
+    }
+
+    void InnerProductBatch(const char* stored, default_long_int vector_amount, default_length_size vector_stride, double* results) const {
+        if (storage_type == ELEMENT_FP64) {
+            kernels.inner_product_batch(query.data(), (const double*) stored, length, vector_amount, vector_stride / sizeof(double), results);
+            return;
+        }
+        element_kernels.inner_product_batch(query_fp32.data(), stored, length, vector_amount, vector_stride, results);
+    }
+
+    // bytes of one stored vector
+    default_length_size GetStoredLength() const {
+        return length * ElementTypeUtil::GetElementSize(storage_type);
+    }
+
+    default_length_size GetLength() const {
+        return length;
+    }
+
+    vector_element_type GetStorageType() const {
+        return storage_type;
+    }
+
+    // query converted to fp32, such as to compare with fp32 centroids
+    const float* GetQueryFp32() const {
+        return query_fp32.data();
+    }
+
+private:
+    std::vector<double> query;
+    std::vector<float> query_fp32;
+    default_length_size length;
+    vector_element_type storage_type;
+    const DistanceKernelTable& kernels;             // used by fp64 storage
+    const ElementKernelTable& element_kernels;      // used by other element types
+};
+
+}
+#endif // VDBMS_DISTANCE_MIXED_PRECISION_QUERY_H_
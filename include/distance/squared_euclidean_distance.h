@@ -0,0 +1,77 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : squared_euclidean_distance.h
+// since : 2024-09-04
+// desc  : Squared euclidean distance, used for ranking. Sqrt keeps the order of
+// distances, so searching only needs to sqrt the final k results.
+#ifndef VDBMS_DISTANCE_SQUARED_EUCLIDEAN_DISTANCE_H_
+#define VDBMS_DISTANCE_SQUARED_EUCLIDEAN_DISTANCE_H_
+
+#include "basic_distance.h"
+#include "kernel/kernel_dispatcher.h"
+
+namespace tiny_v_dbms {
+
+template<typename DATA_TYPE>
+class SquaredEuclideanDistance : public BasicDistance<DATA_TYPE> {
+
+public:
+
+    SquaredEuclideanDistance() {
+        this->SetCalFunction(SquaredEuclideanDistanceFunction);
+        this->SetViewCalFunction(SquaredEuclideanDistanceViewFunction);
+        this->SetBatchCalFunction(SquaredEuclideanDistanceBatchFunction);
+    }
+
+    /**
+    * @brief Calculate the distance, but stop once it is larger than threshold.
+    * @param first_vector first vector.
+    * @param second_vector second vector.
+    * @param threshold the current k-th best distance.
+    * @return The exact distance if it is not larger than threshold, else a value larger than threshold.
+    */
+    DATA_TYPE CalWithThreshold(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector, double threshold) {
+        return CalWithThreshold(first_vector.GetView(), second_vector.GetView(), threshold);
+    }
+
+    /**
+    * @brief Same as above, but calculate on views, such as a query and a record in a pinned block.
+    */
+    DATA_TYPE CalWithThreshold(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view, double threshold) {
+
+        assert(first_view.GetLength() == second_view.GetLength());
+
+        return KernelDispatcher::GetKernels().l2_sqr_early_abandon(first_view.GetData(), second_view.GetData(), first_view.GetLength(), threshold);
+    }
+
+    /**
+    * @brief The function to calculate the squared Euclidean distance between two vectors, not sqrt.
+    * @param first_vector first vector.
+    * @param second_vector second vector.
+    */
+    static DATA_TYPE SquaredEuclideanDistanceFunction(BASE_VECTOR & first_vector, BASE_VECTOR & second_vector) {
+        return SquaredEuclideanDistanceViewFunction(first_vector.GetView(), second_vector.GetView());
+    }
+
+    /**
+    * @brief Same as above, but calculate on views.
+    */
+    static DATA_TYPE SquaredEuclideanDistanceViewFunction(const BASE_VECTOR_VIEW & first_view, const BASE_VECTOR_VIEW & second_view) {
+
+        assert(first_view.GetLength() == second_view.GetLength());
+
+        return KernelDispatcher::GetKernels().l2_sqr(first_view.GetData(), second_view.GetData(), first_view.GetLength());
+    }
+
+    /**
+    * @brief Calculate the squared Euclidean distances between one query and a contiguous run of vectors.
+    */
+    static void SquaredEuclideanDistanceBatchFunction(BASE_VECTOR & query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, DATA_TYPE* results) {
+
+        BasicDistance<DATA_TYPE>::RunBatchKernel(KernelDispatcher::GetKernels().l2_sqr_batch, query, vectors, vector_amount, vector_stride, results);
+    }
+
+};
+
+}
+#endif // VDBMS_DISTANCE_SQUARED_EUCLIDEAN_DISTANCE_H_
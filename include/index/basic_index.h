@@ -3,18 +3,127 @@
 // file  : basic_index.h
 // since : 2024-07-17
 // desc  : Base index, which defines the action and interface about an index. Any index must offer the interface defined here.
+// An index searches the records of one vector column, the records are offered as runs, each run is the records of one
+// data block, which stay pinned in buffer pool while searching. Indexes keeping their own copy of vectors, such as
+// graph indexes, are built from runs once, and then search without runs.
 
 #ifndef VDBMS_BASIC_INDEX_
 #define VDBMS_BASIC_INDEX_
 
-#include "../config.h" 
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "../distance/mixed_precision_query.h"
+#include "range_collector.h"
+#include "top_k_collector.h"
 
 namespace tiny_v_dbms {
 
+struct VectorRun
+{
+    const char* records;            // the first record of the run
+    default_long_int amount;        // amount of records in the run
+    default_long_int first_id;      // id of the first record, records in the run get continuous ids
+    bool reversed = false;          // records are stored from the newest one, so ids decrease from first_id
+    const default_long_int* ids = nullptr;     // ids of records if they are not continuous, such as a posting list
+
+    default_long_int GetId(default_long_int i) const
+    {
+        if (ids != nullptr)
+        {
+            return ids[i];
+        }
+        return reversed ? first_id - i : first_id + i;
+    }
+};
+
 class BasicIndex {
 
+public:
+
+    virtual ~BasicIndex()
+    {
+    }
+
+    virtual column_index_type GetIndexType() const = 0;
+
+    // true if search reads records from runs, false if the index keeps its own copy of vectors
+    virtual bool NeedRuns() const = 0;
+
+    // amount of sampled vectors wanted by Train before Add, 0 if the index needs no training
+    virtual default_long_int GetTrainingSampleAmount() const = 0;
+
+    /**
+     * @brief Train the index by sampled vectors of the column, such as k-means centroids.
+     * @param samples sampled vectors decoded to fp32, one after another.
+     */
+    virtual void Train(const std::vector<float>& samples) = 0;
+
+    /**
+     * @brief Distances of a quantized index are approximate, so more candidates can be searched, then reranked by
+     * exact distances calculated from records of the column.
+     * @return Amount of candidates to search for k results, 0 if the results need no reranking.
+     */
+    virtual default_long_int GetRerankAmount(default_long_int k) const = 0;
+
+    /**
+     * @brief Add records of runs into the index, the id of each record is returned by search.
+     */
+    virtual void Add(const std::vector<VectorRun>& runs, default_length_size record_length) = 0;
+
+    /**
+     * @brief Called once after all records of the column are added when building. An index built from all records
+     * at once (such as vamana) builds here, and records added later are inserted one by one.
+     */
+    virtual void FinishBuild()
+    {
+    }
+
+    /**
+     * @brief Save the index into an index file (see index_file.h), which is loaded later instead of rebuilding.
+     * @return false if this type of index is not persisted.
+     * @throws std::runtime_error If the file can not be written.
+     */
+    virtual bool Save(const std::string& /* file_path */) const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Search runs of one column, and insert the candidates nearer than the k-th best into collector.
+     * Distances stored in collector are squared euclidean distances, so it can be used by many calls.
+     * @param query query, which knows the element type of stored records.
+     * @param runs records of the column.
+     * @param record_length distance between the begin of two neighbor records, count by byte.
+     * @param collector top k collector.
+     */
+    virtual void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& runs, default_length_size record_length, TopKCollector& collector) const = 0;
+
+    /**
+     * @brief Search runs of one column for many queries, collectors[i] collects the candidates of queries[i].
+     * Queries are searched one by one, indexes which can share work between queries override it.
+     */
+    virtual void BatchSearch(const std::vector<MixedPrecisionQuery>& queries, const std::vector<VectorRun>& runs, default_length_size record_length,
+        std::vector<TopKCollector>& collectors) const
+    {
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            Search(queries[i], runs, record_length, collectors[i]);
+        }
+    }
+
+    /**
+     * @brief Search runs of one column for all records nearer than the radius of collector.
+     * @return false if this type of index can not search by range, such as indexes with approximate distances, then
+     * the column is scanned instead.
+     */
+    virtual bool RangeSearch(const MixedPrecisionQuery& /* query */, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, RangeCollector& /* collector */) const
+    {
+        return false;
+    }
 };
 
 }
 
-#endif // VDBMS_BASIC_INDEX_
\ No newline at end of file
+#endif // VDBMS_BASIC_INDEX_
@@ -0,0 +1,740 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : diskann_index.h
+// since : 2024-09-10
+// desc  : DiskANN index, a vamana graph whose nodes live in pages of a node
+// page store, so a column larger than memory can be searched by a few page
+// reads. A node is the id, the full vector and the neighbors of one vector,
+// only the pq codes of vectors are kept in memory. A search walks the graph
+// from the medoid by beam search: each step reads the pages of the beam_width
+// nearest unexpanded candidates as one batch, exact distances of the read
+// nodes go into the collector, and their neighbors are ordered by pq distances.
+// The graph is built in memory from all records of the column when building
+// finishes, records added later are inserted into the pages one by one.
+
+#ifndef VDBMS_DISKANN_INDEX_
+#define VDBMS_DISKANN_INDEX_
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/mixed_precision_query.h"
+#include "../distance/kernel/element_kernel.h"
+#include "basic_index.h"
+#include "node_page_store.h"
+#include "product_quantizer.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class DiskAnnIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors, must be a multiple of m.
+     * @param element_type element type of stored vectors.
+     * @param r max amount of neighbors of a node.
+     * @param l_build size of candidate list when building and inserting.
+     * @param beam_width amount of nodes read by one step of a search.
+     * @param l_search size of candidate list when searching, at least k is used.
+     * @param m amount of sub quantizers of pq codes kept in memory.
+     * @param store storage of nodes, owned by the index, nodes are kept in memory if it is nullptr.
+     * @param alpha a neighbor is pruned if it is alpha times nearer to a kept neighbor than to the node.
+     * @param seed seed of the random initial graph.
+     */
+    DiskAnnIndex(default_length_size dimension, vector_element_type element_type, default_amount_type r = 32, default_amount_type l_build = 64,
+        default_amount_type beam_width = 4, default_amount_type l_search = 100, default_amount_type m = 8, NodePageStore* store = nullptr,
+        double alpha = 1.2, unsigned int seed = 100)
+        : dimension(dimension), element_type(element_type), r(r), l_build(l_build), beam_width(beam_width), l_search(l_search), alpha(alpha),
+          store(store), pq(nullptr), built(false), node_count(0), medoid(0), random_engine(seed)
+    {
+        try
+        {
+            if (r < 1 || l_build < 1 || beam_width < 1 || l_search < 1 || alpha < 1)
+            {
+                throw std::runtime_error("diskann index needs r >= 1, l_build >= 1, beam_width >= 1, l_search >= 1 and alpha >= 1");
+            }
+            pq = new ProductQuantizer(dimension, m);
+        }
+        catch (...)
+        {
+            delete store;
+            throw;
+        }
+        if (this->store == nullptr)
+        {
+            this->store = new MemoryNodePageStore();
+        }
+        l2_sqr = ElementKernelDispatcher::GetKernels(ELEMENT_FP32).l2_sqr;
+        stored_length = dimension * ElementTypeUtil::GetElementSize(element_type);
+        node_length = GetNodeLength(dimension, element_type, r);
+    }
+
+    ~DiskAnnIndex()
+    {
+        delete pq;
+        delete store;
+    }
+
+    DiskAnnIndex(const DiskAnnIndex&) = delete;
+    DiskAnnIndex& operator=(const DiskAnnIndex&) = delete;
+
+    column_index_type GetIndexType() const override
+    {
+        return DISKANN;
+    }
+
+    // vectors are read from the pages of the index
+    bool NeedRuns() const override
+    {
+        return false;
+    }
+
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return (default_long_int) pq->GetKsub() * TRAINING_SAMPLES_PER_CENTROID;
+    }
+
+    // train the pq, all nodes are dropped
+    void Train(const std::vector<float>& samples) override
+    {
+        std::unique_lock<std::shared_mutex> lock(index_mutex);
+        pq->Train(samples);
+        store->Reset(node_length);
+        codes.clear();
+        build_records.clear();
+        build_ids.clear();
+        built = false;
+        node_count = 0;
+    }
+
+    // distances of the nodes read by search are exact
+    default_long_int GetRerankAmount(default_long_int /* k */) const override
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Keep records of runs until building finishes, then insert each record into the graph.
+     */
+    void Add(const std::vector<VectorRun>& runs, default_length_size record_length) override
+    {
+        if (!pq->IsTrained())
+        {
+            throw std::runtime_error("diskann index must be trained before adding vectors");
+        }
+        std::unique_lock<std::shared_mutex> lock(index_mutex);
+        for (const VectorRun& run : runs)
+        {
+            for (default_long_int i = 0; i < run.amount; i++)
+            {
+                if (node_count + build_ids.size() >= UINT32_MAX)
+                {
+                    throw std::runtime_error("diskann index is full");
+                }
+                if (built)
+                {
+                    Insert(run.records + i * record_length, run.GetId(i));
+                    continue;
+                }
+                build_records.insert(build_records.end(), run.records + i * record_length, run.records + i * record_length + stored_length);
+                build_ids.push_back(run.GetId(i));
+            }
+        }
+    }
+
+    // build the graph of all added records, write its nodes into the store
+    void FinishBuild() override
+    {
+        std::unique_lock<std::shared_mutex> lock(index_mutex);
+        if (built)
+        {
+            return;
+        }
+        Build();
+        built = true;
+    }
+
+    /**
+     * @brief Beam search from the medoid, runs of the column are not used.
+     * Distances stored in collector are exact squared distances of the nodes read. If collector has a filter, the
+     * candidate list is enlarged by the ratio of nodes out of the filter.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, TopKCollector& collector) const override
+    {
+        if (query.GetStorageType() != element_type || query.GetLength() != dimension)
+        {
+            throw std::runtime_error("query does not match the element type or dimension of diskann index");
+        }
+
+        std::shared_lock<std::shared_mutex> lock(index_mutex);
+        if (node_count == 0 || collector.GetK() == 0)
+        {
+            return;
+        }
+        std::vector<float> table((size_t) pq->GetM() * pq->GetKsub());
+        pq->ComputeDistanceTable(query.GetQueryFp32(), table.data());
+
+        default_amount_type list_size = std::max<default_long_int>(l_search, collector.GetK());
+        const TagBitmap* filter = collector.GetFilter();
+        if (filter != nullptr)
+        {
+            // nodes out of filter are read but not collected, enlarge the list so about the same amount of nodes
+            // in filter are read
+            list_size = std::min<default_long_int>(node_count, (default_long_int) list_size * node_count / std::max<default_long_int>(filter->Count(), 1));
+            list_size = std::max<default_long_int>(list_size, 1);
+        }
+        BeamSearch(table.data(), list_size, [&](uint32_t /* node */, const char* node_data)
+        {
+            double distance = query.L2Sqr(node_data + NODE_VECTOR_OFFSET);
+            if (distance < collector.GetThreshold())
+            {
+                collector.Insert(GetNodeId(node_data), distance);
+            }
+            return distance;
+        });
+    }
+
+    /**
+     * @brief Range search of the diskann paper: beam search with a list of L_SEARCH nodes, if at least half of the
+     * list is in the radius of collector, more nodes may be in it, so search again with a list twice larger.
+     */
+    bool RangeSearch(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, RangeCollector& collector) const override
+    {
+        if (query.GetStorageType() != element_type || query.GetLength() != dimension)
+        {
+            throw std::runtime_error("query does not match the element type or dimension of diskann index");
+        }
+
+        std::shared_lock<std::shared_mutex> lock(index_mutex);
+        if (node_count == 0)
+        {
+            return true;
+        }
+        std::vector<float> table((size_t) pq->GetM() * pq->GetKsub());
+        pq->ComputeDistanceTable(query.GetQueryFp32(), table.data());
+
+        std::vector<SearchResult> in_range;
+        default_long_int list_size = std::min<default_long_int>(l_search, node_count);
+        while (true)
+        {
+            in_range.clear();
+            BeamSearch(table.data(), list_size, [&](uint32_t /* node */, const char* node_data)
+            {
+                double distance = query.L2Sqr(node_data + NODE_VECTOR_OFFSET);
+                if (distance < collector.GetThreshold())
+                {
+                    in_range.push_back(SearchResult{GetNodeId(node_data), distance});
+                }
+                return distance;
+            });
+            if ((default_long_int) in_range.size() * 2 < list_size || list_size >= node_count)
+            {
+                break;
+            }
+            list_size = std::min<default_long_int>(list_size * 2, node_count);
+        }
+
+        for (const SearchResult& result : in_range)
+        {
+            collector.Insert(result.id, result.distance);
+        }
+        return true;
+    }
+
+    default_long_int Size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(index_mutex);
+        return node_count + build_ids.size();
+    }
+
+    void SetLSearch(default_amount_type l)
+    {
+        if (l < 1)
+        {
+            throw std::runtime_error("l_search of diskann index must >= 1");
+        }
+        std::unique_lock<std::shared_mutex> lock(index_mutex);
+        l_search = l;
+    }
+
+    void SetBeamWidth(default_amount_type width)
+    {
+        if (width < 1)
+        {
+            throw std::runtime_error("beam_width of diskann index must >= 1");
+        }
+        std::unique_lock<std::shared_mutex> lock(index_mutex);
+        beam_width = width;
+    }
+
+    default_amount_type GetR() const
+    {
+        return r;
+    }
+
+    NodePageStore* GetStore() const
+    {
+        return store;
+    }
+
+    // a node is the id, the stored vector, the amount of neighbors, then r neighbors
+    static default_length_size GetNodeLength(default_length_size dimension, vector_element_type element_type, default_amount_type r)
+    {
+        return NODE_VECTOR_OFFSET + dimension * ElementTypeUtil::GetElementSize(element_type) + sizeof(uint32_t) * (r + 1);
+    }
+
+private:
+
+    typedef std::pair<double, uint32_t> Candidate;      // distance, node
+
+    // candidates of a beam search, nearest first, at most capacity ones are kept
+    struct CandidateList
+    {
+        std::vector<Candidate> candidates;
+        std::vector<bool> expanded;
+        size_t capacity;
+
+        explicit CandidateList(size_t capacity) : capacity(capacity)
+        {
+        }
+
+        void Insert(double distance, uint32_t node)
+        {
+            if (candidates.size() >= capacity && distance >= candidates.back().first)
+            {
+                return;
+            }
+            size_t position = std::upper_bound(candidates.begin(), candidates.end(), Candidate(distance, node)) - candidates.begin();
+            candidates.insert(candidates.begin() + position, Candidate(distance, node));
+            expanded.insert(expanded.begin() + position, false);
+            if (candidates.size() > capacity)
+            {
+                candidates.pop_back();
+                expanded.pop_back();
+            }
+        }
+
+        // replace the distance of an expanded node, such as its pq distance by the exact one
+        void SetExpandedDistance(uint32_t node, double distance)
+        {
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                if (candidates[i].second == node)
+                {
+                    candidates.erase(candidates.begin() + i);
+                    expanded.erase(expanded.begin() + i);
+                    break;
+                }
+            }
+            size_t position = std::upper_bound(candidates.begin(), candidates.end(), Candidate(distance, node)) - candidates.begin();
+            candidates.insert(candidates.begin() + position, Candidate(distance, node));
+            expanded.insert(expanded.begin() + position, true);
+        }
+
+        // mark the nearest amount unexpanded candidates as expanded, and return them
+        std::vector<uint32_t> PopUnexpanded(default_amount_type amount)
+        {
+            std::vector<uint32_t> nodes;
+            for (size_t i = 0; i < candidates.size() && nodes.size() < (size_t) amount; i++)
+            {
+                if (!expanded[i])
+                {
+                    expanded[i] = true;
+                    nodes.push_back(candidates[i].second);
+                }
+            }
+            return nodes;
+        }
+    };
+
+    static constexpr default_long_int TRAINING_SAMPLES_PER_CENTROID = 32;
+    static constexpr default_length_size NODE_VECTOR_OFFSET = sizeof(default_long_int);
+    static constexpr double BUILD_SLACK_FACTOR = 1.3;      // neighbors may grow to r * BUILD_SLACK_FACTOR when building
+
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_length_size stored_length;      // bytes of one vector
+    default_length_size node_length;
+    default_amount_type r;
+    default_amount_type l_build;
+    default_amount_type beam_width;
+    default_amount_type l_search;
+    double alpha;
+    ElementKernelFunction l2_sqr;           // distances between fp32 vectors when building and inserting
+
+    NodePageStore* store;
+    ProductQuantizer* pq;
+    std::vector<uint8_t> codes;             // pq code of each node
+    bool built;
+    default_long_int node_count;
+    uint32_t medoid;                        // entry of searches
+
+    // records added before building finishes
+    std::vector<char> build_records;
+    std::vector<default_long_int> build_ids;
+
+    std::mt19937 random_engine;
+    mutable std::shared_mutex index_mutex;
+
+    static default_long_int GetNodeId(const char* node_data)
+    {
+        default_long_int id;
+        memcpy(&id, node_data, sizeof(default_long_int));
+        return id;
+    }
+
+    // neighbors of a node, copied out of its page
+    std::vector<uint32_t> GetNodeNeighbors(const char* node_data) const
+    {
+        uint32_t degree;
+        memcpy(&degree, node_data + NODE_VECTOR_OFFSET + stored_length, sizeof(uint32_t));
+        std::vector<uint32_t> neighbors(degree);
+        memcpy(neighbors.data(), node_data + NODE_VECTOR_OFFSET + stored_length + sizeof(uint32_t), degree * sizeof(uint32_t));
+        return neighbors;
+    }
+
+    void FillNode(char* node_data, default_long_int id, const char* record, const std::vector<uint32_t>& neighbors) const
+    {
+        memcpy(node_data, &id, sizeof(default_long_int));
+        memcpy(node_data + NODE_VECTOR_OFFSET, record, stored_length);
+        SetNodeNeighbors(node_data, neighbors);
+    }
+
+    // unused neighbor slots are zero, so a page never keeps garbage
+    void SetNodeNeighbors(char* node_data, const std::vector<uint32_t>& neighbors) const
+    {
+        char* degree_data = node_data + NODE_VECTOR_OFFSET + stored_length;
+        uint32_t degree = neighbors.size();
+        memset(degree_data, 0, sizeof(uint32_t) * (r + 1));
+        memcpy(degree_data, &degree, sizeof(uint32_t));
+        memcpy(degree_data + sizeof(uint32_t), neighbors.data(), degree * sizeof(uint32_t));
+    }
+
+    void DecodeFp32(const char* record, float* vector) const
+    {
+        std::vector<double> values(dimension);
+        ElementTypeUtil::Decode(record, dimension, element_type, values.data());
+        std::copy(values.begin(), values.end(), vector);
+    }
+
+    double Distance(const float* a, const float* b) const
+    {
+        return l2_sqr(a, (const char*) b, dimension);
+    }
+
+    /**
+     * @brief Beam search on the pages by pq distances to the query of table, the pages of beam_width nodes are read
+     * by one batch each step, and the read nodes are reordered by their exact distances. index_mutex must be locked.
+     * @param visit called with each node read and its data, which is valid only in the call, returns the exact distance.
+     */
+    void BeamSearch(const float* table, default_amount_type list_size, const std::function<double(uint32_t, const char*)>& visit) const
+    {
+        default_length_size code_length = pq->GetCodeLength();
+        CandidateList list(list_size);
+        std::unordered_set<uint32_t> visited;
+        visited.insert(medoid);
+        list.Insert(pq->AdcDistance(table, codes.data() + (size_t) medoid * code_length), medoid);
+
+        std::vector<uint32_t> neighbors;
+        while (true)
+        {
+            std::vector<uint32_t> beam = list.PopUnexpanded(beam_width);
+            if (beam.empty())
+            {
+                break;
+            }
+            neighbors.clear();
+            store->Read(std::vector<default_long_int>(beam.begin(), beam.end()), [&](default_long_int node_no, const char* node_data)
+            {
+                list.SetExpandedDistance(node_no, visit(node_no, node_data));
+                std::vector<uint32_t> node_neighbors = GetNodeNeighbors(node_data);
+                neighbors.insert(neighbors.end(), node_neighbors.begin(), node_neighbors.end());
+            });
+            for (uint32_t neighbor : neighbors)
+            {
+                if (visited.insert(neighbor).second)
+                {
+                    list.Insert(pq->AdcDistance(table, codes.data() + (size_t) neighbor * code_length), neighbor);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Select at most r neighbors by the robust prune of vamana: the nearest candidate is kept, then
+     * candidates alpha times nearer to it than to the base node are dropped, until no candidate is left.
+     * @param candidates candidates and their distances to the base node.
+     * @param except node never selected, the base node itself.
+     * @param get_vector fp32 vector of a candidate.
+     */
+    std::vector<uint32_t> RobustPrune(std::vector<Candidate> candidates, uint32_t except, double prune_alpha,
+        const std::function<const float*(uint32_t)>& get_vector) const
+    {
+        std::sort(candidates.begin(), candidates.end());
+        std::vector<uint32_t> selected;
+        std::vector<bool> pruned(candidates.size(), false);
+        double alpha_sqr = prune_alpha * prune_alpha;        // distances are squared
+        for (size_t i = 0; i < candidates.size() && selected.size() < (size_t) r; i++)
+        {
+            if (pruned[i] || candidates[i].second == except || (i > 0 && candidates[i].second == candidates[i - 1].second))
+            {
+                continue;
+            }
+            selected.push_back(candidates[i].second);
+            const float* selected_vector = get_vector(candidates[i].second);
+            for (size_t j = i + 1; j < candidates.size(); j++)
+            {
+                if (!pruned[j] && alpha_sqr * Distance(selected_vector, get_vector(candidates[j].second)) <= candidates[j].first)
+                {
+                    pruned[j] = true;
+                }
+            }
+        }
+        return selected;
+    }
+
+    // robust prune the neighbors of node
+    std::vector<uint32_t> PruneNeighbors(uint32_t node, const std::vector<uint32_t>& neighbors, double prune_alpha,
+        const std::function<const float*(uint32_t)>& get_vector) const
+    {
+        const float* node_vector = get_vector(node);
+        std::vector<Candidate> candidates;
+        for (uint32_t neighbor : neighbors)
+        {
+            candidates.push_back(Candidate(Distance(node_vector, get_vector(neighbor)), neighbor));
+        }
+        return RobustPrune(candidates, node, prune_alpha, get_vector);
+    }
+
+    /**
+     * @brief Build the vamana graph of added records in memory by two passes over all nodes, the first one prunes
+     * with alpha 1, then write all nodes into the store and encode their pq codes. index_mutex must be locked.
+     */
+    void Build()
+    {
+        uint32_t amount = build_ids.size();
+        std::vector<float> vectors((size_t) amount * dimension);
+        for (uint32_t i = 0; i < amount; i++)
+        {
+            DecodeFp32(build_records.data() + (size_t) i * stored_length, vectors.data() + (size_t) i * dimension);
+        }
+        auto get_vector = [&](uint32_t node) -> const float*
+        {
+            return vectors.data() + (size_t) node * dimension;
+        };
+
+        std::vector<std::vector<uint32_t> > graph(amount);
+        if (amount > 0)
+        {
+            // random initial graph, and the medoid is the node nearest to the mean
+            std::uniform_int_distribution<uint32_t> random_node(0, amount - 1);
+            for (uint32_t node = 0; node < amount; node++)
+            {
+                default_amount_type degree = std::min<default_long_int>(r, amount - 1);
+                while ((default_amount_type) graph[node].size() < degree)
+                {
+                    uint32_t neighbor = random_node(random_engine);
+                    if (neighbor != node && std::find(graph[node].begin(), graph[node].end(), neighbor) == graph[node].end())
+                    {
+                        graph[node].push_back(neighbor);
+                    }
+                }
+            }
+            std::vector<float> mean(dimension, 0.0f);
+            for (uint32_t node = 0; node < amount; node++)
+            {
+                for (default_length_size d = 0; d < dimension; d++)
+                {
+                    mean[d] += get_vector(node)[d] / amount;
+                }
+            }
+            medoid = 0;
+            for (uint32_t node = 1; node < amount; node++)
+            {
+                if (Distance(mean.data(), get_vector(node)) < Distance(mean.data(), get_vector(medoid)))
+                {
+                    medoid = node;
+                }
+            }
+        }
+
+        std::vector<uint32_t> order(amount);
+        for (uint32_t i = 0; i < amount; i++)
+        {
+            order[i] = i;
+        }
+        for (double pass_alpha : {1.0, alpha})
+        {
+            std::shuffle(order.begin(), order.end(), random_engine);
+            for (uint32_t node : order)
+            {
+                std::vector<Candidate> candidates = GreedySearchInMemory(graph, get_vector, node);
+                for (uint32_t neighbor : graph[node])
+                {
+                    candidates.push_back(Candidate(Distance(get_vector(node), get_vector(neighbor)), neighbor));
+                }
+                graph[node] = RobustPrune(candidates, node, pass_alpha, get_vector);
+
+                for (uint32_t neighbor : graph[node])
+                {
+                    std::vector<uint32_t>& back_edges = graph[neighbor];
+                    if (std::find(back_edges.begin(), back_edges.end(), node) != back_edges.end())
+                    {
+                        continue;
+                    }
+                    // neighbors may grow over r a little before pruning, so a node is not pruned by every back edge
+                    back_edges.push_back(node);
+                    if (back_edges.size() > r * BUILD_SLACK_FACTOR)
+                    {
+                        back_edges = PruneNeighbors(neighbor, back_edges, pass_alpha, get_vector);
+                    }
+                }
+            }
+        }
+        for (uint32_t node = 0; node < amount; node++)
+        {
+            if ((default_amount_type) graph[node].size() > r)
+            {
+                graph[node] = PruneNeighbors(node, graph[node], alpha, get_vector);
+            }
+        }
+
+        std::vector<char> node_data(node_length);
+        codes.resize((size_t) amount * pq->GetCodeLength());
+        for (uint32_t node = 0; node < amount; node++)
+        {
+            FillNode(node_data.data(), build_ids[node], build_records.data() + (size_t) node * stored_length, graph[node]);
+            store->Write(node, node_data.data());
+            pq->Encode(get_vector(node), codes.data() + (size_t) node * pq->GetCodeLength());
+        }
+        node_count = amount;
+
+        std::vector<char>().swap(build_records);
+        std::vector<default_long_int>().swap(build_ids);
+    }
+
+    // greedy search for node on the graph in memory from the medoid, return the expanded nodes and their distances
+    std::vector<Candidate> GreedySearchInMemory(const std::vector<std::vector<uint32_t> >& graph, const std::function<const float*(uint32_t)>& get_vector,
+        uint32_t node) const
+    {
+        const float* query = get_vector(node);
+        CandidateList list(l_build);
+        std::unordered_set<uint32_t> visited;
+        visited.insert(medoid);
+        list.Insert(Distance(query, get_vector(medoid)), medoid);
+
+        std::vector<Candidate> expanded;
+        while (true)
+        {
+            std::vector<uint32_t> nearest = list.PopUnexpanded(1);
+            if (nearest.empty())
+            {
+                break;
+            }
+            expanded.push_back(Candidate(Distance(query, get_vector(nearest[0])), nearest[0]));
+            for (uint32_t neighbor : graph[nearest[0]])
+            {
+                if (visited.insert(neighbor).second)
+                {
+                    list.Insert(Distance(query, get_vector(neighbor)), neighbor);
+                }
+            }
+        }
+        return expanded;
+    }
+
+    /**
+     * @brief Insert one record into the built graph like FreshDiskANN: neighbors are pruned from the nodes read by
+     * a beam search, then the new node is added to their neighbors, a neighbor having too many neighbors is pruned
+     * again by pq distances. index_mutex must be locked exclusively.
+     */
+    void Insert(const char* record, default_long_int id)
+    {
+        uint32_t node = node_count;
+        default_length_size code_length = pq->GetCodeLength();
+        std::unordered_map<uint32_t, std::vector<float> > vectors;
+        std::vector<float>& node_vector = vectors[node];
+        node_vector.resize(dimension);
+        DecodeFp32(record, node_vector.data());
+        codes.resize(codes.size() + code_length);
+        pq->Encode(node_vector.data(), codes.data() + (size_t) node * code_length);
+
+        std::vector<char> node_data(node_length);
+        if (node_count == 0)
+        {
+            FillNode(node_data.data(), id, record, std::vector<uint32_t>());
+            store->Write(node, node_data.data());
+            medoid = node;
+            node_count++;
+            return;
+        }
+
+        std::vector<float> table((size_t) pq->GetM() * pq->GetKsub());
+        pq->ComputeDistanceTable(node_vector.data(), table.data());
+        std::vector<Candidate> candidates;
+        BeamSearch(table.data(), l_build, [&](uint32_t visited_node, const char* visited_data)
+        {
+            std::vector<float>& visited_vector = vectors[visited_node];
+            visited_vector.resize(dimension);
+            DecodeFp32(visited_data + NODE_VECTOR_OFFSET, visited_vector.data());
+            candidates.push_back(Candidate(Distance(vectors[node].data(), visited_vector.data()), visited_node));
+            return candidates.back().first;
+        });
+        // vectors of nodes never read are decoded from their pq codes
+        auto get_vector = [&](uint32_t item) -> const float*
+        {
+            std::vector<float>& item_vector = vectors[item];
+            if (item_vector.empty())
+            {
+                item_vector.resize(dimension);
+                pq->Decode(codes.data() + (size_t) item * code_length, item_vector.data());
+            }
+            return item_vector.data();
+        };
+
+        std::vector<uint32_t> neighbors = RobustPrune(candidates, node, alpha, get_vector);
+        FillNode(node_data.data(), id, record, neighbors);
+        store->Write(node, node_data.data());
+        node_count++;
+
+        // read the pages of all neighbors as one batch, then write the changed ones
+        std::unordered_map<uint32_t, std::vector<char> > neighbor_nodes;
+        store->Read(std::vector<default_long_int>(neighbors.begin(), neighbors.end()), [&](default_long_int neighbor, const char* data)
+        {
+            neighbor_nodes[neighbor].assign(data, data + node_length);
+        });
+        for (uint32_t neighbor : neighbors)
+        {
+            std::vector<char>& data = neighbor_nodes[neighbor];
+            std::vector<uint32_t> back_edges = GetNodeNeighbors(data.data());
+            if ((default_amount_type) back_edges.size() < r)
+            {
+                back_edges.push_back(node);
+            }
+            else
+            {
+                back_edges.push_back(node);
+                back_edges = PruneNeighbors(neighbor, back_edges, alpha, get_vector);
+            }
+            SetNodeNeighbors(data.data(), back_edges);
+            store->Write(neighbor, data.data());
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_DISKANN_INDEX_
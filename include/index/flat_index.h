@@ -2,13 +2,388 @@
 //
 // file  : flat_index.h
 // since : 2024-07-17
-// desc  : 
+// desc  : Flat index, search by scanning all vectors. Candidates are ranked by
+// squared euclidean distance, and each distance stops being calculated once it
+// is larger than the current k-th best. Only the final k results are sqrt.
+// Runs of a column are scanned by many threads, each thread takes the next not
+// scanned run and keeps its own top k heap, heaps are merged after all threads
+// finish, so threads never wait for each other while scanning. A range search
+// has a fixed threshold, so threads share one range collector. A batch of
+// queries is searched as a blocked matrix multiply of query tiles and vector
+// tiles, so one pass over the records serves all queries.
 
 #ifndef VDBMS_FLAT_INDEX_
 #define VDBMS_FLAT_INDEX_
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include "../config.h" 
+#include "../distance/kernel/fixed_dimension_kernel.h"
+#include "../distance/kernel/gemm_kernel.h"
+#include "../distance/mixed_precision_query.h"
+#include "basic_index.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class FlatIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors.
+     * @param thread_amount max amount of threads used by one search, 0 means all cores.
+     */
+    FlatIndex(default_length_size dimension, default_amount_type thread_amount = 0) 
+        : dimension(dimension), kernels(DimensionKernelRegistry::GetKernels(dimension)), thread_amount(thread_amount)
+    {
+        if (this->thread_amount == 0)
+        {
+            this->thread_amount = std::thread::hardware_concurrency();
+        }
+        if (this->thread_amount == 0)
+        {
+            this->thread_amount = 1;
+        }
+    }
+
+    column_index_type GetIndexType() const override
+    {
+        return FLAT;
+    }
+
+    bool NeedRuns() const override
+    {
+        return true;
+    }
+
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return 0;
+    }
+
+    void Train(const std::vector<float>& /* samples */) override
+    {
+    }
+
+    // distances are exact
+    default_long_int GetRerankAmount(default_long_int /* k */) const override
+    {
+        return 0;
+    }
+
+    // records are scanned from runs when searching, nothing is kept
+    void Add(const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */) override
+    {
+    }
+
+    /**
+     * @brief Scan a contiguous run of vectors, and insert the candidates nearer than the k-th best into collector.
+     * Distances stored in collector are squared, so runs from different blocks can share one collector.
+     * @param query query array, has dimension elements.
+     * @param vectors the first vector of the run.
+     * @param vector_amount amount of vectors in the run.
+     * @param vector_stride distance between the begin of two neighbor vectors, count by element.
+     * @param first_id id of the first vector, vectors in the run get continuous ids.
+     * @param collector top k collector.
+     */
+    void Scan(const double* query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, default_long_int first_id, TopKCollector& collector) const
+    {
+        for (default_long_int row = 0; row < vector_amount; row++)
+        {
+            double threshold = collector.GetThreshold();
+            double distance = kernels.l2_sqr_early_abandon(query, vectors + row * vector_stride, dimension, threshold);
+            if (distance < threshold)
+            {
+                collector.Insert(first_id + row, distance);
+            }
+        }
+    }
+
+    /**
+     * @brief Search the k nearest vectors of a contiguous run.
+     * @return Results ordered by euclidean distance, the nearest first.
+     */
+    std::vector<SearchResult> Search(const double* query, const double* vectors, default_long_int vector_amount, default_length_size vector_stride, default_long_int k) const
+    {
+        TopKCollector collector(k);
+        Scan(query, vectors, vector_amount, vector_stride, 0, collector);
+        return FinishResults(collector);
+    }
+
+    /**
+     * @brief Scan one run of stored records of any element type. Each distance stops early once it is larger than
+     * the threshold of collector, the element kernels widen narrow records to fp32 on the way.
+     * @param collector TopKCollector, or RangeCollector whose threshold is fixed.
+     */
+    template <class Collector>
+    void Scan(const MixedPrecisionQuery& query, const VectorRun& run, default_length_size record_length, Collector& collector) const
+    {
+        for (default_long_int row = 0; row < run.amount; row++)
+        {
+            double threshold = collector.GetThreshold();
+            double distance = query.L2SqrWithThreshold(run.records + row * record_length, threshold);
+            if (distance < threshold)
+            {
+                collector.Insert(run.GetId(row), distance);
+            }
+        }
+    }
+
+    /**
+     * @brief Scan runs by many threads, each thread has its own collector, which are merged into collector at last.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& runs, default_length_size record_length, TopKCollector& collector) const override
+    {
+        default_amount_type used_thread_amount = std::min<size_t>(thread_amount, runs.size());
+        
+        // not worth to start a thread
+        if (used_thread_amount <= 1)
+        {
+            for (const VectorRun& run : runs)
+            {
+                Scan(query, run, record_length, collector);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next_run(0);
+        std::vector<TopKCollector> thread_collectors(used_thread_amount, TopKCollector(collector.GetK(), collector.GetFilter()));
+        std::vector<std::thread> threads;
+        for (default_amount_type i = 0; i < used_thread_amount; i++)
+        {
+            threads.emplace_back([&, i]() {
+                size_t run_no;
+                while ((run_no = next_run.fetch_add(1)) < runs.size())
+                {
+                    Scan(query, runs[run_no], record_length, thread_collectors[i]);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (const TopKCollector& thread_collector : thread_collectors)
+        {
+            collector.Merge(thread_collector);
+        }
+    }
+
+    /**
+     * @brief Scan runs by many threads for the records nearer than the radius of collector, threads share the
+     * collector, whose threshold never changes.
+     */
+    bool RangeSearch(const MixedPrecisionQuery& query, const std::vector<VectorRun>& runs, default_length_size record_length, RangeCollector& collector) const override
+    {
+        default_amount_type used_thread_amount = std::min<size_t>(thread_amount, runs.size());
+        if (used_thread_amount <= 1)
+        {
+            for (const VectorRun& run : runs)
+            {
+                Scan(query, run, record_length, collector);
+            }
+            return true;
+        }
+
+        std::atomic<size_t> next_run(0);
+        std::vector<std::thread> threads;
+        for (default_amount_type i = 0; i < used_thread_amount; i++)
+        {
+            threads.emplace_back([&]() {
+                size_t run_no;
+                while ((run_no = next_run.fetch_add(1)) < runs.size())
+                {
+                    Scan(query, runs[run_no], record_length, collector);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Search runs for many queries as a blocked matrix multiply. Records are decoded to fp32 into tiles of
+     * BATCH_SEARCH_VECTOR_TILE vectors, which may span many runs, and each tile is compared with queries by tiles
+     * of BATCH_SEARCH_QUERY_TILE, so a loaded record is reused by all queries while it is in cache. Tiles are
+     * scanned by many threads, each thread keeps its own collectors of all queries, merged at last. fp64 records
+     * keep the exact double kernels, and are searched one query after another.
+     */
+    void BatchSearch(const std::vector<MixedPrecisionQuery>& queries, const std::vector<VectorRun>& runs, default_length_size record_length,
+        std::vector<TopKCollector>& collectors) const override
+    {
+        if (queries.empty() || runs.empty())
+        {
+            return;
+        }
+        if (queries[0].GetStorageType() == ELEMENT_FP64)
+        {
+            BasicIndex::BatchSearch(queries, runs, record_length, collectors);
+            return;
+        }
+
+        std::vector<float> packed_queries(queries.size() * dimension);
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            std::copy(queries[i].GetQueryFp32(), queries[i].GetQueryFp32() + dimension, packed_queries.begin() + i * dimension);
+        }
+
+        // cut runs into tiles, a tile is a list of pieces of runs
+        std::vector<std::vector<RunPiece> > tiles(1);
+        default_long_int tile_amount = 0;
+        for (size_t run_no = 0; run_no < runs.size(); run_no++)
+        {
+            for (default_long_int row = 0; row < runs[run_no].amount;)
+            {
+                if (tile_amount == BATCH_SEARCH_VECTOR_TILE)
+                {
+                    tiles.emplace_back();
+                    tile_amount = 0;
+                }
+                default_long_int amount = std::min<default_long_int>(BATCH_SEARCH_VECTOR_TILE - tile_amount, runs[run_no].amount - row);
+                tiles.back().push_back(RunPiece{run_no, row, amount});
+                tile_amount += amount;
+                row += amount;
+            }
+        }
+
+        default_amount_type used_thread_amount = std::min<size_t>(thread_amount, tiles.size());
+        if (used_thread_amount <= 1)
+        {
+            for (const std::vector<RunPiece>& tile : tiles)
+            {
+                ScanTile(packed_queries, queries[0].GetStorageType(), runs, tile, record_length, collectors);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next_tile(0);
+        std::vector<std::vector<TopKCollector> > thread_collectors(used_thread_amount);
+        std::vector<std::thread> threads;
+        for (default_amount_type i = 0; i < used_thread_amount; i++)
+        {
+            for (const TopKCollector& collector : collectors)
+            {
+                thread_collectors[i].emplace_back(collector.GetK(), collector.GetFilter());
+            }
+            threads.emplace_back([&, i]() {
+                size_t tile_no;
+                while ((tile_no = next_tile.fetch_add(1)) < tiles.size())
+                {
+                    ScanTile(packed_queries, queries[0].GetStorageType(), runs, tiles[tile_no], record_length, thread_collectors[i]);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (const std::vector<TopKCollector>& one_thread_collectors : thread_collectors)
+        {
+            for (size_t i = 0; i < collectors.size(); i++)
+            {
+                collectors[i].Merge(one_thread_collectors[i]);
+            }
+        }
+    }
+
+    default_amount_type GetThreadAmount() const
+    {
+        return thread_amount;
+    }
+
+    /**
+     * @brief Get the sorted results of collector, and turn squared distances into euclidean distances.
+     */
+    static std::vector<SearchResult> FinishResults(const TopKCollector& collector)
+    {
+        std::vector<SearchResult> results = collector.GetSortedResults();
+        for (SearchResult& result : results)
+        {
+            result.distance = std::sqrt(result.distance);
+        }
+        return results;
+    }
+
+private:
+
+    // rows [row, row + amount) of the run_no-th run
+    struct RunPiece
+    {
+        size_t run_no;
+        default_long_int row;
+        default_long_int amount;
+    };
+
+    /**
+     * @brief Decode the records of a tile into fp32, then compare them with every tile of queries.
+     * @param packed_queries all queries in fp32, one after another.
+     */
+    void ScanTile(const std::vector<float>& packed_queries, vector_element_type element_type, const std::vector<VectorRun>& runs, const std::vector<RunPiece>& tile,
+        default_length_size record_length, std::vector<TopKCollector>& collectors) const
+    {
+        std::vector<float> vectors(BATCH_SEARCH_VECTOR_TILE * dimension);
+        std::vector<default_long_int> ids(BATCH_SEARCH_VECTOR_TILE);
+        std::vector<double> decoded(element_type == ELEMENT_FP32 ? 0 : dimension);
+        default_long_int vector_amount = 0;
+        for (const RunPiece& piece : tile)
+        {
+            const VectorRun& run = runs[piece.run_no];
+            for (default_long_int row = piece.row; row < piece.row + piece.amount; row++)
+            {
+                const char* record = run.records + row * record_length;
+                float* vector = vectors.data() + vector_amount * dimension;
+                if (element_type == ELEMENT_FP32)
+                {
+                    memcpy(vector, record, dimension * sizeof(float));
+                }
+                else
+                {
+                    ElementTypeUtil::Decode(record, dimension, element_type, decoded.data());
+                    std::copy(decoded.begin(), decoded.end(), vector);
+                }
+                ids[vector_amount++] = run.GetId(row);
+            }
+        }
+
+        L2SqrTileKernelFunction kernel = GemmKernel::GetKernel();
+        default_amount_type query_amount = collectors.size();
+        std::vector<float> distances(BATCH_SEARCH_QUERY_TILE * vector_amount);
+        for (default_amount_type query_begin = 0; query_begin < query_amount; query_begin += BATCH_SEARCH_QUERY_TILE)
+        {
+            default_amount_type tile_query_amount = std::min<default_amount_type>(BATCH_SEARCH_QUERY_TILE, query_amount - query_begin);
+            kernel(packed_queries.data() + query_begin * dimension, tile_query_amount, vectors.data(), vector_amount, dimension, dimension, distances.data());
+            for (default_amount_type q = 0; q < tile_query_amount; q++)
+            {
+                TopKCollector& collector = collectors[query_begin + q];
+                const float* query_distances = distances.data() + q * vector_amount;
+                for (default_long_int v = 0; v < vector_amount; v++)
+                {
+                    if (query_distances[v] < collector.GetThreshold())
+                    {
+                        collector.Insert(ids[v], query_distances[v]);
+                    }
+                }
+            }
+        }
+    }
 
+    default_length_size dimension;
+    const DistanceKernelTable& kernels;
+    default_amount_type thread_amount;
+};
 
+}
 
-#endif // VDBMS_FLAT_INDEX_
\ No newline at end of file
+#endif // VDBMS_FLAT_INDEX_
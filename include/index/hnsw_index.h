@@ -0,0 +1,888 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : hnsw_index.h
+// since : 2024-09-09
+// desc  : HNSW (Hierarchical Navigable Small World) index, an approximate nearest
+// neighbor index based on graph. Every vector is a node, which is linked with its
+// near nodes on each layer it belongs to. Upper layers are sparse, so a search
+// greedily goes down from the top layer to layer 0, and only visits a few nodes.
+// Vectors are copied into the index in their stored element type.
+// Inserts can run in many threads. Each node's neighbor lists are guarded by a
+// lock, and only an insert which creates a new top layer holds the entry lock.
+// Vectors, ids and layer 0 links are flat arrays, so an index saved into an index
+// file (see index_file.h) is loaded by mapping the file, and only the links of
+// upper layers (about 1 / m of nodes) are copied out of it.
+
+#ifndef VDBMS_HNSW_INDEX_
+#define VDBMS_HNSW_INDEX_
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/mixed_precision_query.h"
+#include "basic_index.h"
+#include "index_file.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class HnswIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors.
+     * @param element_type element type of stored vectors.
+     * @param m max amount of neighbors of a node on upper layers, layer 0 keeps 2 * m.
+     * @param ef_construction size of candidate list when inserting, larger builds a better graph but inserts slower.
+     * @param ef_search size of candidate list when searching, at least k is used.
+     * @param initial_capacity amount of vectors stored before the first growing.
+     * @param seed seed to choose levels of nodes.
+     */
+    HnswIndex(default_length_size dimension, vector_element_type element_type, default_amount_type m = 16, default_amount_type ef_construction = 200,
+        default_amount_type ef_search = 64, default_long_int initial_capacity = 1024, unsigned int seed = 100)
+        : dimension(dimension), element_type(element_type), m(m), max_m0(2 * m), ef_construction(ef_construction), ef_search(ef_search), random_engine(seed)
+    {
+        if (m < 2 || ef_construction < 1 || ef_search < 1)
+        {
+            throw std::runtime_error("hnsw index needs m >= 2, ef_construction >= 1 and ef_search >= 1");
+        }
+        level_multiplier = 1 / std::log((double) m);
+
+        stored_length = dimension * ElementTypeUtil::GetElementSize(element_type);
+        record_length = (stored_length + VECTOR_ALIGNMENT - 1) / VECTOR_ALIGNMENT * VECTOR_ALIGNMENT;
+
+        capacity = initial_capacity > 0 ? initial_capacity : 1;
+        element_count = 0;
+        records = new (std::align_val_t(VECTOR_ALIGNMENT)) char[capacity * record_length];
+        labels = new default_long_int[capacity];
+        level0_links = new uint32_t[capacity * (max_m0 + 1)];
+        upper_links.resize(capacity);
+        mapped_file = nullptr;
+
+        entry_point = NO_NODE;
+        max_level = -1;
+    }
+
+    ~HnswIndex()
+    {
+        FreeStorage();
+        for (VisitedList* visited : visited_pool)
+        {
+            delete visited;
+        }
+    }
+
+    HnswIndex(const HnswIndex&) = delete;
+    HnswIndex& operator=(const HnswIndex&) = delete;
+
+    column_index_type GetIndexType() const override
+    {
+        return HNSW;
+    }
+
+    // vectors are kept in the index, runs are not needed by search
+    bool NeedRuns() const override
+    {
+        return false;
+    }
+
+    // the graph is built by inserting, nothing to train
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return 0;
+    }
+
+    void Train(const std::vector<float>& /* samples */) override
+    {
+    }
+
+    // distances are exact
+    default_long_int GetRerankAmount(default_long_int /* k */) const override
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Insert all records of runs, records are inserted by all cores.
+     */
+    void Add(const std::vector<VectorRun>& runs, default_length_size record_length) override
+    {
+        std::vector<default_long_int> run_begins(runs.size() + 1, 0);
+        for (size_t i = 0; i < runs.size(); i++)
+        {
+            run_begins[i + 1] = run_begins[i] + runs[i].amount;
+        }
+        default_long_int total = run_begins.back();
+
+        default_long_int thread_amount = build_thread_amount > 0 ? build_thread_amount : std::max<default_long_int>(1, std::thread::hardware_concurrency());
+        thread_amount = std::min<default_long_int>(thread_amount, total / ADD_PER_THREAD_AT_LEAST + 1);
+
+        std::atomic<default_long_int> next_record(0);
+        auto insert_records = [&]() {
+            size_t run_no = 0;
+            default_long_int record_no;
+            while ((record_no = next_record.fetch_add(1)) < total)
+            {
+                while (run_begins[run_no + 1] <= record_no)
+                {
+                    run_no++;
+                }
+                default_long_int i = record_no - run_begins[run_no];
+                Insert(runs[run_no].records + i * record_length, runs[run_no].GetId(i));
+            }
+        };
+
+        if (thread_amount <= 1)
+        {
+            insert_records();
+            return;
+        }
+        std::vector<std::thread> threads;
+        for (default_long_int i = 0; i < thread_amount; i++)
+        {
+            threads.emplace_back(insert_records);
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Insert one vector, can be called by many threads at the same time.
+     * @param record stored bytes of the vector, in the element type of index.
+     * @param id id returned by search for this vector, such as the tag of the record.
+     */
+    void Insert(const char* record, default_long_int id)
+    {
+        std::shared_lock<std::shared_mutex> grow_lock(grow_mutex);
+        uint32_t node = ReserveNode(grow_lock);
+        int level = RandomLevel();
+
+        memcpy(GetRecord(node), record, stored_length);
+        labels[node] = id;
+        {
+            std::lock_guard<std::mutex> node_lock(GetNodeLock(node));
+            GetLevel0Links(node)[0] = 0;
+            upper_links[node].assign(level, std::vector<uint32_t>());
+        }
+
+        MixedPrecisionQuery query = DecodeAsQuery(node);
+
+        // keep holding the entry lock if this node will be the new entry
+        std::unique_lock<std::mutex> entry_lock(entry_mutex);
+        int64_t entry = entry_point;
+        int top_level = max_level;
+        if (entry == NO_NODE)
+        {
+            entry_point = node;
+            max_level = level;
+            return;
+        }
+        if (level <= top_level)
+        {
+            entry_lock.unlock();
+        }
+
+        uint32_t current = entry;
+        double current_distance = query.L2Sqr(GetRecord(current));
+        GreedySearch(query, current, current_distance, top_level, level);
+
+        for (int layer = std::min(level, top_level); layer >= 0; layer--)
+        {
+            std::vector<Candidate> candidates = SortNearestFirst(SearchLayer(query, current, current_distance, ef_construction, layer));
+            std::vector<Candidate> neighbors = SelectNeighbors(candidates, m, node);
+
+            {
+                std::vector<uint32_t> neighbor_nodes;
+                for (const Candidate& neighbor : neighbors)
+                {
+                    neighbor_nodes.push_back(neighbor.second);
+                }
+                std::lock_guard<std::mutex> node_lock(GetNodeLock(node));
+                SetNeighbors(node, layer, neighbor_nodes);
+            }
+            for (const Candidate& neighbor : neighbors)
+            {
+                Connect(neighbor.second, node, neighbor.first, layer);
+            }
+
+            current = candidates[0].second;
+            current_distance = candidates[0].first;
+        }
+
+        if (level > top_level)
+        {
+            entry_point = node;
+            max_level = level;
+        }
+    }
+
+    /**
+     * @brief Search the approximate nearest vectors of query, runs are not used.
+     * Distances stored in collector are squared euclidean distances.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, TopKCollector& collector) const override
+    {
+        if (query.GetStorageType() != element_type || query.GetLength() != dimension)
+        {
+            throw std::runtime_error("query does not match the element type or dimension of hnsw index");
+        }
+
+        std::shared_lock<std::shared_mutex> grow_lock(grow_mutex);
+        int64_t entry;
+        int top_level;
+        {
+            std::lock_guard<std::mutex> entry_lock(entry_mutex);
+            entry = entry_point;
+            top_level = max_level;
+        }
+        if (entry == NO_NODE || collector.GetK() == 0)
+        {
+            return;
+        }
+
+        uint32_t current = entry;
+        double current_distance = query.L2Sqr(GetRecord(current));
+        GreedySearch(query, current, current_distance, top_level, 0);
+
+        default_amount_type ef = std::max<default_long_int>(ef_search.load(), collector.GetK());
+        std::priority_queue<Candidate> nearest = SearchLayer(query, current, current_distance, ef, 0, collector.GetFilter());
+        while (!nearest.empty())
+        {
+            collector.Insert(labels[nearest.top().second], nearest.top().first);
+            nearest.pop();
+        }
+    }
+
+    /**
+     * @brief Find the nodes nearer than the radius of collector. A search of ef_search nodes finds the nearest
+     * ones first, then the graph is expanded from every node in the radius to its neighbors in the radius, until
+     * no new node in the radius is found. Nodes out of the filter of collector are expanded, but not collected.
+     */
+    bool RangeSearch(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, RangeCollector& collector) const override
+    {
+        if (query.GetStorageType() != element_type || query.GetLength() != dimension)
+        {
+            throw std::runtime_error("query does not match the element type or dimension of hnsw index");
+        }
+
+        std::shared_lock<std::shared_mutex> grow_lock(grow_mutex);
+        int64_t entry;
+        int top_level;
+        {
+            std::lock_guard<std::mutex> entry_lock(entry_mutex);
+            entry = entry_point;
+            top_level = max_level;
+        }
+        if (entry == NO_NODE)
+        {
+            return true;
+        }
+
+        uint32_t current = entry;
+        double current_distance = query.L2Sqr(GetRecord(current));
+        GreedySearch(query, current, current_distance, top_level, 0);
+        std::priority_queue<Candidate> nearest = SearchLayer(query, current, current_distance, ef_search, 0);
+
+        VisitedList* visited = GetVisitedList();
+        std::vector<uint32_t> expanding;
+        while (!nearest.empty())
+        {
+            visited->marks[nearest.top().second] = visited->tag;
+            if (nearest.top().first < collector.GetThreshold())
+            {
+                expanding.push_back(nearest.top().second);
+                collector.Insert(labels[nearest.top().second], nearest.top().first);
+            }
+            nearest.pop();
+        }
+        while (!expanding.empty())
+        {
+            uint32_t node = expanding.back();
+            expanding.pop_back();
+            for (uint32_t neighbor : GetNeighbors(node, 0))
+            {
+                if (visited->marks[neighbor] == visited->tag)
+                {
+                    continue;
+                }
+                visited->marks[neighbor] = visited->tag;
+
+                double distance = query.L2Sqr(GetRecord(neighbor));
+                if (distance < collector.GetThreshold())
+                {
+                    expanding.push_back(neighbor);
+                    collector.Insert(labels[neighbor], distance);
+                }
+            }
+        }
+        ReleaseVisitedList(visited);
+        return true;
+    }
+
+    void SetEfSearch(default_amount_type ef)
+    {
+        if (ef < 1)
+        {
+            throw std::runtime_error("ef_search of hnsw index must >= 1");
+        }
+        ef_search = ef;
+    }
+
+    // threads used by Add, 0 means all cores
+    void SetBuildThreadAmount(default_amount_type thread_amount)
+    {
+        build_thread_amount = thread_amount;
+    }
+
+    default_amount_type GetEfSearch() const
+    {
+        return ef_search;
+    }
+
+    default_amount_type GetM() const
+    {
+        return m;
+    }
+
+    default_length_size GetDimension() const
+    {
+        return dimension;
+    }
+
+    vector_element_type GetElementType() const
+    {
+        return element_type;
+    }
+
+    default_amount_type GetEfConstruction() const
+    {
+        return ef_construction;
+    }
+
+    default_long_int Size() const
+    {
+        std::lock_guard<std::mutex> count_lock(count_mutex);
+        return element_count;
+    }
+
+    /**
+     * @brief Save vectors, ids and layer 0 links as they are in memory, then the level of each node and its links on
+     * upper layers, each upper layer takes m + 1 items like layer 0. Searches and inserts wait until saving finishes.
+     */
+    bool Save(const std::string& file_path) const override
+    {
+        std::unique_lock<std::shared_mutex> grow_lock(grow_mutex);
+        default_long_int next_id = 0;
+        std::vector<int32_t> levels(element_count);
+        std::vector<uint32_t> flat_upper_links;
+        for (default_long_int node = 0; node < element_count; node++)
+        {
+            next_id = std::max(next_id, labels[node] + 1);
+            levels[node] = upper_links[node].size();
+            for (const std::vector<uint32_t>& neighbors : upper_links[node])
+            {
+                flat_upper_links.push_back(neighbors.size());
+                flat_upper_links.insert(flat_upper_links.end(), neighbors.begin(), neighbors.end());
+                flat_upper_links.resize(flat_upper_links.size() + m - neighbors.size(), 0);
+            }
+        }
+
+        IndexFileWriter writer(HNSW, dimension, element_type, next_id);
+        writer.SetParameter(PARAMETER_M, m);
+        writer.SetParameter(PARAMETER_EF_CONSTRUCTION, ef_construction);
+        writer.SetParameter(PARAMETER_EF_SEARCH, ef_search);
+        writer.SetParameter(PARAMETER_ELEMENT_COUNT, element_count);
+        writer.SetParameter(PARAMETER_ENTRY_POINT, entry_point);
+        writer.SetParameter(PARAMETER_MAX_LEVEL, max_level);
+        writer.AddSection(RECORDS_SECTION, records, element_count * record_length);
+        writer.AddSection(LABELS_SECTION, labels, element_count * sizeof(default_long_int));
+        writer.AddSection(LEVEL0_LINKS_SECTION, level0_links, element_count * (max_m0 + 1) * sizeof(uint32_t));
+        writer.AddSection(LEVELS_SECTION, levels.data(), levels.size() * sizeof(int32_t));
+        writer.AddSection(UPPER_LINKS_SECTION, flat_upper_links.data(), flat_upper_links.size() * sizeof(uint32_t));
+        writer.Write(file_path);
+        return true;
+    }
+
+    /**
+     * @brief Load an index saved by Save by mapping its file, searches read the mapped vectors and links directly.
+     * The mapped arrays are copied into memory when the index grows for the first insert.
+     * @param next_id output, records with id >= next_id were not in the index when it was saved.
+     * @throws std::runtime_error If the file is not an hnsw index file.
+     */
+    static HnswIndex* Load(const std::string& file_path, default_long_int& next_id)
+    {
+        MappedIndexFile* file = new MappedIndexFile(file_path);
+        HnswIndex* index = nullptr;
+        try
+        {
+            const IndexFileHeader& header = file->GetHeader();
+            if (header.index_type != HNSW)
+            {
+                throw std::runtime_error("index file " + file_path + " is not an hnsw index");
+            }
+            next_id = header.next_id;
+            index = new HnswIndex(header.dimension, vector_element_type(header.element_type), header.parameters[PARAMETER_M],
+                header.parameters[PARAMETER_EF_CONSTRUCTION], header.parameters[PARAMETER_EF_SEARCH], 1);
+            index->Attach(file);
+        }
+        catch (...)
+        {
+            delete index;
+            delete file;
+            throw;
+        }
+        return index;
+    }
+
+private:
+
+    typedef std::pair<double, uint32_t> Candidate;      // distance to query, node
+
+    // mark of visited nodes, reset by increasing the tag instead of clearing all marks
+    struct VisitedList
+    {
+        std::vector<uint16_t> marks;
+        uint16_t tag = 0;
+
+        void Reset(default_long_int size)
+        {
+            if (marks.size() < size)
+            {
+                marks.assign(size, 0);
+                tag = 0;
+            }
+            tag++;
+            if (tag == 0)
+            {
+                std::fill(marks.begin(), marks.end(), 0);
+                tag = 1;
+            }
+        }
+    };
+
+    // sections and parameters of an hnsw index file
+    enum FileSection {RECORDS_SECTION, LABELS_SECTION, LEVEL0_LINKS_SECTION, LEVELS_SECTION, UPPER_LINKS_SECTION};
+    enum FileParameter {PARAMETER_M, PARAMETER_EF_CONSTRUCTION, PARAMETER_EF_SEARCH, PARAMETER_ELEMENT_COUNT, PARAMETER_ENTRY_POINT, PARAMETER_MAX_LEVEL};
+
+    static const int64_t NO_NODE = -1;
+    static const default_amount_type NODE_LOCK_AMOUNT = 4096;   // nodes share locks by node % NODE_LOCK_AMOUNT
+    static const default_long_int ADD_PER_THREAD_AT_LEAST = 256;
+
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_length_size stored_length;      // bytes of one vector
+    default_length_size record_length;      // bytes between two vectors in records
+    default_amount_type m;
+    default_amount_type max_m0;
+    default_amount_type ef_construction;
+    std::atomic<default_amount_type> ef_search;
+    double level_multiplier;
+    default_amount_type build_thread_amount = 0;
+
+    // storage of nodes, they only grow when grow_mutex is held exclusively
+    default_long_int capacity;
+    default_long_int element_count;
+    char* records;
+    default_long_int* labels;
+    uint32_t* level0_links;                 // max_m0 + 1 items of each node, amount of neighbors then neighbors on layer 0
+    std::vector<std::vector<std::vector<uint32_t> > > upper_links;     // upper_links[node][layer - 1] are neighbors of node
+    MappedIndexFile* mapped_file;           // records, labels and level0_links point into it if it is not nullptr
+
+    mutable std::shared_mutex grow_mutex;
+    mutable std::mutex count_mutex;
+    mutable std::mutex node_locks[NODE_LOCK_AMOUNT];
+    mutable std::mutex entry_mutex;
+    int64_t entry_point;
+    int max_level;
+
+    std::mutex random_mutex;
+    std::mt19937 random_engine;
+
+    mutable std::mutex visited_pool_mutex;
+    mutable std::vector<VisitedList*> visited_pool;
+
+    char* GetRecord(uint32_t node) const
+    {
+        return records + (size_t) node * record_length;
+    }
+
+    std::mutex& GetNodeLock(uint32_t node) const
+    {
+        return node_locks[node % NODE_LOCK_AMOUNT];
+    }
+
+    uint32_t* GetLevel0Links(uint32_t node) const
+    {
+        return level0_links + (size_t) node * (max_m0 + 1);
+    }
+
+    std::vector<uint32_t> GetNeighbors(uint32_t node, int layer) const
+    {
+        std::lock_guard<std::mutex> node_lock(GetNodeLock(node));
+        if (layer == 0)
+        {
+            const uint32_t* links = GetLevel0Links(node);
+            return std::vector<uint32_t>(links + 1, links + 1 + links[0]);
+        }
+        if (layer <= (int) upper_links[node].size())
+        {
+            return upper_links[node][layer - 1];
+        }
+        return std::vector<uint32_t>();
+    }
+
+    // the node lock must be held
+    void SetNeighbors(uint32_t node, int layer, const std::vector<uint32_t>& neighbors)
+    {
+        if (layer == 0)
+        {
+            uint32_t* links = GetLevel0Links(node);
+            links[0] = neighbors.size();
+            std::copy(neighbors.begin(), neighbors.end(), links + 1);
+            return;
+        }
+        upper_links[node][layer - 1] = neighbors;
+    }
+
+    /**
+     * @brief Point vectors, ids and layer 0 links into a mapped index file, and copy the upper layers out of it.
+     * The index owns file only if this returns.
+     */
+    void Attach(MappedIndexFile* file)
+    {
+        const IndexFileHeader& header = file->GetHeader();
+        int64_t count = header.parameters[PARAMETER_ELEMENT_COUNT];
+        int64_t entry = header.parameters[PARAMETER_ENTRY_POINT];
+        if (count < 0 || count > UINT32_MAX || entry < NO_NODE || entry >= count || (entry == NO_NODE) != (count == 0))
+        {
+            throw std::runtime_error("hnsw index file has wrong nodes");
+        }
+        char* file_records = file->GetSection(RECORDS_SECTION, count * record_length);
+        char* file_labels = file->GetSection(LABELS_SECTION, count * sizeof(default_long_int));
+        char* file_level0_links = file->GetSection(LEVEL0_LINKS_SECTION, count * (max_m0 + 1) * sizeof(uint32_t));
+        const int32_t* levels = (const int32_t*) file->GetSection(LEVELS_SECTION, count * sizeof(int32_t));
+        default_long_int upper_layer_amount = 0;
+        for (int64_t node = 0; node < count; node++)
+        {
+            if (levels[node] < 0 || levels[node] > header.parameters[PARAMETER_MAX_LEVEL])
+            {
+                throw std::runtime_error("hnsw index file has wrong levels");
+            }
+            upper_layer_amount += levels[node];
+        }
+        const uint32_t* file_upper_links = (const uint32_t*) file->GetSection(UPPER_LINKS_SECTION, upper_layer_amount * (m + 1) * sizeof(uint32_t));
+
+        std::vector<std::vector<std::vector<uint32_t> > > new_upper_links(count);
+        for (int64_t node = 0; node < count; node++)
+        {
+            new_upper_links[node].resize(levels[node]);
+            for (std::vector<uint32_t>& neighbors : new_upper_links[node])
+            {
+                if (file_upper_links[0] > (uint32_t) m)
+                {
+                    throw std::runtime_error("hnsw index file has wrong links");
+                }
+                neighbors.assign(file_upper_links + 1, file_upper_links + 1 + file_upper_links[0]);
+                file_upper_links += m + 1;
+            }
+        }
+
+        FreeStorage();
+        records = file_records;
+        labels = (default_long_int*) file_labels;
+        level0_links = (uint32_t*) file_level0_links;
+        upper_links.swap(new_upper_links);
+        capacity = count;
+        element_count = count;
+        entry_point = entry;
+        max_level = header.parameters[PARAMETER_MAX_LEVEL];
+        mapped_file = file;
+    }
+
+    void FreeStorage()
+    {
+        if (mapped_file != nullptr)
+        {
+            delete mapped_file;
+            mapped_file = nullptr;
+            return;
+        }
+        operator delete[](records, std::align_val_t(VECTOR_ALIGNMENT));
+        delete[] labels;
+        delete[] level0_links;
+    }
+
+    MixedPrecisionQuery DecodeAsQuery(uint32_t node) const
+    {
+        std::vector<double> values(dimension);
+        ElementTypeUtil::Decode(GetRecord(node), dimension, element_type, values.data());
+        return MixedPrecisionQuery(values.data(), dimension, element_type);
+    }
+
+    int RandomLevel()
+    {
+        std::lock_guard<std::mutex> random_lock(random_mutex);
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        double random_value = distribution(random_engine);
+        return (int) (-std::log(std::max(random_value, 1e-12)) * level_multiplier);
+    }
+
+    /**
+     * @brief Get a free node, grow the storage if it is full. grow_lock is released while growing.
+     */
+    uint32_t ReserveNode(std::shared_lock<std::shared_mutex>& grow_lock)
+    {
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> count_lock(count_mutex);
+                if (element_count < capacity)
+                {
+                    if (element_count >= UINT32_MAX)
+                    {
+                        throw std::runtime_error("hnsw index is full");
+                    }
+                    return element_count++;
+                }
+            }
+            grow_lock.unlock();
+            Grow();
+            grow_lock.lock();
+        }
+    }
+
+    void Grow()
+    {
+        std::unique_lock<std::shared_mutex> grow_lock(grow_mutex);
+        if (element_count < capacity)
+        {
+            return;
+        }
+
+        // a mapped index is copied into memory by its first growing
+        default_long_int new_capacity = std::max<default_long_int>(capacity * 2, 1);
+        char* new_records = new (std::align_val_t(VECTOR_ALIGNMENT)) char[new_capacity * record_length];
+        default_long_int* new_labels = new default_long_int[new_capacity];
+        uint32_t* new_level0_links = new uint32_t[new_capacity * (max_m0 + 1)];
+        memcpy(new_records, records, element_count * record_length);
+        memcpy(new_labels, labels, element_count * sizeof(default_long_int));
+        memcpy(new_level0_links, level0_links, element_count * (max_m0 + 1) * sizeof(uint32_t));
+        FreeStorage();
+        records = new_records;
+        labels = new_labels;
+        level0_links = new_level0_links;
+
+        upper_links.resize(new_capacity);
+        capacity = new_capacity;
+    }
+
+    VisitedList* GetVisitedList() const
+    {
+        VisitedList* visited = nullptr;
+        {
+            std::lock_guard<std::mutex> pool_lock(visited_pool_mutex);
+            if (!visited_pool.empty())
+            {
+                visited = visited_pool.back();
+                visited_pool.pop_back();
+            }
+        }
+        if (visited == nullptr)
+        {
+            visited = new VisitedList();
+        }
+        visited->Reset(capacity);
+        return visited;
+    }
+
+    void ReleaseVisitedList(VisitedList* visited) const
+    {
+        std::lock_guard<std::mutex> pool_lock(visited_pool_mutex);
+        visited_pool.push_back(visited);
+    }
+
+    /**
+     * @brief Go down from layer from_layer to layer to_layer + 1, on each layer move to the nearest neighbor until no one is nearer.
+     */
+    void GreedySearch(const MixedPrecisionQuery& query, uint32_t& current, double& current_distance, int from_layer, int to_layer) const
+    {
+        for (int layer = from_layer; layer > to_layer; layer--)
+        {
+            bool changed = true;
+            while (changed)
+            {
+                changed = false;
+                for (uint32_t neighbor : GetNeighbors(current, layer))
+                {
+                    double distance = query.L2Sqr(GetRecord(neighbor));
+                    if (distance < current_distance)
+                    {
+                        current = neighbor;
+                        current_distance = distance;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Best first search on one layer. With a filter, nodes not in it are still traversed, but never returned,
+     * so the search goes on until ef nodes in the filter are found, or no candidate is left.
+     * @param filter labels of the nodes can be returned, nullptr if all nodes can.
+     * @return At most ef nearest nodes found, the farthest one on the top.
+     */
+    std::priority_queue<Candidate> SearchLayer(const MixedPrecisionQuery& query, uint32_t entry, double entry_distance, default_long_int ef, int layer,
+        const TagBitmap* filter = nullptr) const
+    {
+        VisitedList* visited = GetVisitedList();
+
+        std::priority_queue<Candidate> nearest;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > candidates;
+        visited->marks[entry] = visited->tag;
+        if (filter == nullptr || filter->Contains(labels[entry]))
+        {
+            nearest.push(Candidate(entry_distance, entry));
+        }
+        candidates.push(Candidate(entry_distance, entry));
+
+        while (!candidates.empty())
+        {
+            Candidate current = candidates.top();
+            if (nearest.size() >= ef && current.first > nearest.top().first)
+            {
+                break;
+            }
+            candidates.pop();
+
+            for (uint32_t neighbor : GetNeighbors(current.second, layer))
+            {
+                if (visited->marks[neighbor] == visited->tag)
+                {
+                    continue;
+                }
+                visited->marks[neighbor] = visited->tag;
+
+                double distance = query.L2Sqr(GetRecord(neighbor));
+                if (nearest.size() < ef || distance < nearest.top().first)
+                {
+                    candidates.push(Candidate(distance, neighbor));
+                    if (filter == nullptr || filter->Contains(labels[neighbor]))
+                    {
+                        nearest.push(Candidate(distance, neighbor));
+                        if (nearest.size() > ef)
+                        {
+                            nearest.pop();
+                        }
+                    }
+                }
+            }
+        }
+
+        ReleaseVisitedList(visited);
+        return nearest;
+    }
+
+    static std::vector<Candidate> SortNearestFirst(std::priority_queue<Candidate> heap)
+    {
+        std::vector<Candidate> sorted(heap.size());
+        for (size_t i = sorted.size(); i > 0; i--)
+        {
+            sorted[i - 1] = heap.top();
+            heap.pop();
+        }
+        return sorted;
+    }
+
+    /**
+     * @brief Select at most amount neighbors by the heuristic of HNSW paper: a candidate is kept only if it is nearer
+     * to the base node than to every kept one, so neighbors spread in different directions.
+     * @param candidates candidates and their distances to the base node, nearest first.
+     * @param except node never selected, the base node itself.
+     */
+    std::vector<Candidate> SelectNeighbors(const std::vector<Candidate>& candidates, default_long_int amount, uint32_t except) const
+    {
+        std::vector<Candidate> selected;
+        std::vector<MixedPrecisionQuery> selected_queries;
+        for (const Candidate& candidate : candidates)
+        {
+            if (selected.size() >= amount)
+            {
+                break;
+            }
+            if (candidate.second == except)
+            {
+                continue;
+            }
+
+            bool good = true;
+            for (const MixedPrecisionQuery& selected_query : selected_queries)
+            {
+                if (selected_query.L2Sqr(GetRecord(candidate.second)) < candidate.first)
+                {
+                    good = false;
+                    break;
+                }
+            }
+            if (good)
+            {
+                selected.push_back(candidate);
+                selected_queries.push_back(DecodeAsQuery(candidate.second));
+            }
+        }
+        return selected;
+    }
+
+    /**
+     * @brief Add new_node to the neighbors of node on layer, reselect the neighbors if there are too many.
+     */
+    void Connect(uint32_t node, uint32_t new_node, double distance, int layer)
+    {
+        default_long_int max_neighbors = layer == 0 ? max_m0 : m;
+
+        std::lock_guard<std::mutex> node_lock(GetNodeLock(node));
+        std::vector<uint32_t> neighbors = layer == 0 ? std::vector<uint32_t>(GetLevel0Links(node) + 1, GetLevel0Links(node) + 1 + GetLevel0Links(node)[0])
+            : upper_links[node][layer - 1];
+        if (neighbors.size() < max_neighbors)
+        {
+            neighbors.push_back(new_node);
+            SetNeighbors(node, layer, neighbors);
+            return;
+        }
+
+        MixedPrecisionQuery node_query = DecodeAsQuery(node);
+        std::vector<Candidate> candidates;
+        candidates.push_back(Candidate(distance, new_node));
+        for (uint32_t neighbor : neighbors)
+        {
+            candidates.push_back(Candidate(node_query.L2Sqr(GetRecord(neighbor)), neighbor));
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        neighbors.clear();
+        for (const Candidate& selected : SelectNeighbors(candidates, max_neighbors, node))
+        {
+            neighbors.push_back(selected.second);
+        }
+        SetNeighbors(node, layer, neighbors);
+    }
+};
+
+}
+
+#endif // VDBMS_HNSW_INDEX_
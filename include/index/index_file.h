@@ -0,0 +1,251 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : index_file.h
+// since : 2024-09-10
+// desc  : File format of persisted vector indexes. A file is a header page, then
+// sections one after another, each section starts at a page boundary. The header
+// keeps a magic, the format version, what the index is built on, parameters of
+// the index type and where each section is. A section is an array the index uses
+// directly (such as the vectors or the links of a graph), so a file is loaded by
+// mmap, and the index points into the mapped pages without a deserialization
+// pass. The file is mapped privately, so an index can still change its mapped
+// arrays, the changes are not written back. Numbers are stored in the byte order
+// of the machine writing the file.
+
+#ifndef VDBMS_INDEX_FILE_
+#define VDBMS_INDEX_FILE_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../storage/file_descriptor_cache.h"
+
+namespace tiny_v_dbms {
+
+struct IndexFileSection
+{
+    uint32_t id;                // which array of the index, defined by the index type
+    uint32_t reserved;
+    uint64_t offset;            // from the begin of file, a multiple of IndexFile::ALIGNMENT
+    uint64_t length;            // count by byte
+};
+
+struct IndexFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t index_type;        // column_index_type
+    uint32_t dimension;
+    uint32_t element_type;      // vector_element_type
+    uint64_t next_id;           // records with id >= next_id were added to the column after saving
+    uint32_t section_amount;
+    uint32_t reserved;
+    int64_t parameters[16];     // parameters of the index type
+    IndexFileSection sections[16];
+};
+
+class IndexFile
+{
+
+public:
+
+    static constexpr char MAGIC[8] = {'T', 'V', 'D', 'B', 'I', 'D', 'X', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t ALIGNMENT = 4096;    // a page, so mapped sections are aligned for the simd kernels
+    static constexpr uint32_t MAX_SECTION_AMOUNT = 16;
+    static constexpr uint32_t MAX_PARAMETER_AMOUNT = 16;
+
+    static bool Exists(const std::string& file_path)
+    {
+        struct stat file_stat;
+        return stat(file_path.c_str(), &file_stat) == 0;
+    }
+};
+
+static_assert(sizeof(IndexFileHeader) <= IndexFile::ALIGNMENT, "header of index file must fit one page");
+
+class IndexFileWriter
+{
+
+public:
+
+    IndexFileWriter(column_index_type index_type, default_length_size dimension, vector_element_type element_type, default_long_int next_id)
+    {
+        memset(&header, 0, sizeof(IndexFileHeader));
+        memcpy(header.magic, IndexFile::MAGIC, sizeof(header.magic));
+        header.version = IndexFile::VERSION;
+        header.index_type = index_type;
+        header.dimension = dimension;
+        header.element_type = element_type;
+        header.next_id = next_id;
+    }
+
+    void SetParameter(uint32_t parameter_no, int64_t value)
+    {
+        if (parameter_no >= IndexFile::MAX_PARAMETER_AMOUNT)
+        {
+            throw std::runtime_error("index file has at most " + std::to_string(IndexFile::MAX_PARAMETER_AMOUNT) + " parameters");
+        }
+        header.parameters[parameter_no] = value;
+    }
+
+    /**
+     * @brief Add a section, data is not copied, so it must stay valid until Write returns.
+     */
+    void AddSection(uint32_t section_id, const void* data, uint64_t length)
+    {
+        if (header.section_amount >= IndexFile::MAX_SECTION_AMOUNT)
+        {
+            throw std::runtime_error("index file has at most " + std::to_string(IndexFile::MAX_SECTION_AMOUNT) + " sections");
+        }
+        uint64_t offset = IndexFile::ALIGNMENT;
+        if (header.section_amount > 0)
+        {
+            const IndexFileSection& last = header.sections[header.section_amount - 1];
+            offset = (last.offset + last.length + IndexFile::ALIGNMENT - 1) / IndexFile::ALIGNMENT * IndexFile::ALIGNMENT;
+        }
+        header.sections[header.section_amount] = IndexFileSection{section_id, 0, offset, length};
+        section_data.push_back((const char*) data);
+        header.section_amount++;
+    }
+
+    /**
+     * @brief Write the file to file_path.tmp, then rename it to file_path, so file_path is never a half written file.
+     * @throws std::runtime_error If the file can not be written.
+     */
+    void Write(const std::string& file_path) const
+    {
+        std::string temp_path = file_path + ".tmp";
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("can not open index file " + temp_path);
+        }
+        std::vector<char> page(IndexFile::ALIGNMENT, 0);
+        memcpy(page.data(), &header, sizeof(IndexFileHeader));
+        file.write(page.data(), page.size());
+
+        uint64_t position = IndexFile::ALIGNMENT;
+        for (uint32_t i = 0; i < header.section_amount; i++)
+        {
+            const IndexFileSection& section = header.sections[i];
+            std::fill(page.begin(), page.end(), 0);
+            file.write(page.data(), section.offset - position);
+            file.write(section_data[i], section.length);
+            position = section.offset + section.length;
+        }
+        file.close();
+        if (!file || std::rename(temp_path.c_str(), file_path.c_str()) != 0)
+        {
+            std::remove(temp_path.c_str());
+            throw std::runtime_error("can not write index file " + file_path);
+        }
+        // a descriptor kept opened still points to the replaced file
+        FileDescriptorCache::GetInstance().Forget(file_path);
+    }
+
+private:
+    IndexFileHeader header;
+    std::vector<const char*> section_data;
+};
+
+class MappedIndexFile
+{
+
+public:
+
+    /**
+     * @brief Map a whole index file, and check its header.
+     * @throws std::runtime_error If the file can not be mapped, or it is not an index file of this version.
+     */
+    explicit MappedIndexFile(const std::string& file_path) : file_path(file_path), data(nullptr), length(0)
+    {
+        int fd = open(file_path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("can not open index file " + file_path);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || (uint64_t) file_stat.st_size < IndexFile::ALIGNMENT)
+        {
+            close(fd);
+            throw std::runtime_error("index file " + file_path + " is too short");
+        }
+        length = file_stat.st_size;
+        void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+        {
+            throw std::runtime_error("can not map index file " + file_path);
+        }
+        data = (char*) address;
+
+        const IndexFileHeader& header = GetHeader();
+        bool right = memcmp(header.magic, IndexFile::MAGIC, sizeof(header.magic)) == 0 && header.version == IndexFile::VERSION
+            && header.section_amount <= IndexFile::MAX_SECTION_AMOUNT;
+        for (uint32_t i = 0; right && i < header.section_amount; i++)
+        {
+            const IndexFileSection& section = header.sections[i];
+            right = section.offset % IndexFile::ALIGNMENT == 0 && section.offset <= length && section.length <= length - section.offset;
+        }
+        if (!right)
+        {
+            munmap(data, length);
+            throw std::runtime_error("index file " + file_path + " is broken or of another version");
+        }
+    }
+
+    ~MappedIndexFile()
+    {
+        munmap(data, length);
+    }
+
+    MappedIndexFile(const MappedIndexFile&) = delete;
+    MappedIndexFile& operator=(const MappedIndexFile&) = delete;
+
+    const IndexFileHeader& GetHeader() const
+    {
+        return *(const IndexFileHeader*) data;
+    }
+
+    /**
+     * @brief Get the mapped data of a section, which can be changed privately.
+     * @throws std::runtime_error If the section is missing or its length is not expect_length.
+     */
+    char* GetSection(uint32_t section_id, uint64_t expect_length) const
+    {
+        const IndexFileHeader& header = GetHeader();
+        for (uint32_t i = 0; i < header.section_amount; i++)
+        {
+            if (header.sections[i].id == section_id)
+            {
+                if (header.sections[i].length != expect_length)
+                {
+                    break;
+                }
+                return data + header.sections[i].offset;
+            }
+        }
+        throw std::runtime_error("section " + std::to_string(section_id) + " of index file " + file_path + " is missing or broken");
+    }
+
+private:
+    std::string file_path;
+    char* data;
+    uint64_t length;
+};
+
+}
+
+#endif // VDBMS_INDEX_FILE_
@@ -0,0 +1,286 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : ivf_flat_index.h
+// since : 2024-09-10
+// desc  : IVF-Flat (inverted file) index. Centroids are trained by k-means over
+// a sample of the column, and each vector is appended to the posting list of
+// its nearest centroid. A search only scans the lists of the nprobe centroids
+// nearest to the query, with the flat index. Postings keep the vector in its
+// stored element type, so distances are the same as a flat scan of the column.
+// Lists are kept by a PostingListStore, in memory by default.
+
+#ifndef VDBMS_IVF_FLAT_INDEX_
+#define VDBMS_IVF_FLAT_INDEX_
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/mixed_precision_query.h"
+#include "basic_index.h"
+#include "flat_index.h"
+#include "kmeans.h"
+#include "posting_list_store.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class IvfFlatIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors.
+     * @param element_type element type of stored vectors.
+     * @param nlist amount of centroids (posting lists).
+     * @param nprobe amount of lists scanned by one search, the default is GetDefaultNprobe(128).
+     * @param store storage of posting lists, owned by the index, lists are kept in memory if it is nullptr.
+     * @param seed seed of k-means.
+     */
+    IvfFlatIndex(default_length_size dimension, vector_element_type element_type, default_amount_type nlist = 128, default_amount_type nprobe = 12,
+        PostingListStore* store = nullptr, unsigned int seed = 100)
+        : dimension(dimension), element_type(element_type), nprobe(nprobe), trained(false), store(store), flat_index(dimension)
+    {
+        if (nlist < 1 || nprobe < 1)
+        {
+            if (store != nullptr)
+            {
+                delete store;
+            }
+            throw std::runtime_error("ivf index needs nlist >= 1 and nprobe >= 1");
+        }
+        if (this->store == nullptr)
+        {
+            this->store = new MemoryPostingListStore();
+        }
+        quantizer = new KMeans(dimension, nlist, KMEANS_ITERATIONS, seed);
+
+        stored_length = dimension * ElementTypeUtil::GetElementSize(element_type);
+        posting_length = GetPostingLength(dimension, element_type);
+    }
+
+    ~IvfFlatIndex()
+    {
+        delete quantizer;
+        delete store;
+    }
+
+    IvfFlatIndex(const IvfFlatIndex&) = delete;
+    IvfFlatIndex& operator=(const IvfFlatIndex&) = delete;
+
+    column_index_type GetIndexType() const override
+    {
+        return IVF_FLAT;
+    }
+
+    // postings are read from the store
+    bool NeedRuns() const override
+    {
+        return false;
+    }
+
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return (default_long_int) quantizer->GetK() * TRAINING_SAMPLES_PER_LIST;
+    }
+
+    // train centroids, all postings are dropped
+    void Train(const std::vector<float>& samples) override
+    {
+        quantizer->Train(samples);
+        store->Reset(quantizer->GetK(), posting_length);
+        trained = true;
+    }
+
+    // distances are exact
+    default_long_int GetRerankAmount(default_long_int /* k */) const override
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Append each record of runs to the list of its nearest centroid, the index must be trained.
+     */
+    void Add(const std::vector<VectorRun>& runs, default_length_size record_length) override
+    {
+        if (!trained)
+        {
+            throw std::runtime_error("ivf index must be trained before adding vectors");
+        }
+        for (const VectorRun& run : runs)
+        {
+            for (default_long_int i = 0; i < run.amount; i++)
+            {
+                Insert(run.records + i * record_length, run.GetId(i));
+            }
+        }
+    }
+
+    /**
+     * @brief Append one vector to the list of its nearest centroid.
+     * @param record stored bytes of the vector, in the element type of index.
+     * @param id id returned by search for this vector, such as the tag of the record.
+     */
+    void Insert(const char* record, default_long_int id)
+    {
+        std::vector<double> values(dimension);
+        ElementTypeUtil::Decode(record, dimension, element_type, values.data());
+        std::vector<float> values_fp32(values.begin(), values.end());
+
+        std::vector<char> posting(posting_length, 0);
+        memcpy(posting.data(), &id, sizeof(default_long_int));
+        memcpy(posting.data() + POSTING_HEADER_LENGTH, record, stored_length);
+        store->Append(quantizer->Assign(values_fp32.data()), posting.data());
+    }
+
+    /**
+     * @brief Scan the lists of the nprobe centroids nearest to query, runs of the column are not used.
+     * If collector has a filter, nprobe is enlarged by the ratio of records out of the filter, so about the same
+     * amount of records in filter are scanned, and farther lists are still scanned until k records in filter are found.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, TopKCollector& collector) const override
+    {
+        if (!trained || collector.GetK() == 0)
+        {
+            return;
+        }
+
+        std::vector<default_amount_type> list_nos = quantizer->Search(query.GetQueryFp32(), collector.GetFilter() == nullptr ? nprobe : GetNlist());
+        size_t probe_amount = std::min<size_t>(GetProbeAmount(collector.GetFilter()), list_nos.size());
+        auto scan = [&](const std::vector<VectorRun>& vector_runs)
+        {
+            flat_index.Search(query, vector_runs, posting_length, collector);
+        };
+        ScanLists(std::vector<default_amount_type>(list_nos.begin(), list_nos.begin() + probe_amount), scan);
+        for (size_t i = probe_amount; i < list_nos.size() && collector.Size() < collector.GetK(); i++)
+        {
+            ScanLists({list_nos[i]}, scan);
+        }
+    }
+
+    /**
+     * @brief Scan the lists of the nprobe centroids nearest to query for the records in the radius of collector.
+     */
+    bool RangeSearch(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, RangeCollector& collector) const override
+    {
+        if (!trained)
+        {
+            return true;
+        }
+
+        std::vector<default_amount_type> list_nos = quantizer->Search(query.GetQueryFp32(), GetProbeAmount(collector.GetFilter()));
+        ScanLists(list_nos, [&](const std::vector<VectorRun>& vector_runs)
+        {
+            flat_index.RangeSearch(query, vector_runs, posting_length, collector);
+        });
+        return true;
+    }
+
+
+    void SetNprobe(default_amount_type nprobe)
+    {
+        if (nprobe < 1)
+        {
+            throw std::runtime_error("ivf index needs nprobe >= 1");
+        }
+        this->nprobe = nprobe;
+    }
+
+    default_amount_type GetNprobe() const
+    {
+        return nprobe;
+    }
+
+    /**
+     * @brief Default amount of lists scanned by one search, about the square root of nlist. Recall grows with nprobe,
+     * near records are often in lists whose centroids are not the nearest ones, so a few fixed lists miss them.
+     */
+    static default_amount_type GetDefaultNprobe(default_amount_type nlist)
+    {
+        return std::max<default_amount_type>(1, std::ceil(std::sqrt(nlist)));
+    }
+
+    // amount of lists to scan with filter
+    default_amount_type GetProbeAmount(const TagBitmap* filter) const
+    {
+        if (filter == nullptr || filter->GetSelectivity() <= 0)
+        {
+            return nprobe;
+        }
+        return std::min<double>(GetNlist(), std::ceil(nprobe / filter->GetSelectivity()));
+    }
+
+    default_amount_type GetNlist() const
+    {
+        return quantizer->GetK();
+    }
+
+    bool IsTrained() const
+    {
+        return trained;
+    }
+
+    PostingListStore* GetStore() const
+    {
+        return store;
+    }
+
+    // a posting is the id, padded to keep the vector aligned, then the stored vector
+    static default_length_size GetPostingLength(default_length_size dimension, vector_element_type element_type)
+    {
+        default_length_size stored_length = dimension * ElementTypeUtil::GetElementSize(element_type);
+        return POSTING_HEADER_LENGTH + (stored_length + VECTOR_ALIGNMENT - 1) / VECTOR_ALIGNMENT * VECTOR_ALIGNMENT;
+    }
+
+private:
+
+    static constexpr default_length_size POSTING_HEADER_LENGTH = VECTOR_ALIGNMENT;
+    static constexpr default_amount_type KMEANS_ITERATIONS = 20;
+    static constexpr default_long_int TRAINING_SAMPLES_PER_LIST = 64;
+
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_amount_type nprobe;
+    bool trained;
+
+    default_length_size stored_length;      // bytes of one stored vector
+    default_length_size posting_length;
+
+    KMeans* quantizer;
+    PostingListStore* store;
+    FlatIndex flat_index;
+
+    /**
+     * @brief Scan lists, vectors of each batch of postings are offered to scan as runs with their ids.
+     */
+    void ScanLists(const std::vector<default_amount_type>& list_nos, std::function<void(const std::vector<VectorRun>&)> scan) const
+    {
+        store->Scan(list_nos, [&](const std::vector<VectorRun>& posting_runs)
+        {
+            // read ids out of postings, then scan vectors of postings as a column
+            std::vector<std::vector<default_long_int> > ids(posting_runs.size());
+            std::vector<VectorRun> vector_runs;
+            for (size_t r = 0; r < posting_runs.size(); r++)
+            {
+                const VectorRun& run = posting_runs[r];
+                ids[r].resize(run.amount);
+                for (default_long_int i = 0; i < run.amount; i++)
+                {
+                    memcpy(&ids[r][i], run.records + i * posting_length, sizeof(default_long_int));
+                }
+                vector_runs.push_back(VectorRun{run.records + POSTING_HEADER_LENGTH, run.amount, 0, false, ids[r].data()});
+            }
+            scan(vector_runs);
+        });
+    }
+};
+
+}
+
+#endif // VDBMS_IVF_FLAT_INDEX_
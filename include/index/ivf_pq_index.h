@@ -0,0 +1,400 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : ivf_pq_index.h
+// since : 2024-09-10
+// desc  : IVF-PQ index, an inverted file index whose postings are product
+// quantization codes instead of vectors. Each vector is assigned to its nearest
+// coarse centroid, and the residual (vector - centroid) is encoded, which is
+// much more precise than encoding the vector itself. A search scans the nprobe
+// nearest lists, each list with a lookup table of the residual of the query.
+// Lists are kept by a PostingListStore, in memory by default. With 4-bit codes,
+// a posting is a packed block of 32 codes scanned by the fast scan kernel, the
+// last vectors of a list which do not fill a block yet are kept in memory.
+
+#ifndef VDBMS_IVF_PQ_INDEX_
+#define VDBMS_IVF_PQ_INDEX_
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/mixed_precision_query.h"
+#include "../distance/kernel/pq_fast_scan_kernel.h"
+#include "basic_index.h"
+#include "kmeans.h"
+#include "posting_list_store.h"
+#include "product_quantizer.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class IvfPqIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors, must be a multiple of m.
+     * @param element_type element type of stored vectors.
+     * @param nlist amount of coarse centroids (posting lists).
+     * @param nprobe amount of lists scanned by one search.
+     * @param m amount of sub quantizers, one code has m bytes.
+     * @param rerank_factor search rerank_factor * k candidates to rerank, 0 means no reranking.
+     * @param nbits bits of each sub code, 8, or 4 to use fast scan.
+     * @param store storage of posting lists, owned by the index, lists are kept in memory if it is nullptr.
+     * @param seed seed of k-means.
+     */
+    IvfPqIndex(default_length_size dimension, vector_element_type element_type, default_amount_type nlist = 128, default_amount_type nprobe = 12,
+        default_amount_type m = 8, default_amount_type rerank_factor = 0, default_amount_type nbits = 8, PostingListStore* store = nullptr, unsigned int seed = 100)
+        : dimension(dimension), element_type(element_type), nprobe(nprobe), rerank_factor(rerank_factor), trained(false), fast_scan(nbits == 4),
+          store(store), quantizer(nullptr), pq(nullptr)
+    {
+        try
+        {
+            if (nlist < 1 || nprobe < 1 || rerank_factor < 0 || (nbits != 4 && nbits != 8))
+            {
+                throw std::runtime_error("ivf pq index needs nlist >= 1, nprobe >= 1, rerank factor >= 0 and nbits 4 or 8");
+            }
+            pq = new ProductQuantizer(dimension, m, nbits);
+        }
+        catch (...)
+        {
+            delete store;
+            throw;
+        }
+        if (this->store == nullptr)
+        {
+            this->store = new MemoryPostingListStore();
+        }
+        quantizer = new KMeans(dimension, nlist, KMEANS_ITERATIONS, seed);
+        block_length = PqFastScanKernel::GetBlockLength(m);
+        if (fast_scan)
+        {
+            posting_length = PqFastScanKernel::BLOCK_VECTOR_AMOUNT * sizeof(default_long_int) + block_length;
+        }
+        else
+        {
+            posting_length = sizeof(default_long_int) + pq->GetCodeLength();
+        }
+    }
+
+    ~IvfPqIndex()
+    {
+        delete quantizer;
+        delete pq;
+        delete store;
+    }
+
+    IvfPqIndex(const IvfPqIndex&) = delete;
+    IvfPqIndex& operator=(const IvfPqIndex&) = delete;
+
+    column_index_type GetIndexType() const override
+    {
+        return IVF_PQ;
+    }
+
+    // postings are read from the store
+    bool NeedRuns() const override
+    {
+        return false;
+    }
+
+    // enough samples for both coarse centroids and sub quantizers
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return std::max<default_long_int>((default_long_int) quantizer->GetK() * TRAINING_SAMPLES_PER_LIST, (default_long_int) pq->GetKsub() * TRAINING_SAMPLES_PER_CENTROID);
+    }
+
+    // train coarse centroids, then sub quantizers by residuals of samples, all postings are dropped
+    void Train(const std::vector<float>& samples) override
+    {
+        quantizer->Train(samples);
+
+        default_long_int amount = samples.size() / dimension;
+        std::vector<float> residuals(samples.size());
+        for (default_long_int i = 0; i < amount; i++)
+        {
+            const float* sample = samples.data() + i * dimension;
+            ComputeResidual(sample, quantizer->Assign(sample), residuals.data() + i * dimension);
+        }
+        pq->Train(residuals);
+
+        store->Reset(quantizer->GetK(), posting_length);
+        std::unique_lock<std::shared_mutex> lock(tails_mutex);
+        tail_codes.assign(quantizer->GetK(), std::vector<uint8_t>());
+        tail_ids.assign(quantizer->GetK(), std::vector<default_long_int>());
+        trained = true;
+    }
+
+    default_long_int GetRerankAmount(default_long_int k) const override
+    {
+        return rerank_factor > 0 ? k * rerank_factor : 0;
+    }
+
+    /**
+     * @brief Append the code of each record of runs to the list of its nearest centroid, the index must be trained.
+     */
+    void Add(const std::vector<VectorRun>& runs, default_length_size record_length) override
+    {
+        if (!trained)
+        {
+            throw std::runtime_error("ivf pq index must be trained before adding vectors");
+        }
+        for (const VectorRun& run : runs)
+        {
+            for (default_long_int i = 0; i < run.amount; i++)
+            {
+                Insert(run.records + i * record_length, run.GetId(i));
+            }
+        }
+    }
+
+    /**
+     * @brief Append the code of one vector to the list of its nearest centroid.
+     * @param record stored bytes of the vector, in the element type of index.
+     * @param id id returned by search for this vector, such as the tag of the record.
+     */
+    void Insert(const char* record, default_long_int id)
+    {
+        std::vector<double> values(dimension);
+        ElementTypeUtil::Decode(record, dimension, element_type, values.data());
+        std::vector<float> values_fp32(values.begin(), values.end());
+
+        default_amount_type list_no = quantizer->Assign(values_fp32.data());
+        std::vector<float> residual(dimension);
+        ComputeResidual(values_fp32.data(), list_no, residual.data());
+
+        if (fast_scan)
+        {
+            std::vector<uint8_t> code(pq->GetCodeLength());
+            pq->Encode(residual.data(), code.data());
+            AppendToTail(list_no, code.data(), id);
+            return;
+        }
+
+        std::vector<char> posting(posting_length);
+        memcpy(posting.data(), &id, sizeof(default_long_int));
+        pq->Encode(residual.data(), (uint8_t*) posting.data() + sizeof(default_long_int));
+        store->Append(list_no, posting.data());
+    }
+
+    /**
+     * @brief Scan the lists of the nprobe centroids nearest to query, runs of the column are not used.
+     * Distances stored in collector are approximate squared distances. If collector has a filter, nprobe is enlarged
+     * by the ratio of records out of the filter, and farther lists are still scanned until k records in filter are found.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, TopKCollector& collector) const override
+    {
+        if (!trained || collector.GetK() == 0)
+        {
+            return;
+        }
+
+        std::vector<float> residual(dimension);
+        std::vector<float> table((size_t) pq->GetM() * pq->GetKsub());
+        std::vector<default_amount_type> list_nos = quantizer->Search(query.GetQueryFp32(), collector.GetFilter() == nullptr ? nprobe : GetNlist());
+        size_t probe_amount = GetProbeAmount(collector.GetFilter());
+        for (size_t probed = 0; probed < list_nos.size(); probed++)
+        {
+            if (probed >= probe_amount && collector.Size() >= collector.GetK())
+            {
+                break;
+            }
+            default_amount_type list_no = list_nos[probed];
+            // distance from query to centroid + residual code is distance from query residual to the code
+            ComputeResidual(query.GetQueryFp32(), list_no, residual.data());
+            pq->ComputeDistanceTable(residual.data(), table.data());
+            if (fast_scan)
+            {
+                SearchBlocks(list_no, table.data(), collector);
+                continue;
+            }
+            store->Scan({list_no}, [&](const std::vector<VectorRun>& posting_runs)
+            {
+                for (const VectorRun& run : posting_runs)
+                {
+                    for (default_long_int i = 0; i < run.amount; i++)
+                    {
+                        const char* posting = run.records + i * posting_length;
+                        double distance = pq->AdcDistance(table.data(), (const uint8_t*) posting + sizeof(default_long_int));
+                        if (distance < collector.GetThreshold())
+                        {
+                            default_long_int id;
+                            memcpy(&id, posting, sizeof(default_long_int));
+                            collector.Insert(id, distance);
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    void SetNprobe(default_amount_type nprobe)
+    {
+        if (nprobe < 1)
+        {
+            throw std::runtime_error("ivf pq index needs nprobe >= 1");
+        }
+        this->nprobe = nprobe;
+    }
+
+    default_amount_type GetNprobe() const
+    {
+        return nprobe;
+    }
+
+    // amount of lists to scan with filter
+    default_amount_type GetProbeAmount(const TagBitmap* filter) const
+    {
+        if (filter == nullptr || filter->GetSelectivity() <= 0)
+        {
+            return nprobe;
+        }
+        return std::min<double>(GetNlist(), std::ceil(nprobe / filter->GetSelectivity()));
+    }
+
+    default_amount_type GetNlist() const
+    {
+        return quantizer->GetK();
+    }
+
+    PostingListStore* GetStore() const
+    {
+        return store;
+    }
+
+    // amount of vectors in the index
+    default_long_int Size() const
+    {
+        default_long_int size = 0;
+        for (default_amount_type list_no = 0; list_no < quantizer->GetK() && trained; list_no++)
+        {
+            size += store->GetListSize(list_no) * (fast_scan ? PqFastScanKernel::BLOCK_VECTOR_AMOUNT : 1);
+        }
+        std::shared_lock<std::shared_mutex> lock(tails_mutex);
+        for (const std::vector<default_long_int>& ids : tail_ids)
+        {
+            size += ids.size();
+        }
+        return size;
+    }
+
+    // bytes of one posting, the id and the code, or ids and packed codes of a block
+    default_length_size GetPostingLength() const
+    {
+        return posting_length;
+    }
+
+private:
+
+    static constexpr default_amount_type KMEANS_ITERATIONS = 20;
+    static constexpr default_long_int TRAINING_SAMPLES_PER_LIST = 64;
+    static constexpr default_long_int TRAINING_SAMPLES_PER_CENTROID = 32;
+
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_amount_type nprobe;
+    default_amount_type rerank_factor;
+    bool trained;
+    bool fast_scan;                     // 4-bit codes packed in blocks of 32
+    default_length_size block_length;   // bytes of packed codes of a block
+    default_length_size posting_length;
+
+    PostingListStore* store;
+    KMeans* quantizer;
+    ProductQuantizer* pq;
+
+    // vectors of each list not filling a block yet, only used by fast scan
+    std::vector<std::vector<uint8_t> > tail_codes;
+    std::vector<std::vector<default_long_int> > tail_ids;
+    mutable std::shared_mutex tails_mutex;
+
+    // keep code in the tail of list, append the tail to store as one block when it is full
+    void AppendToTail(default_amount_type list_no, const uint8_t* code, default_long_int id)
+    {
+        std::unique_lock<std::shared_mutex> lock(tails_mutex);
+        std::vector<uint8_t>& codes = tail_codes[list_no];
+        std::vector<default_long_int>& ids = tail_ids[list_no];
+        codes.insert(codes.end(), code, code + pq->GetCodeLength());
+        ids.push_back(id);
+        if (ids.size() < PqFastScanKernel::BLOCK_VECTOR_AMOUNT)
+        {
+            return;
+        }
+
+        // a block posting is 32 ids, then the packed codes
+        std::vector<char> posting(posting_length, 0);
+        memcpy(posting.data(), ids.data(), PqFastScanKernel::BLOCK_VECTOR_AMOUNT * sizeof(default_long_int));
+        uint8_t* block = (uint8_t*) posting.data() + PqFastScanKernel::BLOCK_VECTOR_AMOUNT * sizeof(default_long_int);
+        for (default_long_int i = 0; i < PqFastScanKernel::BLOCK_VECTOR_AMOUNT; i++)
+        {
+            PqFastScanKernel::PackCode(codes.data() + i * pq->GetCodeLength(), pq->GetM(), i, block);
+        }
+        store->Append(list_no, posting.data());
+        codes.clear();
+        ids.clear();
+    }
+
+    // scan the blocks of a list by the fast scan kernel, then its tail by the float table
+    void SearchBlocks(default_amount_type list_no, const float* table, TopKCollector& collector) const
+    {
+        QuantizedDistanceTable quantized_table;
+        PqFastScanKernel::QuantizeTable(table, pq->GetM(), quantized_table);
+        PqFastScanKernelFunction kernel = PqFastScanKernel::GetKernel();
+
+        // a full tail is moved to store under the lock, so a vector is seen exactly once
+        std::shared_lock<std::shared_mutex> lock(tails_mutex);
+        uint16_t results[PqFastScanKernel::BLOCK_VECTOR_AMOUNT];
+        store->Scan({list_no}, [&](const std::vector<VectorRun>& posting_runs)
+        {
+            for (const VectorRun& run : posting_runs)
+            {
+                for (default_long_int i = 0; i < run.amount; i++)
+                {
+                    const char* posting = run.records + i * posting_length;
+                    kernel((const uint8_t*) posting + PqFastScanKernel::BLOCK_VECTOR_AMOUNT * sizeof(default_long_int), quantized_table.table.data(), pq->GetM(), results);
+                    for (default_long_int v = 0; v < PqFastScanKernel::BLOCK_VECTOR_AMOUNT; v++)
+                    {
+                        double distance = quantized_table.bias + results[v] / quantized_table.scale;
+                        if (distance < collector.GetThreshold())
+                        {
+                            default_long_int id;
+                            memcpy(&id, posting + v * sizeof(default_long_int), sizeof(default_long_int));
+                            collector.Insert(id, distance);
+                        }
+                    }
+                }
+            }
+        });
+
+        const std::vector<uint8_t>& codes = tail_codes[list_no];
+        const std::vector<default_long_int>& ids = tail_ids[list_no];
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            double distance = pq->AdcDistance(table, codes.data() + i * pq->GetCodeLength());
+            if (distance < collector.GetThreshold())
+            {
+                collector.Insert(ids[i], distance);
+            }
+        }
+    }
+
+    void ComputeResidual(const float* vector, default_amount_type list_no, float* residual) const
+    {
+        const float* centroid = quantizer->GetCentroid(list_no);
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            residual[d] = vector[d] - centroid[d];
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_IVF_PQ_INDEX_
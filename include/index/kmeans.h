@@ -0,0 +1,294 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : kmeans.h
+// since : 2024-09-10
+// desc  : K-means clustering used to train quantizers of indexes, such as the
+// coarse centroids of ivf. Vectors are clustered in fp32 by squared euclidean
+// distance, the assigning step of each iteration runs in many threads. Training
+// vectors are sampled from the runs of a column by TrainingSampler, so only a
+// fixed amount of vectors is kept in memory however large the column is.
+
+#ifndef VDBMS_KMEANS_
+#define VDBMS_KMEANS_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/kernel/element_kernel.h"
+#include "basic_index.h"
+
+namespace tiny_v_dbms {
+
+class KMeans
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors.
+     * @param k amount of centroids.
+     * @param iterations max amount of iterations, training stops early once no vector changes its centroid.
+     * @param seed seed to choose the initial centroids.
+     */
+    KMeans(default_length_size dimension, default_amount_type k, default_amount_type iterations = 20, unsigned int seed = 100)
+        : dimension(dimension), k(k), iterations(iterations), seed(seed), kernels(ElementKernelDispatcher::GetKernels(ELEMENT_FP32))
+    {
+        if (k < 1)
+        {
+            throw std::runtime_error("k-means needs at least one centroid");
+        }
+        centroids.assign((size_t) k * dimension, 0.0f);
+    }
+
+    /**
+     * @brief Cluster samples into k centroids. If there are less than k samples, each sample is a centroid, and the
+     * other centroids are zero vectors.
+     * @param samples vectors one after another.
+     */
+    void Train(const std::vector<float>& samples)
+    {
+        default_long_int amount = samples.size() / dimension;
+        std::fill(centroids.begin(), centroids.end(), 0.0f);
+        if (amount <= static_cast<default_long_int>(k))
+        {
+            std::copy(samples.begin(), samples.begin() + amount * dimension, centroids.begin());
+            return;
+        }
+
+        // init by k different random samples
+        std::mt19937 random_engine(seed);
+        std::vector<default_long_int> order(amount);
+        for (default_long_int i = 0; i < amount; i++)
+        {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), random_engine);
+        for (default_amount_type c = 0; c < k; c++)
+        {
+            std::copy(samples.begin() + order[c] * dimension, samples.begin() + (order[c] + 1) * dimension, centroids.begin() + (size_t) c * dimension);
+        }
+
+        std::vector<default_amount_type> assignment(amount, -1);
+        std::vector<double> sums((size_t) k * dimension);
+        std::vector<default_long_int> counts(k);
+        for (default_amount_type iteration = 0; iteration < iterations; iteration++)
+        {
+            if (AssignAll(samples, amount, assignment) == 0 && iteration > 0)
+            {
+                break;
+            }
+
+            // move each centroid to the mean of its vectors
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (default_long_int i = 0; i < amount; i++)
+            {
+                double* sum = sums.data() + (size_t) assignment[i] * dimension;
+                const float* vector = samples.data() + i * dimension;
+                for (default_length_size d = 0; d < dimension; d++)
+                {
+                    sum[d] += vector[d];
+                }
+                counts[assignment[i]]++;
+            }
+            for (default_amount_type c = 0; c < k; c++)
+            {
+                if (counts[c] == 0)
+                {
+                    continue;
+                }
+                for (default_length_size d = 0; d < dimension; d++)
+                {
+                    centroids[(size_t) c * dimension + d] = sums[(size_t) c * dimension + d] / counts[c];
+                }
+            }
+            SplitEmptyClusters(counts, random_engine);
+        }
+    }
+
+    // index of the nearest centroid
+    default_amount_type Assign(const float* vector) const
+    {
+        std::vector<double> distances(k);
+        kernels.l2_sqr_batch(vector, (const char*) centroids.data(), dimension, k, dimension * sizeof(float), distances.data());
+        return std::min_element(distances.begin(), distances.end()) - distances.begin();
+    }
+
+    /**
+     * @brief Find the n nearest centroids of vector.
+     * @return Indexes of centroids, the nearest first.
+     */
+    std::vector<default_amount_type> Search(const float* vector, default_amount_type n) const
+    {
+        n = std::min(n, k);
+        std::vector<double> distances(k);
+        kernels.l2_sqr_batch(vector, (const char*) centroids.data(), dimension, k, dimension * sizeof(float), distances.data());
+        std::vector<default_amount_type> nearest(k);
+        for (default_amount_type c = 0; c < k; c++)
+        {
+            nearest[c] = c;
+        }
+        std::partial_sort(nearest.begin(), nearest.begin() + n, nearest.end(), [&](default_amount_type a, default_amount_type b) {
+            return distances[a] < distances[b];
+        });
+        nearest.resize(n);
+        return nearest;
+    }
+
+    const std::vector<float>& GetCentroids() const
+    {
+        return centroids;
+    }
+
+    const float* GetCentroid(default_amount_type c) const
+    {
+        return centroids.data() + (size_t) c * dimension;
+    }
+
+    default_amount_type GetK() const
+    {
+        return k;
+    }
+
+private:
+
+    static constexpr default_long_int ASSIGN_PER_THREAD_AT_LEAST = 1024;
+
+    default_length_size dimension;
+    default_amount_type k;
+    default_amount_type iterations;
+    unsigned int seed;
+    const ElementKernelTable& kernels;
+    std::vector<float> centroids;
+
+    // assign each sample to its nearest centroid by many threads, return the amount of changed assignments
+    default_long_int AssignAll(const std::vector<float>& samples, default_long_int amount, std::vector<default_amount_type>& assignment) const
+    {
+        default_long_int thread_amount = std::max<default_long_int>(1, std::thread::hardware_concurrency());
+        thread_amount = std::min<default_long_int>(thread_amount, amount / ASSIGN_PER_THREAD_AT_LEAST + 1);
+        default_long_int per_thread = (amount + thread_amount - 1) / thread_amount;
+
+        std::vector<default_long_int> changed(thread_amount, 0);
+        auto assign_range = [&](default_long_int t) {
+            default_long_int end = std::min(amount, (t + 1) * per_thread);
+            for (default_long_int i = t * per_thread; i < end; i++)
+            {
+                default_amount_type c = Assign(samples.data() + i * dimension);
+                if (c != assignment[i])
+                {
+                    assignment[i] = c;
+                    changed[t]++;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (default_long_int t = 1; t < thread_amount; t++)
+        {
+            threads.emplace_back(assign_range, t);
+        }
+        assign_range(0);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        default_long_int total = 0;
+        for (default_long_int count : changed)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+    // give each empty cluster half of the largest cluster, by moving a slightly shifted copy of its centroid
+    void SplitEmptyClusters(std::vector<default_long_int>& counts, std::mt19937& random_engine)
+    {
+        std::uniform_real_distribution<float> shift(-1e-4f, 1e-4f);
+        for (default_amount_type c = 0; c < k; c++)
+        {
+            if (counts[c] != 0)
+            {
+                continue;
+            }
+            default_amount_type largest = std::max_element(counts.begin(), counts.end()) - counts.begin();
+            for (default_length_size d = 0; d < dimension; d++)
+            {
+                float value = centroids[(size_t) largest * dimension + d];
+                float delta = shift(random_engine) * (std::fabs(value) + 1e-3f);
+                centroids[(size_t) c * dimension + d] = value + delta;
+                centroids[(size_t) largest * dimension + d] = value - delta;
+            }
+            counts[c] = counts[largest] / 2;
+            counts[largest] -= counts[c];
+        }
+    }
+};
+
+/**
+ * Keep a uniform random sample of the records offered by runs (reservoir sampling), the sampled records are decoded
+ * to fp32, so they can train quantizers.
+ */
+class TrainingSampler
+{
+
+public:
+
+    TrainingSampler(default_length_size dimension, vector_element_type element_type, default_long_int capacity, unsigned int seed = 100)
+        : dimension(dimension), element_type(element_type), capacity(capacity), seen(0), random_engine(seed), values(dimension)
+    {
+    }
+
+    void Offer(const std::vector<VectorRun>& runs, default_length_size record_length)
+    {
+        for (const VectorRun& run : runs)
+        {
+            for (default_long_int i = 0; i < run.amount; i++)
+            {
+                default_long_int slot = seen < capacity ? seen : std::uniform_int_distribution<default_long_int>(0, seen)(random_engine);
+                seen++;
+                if (slot >= capacity)
+                {
+                    continue;
+                }
+                if (slot * dimension >= (default_long_int) samples.size())
+                {
+                    samples.resize((slot + 1) * dimension);
+                }
+                ElementTypeUtil::Decode(run.records + i * record_length, dimension, element_type, values.data());
+                std::copy(values.begin(), values.end(), samples.begin() + slot * dimension);
+            }
+        }
+    }
+
+    // sampled vectors one after another
+    const std::vector<float>& GetSamples() const
+    {
+        return samples;
+    }
+
+    // amount of records offered
+    default_long_int GetSeenAmount() const
+    {
+        return seen;
+    }
+
+private:
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_long_int capacity;
+    default_long_int seen;
+    std::mt19937_64 random_engine;
+    std::vector<double> values;
+    std::vector<float> samples;
+};
+
+}
+
+#endif // VDBMS_KMEANS_
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : node_page_store.h
+// since : 2024-09-10
+// desc  : Storage of the nodes of a disk graph index. A node is a fixed length
+// record, such as the id, the full vector and the neighbors of one vector, and
+// nodes are numbered from 0. Nodes are laid out in pages of BLOCK_SIZE one after
+// another, node n is in page n / nodes per page, so reading a few nodes only
+// reads their pages. Pages live in memory (MemoryNodePageStore), or in blocks
+// of the buffer pool (storage/block_node_page_store.h).
+
+#ifndef VDBMS_NODE_PAGE_STORE_
+#define VDBMS_NODE_PAGE_STORE_
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/block/data_block.h"
+
+namespace tiny_v_dbms {
+
+class NodePageStore
+{
+
+public:
+
+    virtual ~NodePageStore()
+    {
+    }
+
+    /**
+     * @brief Drop all nodes.
+     * @param node_length length of each node, count by byte, a page must contain one node at least.
+     */
+    virtual void Reset(default_length_size node_length) = 0;
+
+    /**
+     * @brief Overwrite node node_no, or append it if node_no is the amount of nodes.
+     */
+    virtual void Write(default_long_int node_no, const char* node) = 0;
+
+    /**
+     * @brief Read some nodes as one batch, the page of each node is read once. The node is valid only in the
+     * call of read_node.
+     */
+    virtual void Read(const std::vector<default_long_int>& node_nos, const std::function<void(default_long_int, const char*)>& read_node) = 0;
+
+    // amount of pages read by Read since Reset
+    virtual default_long_int GetPageReadAmount() const = 0;
+
+    // amount of nodes in one page
+    default_length_size GetNodesPerPage() const
+    {
+        return nodes_per_page;
+    }
+
+protected:
+
+    default_length_size node_length = 0;
+    default_length_size nodes_per_page = 0;
+
+    void SetNodeLength(default_length_size node_length)
+    {
+        if (!DataBlock::CanContain(node_length))
+        {
+            throw std::runtime_error("node of length " + std::to_string(node_length) + " can not be stored in one page");
+        }
+        this->node_length = node_length;
+        nodes_per_page = DataBlock::GetCapacity(node_length);
+    }
+};
+
+class MemoryNodePageStore : public NodePageStore
+{
+
+public:
+
+    void Reset(default_length_size node_length) override
+    {
+        std::unique_lock<std::shared_mutex> lock(nodes_mutex);
+        SetNodeLength(node_length);
+        nodes.clear();
+        page_reads = 0;
+    }
+
+    void Write(default_long_int node_no, const char* node) override
+    {
+        std::unique_lock<std::shared_mutex> lock(nodes_mutex);
+        if (node_no * node_length >= nodes.size())
+        {
+            nodes.resize((node_no + 1) * node_length);
+        }
+        memcpy(nodes.data() + node_no * node_length, node, node_length);
+    }
+
+    void Read(const std::vector<default_long_int>& node_nos, const std::function<void(default_long_int, const char*)>& read_node) override
+    {
+        std::shared_lock<std::shared_mutex> lock(nodes_mutex);
+        std::set<default_long_int> pages;
+        for (default_long_int node_no : node_nos)
+        {
+            pages.insert(node_no / nodes_per_page);
+        }
+        page_reads += pages.size();
+        for (default_long_int node_no : node_nos)
+        {
+            read_node(node_no, nodes.data() + node_no * node_length);
+        }
+    }
+
+    default_long_int GetPageReadAmount() const override
+    {
+        return page_reads;
+    }
+
+private:
+    std::vector<char> nodes;
+    std::atomic<default_long_int> page_reads{0};
+    std::shared_mutex nodes_mutex;
+};
+
+}
+
+#endif // VDBMS_NODE_PAGE_STORE_
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : posting_list_store.h
+// since : 2024-09-10
+// desc  : Storage of the posting lists of an inverted file index. A posting is a
+// fixed length record, which is the id of a vector and its stored bytes. The
+// index only decides which list a posting belongs to, the store decides where
+// lists live: in memory (MemoryPostingListStore), or in blocks of the buffer
+// pool (storage/block_posting_list_store.h), so a probe reads a few block
+// chains instead of the whole column.
+
+#ifndef VDBMS_POSTING_LIST_STORE_
+#define VDBMS_POSTING_LIST_STORE_
+
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "../config.h"
+#include "basic_index.h"
+
+namespace tiny_v_dbms {
+
+class PostingListStore
+{
+
+public:
+
+    virtual ~PostingListStore()
+    {
+    }
+
+    /**
+     * @brief Drop all postings, and prepare list_amount empty lists.
+     * @param posting_length length of each posting, count by byte.
+     */
+    virtual void Reset(default_amount_type list_amount, default_length_size posting_length) = 0;
+
+    // append one posting to the end of a list, can be called while scanning
+    virtual void Append(default_amount_type list_no, const char* posting) = 0;
+
+    /**
+     * @brief Offer the postings of some lists as runs, batch by batch. The runs are valid only in the call of
+     * scan_batch, their ids are not set, ids are stored in postings.
+     */
+    virtual void Scan(const std::vector<default_amount_type>& list_nos, const std::function<void(const std::vector<VectorRun>&)>& scan_batch) = 0;
+
+    // amount of postings in a list
+    virtual default_long_int GetListSize(default_amount_type list_no) = 0;
+};
+
+class MemoryPostingListStore : public PostingListStore
+{
+
+public:
+
+    void Reset(default_amount_type list_amount, default_length_size posting_length) override
+    {
+        std::unique_lock<std::shared_mutex> lock(lists_mutex);
+        this->posting_length = posting_length;
+        lists.assign(list_amount, std::vector<char>());
+    }
+
+    void Append(default_amount_type list_no, const char* posting) override
+    {
+        std::unique_lock<std::shared_mutex> lock(lists_mutex);
+        std::vector<char>& list = lists[list_no];
+        list.insert(list.end(), posting, posting + posting_length);
+    }
+
+    // all lists are offered as one batch
+    void Scan(const std::vector<default_amount_type>& list_nos, const std::function<void(const std::vector<VectorRun>&)>& scan_batch) override
+    {
+        std::shared_lock<std::shared_mutex> lock(lists_mutex);
+        std::vector<VectorRun> runs;
+        for (default_amount_type list_no : list_nos)
+        {
+            if (!lists[list_no].empty())
+            {
+                runs.push_back(VectorRun{lists[list_no].data(), (default_long_int) (lists[list_no].size() / posting_length), 0});
+            }
+        }
+        scan_batch(runs);
+    }
+
+    default_long_int GetListSize(default_amount_type list_no) override
+    {
+        std::shared_lock<std::shared_mutex> lock(lists_mutex);
+        return lists[list_no].size() / posting_length;
+    }
+
+private:
+    default_length_size posting_length = 0;
+    std::vector<std::vector<char> > lists;
+    std::shared_mutex lists_mutex;
+};
+
+}
+
+#endif // VDBMS_POSTING_LIST_STORE_
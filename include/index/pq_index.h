@@ -0,0 +1,205 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : pq_index.h
+// since : 2024-09-10
+// desc  : PQ index, every vector of the column is kept in memory as its product
+// quantization code, and a search scans all codes by the lookup table of the
+// query (ADC). Distances are approximate, so the index can ask for rerank_factor
+// times k candidates, which are reranked by exact distances calculated from the
+// records of the column by the caller. With 4-bit codes, codes are packed in
+// blocks of 32 and scanned by the fast scan kernel.
+
+#ifndef VDBMS_PQ_INDEX_
+#define VDBMS_PQ_INDEX_
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/mixed_precision_query.h"
+#include "../distance/kernel/pq_fast_scan_kernel.h"
+#include "basic_index.h"
+#include "product_quantizer.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class PqIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors, must be a multiple of m.
+     * @param element_type element type of stored vectors.
+     * @param m amount of sub quantizers, one code has m bytes.
+     * @param rerank_factor search rerank_factor * k candidates to rerank, 0 means no reranking.
+     * @param nbits bits of each sub code, 8, or 4 to use fast scan.
+     */
+    PqIndex(default_length_size dimension, vector_element_type element_type, default_amount_type m = 8, default_amount_type rerank_factor = 0,
+        default_amount_type nbits = 8)
+        : dimension(dimension), element_type(element_type), rerank_factor(rerank_factor), pq(dimension, m, nbits), fast_scan(nbits == 4)
+    {
+        if (rerank_factor < 0 || (nbits != 4 && nbits != 8))
+        {
+            throw std::runtime_error("pq index needs rerank factor >= 0 and nbits 4 or 8");
+        }
+        block_length = PqFastScanKernel::GetBlockLength(m);
+    }
+
+    column_index_type GetIndexType() const override
+    {
+        return PQ;
+    }
+
+    // codes are kept in the index
+    bool NeedRuns() const override
+    {
+        return false;
+    }
+
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return (default_long_int) pq.GetKsub() * TRAINING_SAMPLES_PER_CENTROID;
+    }
+
+    // train sub quantizers, all codes are dropped
+    void Train(const std::vector<float>& samples) override
+    {
+        std::unique_lock<std::shared_mutex> lock(codes_mutex);
+        pq.Train(samples);
+        codes.clear();
+        ids.clear();
+    }
+
+    default_long_int GetRerankAmount(default_long_int k) const override
+    {
+        return rerank_factor > 0 ? k * rerank_factor : 0;
+    }
+
+    /**
+     * @brief Encode each record of runs, the index must be trained.
+     */
+    void Add(const std::vector<VectorRun>& runs, default_length_size record_length) override
+    {
+        if (!pq.IsTrained())
+        {
+            throw std::runtime_error("pq index must be trained before adding vectors");
+        }
+        std::vector<double> values(dimension);
+        std::vector<float> values_fp32(dimension);
+        std::vector<uint8_t> code(pq.GetCodeLength());
+        for (const VectorRun& run : runs)
+        {
+            for (default_long_int i = 0; i < run.amount; i++)
+            {
+                ElementTypeUtil::Decode(run.records + i * record_length, dimension, element_type, values.data());
+                std::copy(values.begin(), values.end(), values_fp32.begin());
+                pq.Encode(values_fp32.data(), code.data());
+
+                std::unique_lock<std::shared_mutex> lock(codes_mutex);
+                if (fast_scan)
+                {
+                    default_long_int position = ids.size() % PqFastScanKernel::BLOCK_VECTOR_AMOUNT;
+                    if (position == 0)
+                    {
+                        codes.resize(codes.size() + block_length, 0);
+                    }
+                    PqFastScanKernel::PackCode(code.data(), pq.GetM(), position, codes.data() + codes.size() - block_length);
+                }
+                else
+                {
+                    codes.insert(codes.end(), code.begin(), code.end());
+                }
+                ids.push_back(run.GetId(i));
+            }
+        }
+    }
+
+    /**
+     * @brief Scan all codes by the lookup table of query, runs of the column are not used.
+     * Distances stored in collector are approximate squared distances.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, TopKCollector& collector) const override
+    {
+        if (!pq.IsTrained() || collector.GetK() == 0)
+        {
+            return;
+        }
+        std::vector<float> table((size_t) pq.GetM() * pq.GetKsub());
+        pq.ComputeDistanceTable(query.GetQueryFp32(), table.data());
+
+        std::shared_lock<std::shared_mutex> lock(codes_mutex);
+        if (fast_scan)
+        {
+            SearchBlocks(table.data(), collector);
+            return;
+        }
+        default_length_size code_length = pq.GetCodeLength();
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            double distance = pq.AdcDistance(table.data(), codes.data() + i * code_length);
+            if (distance < collector.GetThreshold())
+            {
+                collector.Insert(ids[i], distance);
+            }
+        }
+    }
+
+    default_long_int Size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(codes_mutex);
+        return ids.size();
+    }
+
+    const ProductQuantizer& GetQuantizer() const
+    {
+        return pq;
+    }
+
+private:
+
+    static constexpr default_long_int TRAINING_SAMPLES_PER_CENTROID = 32;
+
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_amount_type rerank_factor;
+
+    ProductQuantizer pq;
+    bool fast_scan;                         // 4-bit codes packed in blocks of 32
+    default_length_size block_length;
+    std::vector<uint8_t> codes;             // codes one after another, or packed blocks one after another
+    std::vector<default_long_int> ids;      // id of each code
+    mutable std::shared_mutex codes_mutex;
+
+    // scan packed blocks with the quantized table, codes_mutex must be locked
+    void SearchBlocks(const float* table, TopKCollector& collector) const
+    {
+        QuantizedDistanceTable quantized_table;
+        PqFastScanKernel::QuantizeTable(table, pq.GetM(), quantized_table);
+        PqFastScanKernelFunction kernel = PqFastScanKernel::GetKernel();
+
+        uint16_t results[PqFastScanKernel::BLOCK_VECTOR_AMOUNT];
+        for (default_long_int begin = 0; begin < ids.size(); begin += PqFastScanKernel::BLOCK_VECTOR_AMOUNT)
+        {
+            kernel(codes.data() + begin / PqFastScanKernel::BLOCK_VECTOR_AMOUNT * block_length, quantized_table.table.data(), pq.GetM(), results);
+            default_long_int amount = std::min<default_long_int>(PqFastScanKernel::BLOCK_VECTOR_AMOUNT, ids.size() - begin);
+            for (default_long_int i = 0; i < amount; i++)
+            {
+                double distance = quantized_table.bias + results[i] / quantized_table.scale;
+                if (distance < collector.GetThreshold())
+                {
+                    collector.Insert(ids[begin + i], distance);
+                }
+            }
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_PQ_INDEX_
@@ -0,0 +1,188 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : product_quantizer.h
+// since : 2024-09-10
+// desc  : Product quantizer (PQ). A vector is split into m sub vectors, each sub
+// vector is replaced by the index of its nearest centroid, which is trained by
+// k-means in its sub space. So a vector is encoded into m bytes, e.g. a 768-d
+// fp32 vector (3072 byte) is 64 byte with m = 64. Distances between a query
+// and codes are asymmetric (ADC): the query is kept exact, a lookup table of
+// the distances from each query sub vector to each centroid is calculated once
+// per query, then the distance to a code is m table lookups.
+
+#ifndef VDBMS_PRODUCT_QUANTIZER_
+#define VDBMS_PRODUCT_QUANTIZER_
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "kmeans.h"
+
+namespace tiny_v_dbms {
+
+class ProductQuantizer
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors, must be a multiple of m.
+     * @param m amount of sub quantizers, which is the length of a code by byte.
+     * @param nbits bits of each sub code, each sub quantizer has 2^nbits centroids, at most 8.
+     */
+    ProductQuantizer(default_length_size dimension, default_amount_type m, default_amount_type nbits = 8)
+        : dimension(dimension), m(m), nbits(nbits), trained(false)
+    {
+        if (m < 1 || dimension % m != 0)
+        {
+            throw std::runtime_error("pq needs m >= 1 and dimension " + std::to_string(dimension) + " to be a multiple of m");
+        }
+        if (nbits < 1 || nbits > 8)
+        {
+            throw std::runtime_error("pq needs 1 <= nbits <= 8");
+        }
+        sub_dimension = dimension / m;
+        ksub = 1 << nbits;
+        centroids.assign((size_t) m * ksub * sub_dimension, 0.0f);
+    }
+
+    /**
+     * @brief Train the centroids of each sub space.
+     * @param samples vectors one after another.
+     */
+    void Train(const std::vector<float>& samples)
+    {
+        default_long_int amount = samples.size() / dimension;
+        std::vector<float> sub_samples(amount * sub_dimension);
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            for (default_long_int i = 0; i < amount; i++)
+            {
+                std::copy(samples.begin() + i * dimension + j * sub_dimension, samples.begin() + i * dimension + (j + 1) * sub_dimension,
+                    sub_samples.begin() + i * sub_dimension);
+            }
+            KMeans kmeans(sub_dimension, ksub, KMEANS_ITERATIONS, 100 + j);
+            kmeans.Train(sub_samples);
+            std::copy(kmeans.GetCentroids().begin(), kmeans.GetCentroids().end(), centroids.begin() + (size_t) j * ksub * sub_dimension);
+        }
+        trained = true;
+    }
+
+    // encode vector into m bytes
+    void Encode(const float* vector, uint8_t* code) const
+    {
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            const float* sub_vector = vector + j * sub_dimension;
+            double best_distance = std::numeric_limits<double>::infinity();
+            for (default_amount_type c = 0; c < ksub; c++)
+            {
+                double distance = SubDistance(sub_vector, GetCentroid(j, c));
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    code[j] = c;
+                }
+            }
+        }
+    }
+
+    // decode code into its approximate vector
+    void Decode(const uint8_t* code, float* vector) const
+    {
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            const float* centroid = GetCentroid(j, code[j]);
+            std::copy(centroid, centroid + sub_dimension, vector + j * sub_dimension);
+        }
+    }
+
+    /**
+     * @brief Calculate the lookup table of query, table[j * ksub + c] is the squared distance from the j-th query
+     * sub vector to the c-th centroid of sub space j.
+     * @param table has m * ksub items.
+     */
+    void ComputeDistanceTable(const float* query, float* table) const
+    {
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            for (default_amount_type c = 0; c < ksub; c++)
+            {
+                table[j * ksub + c] = SubDistance(query + j * sub_dimension, GetCentroid(j, c));
+            }
+        }
+    }
+
+    // asymmetric squared distance between the query of table and a code
+    inline double AdcDistance(const float* table, const uint8_t* code) const
+    {
+        double distance = 0;
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            distance += table[j * ksub + code[j]];
+        }
+        return distance;
+    }
+
+    const float* GetCentroid(default_amount_type j, default_amount_type c) const
+    {
+        return centroids.data() + ((size_t) j * ksub + c) * sub_dimension;
+    }
+
+    default_amount_type GetM() const
+    {
+        return m;
+    }
+
+    default_amount_type GetKsub() const
+    {
+        return ksub;
+    }
+
+    default_amount_type GetNbits() const
+    {
+        return nbits;
+    }
+
+    // bytes of one code
+    default_length_size GetCodeLength() const
+    {
+        return m;
+    }
+
+    bool IsTrained() const
+    {
+        return trained;
+    }
+
+private:
+
+    static constexpr default_amount_type KMEANS_ITERATIONS = 10;
+
+    default_length_size dimension;
+    default_amount_type m;
+    default_amount_type nbits;
+    default_length_size sub_dimension;
+    default_amount_type ksub;
+    bool trained;
+    std::vector<float> centroids;      // m * ksub centroids of sub_dimension
+
+    inline double SubDistance(const float* a, const float* b) const
+    {
+        double distance = 0;
+        for (default_length_size d = 0; d < sub_dimension; d++)
+        {
+            double diff = a[d] - b[d];
+            distance += diff * diff;
+        }
+        return distance;
+    }
+};
+
+}
+
+#endif // VDBMS_PRODUCT_QUANTIZER_
@@ -0,0 +1,132 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : range_collector.h
+// since : 2024-09-10
+// desc  : Collect all candidates nearer than a radius during searching. Results
+// are not kept to the end of the search, they are emitted by batches to a call-
+// back, so a range search with many results only keeps one batch in memory. A
+// collector may have a filter like TopKCollector, and it can be shared by many
+// scanning threads.
+
+#ifndef VDBMS_RANGE_COLLECTOR_
+#define VDBMS_RANGE_COLLECTOR_
+
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "../config.h"
+#include "tag_bitmap.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class RangeCollector
+{
+
+public:
+
+    /**
+     * @param radius euclidean distance, candidates nearer than it are collected.
+     * @param emit called with each batch of results, distances are euclidean, results are in the order found.
+     * @param filter only candidates whose id is in it are collected, nullptr if all are.
+     * @param batch_size amount of results emitted together.
+     */
+    RangeCollector(double radius, std::function<void(const std::vector<SearchResult>&)> emit, const TagBitmap* filter = nullptr,
+        default_long_int batch_size = RANGE_SEARCH_BATCH_SIZE)
+        : squared_radius(radius * radius), emit(emit), filter(filter), batch_size(batch_size > 0 ? batch_size : 1), emit_when_full(true), amount(0)
+    {
+    }
+
+    /**
+     * @brief Get the squared distance a candidate must be smaller than to be collected, which is fixed, so it is
+     * also the threshold of early abandon kernels.
+     */
+    double GetThreshold() const
+    {
+        return squared_radius;
+    }
+
+    bool Accepts(default_long_int id) const
+    {
+        return filter == nullptr || filter->Contains(id);
+    }
+
+    const TagBitmap* GetFilter() const
+    {
+        return filter;
+    }
+
+    /**
+     * @brief Try to insert a candidate, distance is squared.
+     * @return True if the candidate is collected.
+     */
+    bool Insert(default_long_int id, double distance)
+    {
+        if (distance >= squared_radius || !Accepts(id))
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.push_back(SearchResult{id, std::sqrt(distance)});
+        amount++;
+        if (emit_when_full && (default_long_int) batch.size() >= batch_size)
+        {
+            EmitBatch();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Keep full batches until Flush, set to false while the caller pins blocks which the emit callback may
+     * load again, such as the blocks of the searched column.
+     */
+    void SetEmitWhenFull(bool emit_when_full)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->emit_when_full = emit_when_full;
+    }
+
+    /**
+     * @brief Emit the kept results, called at the end of search.
+     * @param only_full emit only if a batch is full, called after releasing pinned blocks.
+     */
+    void Flush(bool only_full = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!batch.empty() && (!only_full || (default_long_int) batch.size() >= batch_size))
+        {
+            EmitBatch();
+        }
+    }
+
+    // amount of results collected so far
+    default_long_int Size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return amount;
+    }
+
+private:
+
+    double squared_radius;
+    std::function<void(const std::vector<SearchResult>&)> emit;
+    const TagBitmap* filter;        // not owned
+    default_long_int batch_size;
+    bool emit_when_full;
+    default_long_int amount;
+
+    std::vector<SearchResult> batch;
+    mutable std::mutex mutex;       // guards batch, and lets only one thread emit at a time
+
+    void EmitBatch()
+    {
+        emit(batch);
+        batch.clear();
+    }
+};
+
+}
+
+#endif // VDBMS_RANGE_COLLECTOR_
@@ -0,0 +1,204 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : scalar_quantizer.h
+// since : 2024-09-10
+// desc  : Scalar quantizer (SQ8 / SQ4). The min and max of each dimension are
+// trained from samples, then each dimension is encoded as an unsigned integer
+// of 8 or 4 bits between them: a 768-d vector is 768 (sq8) or 384 (sq4) bytes
+// instead of 6144 bytes of fp64. A query is prepared once into int8, so the
+// distance to a code is an integer dot product (see distance/kernel/sq_kernel.h):
+// |q - x|^2 = |q|^2 + |x|^2 - 2 * (sum(q_d * min_d) + sum(q_d * step_d * c_d)),
+// where |x|^2 of the decoded vector is calculated once when encoding.
+
+#ifndef VDBMS_SCALAR_QUANTIZER_
+#define VDBMS_SCALAR_QUANTIZER_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../config.h"
+
+namespace tiny_v_dbms {
+
+// a query prepared for the integer kernels of one scalar quantizer
+struct SqQuery
+{
+    std::vector<int8_t> query_low;      // all dimensions of sq8, or even dimensions of sq4
+    std::vector<int8_t> query_high;     // odd dimensions of sq4
+    double scale;                       // q_d * step_d = scale * query item
+    double offset;                      // sum(q_d * min_d)
+    double norm;                        // |q|^2
+};
+
+class ScalarQuantizer
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors.
+     * @param nbits bits of each dimension, 8 or 4.
+     */
+    ScalarQuantizer(default_length_size dimension, default_amount_type nbits = 8)
+        : dimension(dimension), nbits(nbits), trained(false)
+    {
+        if (nbits != 8 && nbits != 4)
+        {
+            throw std::runtime_error("sq needs nbits 8 or 4");
+        }
+        max_code = (1 << nbits) - 1;
+        mins.assign(dimension, 0.0f);
+        steps.assign(dimension, 0.0f);
+    }
+
+    /**
+     * @brief Train the range of each dimension.
+     * @param samples vectors one after another.
+     */
+    void Train(const std::vector<float>& samples)
+    {
+        default_long_int amount = samples.size() / dimension;
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            float min_value = std::numeric_limits<float>::max();
+            float max_value = std::numeric_limits<float>::lowest();
+            for (default_long_int i = 0; i < amount; i++)
+            {
+                min_value = std::min(min_value, samples[i * dimension + d]);
+                max_value = std::max(max_value, samples[i * dimension + d]);
+            }
+            if (amount == 0)
+            {
+                min_value = max_value = 0;
+            }
+            mins[d] = min_value;
+            steps[d] = (max_value - min_value) / max_code;
+        }
+        trained = true;
+    }
+
+    // encode vector into GetCodeLength() bytes, values out of the trained range are clamped
+    void Encode(const float* vector, uint8_t* code) const
+    {
+        if (nbits == 4)
+        {
+            std::fill(code, code + GetCodeLength(), 0);
+        }
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            float value = steps[d] > 0 ? std::round((vector[d] - mins[d]) / steps[d]) : 0;
+            uint8_t item = (uint8_t) std::min<float>(max_code, std::max<float>(0, value));
+            if (nbits == 8)
+            {
+                code[d] = item;
+            }
+            else
+            {
+                code[d / 2] |= d % 2 == 0 ? item : item << 4;
+            }
+        }
+    }
+
+    // decode code into its approximate vector
+    void Decode(const uint8_t* code, float* vector) const
+    {
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            vector[d] = mins[d] + steps[d] * GetItem(code, d);
+        }
+    }
+
+    // |x|^2 of the decoded vector of code
+    float GetCodeNorm(const uint8_t* code) const
+    {
+        double norm = 0;
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            double value = mins[d] + steps[d] * GetItem(code, d);
+            norm += value * value;
+        }
+        return norm;
+    }
+
+    /**
+     * @brief Prepare a query for the integer kernels, q_d * step_d are quantized to int8 by one scale.
+     */
+    void PrepareQuery(const float* query, SqQuery& result) const
+    {
+        double max_value = 0;
+        result.offset = 0;
+        result.norm = 0;
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            max_value = std::max(max_value, std::fabs((double) query[d] * steps[d]));
+            result.offset += (double) query[d] * mins[d];
+            result.norm += (double) query[d] * query[d];
+        }
+        result.scale = max_value > 0 ? max_value / 127 : 1;
+
+        default_length_size byte_length = GetCodeLength();
+        result.query_low.assign(byte_length, 0);
+        result.query_high.assign(nbits == 4 ? byte_length : 0, 0);
+        for (default_length_size d = 0; d < dimension; d++)
+        {
+            int8_t item = (int8_t) std::lround(query[d] * steps[d] / result.scale);
+            if (nbits == 8 || d % 2 == 0)
+            {
+                result.query_low[nbits == 8 ? d : d / 2] = item;
+            }
+            else
+            {
+                result.query_high[d / 2] = item;
+            }
+        }
+    }
+
+    // squared distance from the decoded vector to query, by the integer dot product of query and code
+    inline double GetDistance(const SqQuery& query, int32_t dot, float code_norm) const
+    {
+        double distance = query.norm + code_norm - 2 * (query.offset + query.scale * dot);
+        return distance > 0 ? distance : 0;
+    }
+
+    // bytes of one code
+    default_length_size GetCodeLength() const
+    {
+        return nbits == 8 ? dimension : (dimension + 1) / 2;
+    }
+
+    default_amount_type GetNbits() const
+    {
+        return nbits;
+    }
+
+    bool IsTrained() const
+    {
+        return trained;
+    }
+
+private:
+
+    default_length_size dimension;
+    default_amount_type nbits;
+    default_amount_type max_code;
+    bool trained;
+    std::vector<float> mins;
+    std::vector<float> steps;       // (max - min) / max_code of each dimension
+
+    inline default_amount_type GetItem(const uint8_t* code, default_length_size d) const
+    {
+        if (nbits == 8)
+        {
+            return code[d];
+        }
+        return d % 2 == 0 ? code[d / 2] & 0x0f : code[d / 2] >> 4;
+    }
+};
+
+}
+
+#endif // VDBMS_SCALAR_QUANTIZER_
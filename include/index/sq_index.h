@@ -0,0 +1,179 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : sq_index.h
+// since : 2024-09-10
+// desc  : SQ index, every vector of the column is kept in memory as its scalar
+// quantization code (sq8 or sq4), and a search scans all codes by the integer
+// dot product kernels, batch by batch. Distances are approximate, so the index
+// can ask for rerank_factor times k candidates, which are reranked by exact
+// distances calculated from the full precision records of the column.
+
+#ifndef VDBMS_SQ_INDEX_
+#define VDBMS_SQ_INDEX_
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/element_type.h"
+#include "../distance/mixed_precision_query.h"
+#include "../distance/kernel/sq_kernel.h"
+#include "basic_index.h"
+#include "scalar_quantizer.h"
+#include "top_k_collector.h"
+
+namespace tiny_v_dbms {
+
+class SqIndex : public BasicIndex
+{
+
+public:
+
+    /**
+     * @param dimension dimension of vectors.
+     * @param element_type element type of stored vectors.
+     * @param nbits bits of each dimension, 8 or 4.
+     * @param rerank_factor search rerank_factor * k candidates to rerank, 0 means no reranking.
+     */
+    SqIndex(default_length_size dimension, vector_element_type element_type, default_amount_type nbits = 8, default_amount_type rerank_factor = 0)
+        : dimension(dimension), element_type(element_type), rerank_factor(rerank_factor), sq(dimension, nbits)
+    {
+        if (rerank_factor < 0)
+        {
+            throw std::runtime_error("sq index needs rerank factor >= 0");
+        }
+    }
+
+    column_index_type GetIndexType() const override
+    {
+        return sq.GetNbits() == 8 ? SQ8 : SQ4;
+    }
+
+    // codes are kept in the index
+    bool NeedRuns() const override
+    {
+        return false;
+    }
+
+    default_long_int GetTrainingSampleAmount() const override
+    {
+        return TRAINING_SAMPLE_AMOUNT;
+    }
+
+    // train the range of each dimension, all codes are dropped
+    void Train(const std::vector<float>& samples) override
+    {
+        std::unique_lock<std::shared_mutex> lock(codes_mutex);
+        sq.Train(samples);
+        codes.clear();
+        norms.clear();
+        ids.clear();
+    }
+
+    default_long_int GetRerankAmount(default_long_int k) const override
+    {
+        return rerank_factor > 0 ? k * rerank_factor : 0;
+    }
+
+    /**
+     * @brief Encode each record of runs, the index must be trained.
+     */
+    void Add(const std::vector<VectorRun>& runs, default_length_size record_length) override
+    {
+        if (!sq.IsTrained())
+        {
+            throw std::runtime_error("sq index must be trained before adding vectors");
+        }
+        std::vector<double> values(dimension);
+        std::vector<float> values_fp32(dimension);
+        std::vector<uint8_t> code(sq.GetCodeLength());
+        for (const VectorRun& run : runs)
+        {
+            for (default_long_int i = 0; i < run.amount; i++)
+            {
+                ElementTypeUtil::Decode(run.records + i * record_length, dimension, element_type, values.data());
+                std::copy(values.begin(), values.end(), values_fp32.begin());
+                sq.Encode(values_fp32.data(), code.data());
+                float norm = sq.GetCodeNorm(code.data());
+
+                std::unique_lock<std::shared_mutex> lock(codes_mutex);
+                codes.insert(codes.end(), code.begin(), code.end());
+                norms.push_back(norm);
+                ids.push_back(run.GetId(i));
+            }
+        }
+    }
+
+    /**
+     * @brief Scan all codes by the integer kernels, runs of the column are not used.
+     * Distances stored in collector are approximate squared distances.
+     */
+    void Search(const MixedPrecisionQuery& query, const std::vector<VectorRun>& /* runs */, default_length_size /* record_length */, TopKCollector& collector) const override
+    {
+        if (!sq.IsTrained() || collector.GetK() == 0)
+        {
+            return;
+        }
+        SqQuery sq_query;
+        sq.PrepareQuery(query.GetQueryFp32(), sq_query);
+        const SqKernelTable& kernels = SqKernel::GetKernels();
+        default_length_size code_length = sq.GetCodeLength();
+
+        std::shared_lock<std::shared_mutex> lock(codes_mutex);
+        int32_t dots[SCAN_BATCH_SIZE];
+        for (default_long_int begin = 0; begin < ids.size(); begin += SCAN_BATCH_SIZE)
+        {
+            default_long_int amount = std::min<default_long_int>(SCAN_BATCH_SIZE, ids.size() - begin);
+            const uint8_t* batch_codes = codes.data() + begin * code_length;
+            if (sq.GetNbits() == 8)
+            {
+                kernels.sq8_dot_batch(batch_codes, code_length, amount, sq_query.query_low.data(), code_length, dots);
+            }
+            else
+            {
+                kernels.sq4_dot_batch(batch_codes, code_length, amount, sq_query.query_low.data(), sq_query.query_high.data(), code_length, dots);
+            }
+            for (default_long_int i = 0; i < amount; i++)
+            {
+                double distance = sq.GetDistance(sq_query, dots[i], norms[begin + i]);
+                if (distance < collector.GetThreshold())
+                {
+                    collector.Insert(ids[begin + i], distance);
+                }
+            }
+        }
+    }
+
+    default_long_int Size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(codes_mutex);
+        return ids.size();
+    }
+
+    const ScalarQuantizer& GetQuantizer() const
+    {
+        return sq;
+    }
+
+private:
+
+    static constexpr default_long_int TRAINING_SAMPLE_AMOUNT = 8192;
+    static constexpr default_long_int SCAN_BATCH_SIZE = 256;     // dot products calculated by one batch call
+
+    default_length_size dimension;
+    vector_element_type element_type;
+    default_amount_type rerank_factor;
+
+    ScalarQuantizer sq;
+    std::vector<uint8_t> codes;             // codes one after another
+    std::vector<float> norms;               // |x|^2 of each decoded code
+    std::vector<default_long_int> ids;      // id of each code
+    mutable std::shared_mutex codes_mutex;
+};
+
+}
+
+#endif // VDBMS_SQ_INDEX_
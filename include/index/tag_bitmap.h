@@ -0,0 +1,124 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : tag_bitmap.h
+// since : 2024-09-10
+// desc  : A set of record tags kept as one bit per tag. Tags are the insertion
+// order of records, so they are dense from 0, and a bitmap of a table with n
+// records takes n / 8 bytes. Used to restrict a vector search to the records
+// passing scalar conditions, indexes check a tag by one memory access while
+// traversing. The bitmap also knows the amount of tags it is taken from (the
+// records of the table), so the selectivity of the conditions is known.
+
+#ifndef VDBMS_TAG_BITMAP_
+#define VDBMS_TAG_BITMAP_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../config.h"
+
+namespace tiny_v_dbms {
+
+class TagBitmap
+{
+
+public:
+
+    TagBitmap() : count(0), tag_amount(0)
+    {
+    }
+
+    void Add(default_long_int tag)
+    {
+        Extend(tag + 1);
+        size_t word_no = tag / 64;
+        if (word_no >= words.size())
+        {
+            words.resize(word_no + 1, 0);
+        }
+        uint64_t bit = (uint64_t) 1 << (tag % 64);
+        if ((words[word_no] & bit) == 0)
+        {
+            words[word_no] |= bit;
+            count++;
+        }
+    }
+
+    bool Contains(default_long_int tag) const
+    {
+        size_t word_no = tag / 64;
+        return word_no < words.size() && (words[word_no] >> (tag % 64) & 1) != 0;
+    }
+
+    /**
+     * @brief Tags [0, tag_amount) were checked to build the bitmap, such as all records of a table.
+     */
+    void Extend(default_long_int tag_amount)
+    {
+        this->tag_amount = std::max(this->tag_amount, tag_amount);
+    }
+
+    /**
+     * @brief Keep only the tags also in other, used to combine the conditions joined by AND.
+     */
+    void IntersectWith(const TagBitmap& other)
+    {
+        Extend(other.tag_amount);
+        if (words.size() > other.words.size())
+        {
+            words.resize(other.words.size());
+        }
+        count = 0;
+        for (size_t i = 0; i < words.size(); i++)
+        {
+            words[i] &= other.words[i];
+            count += __builtin_popcountll(words[i]);
+        }
+    }
+
+    // amount of tags in the set
+    default_long_int Count() const
+    {
+        return count;
+    }
+
+    default_long_int GetTagAmount() const
+    {
+        return tag_amount;
+    }
+
+    // ratio of tags in the set
+    double GetSelectivity() const
+    {
+        return tag_amount == 0 ? 0 : (double) count / tag_amount;
+    }
+
+    /**
+     * @brief Get all tags in the set, in increasing order.
+     */
+    std::vector<default_long_int> GetTags() const
+    {
+        std::vector<default_long_int> tags;
+        tags.reserve(count);
+        for (size_t i = 0; i < words.size(); i++)
+        {
+            uint64_t word = words[i];
+            while (word != 0)
+            {
+                tags.push_back(i * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+        return tags;
+    }
+
+private:
+    std::vector<uint64_t> words;
+    default_long_int count;
+    default_long_int tag_amount;
+};
+
+}
+
+#endif // VDBMS_TAG_BITMAP_
@@ -0,0 +1,139 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : top_k_collector.h
+// since : 2024-09-04
+// desc  : Collect the k nearest candidates during searching. A max heap is used,
+// so the k-th best distance is always on the top and can be used as the thre-
+// shold of early abandon kernels. A collector may have a filter, then only the
+// candidates whose id is in the filter are collected.
+
+#ifndef VDBMS_TOP_K_COLLECTOR_
+#define VDBMS_TOP_K_COLLECTOR_
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "../config.h"
+#include "tag_bitmap.h"
+
+namespace tiny_v_dbms {
+
+struct SearchResult
+{
+    default_long_int id;        // position of the vector in the scanned data
+    double distance;
+};
+
+class TopKCollector
+{
+
+public:
+
+    TopKCollector(default_long_int k, const TagBitmap* filter = nullptr) : k(k), filter(filter)
+    {
+        heap.reserve(k);
+    }
+
+    /**
+     * @brief Get the distance a candidate must be smaller than to enter the result.
+     * @return The k-th best distance, or infinity if less than k candidates are collected.
+     */
+    double GetThreshold() const
+    {
+        if (k == 0)
+        {
+            return -std::numeric_limits<double>::infinity();
+        }
+        if (heap.size() < k)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        return heap.front().distance;
+    }
+
+    /**
+     * @brief Try to insert a candidate.
+     * @return True if the candidate is one of the current k best.
+     */
+    bool Insert(default_long_int id, double distance)
+    {
+        if (!Accepts(id))
+        {
+            return false;
+        }
+        if (heap.size() < k)
+        {
+            heap.push_back(SearchResult{id, distance});
+            std::push_heap(heap.begin(), heap.end(), FartherFirst);
+            return true;
+        }
+        if (k == 0 || distance >= heap.front().distance)
+        {
+            return false;
+        }
+        std::pop_heap(heap.begin(), heap.end(), FartherFirst);
+        heap.back() = SearchResult{id, distance};
+        std::push_heap(heap.begin(), heap.end(), FartherFirst);
+        return true;
+    }
+
+    default_long_int Size() const
+    {
+        return heap.size();
+    }
+
+    default_long_int GetK() const
+    {
+        return k;
+    }
+
+    // true if the candidate passes the filter, indexes traversing a graph check it before collecting a node
+    bool Accepts(default_long_int id) const
+    {
+        return filter == nullptr || filter->Contains(id);
+    }
+
+    const TagBitmap* GetFilter() const
+    {
+        return filter;
+    }
+
+    /**
+     * @brief Insert all candidates of another collector, used to merge the collectors of different threads.
+     */
+    void Merge(const TopKCollector& other)
+    {
+        for (const SearchResult& result : other.heap)
+        {
+            Insert(result.id, result.distance);
+        }
+    }
+
+    /**
+     * @brief Get the collected candidates ordered by distance, the nearest first.
+     */
+    std::vector<SearchResult> GetSortedResults() const
+    {
+        std::vector<SearchResult> results(heap);
+        std::sort(results.begin(), results.end(), [](const SearchResult& left, const SearchResult& right) {
+            return left.distance < right.distance || (left.distance == right.distance && left.id < right.id);
+        });
+        return results;
+    }
+
+private:
+
+    default_long_int k;
+    const TagBitmap* filter;        // not owned, nullptr if all candidates are accepted
+    std::vector<SearchResult> heap;
+
+    static bool FartherFirst(const SearchResult& left, const SearchResult& right)
+    {
+        return left.distance < right.distance;
+    }
+};
+
+}
+
+#endif // VDBMS_TOP_K_COLLECTOR_
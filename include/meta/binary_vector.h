@@ -0,0 +1,138 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : binary_vector.h
+// since : 2024-09-06
+// desc  : Packed binary vector, each dimension costs one bit, and bits are stored
+// in 64 bit words (dimension i is bit i % 64 of word i / 64). Unused bits of the
+// last word are always 0, so kernels can compare whole words. A binary quantized
+// embedding is 64x smaller than the double vector it comes from.
+
+#ifndef VDBMS_META_BINARY_VECTOR_H_
+#define VDBMS_META_BINARY_VECTOR_H_
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "../config.h"
+#include "vector_view.h"
+
+namespace tiny_v_dbms {
+
+class BinaryVector
+{
+private:
+    default_length_size dimension;      // amount of bits
+    default_length_size word_length;    // amount of 64 bit words
+    uint64_t* data;
+
+public:
+
+    typedef uint64_t element_type;      // type of the items in GetData()
+
+    /**
+    * @brief Init a vector with all bits 0.
+    * @param dimension amount of bits.
+    */
+    BinaryVector(default_length_size dimension) : dimension(dimension), word_length(CalWordLength(dimension)) {
+        data = new uint64_t[word_length];
+        memset(data, 0, word_length * sizeof(uint64_t));
+    }
+
+    /**
+    * @brief Init a vector using packed words, unused bits of the last word are cleared.
+    * @param data packed words, has CalWordLength(dimension) words.
+    * @param dimension amount of bits.
+    */
+    BinaryVector(const uint64_t* data, default_length_size dimension) : dimension(dimension), word_length(CalWordLength(dimension)) {
+        this->data = new uint64_t[word_length];
+        memcpy(this->data, data, word_length * sizeof(uint64_t));
+        ClearUnusedBits();
+    }
+
+    BinaryVector(const BinaryVector& other) : dimension(other.dimension), word_length(other.word_length) {
+        data = new uint64_t[word_length];
+        memcpy(data, other.data, word_length * sizeof(uint64_t));
+    }
+
+    BinaryVector& operator=(const BinaryVector& other) {
+        if (this != &other) {
+            delete[] data;
+            dimension = other.dimension;
+            word_length = other.word_length;
+            data = new uint64_t[word_length];
+            memcpy(data, other.data, word_length * sizeof(uint64_t));
+        }
+        return *this;
+    }
+
+    ~BinaryVector() {
+        delete[] data;
+    }
+
+    /**
+    * @brief Binary quantize a vector, the bit is 1 if the value is bigger than 0.
+    * @param values vector data.
+    * @param dimension length of values.
+    */
+    static BinaryVector Quantize(const double* values, default_length_size dimension) {
+        BinaryVector vector(dimension);
+        for (default_length_size i = 0; i < dimension; i++) {
+            if (values[i] > 0) {
+                vector.data[i / 64] |= (uint64_t) 1 << (i % 64);
+            }
+        }
+        return vector;
+    }
+
+    // words needed to store dimension bits
+    static default_length_size CalWordLength(default_length_size dimension) {
+        return (dimension + 63) / 64;
+    }
+
+    inline int Get(default_length_size position) {
+        assert(position >= 0 && position < dimension);
+        return (data[position / 64] >> (position % 64)) & 1;
+    }
+
+    inline void Set(default_length_size position, bool value) {
+        assert(position >= 0 && position < dimension);
+        if (value) {
+            data[position / 64] |= (uint64_t) 1 << (position % 64);
+        }
+        else {
+            data[position / 64] &= ~((uint64_t) 1 << (position % 64));
+        }
+    }
+
+    // amount of bits
+    inline default_length_size GetLength() {
+        return dimension;
+    }
+
+    // amount of words in GetData()
+    inline default_length_size GetDataLength() const {
+        return word_length;
+    }
+
+    inline const uint64_t* GetData() const {
+        return data;
+    }
+
+    // view of the packed words, the length of the view is GetDataLength()
+    inline VectorView<default_length_size, uint64_t> GetView() const {
+        return VectorView<default_length_size, uint64_t>(data, word_length);
+    }
+
+private:
+
+    void ClearUnusedBits() {
+        if (dimension % 64 != 0) {
+            data[word_length - 1] &= ((uint64_t) 1 << (dimension % 64)) - 1;
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_META_BINARY_VECTOR_H_
@@ -189,11 +189,30 @@ public:
 
     }
 
+    // begin of the records, records are stored one besides another from here to the block end,
+    // so fixed length records can be visited as one contiguous array (e.g. by CalBatch of distances)
+    const char* GetRecordsBegin() const
+    {
+        return data + last_record_start_address;
+    }
+
     default_length_size GetSpaceCost()
     {
         return 2 * sizeof(default_length_size) + 2 * sizeof(default_address_type) + (BLOCK_SIZE - last_record_start_address);
     }
 
+    // check if an empty block can store one record of value_length, such as a long vector
+    static bool CanContain(default_length_size value_length)
+    {
+        return (default_length_size) (BLOCK_SIZE - 2 * sizeof(default_length_size) - 2 * sizeof(default_address_type)) > value_length;
+    }
+
+    // amount of records of value_length an empty block can store, such as nodes of a graph page
+    static default_length_size GetCapacity(default_length_size value_length)
+    {
+        return (BLOCK_SIZE - 2 * sizeof(default_length_size) - 2 * sizeof(default_address_type)) / value_length;
+    }
+
     bool HaveSpace(default_length_size value_length)
     {
         if ((BLOCK_SIZE - GetSpaceCost()) > value_length)
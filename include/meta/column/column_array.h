@@ -19,6 +19,8 @@ struct Columns {
     default_length_size* column_length_array;             // space cost of each column
     default_enum_type* column_index_type_array;           // index type of each column
     default_address_type* column_storage_address_array;   // where to store each column, is the address of first block number in table data file
+    default_enum_type* column_option_array;               // options of each column, bit flags of column_option
+    default_enum_type* column_element_type_array;         // element type of each vector column, vector_element_type
 };
 
 }
@@ -0,0 +1,283 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : element_type.h
+// since : 2024-09-07
+// desc  : Element types a vector column can store each dimension as. Narrow types
+// put more vectors in one block: a 768 dimension vector costs 6144 bytes as fp64,
+// but only 1536 bytes as fp16/bf16 and 768 bytes as int8. Values are converted
+// once on insert, and kernels read them directly (see element_kernel.h).
+// int8 stores values rounded to integers, it is used for int8 quantized embeddings.
+
+#ifndef VDBMS_META_ELEMENT_TYPE_H_
+#define VDBMS_META_ELEMENT_TYPE_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "../config.h"
+
+namespace tiny_v_dbms {
+
+class ElementTypeUtil
+{
+
+public:
+
+    // bytes cost by one dimension
+    static default_length_size GetElementSize(vector_element_type element_type)
+    {
+        switch (element_type)
+        {
+            case ELEMENT_FP64:
+                return sizeof(double);
+            case ELEMENT_FP32:
+                return sizeof(float);
+            case ELEMENT_FP16:
+            case ELEMENT_BF16:
+                return sizeof(uint16_t);
+            case ELEMENT_INT8:
+                return sizeof(int8_t);
+            default:
+                throw std::runtime_error("unknown vector element type");
+        }
+    }
+
+    static const char* GetElementTypeName(vector_element_type element_type)
+    {
+        switch (element_type)
+        {
+            case ELEMENT_FP64:
+                return "FP64";
+            case ELEMENT_FP32:
+                return "FP32";
+            case ELEMENT_FP16:
+                return "FP16";
+            case ELEMENT_BF16:
+                return "BF16";
+            case ELEMENT_INT8:
+                return "INT8";
+            default:
+                return "UNKNOWN";
+        }
+    }
+
+    /**
+     * @brief Get element type from its name, such as "FP16".
+     * @return False if the name is not an element type.
+     */
+    static bool GetElementTypeFromStr(const std::string& name, vector_element_type& element_type)
+    {
+        const vector_element_type types[] = {ELEMENT_FP64, ELEMENT_FP32, ELEMENT_FP16, ELEMENT_BF16, ELEMENT_INT8};
+        for (vector_element_type type : types)
+        {
+            if (name == GetElementTypeName(type))
+            {
+                element_type = type;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Convert values to the element type and store them in buffer.
+     * @param values vector data.
+     * @param length length of values.
+     * @param element_type the element type to store as.
+     * @param buffer output, has length * GetElementSize(element_type) bytes.
+     */
+    static void Encode(const double* values, default_length_size length, vector_element_type element_type, char* buffer)
+    {
+        for (default_length_size i = 0; i < length; i++)
+        {
+            switch (element_type)
+            {
+                case ELEMENT_FP64:
+                    memcpy(buffer + i * sizeof(double), &values[i], sizeof(double));
+                    break;
+                case ELEMENT_FP32:
+                {
+                    float value = (float) values[i];
+                    memcpy(buffer + i * sizeof(float), &value, sizeof(float));
+                    break;
+                }
+                case ELEMENT_FP16:
+                {
+                    uint16_t value = FloatToHalf((float) values[i]);
+                    memcpy(buffer + i * sizeof(uint16_t), &value, sizeof(uint16_t));
+                    break;
+                }
+                case ELEMENT_BF16:
+                {
+                    uint16_t value = FloatToBFloat16((float) values[i]);
+                    memcpy(buffer + i * sizeof(uint16_t), &value, sizeof(uint16_t));
+                    break;
+                }
+                case ELEMENT_INT8:
+                {
+                    double rounded = std::nearbyint(values[i]);
+                    rounded = rounded > 127 ? 127 : (rounded < -128 ? -128 : rounded);
+                    buffer[i] = (char) (int8_t) rounded;
+                    break;
+                }
+                default:
+                    throw std::runtime_error("unknown vector element type");
+            }
+        }
+    }
+
+    /**
+     * @brief Read values stored as the element type.
+     * @param buffer stored data.
+     * @param length amount of dimensions.
+     * @param element_type the element type stored as.
+     * @param values output, has length space.
+     */
+    static void Decode(const char* buffer, default_length_size length, vector_element_type element_type, double* values)
+    {
+        for (default_length_size i = 0; i < length; i++)
+        {
+            values[i] = ReadElement(buffer, i, element_type);
+        }
+    }
+
+    // read the i-th dimension
+    static double ReadElement(const char* buffer, default_length_size i, vector_element_type element_type)
+    {
+        switch (element_type)
+        {
+            case ELEMENT_FP64:
+            {
+                double value;
+                memcpy(&value, buffer + i * sizeof(double), sizeof(double));
+                return value;
+            }
+            case ELEMENT_FP32:
+            {
+                float value;
+                memcpy(&value, buffer + i * sizeof(float), sizeof(float));
+                return value;
+            }
+            case ELEMENT_FP16:
+            {
+                uint16_t value;
+                memcpy(&value, buffer + i * sizeof(uint16_t), sizeof(uint16_t));
+                return HalfToFloat(value);
+            }
+            case ELEMENT_BF16:
+            {
+                uint16_t value;
+                memcpy(&value, buffer + i * sizeof(uint16_t), sizeof(uint16_t));
+                return BFloat16ToFloat(value);
+            }
+            case ELEMENT_INT8:
+                return (int8_t) buffer[i];
+            default:
+                throw std::runtime_error("unknown vector element type");
+        }
+    }
+
+    // ieee 754 half precision, round to nearest even
+    static uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        int32_t exponent = (int32_t) ((bits >> 23) & 0xFF);
+
+        // inf or nan
+        if (exponent == 0xFF)
+        {
+            return (uint16_t) (sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+        }
+
+        int32_t half_exponent = exponent - 127 + 15;
+        // too big, becomes inf
+        if (half_exponent >= 0x1F)
+        {
+            return (uint16_t) (sign | 0x7C00);
+        }
+        // too small, becomes subnormal or zero
+        if (half_exponent <= 0)
+        {
+            if (half_exponent < -10)
+            {
+                return (uint16_t) sign;
+            }
+            mantissa |= 0x800000;
+            uint32_t shift = (uint32_t) (14 - half_exponent);
+            uint32_t half_mantissa = mantissa >> shift;
+            uint32_t remain = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remain > halfway || (remain == halfway && (half_mantissa & 1)))
+            {
+                half_mantissa++;
+            }
+            return (uint16_t) (sign | half_mantissa);
+        }
+
+        uint32_t half = sign | ((uint32_t) half_exponent << 10) | (mantissa >> 13);
+        uint32_t remain = mantissa & 0x1FFF;
+        // carry into exponent is right, the biggest value rounds to inf
+        if (remain > 0x1000 || (remain == 0x1000 && (half & 1)))
+        {
+            half++;
+        }
+        return (uint16_t) half;
+    }
+
+    static float HalfToFloat(uint16_t half)
+    {
+        uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1F;
+        uint32_t mantissa = half & 0x3FF;
+
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            // zero or subnormal, value is mantissa * 2^-24
+            float value = (float) mantissa * 5.9604644775390625e-8f;
+            return sign != 0 ? -value : value;
+        }
+        else if (exponent == 0x1F)
+        {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // bfloat16 is the high 16 bits of a float, round to nearest even
+    static uint16_t FloatToBFloat16(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        if ((bits & 0x7FFFFFFF) > 0x7F800000)
+        {
+            return (uint16_t) ((bits >> 16) | 0x40);   // keep nan
+        }
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        return (uint16_t) (bits >> 16);
+    }
+
+    static float BFloat16ToFloat(uint16_t bfloat)
+    {
+        uint32_t bits = (uint32_t) bfloat << 16;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+}
+
+#endif // VDBMS_META_ELEMENT_TYPE_H_
@@ -157,7 +157,15 @@ public:
         default_address_type offset = 0;
         for (default_amount_type col_num = 0; col_num < table->column_size; col_num++)
         {
-            Value* new_val = SerializeValueFromBuffer(GetEnumType(table->columns.column_type_array[col_num]), log_body, offset);
+            Value* new_val;
+            if (table->columns.column_type_array[col_num] == VECTOR_T)
+            {
+                new_val = SerializeVectorValueFromBuffer(log_body, offset, table->columns.column_length_array[col_num], vector_element_type(table->columns.column_element_type_array[col_num]));
+            }
+            else
+            {
+                new_val = SerializeValueFromBuffer(GetEnumType(table->columns.column_type_array[col_num]), log_body, offset);
+            }
             offset += new_val->GetValueLength();
 
             if (offset > header.log_data_length)
@@ -4,6 +4,7 @@
 // since : 2024-07-17
 // desc  : Organize data by column, not by row.
 /*
+-header_version.                    such as |-1|, missing in version 0
 table_name_size.                    such as |5|
 table_name.                         such as |test/0|
 column_size.                        such as |1|
@@ -12,6 +13,8 @@ column_type_array.                  such as |0(VECTOR)|
 column_length_array                 such as |20|
 column_index_type_array.            such as |NONE|
 column_storage_address_array.             such as |0x0000|
+column_option_array.                such as |1(NORMALIZE)|, since version 1
+column_element_type_array.          such as |1(FP32)|, since version 1
 
 */
 
@@ -20,6 +23,7 @@ column_storage_address_array.             such as |0x0000|
 #define VDBMS_META_TABLE_COLUMN_TABLE_H_
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 #include "../../config.h" 
@@ -37,6 +41,7 @@ public:
     string table_name;
     default_enum_type table_type;
     default_amount_type column_size;                      // amount of column
+    default_enum_type header_version;                     // layout of the stored header, a header is written back in its own layout
 
     // struct Columns {
     //     string* column_name_array;                            // names of each column
@@ -44,19 +49,27 @@ public:
     //     default_length_size* column_length_array;                   // space cost of each column
     //     default_enum_type* column_index_type_array;           // index type of each column
     //     default_address_type* column_storage_address_array;   // where to store each column, is the address of first block number in table data file
+    //     default_enum_type* column_option_array;               // options of each column
+    //     default_enum_type* column_element_type_array;         // element type of each vector column
     // } columns;
 
     Columns columns;
 
-    ColumnTable() : column_size(0), columns() {}
+    ColumnTable() : column_size(0), header_version(TABLE_HEADER_VERSION), columns() {}
 
-    ColumnTable(default_amount_type col_num) : column_size(col_num) {
+    ColumnTable(default_amount_type col_num) : column_size(col_num), header_version(TABLE_HEADER_VERSION) {
         if (col_num > 0) {
             columns.column_name_array = new string[col_num];
             columns.column_type_array = new default_enum_type[col_num];
             columns.column_length_array = new default_length_size[col_num];
             columns.column_index_type_array = new default_enum_type[col_num];
             columns.column_storage_address_array = new default_address_type[col_num];
+            columns.column_option_array = new default_enum_type[col_num];
+            columns.column_element_type_array = new default_enum_type[col_num];
+            for (default_amount_type i = 0; i < col_num; i++) {
+                columns.column_option_array[i] = COLUMN_OPTION_NONE;
+                columns.column_element_type_array[i] = ELEMENT_FP32;
+            }
         }
     }
 
@@ -64,17 +77,22 @@ public:
         table_name = table.table_name;
         table_type = table.table_type;
         column_size = table.column_size;
+        header_version = table.header_version;
         columns.column_name_array = new string[column_size];
         columns.column_type_array = new default_enum_type[column_size];
         columns.column_length_array = new default_length_size[column_size];
         columns.column_index_type_array = new default_enum_type[column_size];
         columns.column_storage_address_array = new default_address_type[column_size];
+        columns.column_option_array = new default_enum_type[column_size];
+        columns.column_element_type_array = new default_enum_type[column_size];
         for (default_length_size i = 0; i < column_size; ++i) {
             columns.column_name_array[i] = table.columns.column_name_array[i];
             columns.column_type_array[i] = table.columns.column_type_array[i];
             columns.column_length_array[i] = table.columns.column_length_array[i];
             columns.column_index_type_array[i] = table.columns.column_index_type_array[i];
             columns.column_storage_address_array[i] = table.columns.column_storage_address_array[i];
+            columns.column_option_array[i] = table.columns.column_option_array[i];
+            columns.column_element_type_array[i] = table.columns.column_element_type_array[i];
         }
     }
 
@@ -82,6 +100,7 @@ public:
         : table_name(other.table_name), 
         table_type(other.table_type), 
         column_size(other.column_size), 
+        header_version(other.header_version),
         columns(other.columns) {
         other.column_size = 0; // mark the other object as empty
     }
@@ -94,21 +113,28 @@ public:
                 delete[] columns.column_length_array;
                 delete[] columns.column_index_type_array;
                 delete[] columns.column_storage_address_array;
+                delete[] columns.column_option_array;
+                delete[] columns.column_element_type_array;
             }
             table_name = other.table_name;
             table_type = other.table_type;
             column_size = other.column_size;
+            header_version = other.header_version;
             columns.column_name_array = new string[column_size];
             columns.column_type_array = new default_enum_type[column_size];
             columns.column_length_array = new default_length_size[column_size];
             columns.column_index_type_array = new default_enum_type[column_size];
             columns.column_storage_address_array = new default_address_type[column_size];
+            columns.column_option_array = new default_enum_type[column_size];
+            columns.column_element_type_array = new default_enum_type[column_size];
             for (default_length_size i = 0; i < column_size; ++i) {
                 columns.column_name_array[i] = other.columns.column_name_array[i];
                 columns.column_type_array[i] = other.columns.column_type_array[i];
                 columns.column_length_array[i] = other.columns.column_length_array[i];
                 columns.column_index_type_array[i] = other.columns.column_index_type_array[i];
                 columns.column_storage_address_array[i] = other.columns.column_storage_address_array[i];
+                columns.column_option_array[i] = other.columns.column_option_array[i];
+                columns.column_element_type_array[i] = other.columns.column_element_type_array[i];
             }
         }
         return *this;
@@ -122,10 +148,13 @@ public:
                 delete[] columns.column_length_array;
                 delete[] columns.column_index_type_array;
                 delete[] columns.column_storage_address_array;
+                delete[] columns.column_option_array;
+                delete[] columns.column_element_type_array;
             }
             table_name = other.table_name;
             table_type = other.table_type;
             column_size = other.column_size;
+            header_version = other.header_version;
             columns = other.columns;
             other.column_size = 0; // mark the other object as empty
         }
@@ -141,6 +170,8 @@ public:
      * @param column_type The data type of the new column (e.g. integer, string, etc.).
      * @param column_index_type The type of index to be created for the new column (e.g. primary key, unique, etc.).
      * @param column_storage_address The storage address for the new column.
+     * @param column_option The options of the new column, bit flags of column_option.
+     * @param column_element_type The element type of the new column if it is a vector column.
      * 
      * Example:
      * ```cpp
@@ -153,7 +184,9 @@ public:
         default_enum_type column_type,
         default_length_size column_length,
         default_enum_type column_index_type,
-        default_address_type column_storage_address
+        default_address_type column_storage_address,
+        default_enum_type column_option = COLUMN_OPTION_NONE,
+        default_enum_type column_element_type = ELEMENT_FP32
         )
     {
 
@@ -176,6 +209,12 @@ public:
             columns.column_storage_address_array = new default_address_type[1];
             columns.column_storage_address_array[0] = column_storage_address;
 
+            columns.column_option_array = new default_enum_type[1];
+            columns.column_option_array[0] = column_option;
+
+            columns.column_element_type_array = new default_enum_type[1];
+            columns.column_element_type_array[0] = column_element_type;
+
             return;
         }
 
@@ -235,13 +274,36 @@ public:
 
         delete[] columns.column_storage_address_array;
         columns.column_storage_address_array = cache_column_storage_address_array;
+
+        // Update the column option array
+        default_enum_type* cache_column_option_array = new default_enum_type[column_size];
+        for (int i = 0; i < column_size - 1; i++)
+        {
+            cache_column_option_array[i] = columns.column_option_array[i];
+        }
+        cache_column_option_array[column_size - 1] = column_option;
+
+        delete[] columns.column_option_array;
+        columns.column_option_array = cache_column_option_array;
+
+        // Update the column element type array
+        default_enum_type* cache_column_element_type_array = new default_enum_type[column_size];
+        for (int i = 0; i < column_size - 1; i++)
+        {
+            cache_column_element_type_array[i] = columns.column_element_type_array[i];
+        }
+        cache_column_element_type_array[column_size - 1] = column_element_type;
+
+        delete[] columns.column_element_type_array;
+        columns.column_element_type_array = cache_column_element_type_array;
    
     }   
 
     /**
      * @brief Calculates the total length of the serialized data for the ColumnTable struct.
      * 
-     * This function calculates the total length of the serialized data, which includes:
+     * This function calculates the total length of the serialized data in the layout of header_version, which includes:
+     * - The header version (sizeof(default_length_size)), since version 1
      * - The size of the table name (sizeof(default_length_size) + table_name.size())
      * - The size of the table type (sizeof(table_type))
      * - The size of the column amount (sizeof(default_amount_type))
@@ -250,12 +312,19 @@ public:
      * - The size of the column length array (column_size * sizeof(default_length_size))
      * - The size of the column index type array (column_size * sizeof(default_enum_type))
      * - The size of the column storage address array (column_size * sizeof(default_address_type))
+     * - The size of the column option array (column_size * sizeof(default_enum_type)), since version 1
+     * - The size of the column element type array (column_size * sizeof(default_enum_type)), since version 1
      * 
      * @return The total length of the serialized data.
      */
     default_length_size GetLength() {
         default_length_size length = 0;
 
+        // header version
+        if (header_version >= 1) {
+            length += sizeof(default_length_size);
+        }
+
         // table name size + table name
         length += sizeof(default_length_size) + table_name.size();
 
@@ -282,13 +351,23 @@ public:
         // column storage address array
         length += column_size * sizeof(default_address_type);
 
+        if (header_version >= 1) {
+            // column option array
+            length += column_size * sizeof(default_enum_type);
+
+            // column element type array
+            length += column_size * sizeof(default_enum_type);
+        }
+
         return length;
     }
 
     /**
      * @brief Serialize the ColumnTable struct to a binary buffer.
      * 
-     * This function serializes the ColumnTable struct into a binary buffer, which includes:
+     * This function serializes the ColumnTable struct into a binary buffer in the layout of header_version,
+     * so a header read from disk keeps its length when written back. It includes:
+     * - The header version, since version 1
      * - The table name
      * - The table type
      * - The column amount
@@ -297,6 +376,8 @@ public:
      * - The column length array
      * - The column index type array
      * - The column storage address array
+     * - The column option array, since version 1
+     * - The column element type array, since version 1
      * 
      * @param buffer The binary buffer to serialize into.
      * @param begin_offset The starting offset in the buffer to begin serialization.
@@ -306,6 +387,13 @@ public:
     default_length_size Serialize(char* buffer, default_length_size begin_offset) {
         default_length_size offset = 0;
 
+        // Write the header version, negative so it is not taken as the table name size of version 0
+        if (header_version >= 1) {
+            default_length_size version_sign = -header_version;
+            memcpy(buffer + offset + begin_offset, &version_sign, sizeof(default_length_size));
+            offset += sizeof(default_length_size);
+        }
+
         // Write the table name
         default_length_size table_name_size = table_name.size();
         memcpy(buffer + offset + begin_offset, &table_name_size, sizeof(default_length_size));
@@ -355,23 +443,52 @@ public:
             offset += sizeof(default_address_type);
         }
 
+        if (header_version < 1) {
+            return offset;
+        }
+
+        // Write the column option array
+        for (default_amount_type i = 0; i < column_size; ++i) {
+            memcpy(buffer + offset + begin_offset, &columns.column_option_array[i], sizeof(default_enum_type));
+            offset += sizeof(default_enum_type);
+        }
+
+        // Write the column element type array
+        for (default_amount_type i = 0; i < column_size; ++i) {
+            memcpy(buffer + offset + begin_offset, &columns.column_element_type_array[i], sizeof(default_enum_type));
+            offset += sizeof(default_enum_type);
+        }
+
         return offset;
     }
 
     /**
-     * @brief Deserialize a ColumnTable struct from a binary buffer.
+     * @brief Deserialize a ColumnTable struct from a binary buffer. Headers of version 0 have no column options
+     * and element types, they are read as COLUMN_OPTION_NONE and ELEMENT_FP32.
      * 
      * @param buffer The binary buffer to read from.
      * @param read_offset Start read offset.
+     * @throws std::runtime_error If the header is of a newer version.
      */
     void Deserialize(const char* buffer, default_length_size read_offset) {
         default_length_size offset = read_offset;
 
-        // Read the table name
+        // Read the header version, a header of version 0 begins with the table name size
         default_length_size table_name_size;
         memcpy(&table_name_size, buffer + offset, sizeof(default_length_size));
-        // std::cout << "table_name_size" << table_name_size << std::endl;
         offset += sizeof(default_length_size);
+        header_version = 0;
+        if (table_name_size < 0) {
+            header_version = -table_name_size;
+            if (header_version > TABLE_HEADER_VERSION) {
+                throw std::runtime_error("Table header version " + std::to_string(header_version) + " is not supported");
+            }
+            memcpy(&table_name_size, buffer + offset, sizeof(default_length_size));
+            offset += sizeof(default_length_size);
+        }
+
+        // Read the table name
+        // std::cout << "table_name_size" << table_name_size << std::endl;
         table_name.resize(table_name_size);
         memcpy(&table_name[0], buffer + offset, table_name_size);
         offset += table_name_size;
@@ -424,6 +541,28 @@ public:
             memcpy(&columns.column_storage_address_array[i], buffer + offset, sizeof(default_address_type));
             offset += sizeof(default_address_type);
         }
+
+        columns.column_option_array = new default_enum_type[column_size];
+        columns.column_element_type_array = new default_enum_type[column_size];
+        if (header_version < 1) {
+            for (default_amount_type i = 0; i < column_size; ++i) {
+                columns.column_option_array[i] = COLUMN_OPTION_NONE;
+                columns.column_element_type_array[i] = ELEMENT_FP32;
+            }
+            return;
+        }
+
+        // Read the column option array
+        for (default_amount_type i = 0; i < column_size; ++i) {
+            memcpy(&columns.column_option_array[i], buffer + offset, sizeof(default_enum_type));
+            offset += sizeof(default_enum_type);
+        }
+
+        // Read the column element type array
+        for (default_amount_type i = 0; i < column_size; ++i) {
+            memcpy(&columns.column_element_type_array[i], buffer + offset, sizeof(default_enum_type));
+            offset += sizeof(default_enum_type);
+        }
     }
 };
 
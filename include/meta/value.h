@@ -6,14 +6,21 @@
 // supply the serialize, deserialize, compare, convert functions to upper.
 // The serialize and deserialize will be decide by value type.
 // If it's a number, string_value will be unusefull. If it's a vchar, 
-// the num_value will store the char length.
+// the num_value will store the char length. If it's a vector, string_value 
+// stores the encoded elements (see element_type.h) padded to VECTOR_ALIGNMENT, 
+// and num_value stores the length of this record. A vector record has no 
+// header, its dimension and element type come from the column.
 
 #ifndef VDBMS_META_VALUE_H_
 #define VDBMS_META_VALUE_H_
 
 #include <string>
+#include <vector>
+#include <sstream>
 
 #include "../config.h"
+#include "element_type.h"
+#include "../utils/vector_normalize_util.h"
 
 using std::string;
 
@@ -23,6 +30,7 @@ enum ValueType {
     INT_T, 
     FLOAT_T,
     VCHAR_T,
+    VECTOR_T,
 
     RAW_VALUE  // used when value is read from sql and not get it's type from stored table file
 };
@@ -45,6 +53,8 @@ public:
 
         num_value = other.num_value;
         raw_value = other.raw_value;
+        vector_dimension = other.vector_dimension;
+        element_type = other.element_type;
     }
 
     Value(Value&& other) : value_type(other.value_type) {
@@ -53,6 +63,8 @@ public:
 
         num_value = other.num_value;
         raw_value = std::move(other.raw_value);
+        vector_dimension = other.vector_dimension;
+        element_type = other.element_type;
     }
     
     Value& operator=(const Value& other) {
@@ -72,6 +84,8 @@ public:
 
             num_value = other.num_value;
             raw_value = other.raw_value;
+            vector_dimension = other.vector_dimension;
+            element_type = other.element_type;
         }
 
         return *this;
@@ -123,6 +137,19 @@ public:
         memcpy(string_value, value, value_length);
     }
 
+    /**
+     * Init a vector value, values are encoded as the element type.
+     * 
+     * @param values vector data.
+     * @param dimension length of values.
+     * @param element_type the element type of the column storing this value.
+     */
+    Value(const double* values, default_length_size dimension, vector_element_type element_type)
+    {
+        string_value = nullptr;
+        SetVector(values, dimension, element_type);
+    }
+
     // this function is used after set raw value, and know the type of value
     bool InitValue(ValueType type)
     {
@@ -159,6 +186,82 @@ public:
         return true;
     }
 
+    /**
+     * Init raw value as a vector, such as "[0.1, 0.2, 0.3]". Vectors need the column 
+     * information to be initialized, so they are not supported by InitValue.
+     * 
+     * @param dimension declared length of the vector column.
+     * @param element_type element type of the vector column.
+     * @param normalize true if the column has the NORMALIZE option, a zero vector is kept as it is.
+     * @return false if raw value is not a vector literal of dimension numbers.
+     */
+    bool InitVectorValue(default_length_size dimension, vector_element_type element_type, bool normalize)
+    {
+        std::vector<double> values;
+        if (!ParseVectorLiteral(raw_value, values) || values.size() != dimension)
+        {
+            return false;
+        }
+
+        if (normalize)
+        {
+            VectorNormalizeUtil::Normalize(values.data(), dimension);
+        }
+
+        SetVector(values.data(), dimension, element_type);
+        return true;
+    }
+
+    /**
+     * Decode a vector value to double.
+     * 
+     * @param values output, has vector_dimension space.
+     */
+    void GetVectorValue(double* values) const
+    {
+        if (value_type != ValueType::VECTOR_T)
+        {
+            throw std::runtime_error("not a vector value");
+        }
+        ElementTypeUtil::Decode(string_value, vector_dimension, element_type, values);
+    }
+
+    /**
+     * Parse a vector literal, numbers are separated by ',' and enclosed by '[' and ']'.
+     * 
+     * @param literal such as "[0.1, -0.2, 3e-2]".
+     * @param values output numbers.
+     * @return false if literal can not be parsed.
+     */
+    static bool ParseVectorLiteral(const string& literal, std::vector<double>& values)
+    {
+        values.clear();
+
+        size_t begin = literal.find('[');
+        size_t end = literal.rfind(']');
+        if (begin == string::npos || end == string::npos || end < begin)
+        {
+            return false;
+        }
+
+        std::stringstream ss(literal.substr(begin + 1, end - begin - 1));
+        string item;
+        while (std::getline(ss, item, ','))
+        {
+            try {
+                size_t parsed_length;
+                values.push_back(std::stod(item, &parsed_length));
+                if (item.find_first_not_of(" \t\r\n", parsed_length) != string::npos)
+                {
+                    return false;
+                }
+            } catch (std::exception& e) {
+                return false;
+            }
+        }
+        return !values.empty();
+    }
+
     int GetIntValue()
     {
         switch (value_type)
@@ -211,6 +314,8 @@ public:
             return std::to_string(num_value.float_value);
         case ValueType::VCHAR_T: 
             return string_value;
+        case ValueType::VECTOR_T: 
+            return ToString();
         default:
             throw std::runtime_error("not support data type");
             break;
@@ -234,6 +339,11 @@ public:
             
             return;
         }
+        else if (value_type == ValueType::VECTOR_T)
+        {
+            // fixed length record, no length is stored
+            memcpy(data + offset, string_value, num_value.int_value);
+        }
         else if (value_type == ValueType::RAW_VALUE)
         {
             throw std::runtime_error("Raw value can not be Serialize to buffer");
@@ -252,6 +362,15 @@ public:
      */
     void Deserialize(char* data, default_address_type offset)
     {
+        // vector_dimension and element_type must be set before
+        if (value_type == ValueType::VECTOR_T)
+        {
+            num_value.int_value = GetVectorValueLength(vector_dimension, element_type);
+            string_value = new char[num_value.int_value];
+            memcpy(string_value, data + offset, num_value.int_value);
+            return;
+        }
+
         memcpy(&num_value, data + offset, sizeof(num_value));
         offset += sizeof(num_value);
 
@@ -272,6 +391,17 @@ public:
                 return std::to_string(num_value.float_value);
             case VCHAR_T:
                 return string(string_value, num_value.int_value);
+            case VECTOR_T:
+            {
+                std::stringstream ss;
+                ss << "[";
+                for (default_length_size i = 0; i < vector_dimension; i++)
+                {
+                    ss << (i == 0 ? "" : ", ") << ElementTypeUtil::ReadElement(string_value, i, element_type);
+                }
+                ss << "]";
+                return ss.str();
+            }
             case RAW_VALUE:
                 return raw_value;
             default:
@@ -285,6 +415,10 @@ public:
         {
             return sizeof(num_value) + num_value.int_value;
         }
+        else if (value_type == ValueType::VECTOR_T)
+        {
+            return num_value.int_value;
+        }
         else if (value_type == ValueType::RAW_VALUE)
         {
             return raw_value.length();
@@ -302,6 +436,39 @@ public:
         float float_value;
     } num_value;
     char* string_value;
+    default_length_size vector_dimension = 0;           // only used by vector
+    vector_element_type element_type = ELEMENT_FP32;    // only used by vector
+
+    /**
+     * Get the record length of a vector, the encoded elements are padded to VECTOR_ALIGNMENT.
+     * 
+     * @param dimension length of the vector.
+     * @param element_type element type of the vector.
+     */
+    static default_length_size GetVectorValueLength(default_length_size dimension, vector_element_type element_type)
+    {
+        default_length_size length = dimension * ElementTypeUtil::GetElementSize(element_type);
+        return (length + VECTOR_ALIGNMENT - 1) / VECTOR_ALIGNMENT * VECTOR_ALIGNMENT;
+    }
+
+private:
+
+    void SetVector(const double* values, default_length_size dimension, vector_element_type element_type)
+    {
+        if (string_value != nullptr)
+        {
+            delete[] string_value;
+        }
+
+        value_type = ValueType::VECTOR_T;
+        vector_dimension = dimension;
+        this->element_type = element_type;
+        num_value.int_value = GetVectorValueLength(dimension, element_type);
+
+        string_value = new char[num_value.int_value];
+        memset(string_value, 0, num_value.int_value);
+        ElementTypeUtil::Encode(values, dimension, element_type, string_value);
+    }
 };
 
 /**
@@ -372,6 +539,10 @@ ValueType GetValueTypeFromStr(string value_str)
     {
         return VCHAR_T;
     }
+    if (value_str == "VECTOR")
+    {
+        return VECTOR_T;
+    }
 
     throw std::runtime_error("can not parse value type: " + value_str);
 }
@@ -400,7 +571,7 @@ default_length_size GetValueTypeLength(ValueType type)
 
 Value* SerializeValueFromBuffer(ValueType type, char* buffer, default_address_type offset)
 {
-    Value* value;
+    Value* value = nullptr;
 
     switch (type)
     {
@@ -428,6 +599,8 @@ Value* SerializeValueFromBuffer(ValueType type, char* buffer, default_address_ty
             delete[] val_c;
             break;
         }
+        case VECTOR_T:
+            throw std::runtime_error("vector needs the column to be read, use SerializeVectorValueFromBuffer");
         case RAW_VALUE:
         {
             char* raw_val_c = new char[RAW_LENGTH];
@@ -442,6 +615,30 @@ Value* SerializeValueFromBuffer(ValueType type, char* buffer, default_address_ty
     return value;
 }
 
+/**
+ * Read a vector record from buffer, the encoded elements are copied as they are, no string is parsed.
+ * 
+ * @param buffer Buffer pointer, such as the data of a block.
+ * @param offset Buffer offset of the record.
+ * @param dimension declared length of the vector column.
+ * @param element_type element type of the vector column.
+ */
+Value* SerializeVectorValueFromBuffer(char* buffer, default_address_type offset, default_length_size dimension, vector_element_type element_type)
+{
+    Value* value = new Value(ValueType::VECTOR_T);
+    value->vector_dimension = dimension;
+    value->element_type = element_type;
+    value->Deserialize(buffer, offset);
+    return value;
+}
+
+// a zero vector, used when the vector column is not given by insert sql
+Value* BuildDefaultVectorValue(default_length_size dimension, vector_element_type element_type)
+{
+    std::vector<double> values(dimension, 0);
+    return new Value(values.data(), dimension, element_type);
+}
+
 Value* BuildDefaultValue(ValueType value_type)
 {
     Value* value = nullptr;
@@ -8,6 +8,9 @@
 #define VDBMS_META_VECTOR_H_
 
 #include <cassert>
+#include <cstring>
+
+#include "vector_view.h"
 
 namespace tiny_v_dbms {
 
@@ -21,6 +24,8 @@ private:
 
 public:
 
+    typedef DATA_TYPE element_type;     // type of the items in GetData()
+
     /**
     * @brief Init a empty vector using input length as space
     * @param length Length of this vector.
@@ -52,6 +57,21 @@ public:
         return vector_length;
     }
 
+    // amount of items in GetData(), same as length
+    inline LENGTH_TYPE GetDataLength() const {
+        return vector_length;
+    }
+
+    // raw data pointer, used by distance kernels to avoid checking every position
+    inline const DATA_TYPE* GetData() const {
+        return data;
+    }
+
+    // view of this vector, valid while this vector is alive
+    inline VectorView<LENGTH_TYPE, DATA_TYPE> GetView() const {
+        return VectorView<LENGTH_TYPE, DATA_TYPE>(data, vector_length);
+    }
+
     ~Vector() {
         delete[] data;
     }
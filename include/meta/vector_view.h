@@ -0,0 +1,77 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : vector_view.h
+// since : 2024-09-08
+// desc  : Non-owning view of a vector, only a pointer and a length. It is used to
+// read vectors stored in a block of the buffer pool without allocating and copying
+// each one into a Vector. The view is valid only while the memory it points to is
+// alive, e.g. while the BlockSlot is pinned (in_use) by the reader.
+
+#ifndef VDBMS_META_VECTOR_VIEW_H_
+#define VDBMS_META_VECTOR_VIEW_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace tiny_v_dbms {
+
+template<typename LENGTH_TYPE, typename DATA_TYPE>
+class VectorView
+{
+private:
+    const DATA_TYPE* data;          // not owned
+    LENGTH_TYPE length;             // amount of DATA_TYPE items
+
+public:
+
+    typedef DATA_TYPE element_type;     // type of the items in GetData()
+
+    VectorView() : data(nullptr), length(0) {
+    }
+
+    /**
+    * @brief Init a view on existing data, data is not copied.
+    * @param data first item of the vector.
+    * @param length amount of items.
+    */
+    VectorView(const DATA_TYPE* data, LENGTH_TYPE length) : data(data), length(length) {
+    }
+
+    /**
+    * @brief View the record at address of a block, such as BlockSlot::data.
+    * @param block_data begin of the block in memory.
+    * @param address offset of the record in block, count by byte.
+    * @param length amount of items of the record.
+    */
+    static VectorView FromBlock(const char* block_data, size_t address, LENGTH_TYPE length) {
+        return VectorView((const DATA_TYPE*) (block_data + address), length);
+    }
+
+    inline DATA_TYPE Get(LENGTH_TYPE position) const {
+        assert(position >= 0 && position < length);
+        return data[position];
+    }
+
+    inline LENGTH_TYPE GetLength() const {
+        return length;
+    }
+
+    // amount of items in GetData(), same as length
+    inline LENGTH_TYPE GetDataLength() const {
+        return length;
+    }
+
+    inline const DATA_TYPE* GetData() const {
+        return data;
+    }
+
+    // check if the data begins at a multiple of alignment, such as 32 (one avx2 register) or 64 (one cache line)
+    inline bool IsAligned(size_t alignment) const {
+        return ((uintptr_t) data) % alignment == 0;
+    }
+};
+
+}
+
+#endif // VDBMS_META_VECTOR_VIEW_H_
@@ -11,6 +11,11 @@
 #include <iostream>
 #include <set>
 #include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <algorithm>
 
 #include "../../config.h"
 // meta struct
@@ -19,14 +24,29 @@
 #include "../../meta/value_tag.h"
 // sql
 #include "../../sql/sql_struct.h"
+#include "../../sql/parser/ast.h"
 // memory buffer poll
 #include "../../storage/file_management.h"
 #include "../../storage/block_file_management.h"
+#include "../../storage/chain_read_ahead.h"
+#include "../../storage/block_directory.h"
 #include "../../storage/memory/lock_watcher.h"
+#include "../../storage/block_posting_list_store.h"
+#include "../../storage/block_node_page_store.h"
 // table header & table data
 #include "../../meta/table/column_table.h"
 #include "../../meta/block/table_block.h"
 #include "../../meta/block/data_block.h"
+// index
+#include "../../index/flat_index.h"
+#include "../../index/hnsw_index.h"
+#include "../../index/ivf_flat_index.h"
+#include "../../index/pq_index.h"
+#include "../../index/ivf_pq_index.h"
+#include "../../index/sq_index.h"
+#include "../../index/diskann_index.h"
+#include "../../index/index_file.h"
+#include "../../index/tag_bitmap.h"
 
 // log
 #include "../../log/log_central_management.h"
@@ -36,6 +56,7 @@
 
 using std::set;
 using std::map;
+using std::list;
 
 namespace tiny_v_dbms {
 
@@ -77,6 +98,43 @@ private:
     LockWatcher* lw;
     LogCentralManagement* lcm;
 
+    // vector indexes in memory, key is "db.table.column"
+    map<string, BasicIndex*> vector_indexes;
+    map<string, string> vector_index_files;     // index files of persisted indexes, by the same key
+    std::mutex vector_indexes_mutex;
+
+    // block directory of a table in memory. The last blocks of its columns stay pinned in buffer pool while it is
+    // one of the PINNED_TAIL_TABLE_AMOUNT tables inserted into most recently. It is shared by the inserts using it,
+    // so a directory replaced by re-creating the table is deleted after the last of them
+    struct TableDirectory
+    {
+        string db_name;
+        string table_name;
+        default_amount_type column_size;
+        BlockDirectory* directory;
+        bool keep_tails_pinned;         // guarded by block_directories_mutex
+        bool retired;                   // replaced or the operator is deleted, never pinned again, guarded by block_directories_mutex
+        bool* tails_pinned;             // of each column, changed only while holding the last block of column
+        std::mutex tails_mutex;         // held while pinning or unpinning the last blocks
+
+        TableDirectory(const string& db_name, const string& table_name, default_amount_type column_size, BlockDirectory* directory)
+            : db_name(db_name), table_name(table_name), column_size(column_size), directory(directory),
+              keep_tails_pinned(false), retired(false), tails_pinned(new bool[column_size]())
+        {
+        }
+
+        ~TableDirectory()
+        {
+            delete directory;
+            delete[] tails_pinned;
+        }
+    };
+
+    // block directories of tables in memory, key is "db.table"
+    map<string, std::shared_ptr<TableDirectory> > block_directories;
+    list<std::shared_ptr<TableDirectory> > pinned_tail_tables;     // tables keeping last blocks pinned, the least recently inserted first
+    std::mutex block_directories_mutex;
+
     // get install path from file
     void GetInstallPath(string& install_path) 
     {
@@ -246,6 +304,28 @@ public:
         if (db->db_name == DEFAULT_DB_FILE_NAME)
             throw std::runtime_error("Can not create table in base_db!");
 
+        // Check vector columns, one record must fit in one block
+        for (default_amount_type i = 0; i < table->column_size; i++)
+        {
+            if (table->columns.column_type_array[i] != VECTOR_T)
+                continue;
+
+            default_length_size dimension = table->columns.column_length_array[i];
+            vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[i]);
+            if (dimension <= 0)
+            {
+                sql_response->sql_state = FAILURE;
+                sql_response->information = "Vector column " + table->columns.column_name_array[i] + " must have a positive length!";
+                return sql_response;
+            }
+            if (!DataBlock::CanContain(Value::GetVectorValueLength(dimension, element_type)))
+            {
+                sql_response->sql_state = FAILURE;
+                sql_response->information = "Vector column " + table->columns.column_name_array[i] + " is too long for one block, use a narrower element type!";
+                return sql_response;
+            }
+        }
+
         // insert table to table header file
         InsertIntoTableHeader(db, table, sql_response);
 
@@ -326,7 +406,22 @@ public:
         for (default_length_size i = 0; i < table->column_size; i++)
         {
             default_length_size val_position = FindValue(table->columns.column_name_array[i], columns);
-            if (val_position == -1)
+            if (table->columns.column_type_array[i] == VECTOR_T)
+            {
+                // vectors need the dimension, element type and option of column to be initialized
+                default_length_size dimension = table->columns.column_length_array[i];
+                vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[i]);
+                if (val_position == -1)
+                {
+                    row->push_back(BuildDefaultVectorValue(dimension, element_type));
+                    continue;
+                }
+                bool normalize = table->columns.column_option_array[i] & COLUMN_OPTION_NORMALIZE;
+                if (!values->at(val_position).InitVectorValue(dimension, element_type, normalize))
+                    return false;
+                row->push_back(new Value(values->at(val_position)));
+            }
+            else if (val_position == -1)
             {
                 row->push_back(BuildDefaultValue(GetEnumType(table->columns.column_type_array[i])));
             }
@@ -682,8 +777,12 @@ public:
         // Load the first data block of the column
         bool has_next = LoadFirstDataBlockForRead(*db, table_name, col_name, column_data_block_offset, block);
 
+        // Read ahead the next blocks of the column while this one is filtered
+        ChainReadAhead read_ahead(lw->cal_url_util->GetTableDataFile(db->db_name, table_name));
+
         // Store the offset of the next data block
         default_address_type cache_next_block_offset = block.next_block_pointer;
+        read_ahead.Advance(column_data_block_offset, cache_next_block_offset);
 
         // Filter the data block to find values equal to the given value
         FilterEqualOp(&block, eq_value, result_values, tag_offset);
@@ -700,6 +799,7 @@ public:
             // Store the offset of the next data block
             column_data_block_offset = cache_next_block_offset;
             cache_next_block_offset = block.next_block_pointer;
+            read_ahead.Advance(column_data_block_offset, cache_next_block_offset);
 
             // Filter the data block to find values equal to the given value
             FilterEqualOp(&block, eq_value, result_values, tag_offset);
@@ -731,6 +831,9 @@ public:
         // Loop through each value in the data block
         while (value_nums > 0)
         {
+            // Records are stored from the newest one, so the tag (order of insertion) decreases
+            default_long_int tag = tag_offset + value_nums - 1;
+
             // Deserialize the value from the data block
             Value* new_val = SerializeValueFromBuffer(equal_val->value_type, block->data, value_offset);
             value_offset += new_val->GetValueLength();
@@ -739,7 +842,7 @@ public:
             if (Compare(equal_val, new_val) == 0)
             {
                 // If they are equal, create a new value tag pair and add it to the result values
-                value_tag new_val_tag_pair(tag_offset, *new_val);
+                value_tag new_val_tag_pair(tag, *new_val);
                 result_values.push_back(new_val_tag_pair);
             }
             else
@@ -748,10 +851,12 @@ public:
                 delete new_val;
             }
 
-            // Decrement the value count and increment the tag offset
+            // Decrement the value count
             value_nums--;
-            tag_offset++;
         }
+
+        // Tags of the next block begin after this block
+        tag_offset += block->field_data_nums;
     }
 
     /**
@@ -777,6 +882,8 @@ public:
             int column_offset;
             GetColumn(*db, table_name, col_name, table, column_offset);
             ValueType value_type = GetEnumType(table->columns.column_type_array[column_offset]);
+            default_length_size column_length = table->columns.column_length_array[column_offset];
+            vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
             
             // Initialize the tag offset to 0
             default_long_int tag_offset = 0;
@@ -793,11 +900,15 @@ public:
             // Load the first data block of the column
             bool has_next = LoadFirstDataBlockForRead(*db, table_name, col_name, column_data_block_offset, block);
 
+            // Read ahead the next blocks of the column while this one is filtered
+            ChainReadAhead read_ahead(lw->cal_url_util->GetTableDataFile(db->db_name, table_name));
+
             // Store the offset of the next data block
             default_address_type cache_next_block_offset = block.next_block_pointer;
+            read_ahead.Advance(column_data_block_offset, cache_next_block_offset);
 
             // Filter the data block to find values
-            SerializeOp(&block, value_type, result_values, tag_offset);
+            SerializeOp(&block, value_type, result_values, tag_offset, column_length, element_type);
 
             // Release the reading block
             lw->ReleaseReadingBlock(db->db_name, table_name, column_data_block_offset, block);
@@ -811,9 +922,10 @@ public:
                 // Store the offset of the next data block
                 column_data_block_offset = cache_next_block_offset;
                 cache_next_block_offset = block.next_block_pointer;
+                read_ahead.Advance(column_data_block_offset, cache_next_block_offset);
 
                 // Filter the data block to find values
-                SerializeOp(&block, value_type, result_values, tag_offset);
+                SerializeOp(&block, value_type, result_values, tag_offset, column_length, element_type);
 
                 // Release the reading block
                 lw->ReleaseReadingBlock(db->db_name, table_name, column_data_block_offset, block);
@@ -836,8 +948,12 @@ public:
             // Load the first data block of the column
             bool has_next = LoadFirstDataBlockForRead(*db, table_name, col_name, column_data_block_offset, block);
 
+            // Read ahead the next blocks of the column while this one is filtered
+            ChainReadAhead read_ahead(lw->cal_url_util->GetTableDataFile(db->db_name, table_name));
+
             // Store the offset of the next data block
             default_address_type cache_next_block_offset = block.next_block_pointer;
+            read_ahead.Advance(column_data_block_offset, cache_next_block_offset);
 
             // Filter the data block to find values
             FilterOp(&block, *comparator, compare_value, result_values, tag_offset);
@@ -854,6 +970,7 @@ public:
                 // Store the offset of the next data block
                 column_data_block_offset = cache_next_block_offset;
                 cache_next_block_offset = block.next_block_pointer;
+                read_ahead.Advance(column_data_block_offset, cache_next_block_offset);
 
                 // Filter the data block to find values
                 FilterOp(&block, *comparator, compare_value, result_values, tag_offset);
@@ -887,6 +1004,9 @@ public:
         // Loop through each value in the data block
         while (value_nums > 0)
         {
+            // Records are stored from the newest one, so the tag (order of insertion) decreases
+            default_long_int tag = tag_offset + value_nums - 1;
+
             // Deserialize the value from the data block
             Value* new_val = SerializeValueFromBuffer(compare_val->value_type, block->data, value_offset);
             value_offset += new_val->GetValueLength();
@@ -899,7 +1019,7 @@ public:
                 {
                     if (com_result > 0)
                     {
-                        value_tag* new_val_tag_pair = new value_tag(tag_offset, *new_val);
+                        value_tag* new_val_tag_pair = new value_tag(tag, *new_val);
                         result_values.push_back(new_val_tag_pair);
                     } 
                     else
@@ -910,7 +1030,7 @@ public:
                 {
                     if (com_result < 0)
                     {
-                        value_tag* new_val_tag_pair = new value_tag(tag_offset, *new_val);
+                        value_tag* new_val_tag_pair = new value_tag(tag, *new_val);
                         result_values.push_back(new_val_tag_pair);
                     } 
                     else
@@ -921,7 +1041,7 @@ public:
                 {
                     if (com_result == 0)
                     {
-                        value_tag* new_val_tag_pair = new value_tag(tag_offset, *new_val);
+                        value_tag* new_val_tag_pair = new value_tag(tag, *new_val);
                         result_values.push_back(new_val_tag_pair);
                     } 
                     else
@@ -932,7 +1052,7 @@ public:
                 {
                     if (com_result != 0)
                     {
-                        value_tag* new_val_tag_pair = new value_tag(tag_offset, *new_val);
+                        value_tag* new_val_tag_pair = new value_tag(tag, *new_val);
                         result_values.push_back(new_val_tag_pair);
                     } 
                     else
@@ -941,10 +1061,12 @@ public:
                 }        
             }
 
-            // Decrement the value count and increment the tag offset
+            // Decrement the value count
             value_nums--;
-            tag_offset++;
         }
+
+        // Tags of the next block begin after this block
+        tag_offset += block->field_data_nums;
     }
 
     /**
@@ -958,8 +1080,10 @@ public:
      * @param value_type The type of values in the data block.
      * @param result_values The vector of value tags to store the serialized values.
      * @param tag_offset The offset of the first value in the data block.
+     * @param vector_dimension The dimension of values, only used by vector.
+     * @param element_type The element type of values, only used by vector.
      */
-    void SerializeOp(DataBlock* block, ValueType value_type, vector<value_tag*>& result_values, default_long_int& tag_offset)
+    void SerializeOp(DataBlock* block, ValueType value_type, vector<value_tag*>& result_values, default_long_int& tag_offset, default_length_size vector_dimension = 0, vector_element_type element_type = ELEMENT_FP32)
     {
         // Get the number of values in the data block
         default_length_size value_nums = block->field_data_nums;
@@ -970,20 +1094,1036 @@ public:
         // Loop through each value in the data block
         while (value_nums > 0)
         {
-            // Deserialize the value from the data block
-            Value* new_val = SerializeValueFromBuffer(value_type, block->data, value_offset);
+            // Records are stored from the newest one, so the tag (order of insertion) decreases
+            default_long_int tag = tag_offset + value_nums - 1;
+
+            // Deserialize the value from the data block, vector records are copied without parsing
+            Value* new_val = value_type == VECTOR_T 
+                ? SerializeVectorValueFromBuffer(block->data, value_offset, vector_dimension, element_type) 
+                : SerializeValueFromBuffer(value_type, block->data, value_offset);
             value_offset += new_val->GetValueLength();
 
             // Create a value tag pair containing the offset and the deserialized value
-            value_tag* new_val_tag_pair = new value_tag(tag_offset, *new_val);
+            value_tag* new_val_tag_pair = new value_tag(tag, *new_val);
 
             // Add the value tag pair to the result vector
             result_values.push_back(new_val_tag_pair);
 
-            // Decrement the value count and increment the tag offset
+            // Decrement the value count
             value_nums--;
-            tag_offset++;
         }
+
+        // Tags of the next block begin after this block
+        tag_offset += block->field_data_nums;
+    }
+
+    /**
+     * Scan all records of a vector column as runs. Blocks of the column are loaded and pinned batch by batch,
+     * each batch is offered to scan_batch, then released. The addresses of blocks are known from the block
+     * directory, so blocks of a batch missing in buffer pool are read from disk together.
+     * Records in a block are stored from the newest one, so the run of a block begins with its largest tag.
+     * 
+     * @param db The database to scan.
+     * @param table The table to scan.
+     * @param column_offset The offset of the vector column in the table.
+     * @param scan_batch Called with the runs of each batch, the runs are valid only in the call.
+     * @param batch_released Called after the blocks of each batch are released, nullptr if not needed.
+     */
+    void ScanColumnRuns(DB* db, ColumnTable* table, default_address_type column_offset, std::function<void(const vector<VectorRun>&)> scan_batch,
+        std::function<void()> batch_released = nullptr)
+    {
+        vector<DirectoryEntry> entries = GetDirectoryEntries(db, table, column_offset);
+        vector<default_address_type> batch_addresses;
+        vector<DataBlock> batch_blocks;
+        vector<VectorRun> runs;
+
+        for (size_t batch_begin = 0; batch_begin < entries.size(); batch_begin += batch_blocks.size())
+        {
+            batch_addresses.clear();
+            batch_blocks.clear();
+            runs.clear();
+            size_t batch_end = std::min(entries.size(), batch_begin + SEARCH_BATCH_BLOCK_AMOUNT);
+            for (size_t i = batch_begin; i < batch_end; i++)
+            {
+                batch_addresses.push_back(entries[i].block_address);
+            }
+
+            // load and pin one batch of blocks, it is cut short if buffer pool has not enough free slots
+            lw->LoadBlocksForRead(db->db_name, table->table_name, batch_addresses, batch_blocks);
+            for (size_t i = 0; i < batch_blocks.size(); i++)
+            {
+                default_long_int amount = batch_blocks[i].field_data_nums;
+                if (amount > 0)
+                {
+                    runs.push_back(VectorRun{batch_blocks[i].data + batch_blocks[i].last_record_start_address, amount,
+                        entries[batch_begin + i].first_tag + amount - 1, true});
+                }
+            }
+
+            scan_batch(runs);
+
+            for (size_t i = 0; i < batch_blocks.size(); i++)
+            {
+                lw->ReleaseReadingBlock(db->db_name, table->table_name, batch_addresses[i], batch_blocks[i]);
+            }
+            if (batch_released != nullptr)
+            {
+                batch_released();
+            }
+        }
+    }
+
+    /**
+     * Find the records of a column passing one condition, and add their tags into a bitmap. Values are compared
+     * one by one from the blocks, no value tag is kept for a record.
+     * 
+     * @param db The database of the table.
+     * @param table The table of the column.
+     * @param column_offset The offset of the column in the table.
+     * @param comparator The comparison operator to use.
+     * @param compare_value The value to compare with, has the type of the column.
+     * @param result Tags of the passing records are added, and it is extended to all records of the column.
+     */
+    void FilterTags(DB* db, ColumnTable* table, default_address_type column_offset, Comparator comparator, Value* compare_value, TagBitmap& result)
+    {
+        default_long_int tag_offset = 0;
+        default_address_type block_address = table->columns.column_storage_address_array[column_offset];
+        ChainReadAhead read_ahead(lw->cal_url_util->GetTableDataFile(db->db_name, table->table_name));
+        bool has_next_block = true;
+        while (has_next_block)
+        {
+            DataBlock block;
+            lw->LoadBlockForRead(db->db_name, table->table_name, block_address, block);
+            read_ahead.Advance(block_address, block.next_block_pointer);
+            default_long_int amount = block.field_data_nums;
+
+            // the newest record is the first one of block
+            default_address_type value_offset = block.last_record_start_address;
+            for (default_long_int position = 0; position < amount; position++)
+            {
+                Value* value = SerializeValueFromBuffer(compare_value->value_type, block.data, value_offset);
+                value_offset += value->GetValueLength();
+                int compare_result = Compare(value, compare_value);
+                delete value;
+
+                if ((comparator == BIGGER && compare_result > 0) || (comparator == LESS && compare_result < 0)
+                    || (comparator == EQUAL && compare_result == 0) || (comparator == NOT_EQUAL && compare_result != 0))
+                {
+                    result.Add(tag_offset + amount - 1 - position);
+                }
+            }
+            tag_offset += amount;
+
+            lw->ReleaseReadingBlock(db->db_name, table->table_name, block_address, block);
+            has_next_block = block.next_block_pointer != 0x0;
+            block_address = block.next_block_pointer;
+        }
+        result.Extend(tag_offset);
+    }
+
+    /**
+     * Search the k records of a vector column nearest to query. If the column has a vector index keeping its own
+     * copy of vectors (such as hnsw), search the index only, or scan the whole column with flat index. Candidates
+     * of an index with approximate distances (such as pq) may be reranked by their records.
+     * With a filter, only records in it are returned, the index skips other records while traversing. If few
+     * records pass the filter (FILTERED_SEARCH_SCAN_SELECTIVITY), or the column has no such index, the records in
+     * filter are scanned by their tags instead.
+     * 
+     * @param db The database to search in.
+     * @param table The table to search in.
+     * @param column_offset The offset of the vector column in the table.
+     * @param query Query vector, has the dimension of the column.
+     * @param k The amount of records to find.
+     * @param filter Tags of the records can be returned, nullptr if all records can.
+     * @return Tags and euclidean distances of the nearest records, the nearest first.
+     */
+    vector<SearchResult> NearestSearch(DB* db, ColumnTable* table, default_address_type column_offset, const double* query, default_long_int k,
+        const TagBitmap* filter = nullptr)
+    {
+        default_length_size dimension = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+        default_length_size record_length = Value::GetVectorValueLength(dimension, element_type);
+
+        MixedPrecisionQuery mixed_query(query, dimension, element_type);
+        TopKCollector collector(k, filter);
+
+        BasicIndex* vector_index = GetVectorIndex(db, table, column_offset);
+        bool use_index = vector_index != nullptr && !vector_index->NeedRuns();
+        if (filter != nullptr && (!use_index || filter->GetSelectivity() < FILTERED_SEARCH_SCAN_SELECTIVITY))
+        {
+            SearchTags(db, table, column_offset, mixed_query, filter->GetTags(), collector);
+            return FlatIndex::FinishResults(collector);
+        }
+
+        if (use_index)
+        {
+            default_long_int rerank_amount = vector_index->GetRerankAmount(k);
+            if (rerank_amount > k)
+            {
+                // distances of the index are approximate, rerank more candidates by their records
+                TopKCollector candidates(rerank_amount, filter);
+                vector_index->Search(mixed_query, vector<VectorRun>(), record_length, candidates);
+                RerankByTags(db, table, column_offset, mixed_query, candidates.GetSortedResults(), collector);
+                return FlatIndex::FinishResults(collector);
+            }
+            vector_index->Search(mixed_query, vector<VectorRun>(), record_length, collector);
+            return FlatIndex::FinishResults(collector);
+        }
+
+        FlatIndex index(dimension);
+        ScanColumnRuns(db, table, column_offset, [&](const vector<VectorRun>& runs)
+        {
+            index.Search(mixed_query, runs, record_length, collector);
+        });
+
+        return FlatIndex::FinishResults(collector);
+    }
+
+    /**
+     * Search the k nearest records of a vector column for many queries. Without an index keeping its own vectors,
+     * the column is scanned only once for all queries by the batch search of flat index, which compares tiles of
+     * queries with tiles of records like a matrix multiply, so each loaded block is reused by every query. With such
+     * an index or a filter, queries are searched one by one as NearestSearch does, because each query walks its own
+     * path of the index, or scans only the records in filter.
+     * 
+     * @param db The database to search in.
+     * @param table The table to search in.
+     * @param column_offset The offset of the vector column in the table.
+     * @param queries Query vectors, each has the dimension of the column.
+     * @param k The amount of records to find for each query.
+     * @param filter Tags of the records can be returned, nullptr if all records can.
+     * @return Results of each query, the nearest first.
+     */
+    vector<vector<SearchResult> > BatchNearestSearch(DB* db, ColumnTable* table, default_address_type column_offset, const vector<vector<double> >& queries,
+        default_long_int k, const TagBitmap* filter = nullptr)
+    {
+        vector<vector<SearchResult> > results;
+        BasicIndex* vector_index = GetVectorIndex(db, table, column_offset);
+        if (filter != nullptr || (vector_index != nullptr && !vector_index->NeedRuns()))
+        {
+            for (const vector<double>& query : queries)
+            {
+                results.push_back(NearestSearch(db, table, column_offset, query.data(), k, filter));
+            }
+            return results;
+        }
+
+        default_length_size dimension = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+        default_length_size record_length = Value::GetVectorValueLength(dimension, element_type);
+
+        vector<MixedPrecisionQuery> mixed_queries;
+        for (const vector<double>& query : queries)
+        {
+            mixed_queries.emplace_back(query.data(), dimension, element_type);
+        }
+        vector<TopKCollector> collectors(queries.size(), TopKCollector(k));
+
+        FlatIndex index(dimension);
+        ScanColumnRuns(db, table, column_offset, [&](const vector<VectorRun>& runs)
+        {
+            index.BatchSearch(mixed_queries, runs, record_length, collectors);
+        });
+
+        for (const TopKCollector& collector : collectors)
+        {
+            results.push_back(FlatIndex::FinishResults(collector));
+        }
+        return results;
+    }
+
+    /**
+     * Search all records of a vector column nearer than the radius of collector, results are emitted by batches
+     * while searching. The index of the column is searched if it keeps its own vectors and can search by range
+     * (FLAT, HNSW, IVF_FLAT, DISKANN), or the column is scanned. With a filter, records in it are scanned by
+     * their tags instead as NearestSearch does. Blocks of the column are released before a batch is emitted, so
+     * the emit callback can load them again.
+     * 
+     * @param db The database to search in.
+     * @param table The table to search in.
+     * @param column_offset The offset of the vector column in the table.
+     * @param query Query vector, has the dimension of the column.
+     * @param collector Has the radius, filter and emit callback, it is flushed at the end.
+     */
+    void RangeSearch(DB* db, ColumnTable* table, default_address_type column_offset, const double* query, RangeCollector& collector)
+    {
+        default_length_size dimension = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+        default_length_size record_length = Value::GetVectorValueLength(dimension, element_type);
+
+        MixedPrecisionQuery mixed_query(query, dimension, element_type);
+        const TagBitmap* filter = collector.GetFilter();
+
+        BasicIndex* vector_index = GetVectorIndex(db, table, column_offset);
+        bool use_index = vector_index != nullptr && !vector_index->NeedRuns();
+        if (use_index && (filter == nullptr || filter->GetSelectivity() >= FILTERED_SEARCH_SCAN_SELECTIVITY)
+            && vector_index->RangeSearch(mixed_query, vector<VectorRun>(), record_length, collector))
+        {
+            collector.Flush();
+            return;
+        }
+
+        collector.SetEmitWhenFull(false);
+        if (filter != nullptr)
+        {
+            SearchTags(db, table, column_offset, mixed_query, filter->GetTags(), collector, [&]()
+            {
+                collector.Flush(true);
+            });
+        }
+        else
+        {
+            FlatIndex index(dimension);
+            ScanColumnRuns(db, table, column_offset, [&](const vector<VectorRun>& runs)
+            {
+                index.RangeSearch(mixed_query, runs, record_length, collector);
+            }, [&]()
+            {
+                collector.Flush(true);
+            });
+        }
+        collector.Flush();
+    }
+
+    /**
+     * Calculate the exact distances of candidates from the records of a vector column, and collect them again.
+     * 
+     * @param db The database of the table.
+     * @param table The table of the column.
+     * @param column_offset The offset of the vector column in the table.
+     * @param query The query of the search.
+     * @param candidates Candidates found by an index, the id of a candidate is the tag of its record.
+     * @param collector Collects the exact squared distances of candidates.
+     */
+    void RerankByTags(DB* db, ColumnTable* table, default_address_type column_offset, const MixedPrecisionQuery& query, const vector<SearchResult>& candidates, TopKCollector& collector)
+    {
+        vector<default_long_int> tags;
+        for (const SearchResult& candidate : candidates)
+        {
+            tags.push_back(candidate.id);
+        }
+        std::sort(tags.begin(), tags.end());
+        tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+        SearchTags(db, table, column_offset, query, tags, collector);
+    }
+
+    /**
+     * Calculate the exact distances of some records of a vector column, and collect them. The blocks of tags are
+     * found by the block directory, only they are loaded, batch by batch, and the records of tags are found in
+     * their blocks directly.
+     * 
+     * @param db The database of the table.
+     * @param table The table of the column.
+     * @param column_offset The offset of the vector column in the table.
+     * @param query The query of the search.
+     * @param tags Tags of the records, in increasing order.
+     * @param collector Collects the exact squared distances of records, TopKCollector or RangeCollector.
+     * @param batch_released Called after the blocks of each batch are released, nullptr if not needed.
+     */
+    template <class Collector>
+    void SearchTags(DB* db, ColumnTable* table, default_address_type column_offset, const MixedPrecisionQuery& query, const vector<default_long_int>& tags, Collector& collector,
+        std::function<void()> batch_released = nullptr)
+    {
+        vector<DirectoryEntry> entries = GetDirectoryEntries(db, table, column_offset);
+        vector<default_long_int>::const_iterator next_tag = tags.begin();
+        vector<default_long_int> block_nos;
+        vector<vector<default_long_int>::const_iterator> block_tags;
+        while (next_tag != tags.end())
+        {
+            vector<default_address_type> batch_addresses;
+            vector<DataBlock> batch_blocks;
+            FindTagBlocks(entries, next_tag, tags.end(), block_nos, block_tags);
+            for (default_long_int block_no : block_nos)
+            {
+                batch_addresses.push_back(entries[block_no].block_address);
+            }
+            lw->LoadBlocksForRead(db->db_name, table->table_name, batch_addresses, batch_blocks);
+            // tags of blocks not loaded are found again by the next batch
+            next_tag = block_tags[batch_blocks.size()];
+
+            for (size_t i = 0; i < batch_blocks.size(); i++)
+            {
+                DataBlock& block = batch_blocks[i];
+                default_long_int amount = block.field_data_nums;
+                default_long_int first_tag = entries[block_nos[i]].first_tag;
+
+                // the newest record is the first one of block
+                for (vector<default_long_int>::const_iterator tag = block_tags[i]; tag != block_tags[i + 1] && *tag - first_tag < amount; tag++)
+                {
+                    default_long_int position = amount - 1 - (*tag - first_tag);
+                    collector.Insert(*tag, query.L2Sqr(block.data + block.last_record_start_address + position * block.field_length));
+                }
+                lw->ReleaseReadingBlock(db->db_name, table->table_name, batch_addresses[i], block);
+            }
+            if (batch_released != nullptr)
+            {
+                batch_released();
+            }
+        }
+    }
+
+    /**
+     * Load the values of some records of a column by their tags, other records are skipped without deserializing.
+     * The blocks of tags are found by the block directory, only they are loaded.
+     * 
+     * @param db The database to load from.
+     * @param table The table to load from.
+     * @param column_offset The offset of the column in the table.
+     * @param tags Tags of records to load.
+     * @param result_values Map from tag to the loaded value, the values must be deleted after using.
+     */
+    void LoadValuesByTags(DB* db, ColumnTable* table, default_address_type column_offset, const set<default_long_int>& tags, map<default_long_int, Value*>& result_values)
+    {
+        ValueType value_type = GetEnumType(table->columns.column_type_array[column_offset]);
+        default_length_size column_length = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+
+        vector<DirectoryEntry> entries = GetDirectoryEntries(db, table, column_offset);
+        set<default_long_int>::const_iterator next_tag = tags.begin();
+        vector<default_long_int> block_nos;
+        vector<set<default_long_int>::const_iterator> block_tags;
+        while (next_tag != tags.end())
+        {
+            vector<default_address_type> batch_addresses;
+            vector<DataBlock> batch_blocks;
+            FindTagBlocks(entries, next_tag, tags.end(), block_nos, block_tags);
+            for (default_long_int block_no : block_nos)
+            {
+                batch_addresses.push_back(entries[block_no].block_address);
+            }
+            lw->LoadBlocksForRead(db->db_name, table->table_name, batch_addresses, batch_blocks);
+            // tags of blocks not loaded are found again by the next batch
+            next_tag = block_tags[batch_blocks.size()];
+
+            for (size_t i = 0; i < batch_blocks.size(); i++)
+            {
+                DataBlock& block = batch_blocks[i];
+                default_long_int amount = block.field_data_nums;
+                default_long_int first_tag = entries[block_nos[i]].first_tag;
+
+                if (value_type == VECTOR_T)
+                {
+                    // vector records have fixed length, jump to the records of tags directly, the newest record is the first
+                    for (set<default_long_int>::const_iterator tag = block_tags[i]; tag != block_tags[i + 1] && *tag - first_tag < amount; tag++)
+                    {
+                        default_long_int position = amount - 1 - (*tag - first_tag);
+                        default_address_type value_offset = block.last_record_start_address + position * block.field_length;
+                        result_values[*tag] = SerializeVectorValueFromBuffer(block.data, value_offset, column_length, element_type);
+                    }
+                }
+                else
+                {
+                    // other records may have different length, deserialize the whole block from the newest record
+                    default_address_type value_offset = block.last_record_start_address;
+                    for (default_long_int position = 0; position < amount; position++)
+                    {
+                        default_long_int tag = first_tag + amount - 1 - position;
+                        Value* value = SerializeValueFromBuffer(value_type, block.data, value_offset);
+                        value_offset += value->GetValueLength();
+                        if (tags.count(tag) > 0)
+                        {
+                            result_values[tag] = value;
+                        }
+                        else
+                        {
+                            delete value;
+                        }
+                    }
+                }
+                lw->ReleaseReadingBlock(db->db_name, table->table_name, batch_addresses[i], block);
+            }
+        }
+    }
+
+    /**
+     * Find the blocks of the next tags by the directory entries of a column, at most SEARCH_BATCH_BLOCK_AMOUNT
+     * blocks, so they can be loaded together.
+     * 
+     * @param entries Directory entries of the column.
+     * @param next_tag The first tag to find, in increasing order. It is moved after the tags of found blocks.
+     * @param tags_end The end of tags.
+     * @param block_nos Positions of found blocks in entries.
+     * @param block_tags The first tag of each found block, and tags_end or the first tag of next block at last.
+     */
+    template <class TagIterator>
+    void FindTagBlocks(const vector<DirectoryEntry>& entries, TagIterator& next_tag, TagIterator tags_end, vector<default_long_int>& block_nos,
+        vector<TagIterator>& block_tags)
+    {
+        block_nos.clear();
+        block_tags.clear();
+        while (next_tag != tags_end && block_nos.size() < SEARCH_BATCH_BLOCK_AMOUNT)
+        {
+            default_long_int block_no = BlockDirectory::FindBlock(entries, *next_tag);
+            if (block_no == entries.size())
+            {
+                next_tag++;
+                continue;
+            }
+            block_nos.push_back(block_no);
+            block_tags.push_back(next_tag);
+            while (next_tag != tags_end && (block_no + 1 == entries.size() || *next_tag < entries[block_no + 1].first_tag))
+            {
+                next_tag++;
+            }
+        }
+        block_tags.push_back(next_tag);
+    }
+
+    /**
+     * Create a vector index on a vector column, build it from all records of the column, and store the index type
+     * into the table header. Supported types and parameters:
+     * HNSW: M, EF_CONSTRUCTION, EF_SEARCH.
+     * IVF_FLAT: NLIST, NPROBE, its posting lists are stored in blocks of a data file of their own. NPROBE is about
+     * the square root of NLIST by default, recall depends on it.
+     * PQ: M, NBITS, RERANK, codes are kept in memory.
+     * IVF_PQ: NLIST, NPROBE, M, NBITS, RERANK, its posting lists are stored like IVF_FLAT.
+     * M of PQ is the amount of sub codes, the dimension must be a multiple of it. NBITS is 8, or 4 to scan codes
+     * by the fast scan kernel.
+     * SQ8, SQ4: RERANK, each dimension is encoded in 8 or 4 bits, codes are kept in memory.
+     * DISKANN: R, L, BEAM, L_SEARCH, M, a vamana graph of max degree R built with candidate list L, its nodes are
+     * stored in blocks of a data file of their own, only pq codes of M bytes are kept in memory. A search reads
+     * BEAM nodes each step, with candidate list L_SEARCH.
+     * If RERANK > 1, RERANK * k candidates are searched by the index, then reranked by the exact distances of
+     * their records.
+     * 
+     * @param db The database of the table.
+     * @param sql The create index sql.
+     * @return The result of creating.
+     */
+    SqlResponse* CreateIndex(DB* db, CreateIndexSql* sql)
+    {
+        SqlResponse* response = new SqlResponse();
+        response->sql_state = FAILURE;
+
+        ColumnTable* table = nullptr;
+        if (!GetTable(*db, sql->table_name, table))
+        {
+            response->information = "Table " + sql->table_name + " not exists!";
+            return response;
+        }
+
+        // GetColumn can not tell a missing column, so check the name here
+        default_address_type column_offset = table->column_size;
+        for (default_amount_type i = 0; i < table->column_size; i++)
+        {
+            if (table->columns.column_name_array[i] == sql->col_name)
+            {
+                column_offset = i;
+                break;
+            }
+        }
+        if (column_offset == (default_address_type) table->column_size || GetEnumType(table->columns.column_type_array[column_offset]) != VECTOR_T)
+        {
+            response->information = "Column " + sql->col_name + " is not a vector column of table " + sql->table_name + "!";
+            return response;
+        }
+
+        IndexType index_type;
+        if (sql->index_type == "HNSW")
+        {
+            index_type = HNSW_INDEX;
+        }
+        else if (sql->index_type == "IVF_FLAT")
+        {
+            index_type = IVF_FLAT_INDEX;
+        }
+        else if (sql->index_type == "PQ")
+        {
+            index_type = PQ_INDEX;
+        }
+        else if (sql->index_type == "IVF_PQ")
+        {
+            index_type = IVF_PQ_INDEX;
+        }
+        else if (sql->index_type == "SQ8")
+        {
+            index_type = SQ8_INDEX;
+        }
+        else if (sql->index_type == "SQ4")
+        {
+            index_type = SQ4_INDEX;
+        }
+        else if (sql->index_type == "DISKANN")
+        {
+            index_type = DISKANN_INDEX;
+        }
+        else
+        {
+            response->information = "Index type " + sql->index_type + " is not supported!";
+            return response;
+        }
+        if (table->columns.column_index_type_array[column_offset] != NONE_INDEX)
+        {
+            response->information = "Column " + sql->col_name + " already has an index!";
+            return response;
+        }
+
+        map<string, int> parameters = GetDefaultIndexParameters(index_type);
+        for (const auto& parameter : sql->parameters)
+        {
+            if (parameters.find(parameter.first) == parameters.end())
+            {
+                response->information = "Unknown index parameter " + parameter.first + "!";
+                return response;
+            }
+            parameters[parameter.first] = parameter.second;
+        }
+        // without NPROBE, lists to scan follow NLIST
+        if ((index_type == IVF_FLAT_INDEX || index_type == IVF_PQ_INDEX) && sql->parameters.find("NPROBE") == sql->parameters.end())
+        {
+            parameters["NPROBE"] = IvfFlatIndex::GetDefaultNprobe(parameters["NLIST"]);
+        }
+
+        BasicIndex* index = nullptr;
+        try
+        {
+            index = NewVectorIndex(db, table, column_offset, index_type, parameters);
+            BuildVectorIndex(db, table, column_offset, index);
+        }
+        catch (const std::runtime_error& e)
+        {
+            delete index;
+            response->information = e.what();
+            return response;
+        }
+
+        vector_indexes_mutex.lock();
+        vector_indexes[GetVectorIndexKey(db, table, column_offset)] = index;
+        SaveVectorIndex(db, table, column_offset, index);
+        vector_indexes_mutex.unlock();
+
+        table->columns.column_index_type_array[column_offset] = index_type;
+        UpdateTableHeader(db, table);
+
+        response->sql_state = SUCCESS;
+        response->information = "Create index " + sql->index_name + " success!";
+        return response;
+    }
+
+    map<string, int> GetDefaultIndexParameters(IndexType index_type)
+    {
+        if (index_type == IVF_FLAT_INDEX)
+        {
+            return {{"NLIST", 128}, {"NPROBE", IvfFlatIndex::GetDefaultNprobe(128)}};
+        }
+        if (index_type == PQ_INDEX)
+        {
+            return {{"M", 8}, {"NBITS", 8}, {"RERANK", 0}};
+        }
+        if (index_type == IVF_PQ_INDEX)
+        {
+            return {{"NLIST", 128}, {"NPROBE", IvfFlatIndex::GetDefaultNprobe(128)}, {"M", 8}, {"NBITS", 8}, {"RERANK", 0}};
+        }
+        if (index_type == SQ8_INDEX || index_type == SQ4_INDEX)
+        {
+            return {{"RERANK", 0}};
+        }
+        if (index_type == DISKANN_INDEX)
+        {
+            return {{"R", 32}, {"L", 64}, {"BEAM", 4}, {"L_SEARCH", 100}, {"M", 8}};
+        }
+        return {{"M", 16}, {"EF_CONSTRUCTION", 200}, {"EF_SEARCH", 64}};
+    }
+
+    /**
+     * Create an empty vector index of a column.
+     * 
+     * @throws std::runtime_error If a parameter is wrong.
+     */
+    BasicIndex* NewVectorIndex(DB* db, ColumnTable* table, default_address_type column_offset, IndexType index_type, map<string, int>& parameters)
+    {
+        default_length_size dimension = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+
+        if (index_type == IVF_FLAT_INDEX)
+        {
+            // lists of table.column are stored in file table.column.ivf
+            string file_name = table->table_name + "." + table->columns.column_name_array[column_offset] + ".ivf";
+            return new IvfFlatIndex(dimension, element_type, parameters["NLIST"], parameters["NPROBE"], new BlockPostingListStore(lw, db->db_name, file_name));
+        }
+        if (index_type == PQ_INDEX)
+        {
+            return new PqIndex(dimension, element_type, parameters["M"], parameters["RERANK"], parameters["NBITS"]);
+        }
+        if (index_type == IVF_PQ_INDEX)
+        {
+            // lists of table.column are stored in file table.column.ivfpq
+            string file_name = table->table_name + "." + table->columns.column_name_array[column_offset] + ".ivfpq";
+            return new IvfPqIndex(dimension, element_type, parameters["NLIST"], parameters["NPROBE"], parameters["M"], parameters["RERANK"],
+                parameters["NBITS"], new BlockPostingListStore(lw, db->db_name, file_name));
+        }
+        if (index_type == SQ8_INDEX || index_type == SQ4_INDEX)
+        {
+            return new SqIndex(dimension, element_type, index_type == SQ8_INDEX ? 8 : 4, parameters["RERANK"]);
+        }
+        if (index_type == DISKANN_INDEX)
+        {
+            // nodes of table.column are stored in file table.column.diskann
+            string file_name = table->table_name + "." + table->columns.column_name_array[column_offset] + ".diskann";
+            return new DiskAnnIndex(dimension, element_type, parameters["R"], parameters["L"], parameters["BEAM"], parameters["L_SEARCH"],
+                parameters["M"], new BlockNodePageStore(lw, db->db_name, file_name));
+        }
+        return new HnswIndex(dimension, element_type, parameters["M"], parameters["EF_CONSTRUCTION"], parameters["EF_SEARCH"]);
+    }
+
+    /**
+     * Build a vector index from all records of a column. If the index needs training, records are sampled by one
+     * scan of the column first, then all records are added by another scan, and the index finishes building.
+     */
+    void BuildVectorIndex(DB* db, ColumnTable* table, default_address_type column_offset, BasicIndex* index)
+    {
+        default_length_size dimension = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+        default_length_size record_length = Value::GetVectorValueLength(dimension, element_type);
+
+        if (index->GetTrainingSampleAmount() > 0)
+        {
+            TrainingSampler sampler(dimension, element_type, index->GetTrainingSampleAmount());
+            ScanColumnRuns(db, table, column_offset, [&](const vector<VectorRun>& runs)
+            {
+                sampler.Offer(runs, record_length);
+            });
+            index->Train(sampler.GetSamples());
+        }
+
+        ScanColumnRuns(db, table, column_offset, [&](const vector<VectorRun>& runs)
+        {
+            index->Add(runs, record_length);
+        });
+        index->FinishBuild();
+    }
+
+    /**
+     * Save a vector index into the index file of its column, so it is loaded instead of rebuilt after restarting.
+     * Indexes not persisted by Save, or failing to write the file, are rebuilt as before. Holds vector_indexes_mutex.
+     */
+    void SaveVectorIndex(DB* db, ColumnTable* table, default_address_type column_offset, BasicIndex* index)
+    {
+        string file_path = lw->cal_url_util->GetIndexFile(db->db_name, table->table_name, table->columns.column_name_array[column_offset]);
+        try
+        {
+            if (index->Save(file_path))
+            {
+                vector_index_files[GetVectorIndexKey(db, table, column_offset)] = file_path;
+            }
+        }
+        catch (const std::runtime_error& e)
+        {
+            ReportIndexSaveFailure(file_path, e);
+        }
+    }
+
+    /**
+     * Report an index failing to be saved. The file is written by a temporary file and renamed, so the last saved
+     * file is kept whole, and records inserted after it are added again from the column when it is loaded.
+     */
+    void ReportIndexSaveFailure(const string& file_path, const std::runtime_error& e)
+    {
+        std::cerr << "Failed to save vector index " << file_path << ": " << e.what() << std::endl;
+    }
+
+    /**
+     * Load the index file of a column saved by SaveVectorIndex. Records added to the column after saving are
+     * found by a scan of the column, and added to the loaded index.
+     * 
+     * @return The index, or nullptr if the column has no index file fitting the column.
+     */
+    BasicIndex* LoadVectorIndex(DB* db, ColumnTable* table, default_address_type column_offset, IndexType index_type)
+    {
+        string file_path = lw->cal_url_util->GetIndexFile(db->db_name, table->table_name, table->columns.column_name_array[column_offset]);
+        if (index_type != HNSW_INDEX || !IndexFile::Exists(file_path))
+        {
+            return nullptr;
+        }
+        default_length_size dimension = table->columns.column_length_array[column_offset];
+        vector_element_type element_type = vector_element_type(table->columns.column_element_type_array[column_offset]);
+        default_length_size record_length = Value::GetVectorValueLength(dimension, element_type);
+
+        HnswIndex* index = nullptr;
+        default_long_int added_amount = 0;
+        try
+        {
+            default_long_int next_id;
+            index = HnswIndex::Load(file_path, next_id);
+            if (index->GetDimension() != dimension || index->GetElementType() != element_type)
+            {
+                delete index;
+                return nullptr;
+            }
+            ScanColumnRuns(db, table, column_offset, [&](const vector<VectorRun>& runs)
+            {
+                vector<VectorRun> new_runs;
+                for (const VectorRun& run : runs)
+                {
+                    for (default_long_int i = 0; i < run.amount; i++)
+                    {
+                        if (run.GetId(i) >= next_id)
+                        {
+                            new_runs.push_back(VectorRun{run.records + i * record_length, 1, run.GetId(i)});
+                        }
+                    }
+                }
+                index->Add(new_runs, record_length);
+                added_amount += new_runs.size();
+            });
+        }
+        catch (const std::runtime_error& e)
+        {
+            delete index;
+            return nullptr;
+        }
+
+        if (added_amount > 0)
+        {
+            SaveVectorIndex(db, table, column_offset, index);
+        }
+        vector_index_files[GetVectorIndexKey(db, table, column_offset)] = file_path;
+        return index;
+    }
+
+    /**
+     * Get the vector index of a column. If the column has an index but it is not in memory (such as after
+     * restarting), the index is loaded from its index file, or rebuilt from the records with default parameters.
+     * 
+     * @return The index, or nullptr if the column has no index.
+     */
+    BasicIndex* GetVectorIndex(DB* db, ColumnTable* table, default_address_type column_offset)
+    {
+        IndexType index_type = IndexType(table->columns.column_index_type_array[column_offset]);
+        if (index_type != HNSW_INDEX && index_type != IVF_FLAT_INDEX && index_type != PQ_INDEX && index_type != IVF_PQ_INDEX
+            && index_type != SQ8_INDEX && index_type != SQ4_INDEX && index_type != DISKANN_INDEX)
+        {
+            return nullptr;
+        }
+
+        string key = GetVectorIndexKey(db, table, column_offset);
+        std::lock_guard<std::mutex> lock(vector_indexes_mutex);
+        if (vector_indexes.find(key) == vector_indexes.end())
+        {
+            BasicIndex* index = LoadVectorIndex(db, table, column_offset, index_type);
+            if (index == nullptr)
+            {
+                map<string, int> parameters = GetDefaultIndexParameters(index_type);
+                try
+                {
+                    index = NewVectorIndex(db, table, column_offset, index_type, parameters);
+                    BuildVectorIndex(db, table, column_offset, index);
+                }
+                catch (const std::runtime_error& e)
+                {
+                    // search the column without index
+                    delete index;
+                    return nullptr;
+                }
+                SaveVectorIndex(db, table, column_offset, index);
+            }
+            vector_indexes[key] = index;
+        }
+        return vector_indexes[key];
+    }
+
+    /**
+     * Find the vector index of a column in memory, never rebuilds it.
+     * 
+     * @return The index, or nullptr if it is not in memory.
+     */
+    BasicIndex* FindVectorIndex(DB* db, ColumnTable* table, default_address_type column_offset)
+    {
+        std::lock_guard<std::mutex> lock(vector_indexes_mutex);
+        map<string, BasicIndex*>::iterator it = vector_indexes.find(GetVectorIndexKey(db, table, column_offset));
+        return it == vector_indexes.end() ? nullptr : it->second;
+    }
+
+    string GetVectorIndexKey(DB* db, ColumnTable* table, default_address_type column_offset)
+    {
+        return db->db_name + "." + table->table_name + "." + table->columns.column_name_array[column_offset];
+    }
+
+    /**
+     * Get the block directory of a table. If it is not in memory, it is loaded from its file, and blocks linked to
+     * a column after its last entry (such as the file is lost, or the table is created before directories) are
+     * found along the chain and added. Must not be called while holding a block of the table.
+     * 
+     * @return The directory, it stays valid while the returned pointer is kept, even if the table is re-created.
+     */
+    std::shared_ptr<TableDirectory> GetTableDirectory(DB* db, ColumnTable* table)
+    {
+        string key = db->db_name + "." + table->table_name;
+        {
+            std::lock_guard<std::mutex> lock(block_directories_mutex);
+            map<string, std::shared_ptr<TableDirectory> >::iterator it = block_directories.find(key);
+            if (it != block_directories.end())
+            {
+                return it->second;
+            }
+        }
+
+        // built without holding block_directories_mutex, the chains of a table without directory file are read
+        // through. No block is linked meanwhile, as inserts wait for the directory
+        BlockDirectory* directory = new BlockDirectory(lw->cal_url_util->GetBlockDirectoryFile(db->db_name, table->table_name), table->column_size);
+        directory->Load();
+        bool stale = false;
+        for (default_amount_type i = 0; i < table->column_size && !stale; i++)
+        {
+            // the file is left by another table of the same name
+            stale = directory->GetBlockAmount(i) > 0 && directory->GetEntries(i)[0].block_address != table->columns.column_storage_address_array[i];
+        }
+
+        vector<vector<DirectoryEntry> > missing_entries(table->column_size);
+        for (default_amount_type i = 0; i < table->column_size; i++)
+        {
+            DirectoryEntry entry{table->columns.column_storage_address_array[i], 0};
+            if (stale || directory->GetBlockAmount(i) == 0)
+            {
+                missing_entries[i].push_back(entry);
+            }
+            else
+            {
+                entry = directory->GetLastEntry(i);
+            }
+
+            bool has_next_block = true;
+            while (has_next_block)
+            {
+                DataBlock block;
+                lw->LoadBlockForRead(db->db_name, table->table_name, entry.block_address, block);
+                entry.first_tag += block.field_data_nums;
+                lw->ReleaseReadingBlock(db->db_name, table->table_name, entry.block_address, block);
+                has_next_block = block.next_block_pointer != 0x0;
+                entry.block_address = block.next_block_pointer;
+                if (has_next_block)
+                {
+                    missing_entries[i].push_back(entry);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(block_directories_mutex);
+        map<string, std::shared_ptr<TableDirectory> >::iterator it = block_directories.find(key);
+        if (it != block_directories.end())
+        {
+            // built by another thread meanwhile, its file is kept
+            delete directory;
+            return it->second;
+        }
+        if (stale)
+        {
+            directory->Reset();
+        }
+        for (default_amount_type i = 0; i < table->column_size; i++)
+        {
+            directory->Append(i, missing_entries[i]);
+        }
+        std::shared_ptr<TableDirectory> table_directory = std::make_shared<TableDirectory>(db->db_name, table->table_name, table->column_size, directory);
+        block_directories[key] = table_directory;
+        return table_directory;
+    }
+
+    // copy the directory entries of a column, see GetTableDirectory
+    vector<DirectoryEntry> GetDirectoryEntries(DB* db, ColumnTable* table, default_address_type column_offset)
+    {
+        return GetTableDirectory(db, table)->directory->GetEntries(column_offset);
+    }
+
+    /**
+     * Keep the last blocks of a table pinned for inserting, they are pinned when the table is not one of the
+     * PINNED_TAIL_TABLE_AMOUNT tables inserted into most recently, and those of the least recently inserted table
+     * are unpinned. Must not be called while holding a block of the table.
+     */
+    void KeepTailsPinned(const std::shared_ptr<TableDirectory>& table_directory)
+    {
+        std::shared_ptr<TableDirectory> unpinned_table;
+        {
+            std::lock_guard<std::mutex> lock(block_directories_mutex);
+            if (table_directory->retired)
+            {
+                return;
+            }
+            if (table_directory->keep_tails_pinned)
+            {
+                if (pinned_tail_tables.back() == table_directory)
+                {
+                    return;
+                }
+                pinned_tail_tables.remove(table_directory);
+                pinned_tail_tables.push_back(table_directory);
+                return;
+            }
+            table_directory->keep_tails_pinned = true;
+            pinned_tail_tables.push_back(table_directory);
+            if (pinned_tail_tables.size() > PINNED_TAIL_TABLE_AMOUNT)
+            {
+                unpinned_table = pinned_tail_tables.front();
+                unpinned_table->keep_tails_pinned = false;
+                pinned_tail_tables.pop_front();
+            }
+        }
+        if (unpinned_table != nullptr)
+        {
+            SyncTailPins(unpinned_table.get());
+        }
+        SyncTailPins(table_directory.get());
+    }
+
+    /**
+     * Pin or unpin the last block of each column of a table, as the table keeps them pinned or not. Called after
+     * changing keep_tails_pinned, the last call sees the last change. The last block is held while its pin changes,
+     * and an insert linking a new block holds it for writing, so the pin is moved to the new block by the insert.
+     */
+    void SyncTailPins(TableDirectory* table_directory)
+    {
+        std::lock_guard<std::mutex> tails_lock(table_directory->tails_mutex);
+        bool keep_tails_pinned;
+        {
+            std::lock_guard<std::mutex> lock(block_directories_mutex);
+            keep_tails_pinned = table_directory->keep_tails_pinned;
+        }
+
+        for (default_amount_type i = 0; i < table_directory->column_size; i++)
+        {
+            if (table_directory->tails_pinned[i] == keep_tails_pinned)
+            {
+                continue;
+            }
+
+            // a block may be linked after the last entry before it is held, follow the chain to the last block
+            DataBlock block;
+            default_address_type block_address = table_directory->directory->GetLastEntry(i).block_address;
+            lw->LoadBlockForRead(table_directory->db_name, table_directory->table_name, block_address, block);
+            while (block.next_block_pointer != 0x0)
+            {
+                default_address_type next_block_address = block.next_block_pointer;
+                lw->ReleaseReadingBlock(table_directory->db_name, table_directory->table_name, block_address, block);
+                block_address = next_block_address;
+                lw->LoadBlockForRead(table_directory->db_name, table_directory->table_name, block_address, block);
+            }
+
+            if (keep_tails_pinned)
+            {
+                lw->PinBlock(table_directory->db_name, table_directory->table_name, block_address);
+            }
+            else
+            {
+                lw->UnpinBlock(table_directory->db_name, table_directory->table_name, block_address);
+            }
+            table_directory->tails_pinned[i] = keep_tails_pinned;
+            lw->ReleaseReadingBlock(table_directory->db_name, table_directory->table_name, block_address, block);
+        }
+    }
+
+    // unpin the last blocks of a table and never pin them again, the directory is deleted after the inserts using it
+    void RetireTableDirectory(const std::shared_ptr<TableDirectory>& table_directory)
+    {
+        {
+            std::lock_guard<std::mutex> lock(block_directories_mutex);
+            table_directory->retired = true;
+            if (table_directory->keep_tails_pinned)
+            {
+                table_directory->keep_tails_pinned = false;
+                pinned_tail_tables.remove(table_directory);
+            }
+        }
+        SyncTailPins(table_directory.get());
     }
 
     void SameColAndOp(vector<value_tag*>& left_vector, vector<value_tag*>& right_vector, vector<value_tag*>& result)
@@ -1272,6 +2412,8 @@ public:
      * 
      * This function checks if the table and column exist, checks the value type,
      * and then inserts the value into the corresponding data block.
+     * The value is appended to the last block of the column, found by the block directory, so only that block
+     * is locked, and it is pinned in buffer pool, so it is not read from disk again.
      * 
      * @param db The database object.
      * @param table_name The name of the table to insert into.
@@ -1299,19 +2441,31 @@ public:
             return;
         }
 
+        // Get the directory and pin the last blocks before holding any block, they may be loaded along the chains.
+        // The directory is kept until the insert returns, even if the table is re-created meanwhile
+        std::shared_ptr<TableDirectory> table_directory = GetTableDirectory(&db, table);
+        KeepTailsPinned(table_directory);
+        BlockDirectory* directory = table_directory->directory;
+
         // Serialize the value into a char array
         default_length_size data_size = insert_value->GetValueLength();
         char* value_c = new char[data_size];
         insert_value->Serialize(value_c, 0);
 
-        // Open the data block for the column
+        // Open the last block of the column directly, it is found by the directory and pinned in buffer pool
         DataBlock* data_block = new DataBlock();
-        default_address_type read_offset = table->columns.column_storage_address_array[column_offset];
+        DirectoryEntry last_entry = directory->GetLastEntry(column_offset);
+        default_address_type read_offset = last_entry.block_address;
         lw->LoadBlockForWrite(db.db_name, table->table_name, read_offset, *data_block);
 
-        // Find the last block in the chain
+        // Tag of the inserted record is the amount of records before it
+        default_long_int record_tag = last_entry.first_tag;
+
+        // Another insert may link a new block after it before it is locked, follow the chain to the last block
         while (data_block->next_block_pointer != 0x0)
         {
+            record_tag += data_block->field_data_nums;
+
             // Cache the next block offset
             default_address_type cached_next_block_offset = data_block->next_block_pointer;
 
@@ -1324,33 +2478,51 @@ public:
         }
 
         // Check if the block has enough space for the new value
-        if (!data_block->HaveSpace(data_size))
+        if (data_block->HaveSpace(data_size))
+        {
+            // Insert the value into the block and write the block back to disk
+            data_block->InsertData(value_c, data_size);
+            record_tag += data_block->field_data_nums - 1;
+            lw->ReleaseWritingBlock(db.db_name, table->table_name, read_offset, *data_block);
+        }
+        else
         {
-            // Create a new block if the current block is full
-            DataBlock* new_data_block = new DataBlock();
-            default_address_type new_block_offset = lw->CreateNewBlock(db.db_name, table_name, *new_data_block);
+            // Create a new block if the current block is full, and insert the value into it
+            DataBlock new_data_block;
+            default_address_type new_block_offset = lw->CreateNewBlock(db.db_name, table_name, new_data_block);
             if (table->columns.column_type_array[column_offset] == VCHAR)
             {
-                new_data_block->InitBlock(0);
+                new_data_block.InitBlock(0);
             }
             else
             {
-                new_data_block->InitBlock(data_size);
+                new_data_block.InitBlock(data_size);
             }
-            
-            // Update the last block to point to the new block
+            new_data_block.InsertData(value_c, data_size);
+            record_tag += data_block->field_data_nums;
+
+            // Write the new block, it is pinned until it is linked as the last block of column
+            lw->PinBlock(db.db_name, table->table_name, new_block_offset);
+            lw->ReleaseWritingBlock(db.db_name, table->table_name, new_block_offset, new_data_block);
+
+            // Link and write the old last block while holding it, then add the new block to the directory, so the
+            // directory never names a block not on disk or not in the chain, and blocks of a column are added in order
             data_block->next_block_pointer = new_block_offset;
+            lw->FlushWritingBlock(db.db_name, table->table_name, read_offset, *data_block);
+            directory->Append(column_offset, new_block_offset, record_tag);
+
+            // The new last block keeps its pin if the last block of column is pinned, the old one drops it
+            bool tail_pinned = table_directory->tails_pinned[column_offset];
+            lw->UnpinBlock(db.db_name, table->table_name, tail_pinned ? read_offset : new_block_offset);
             lw->ReleaseWritingBlock(db.db_name, table->table_name, read_offset, *data_block);
-            delete data_block;
-            data_block = new_data_block;
-            read_offset = new_block_offset;
         }
 
-        // Insert the value into the block
-        data_block->InsertData(value_c, data_size);
-
-        // Write the block back to disk
-        lw->ReleaseWritingBlock(db.db_name, table->table_name, read_offset, *data_block);
+        // Keep the vector index in memory up to date, the index is rebuilt with all records if not in memory
+        BasicIndex* vector_index = FindVectorIndex(&db, table, column_offset);
+        if (vector_index != nullptr)
+        {
+            vector_index->Add(vector<VectorRun>{VectorRun{value_c, 1, record_tag}}, data_size);
+        }
 
         // Clean up
         delete data_block;
@@ -1381,7 +2553,15 @@ public:
 
             // Create a new data block for the column
             default_address_type new_data_block_address = lw->CreateNewBlock(db->db_name, table->table_name, data_block);
-            data_block.InitBlock(0);
+            if (table->columns.column_type_array[i] == VECTOR_T)
+            {
+                // vector records have fixed length
+                data_block.InitBlock(Value::GetVectorValueLength(table->columns.column_length_array[i], vector_element_type(table->columns.column_element_type_array[i])));
+            }
+            else
+            {
+                data_block.InitBlock(0);
+            }
 
             // Write the data block to disk
             lw->ReleaseWritingBlock(db->db_name, table->table_name, new_data_block_address, data_block);
@@ -1430,9 +2610,67 @@ public:
         lw->ReleaseWritingBlock(db->db_name, DEFAULT_TABLE_NAME, block_offset, *block);
         delete block;
 
+        // Store the first blocks of columns into the block directory of table, next to the table header file
+        BlockDirectory* directory = new BlockDirectory(lw->cal_url_util->GetBlockDirectoryFile(db->db_name, table->table_name), table->column_size);
+        directory->Reset();
+        for (default_amount_type i = 0; i < table->column_size; i++)
+        {
+            directory->Append(i, table->columns.column_storage_address_array[i], 0);
+        }
+        // The last blocks are pinned by the first insert
+        std::shared_ptr<TableDirectory> replaced_directory;
+        block_directories_mutex.lock();
+        string key = db->db_name + "." + table->table_name;
+        if (block_directories.find(key) != block_directories.end())
+        {
+            replaced_directory = block_directories[key];
+        }
+        block_directories[key] = std::make_shared<TableDirectory>(db->db_name, table->table_name, table->column_size, directory);
+        block_directories_mutex.unlock();
+        if (replaced_directory != nullptr)
+        {
+            RetireTableDirectory(replaced_directory);
+        }
+
         sql_response->sql_state = SUCCESS;
     }
     
+    /**
+     * Write a changed table header back to the table header file, the header must keep its length, such as
+     * changing the index type of a column.
+     * 
+     * @param db The database object.
+     * @param table The changed table, found by its name in the table header file.
+     */
+    void UpdateTableHeader(DB* db, ColumnTable* table)
+    {
+        TableBlock block;
+        default_address_type block_offset = 0;
+        while (true)
+        {
+            lw->LoadBlockForWrite(db->db_name, DEFAULT_TABLE_NAME, block_offset, block);
+            for (default_amount_type i = 0; i < block.table_amount; i++)
+            {
+                ColumnTable stored_table;
+                stored_table.Deserialize(block.data, block.tables_begin_address[i]);
+                if (stored_table.table_name == table->table_name)
+                {
+                    table->Serialize(block.data, block.tables_begin_address[i]);
+                    lw->ReleaseWritingBlock(db->db_name, DEFAULT_TABLE_NAME, block_offset, block);
+                    return;
+                }
+            }
+
+            default_address_type cached_next_block = block.next_block_pointer;
+            lw->ReleaseWritingBlock(db->db_name, DEFAULT_TABLE_NAME, block_offset, block);
+            if (cached_next_block == 0x0)
+            {
+                return;
+            }
+            block_offset = cached_next_block;
+        }
+    }
+
     /**
      * Retrieves a table from the database by name.
      * 
@@ -1608,16 +2846,20 @@ public:
         {   
             if (ct.columns.column_name_array[i] == column_name)
             {   
-                column.column_name_array = new string[0];
+                column.column_name_array = new string[1];
                 column.column_name_array[0] = ct.columns.column_name_array[i];
-                column.column_type_array = new default_enum_type[0];
+                column.column_type_array = new default_enum_type[1];
                 column.column_type_array[0] = ct.columns.column_type_array[i];
-                column.column_length_array = new default_length_size[0];
+                column.column_length_array = new default_length_size[1];
                 column.column_length_array[0] = ct.columns.column_length_array[i];
-                column.column_index_type_array = new default_enum_type[0];
+                column.column_index_type_array = new default_enum_type[1];
                 column.column_index_type_array[0] = ct.columns.column_index_type_array[i];
-                column.column_storage_address_array = new default_address_type[0];
+                column.column_storage_address_array = new default_address_type[1];
                 column.column_storage_address_array[0] = ct.columns.column_storage_address_array[i];
+                column.column_option_array = new default_enum_type[1];
+                column.column_option_array[0] = ct.columns.column_option_array[i];
+                column.column_element_type_array = new default_enum_type[1];
+                column.column_element_type_array[0] = ct.columns.column_element_type_array[i];
                 return true;
             }
             
@@ -1635,6 +2877,32 @@ public:
         lw = new LockWatcher(SLOT_AMOUNT);
         lcm = LogCentralManagement::GetInstance();
     }
+
+    ~Operator()
+    {
+        for (auto& index : vector_indexes)
+        {
+            // save records inserted since the last save, so they are not added again after restarting
+            map<string, string>::iterator file = vector_index_files.find(index.first);
+            if (file != vector_index_files.end())
+            {
+                try
+                {
+                    index.second->Save(file->second);
+                }
+                catch (const std::runtime_error& e)
+                {
+                    ReportIndexSaveFailure(file->second, e);
+                }
+            }
+            delete index.second;
+        }
+        for (auto& directory : block_directories)
+        {
+            RetireTableDirectory(directory.second);
+        }
+        block_directories.clear();
+    }
     
     // store a db object to file
     void SerializeDBFile(DB& db, string file_path)
@@ -65,6 +65,22 @@ public:
             return response;
         }
         
+        // distance less than a radius, search all records in range
+        if (!sql->range_column.empty())
+        {
+            response = SelectRange(db, table, sql);
+            delete sql;
+            return response;
+        }
+
+        // order by distance, search the nearest records
+        if (!sql->order_column.empty())
+        {
+            response = SelectNearest(db, table, sql);
+            delete sql;
+            return response;
+        }
+
         // execute select
         vector<Row*> result;
         // select all
@@ -101,6 +117,317 @@ public:
         return response;
     }
 
+    /**
+     * Select the k records nearest to the query vector, such as: SELECT id FROM t ORDER BY emb <-> [..] LIMIT k;
+     * Records are ordered by euclidean distance, which is appended as the last column of the result.
+     * A batch of query vectors is searched together, such as: SELECT id FROM t ORDER BY emb <-> [[..], [..]] LIMIT k;
+     * the k records of each query follow each other, and the number of query is prepended as the first column.
+     * Conditions joined by AND restrict the search to the records passing all of them, such as:
+     * SELECT id FROM t WHERE category = 3 ORDER BY emb <-> [..] LIMIT k;
+     * @todo not support OR condition with ORDER BY distance now!
+     * @param db: a pointer to the database object
+     * @param table: the table to select from
+     * @param sql: the SELECT statement, which has order_column, order_vector and limit
+     * @return a pointer to a SqlResponse object containing the result of the query
+     */
+    SqlResponse* SelectNearest(DB* db, ColumnTable* table, SelectFromOneTableSql* sql)
+    {
+        SqlResponse* response = new SqlResponse();
+        response->sql_state = FAILURE;
+
+        for (const Operation& operation : sql->operation_vector)
+        {
+            if (operation.opreator == OR)
+            {
+                response->information = "OR condition can not be used with ORDER BY distance now!";
+                return response;
+            }
+        }
+
+        // order column must be a vector column
+        default_address_type order_offset;
+        if (!FindColumnOffset(table, sql->order_column, order_offset) || GetEnumType(table->columns.column_type_array[order_offset]) != VECTOR_T)
+        {
+            response->information = "Order column " + sql->order_column + " is not a vector column!";
+            return response;
+        }
+
+        // selected columns
+        vector<Column> columns;
+        if (sql->columns.size() == 1 && sql->columns[0].col_name == "*")
+        {
+            BuildAllCols(table, columns);
+        }
+        else if (op->CheckColsExists(table, sql->columns))
+        {
+            columns = sql->columns;
+        }
+        else
+        {
+            response->information = "Select column not exist!";
+            return response;
+        }
+
+        // parse query vectors as the order column, normalized if the column is normalized
+        default_length_size dimension = table->columns.column_length_array[order_offset];
+        bool normalize = (table->columns.column_option_array[order_offset] & COLUMN_OPTION_NORMALIZE) != 0;
+        vector<string> query_literals = sql->order_vectors.empty() ? vector<string>{sql->order_vector} : sql->order_vectors;
+        vector<vector<double> > queries;
+        for (const string& query_literal : query_literals)
+        {
+            Value query_value(query_literal);
+            if (!query_value.InitVectorValue(dimension, ELEMENT_FP64, normalize))
+            {
+                response->information = "Query vector can not be parsed, or its dimension is not " + std::to_string(dimension);
+                return response;
+            }
+            queries.emplace_back(dimension);
+            query_value.GetVectorValue(queries.back().data());
+        }
+
+        // tags of the records passing all conditions
+        TagBitmap filter;
+        if (!sql->compare_vector.empty() && !BuildConditionFilter(db, table, sql->compare_vector, filter, response->information))
+        {
+            return response;
+        }
+        const TagBitmap* search_filter = sql->compare_vector.empty() ? nullptr : &filter;
+
+        if (sql->order_vectors.empty())
+        {
+            vector<SearchResult> nearest = op->NearestSearch(db, table, order_offset, queries[0].data(), sql->limit, search_filter);
+
+            response->sql_state = SqlState::SUCCESS;
+            response->information = SerializeRowsHeader(columns) + "distance | ";
+            response->information += "\n";
+            response->information += SerializeSearchResults(db, table, columns, nearest);
+            return response;
+        }
+
+        // a batch of queries, the first column of results is the number of query, from 0
+        vector<vector<SearchResult> > batch_nearest = op->BatchNearestSearch(db, table, order_offset, queries, sql->limit, search_filter);
+        response->sql_state = SqlState::SUCCESS;
+        response->information = "| query " + SerializeRowsHeader(columns) + "distance | ";
+        response->information += "\n";
+        for (size_t i = 0; i < batch_nearest.size(); i++)
+        {
+            response->information += SerializeSearchResults(db, table, columns, batch_nearest[i], i);
+        }
+
+        return response;
+    }
+
+    /**
+     * Select all records nearer to the query vector than a radius, such as:
+     * SELECT id FROM t WHERE DISTANCE(emb, [..]) < 0.5;
+     * Euclidean distance is appended as the last column of the result. Records are not ordered, they are serialized
+     * by batches of RANGE_SEARCH_BATCH_SIZE while searching, so the search does not keep all results in memory.
+     * Conditions joined by AND behind the range condition restrict the search like SelectNearest.
+     * @todo not support OR condition and ORDER BY with a range condition now!
+     * @param db: a pointer to the database object
+     * @param table: the table to select from
+     * @param sql: the SELECT statement, which has range_column, range_vector and range_radius
+     * @return a pointer to a SqlResponse object containing the result of the query
+     */
+    SqlResponse* SelectRange(DB* db, ColumnTable* table, SelectFromOneTableSql* sql)
+    {
+        SqlResponse* response = new SqlResponse();
+        response->sql_state = FAILURE;
+
+        if (!sql->order_column.empty())
+        {
+            response->information = "ORDER BY can not be used with DISTANCE condition now!";
+            return response;
+        }
+        for (const Operation& operation : sql->operation_vector)
+        {
+            if (operation.opreator == OR)
+            {
+                response->information = "OR condition can not be used with DISTANCE condition now!";
+                return response;
+            }
+        }
+
+        // range column must be a vector column
+        default_address_type range_offset;
+        if (!FindColumnOffset(table, sql->range_column, range_offset) || GetEnumType(table->columns.column_type_array[range_offset]) != VECTOR_T)
+        {
+            response->information = "Distance column " + sql->range_column + " is not a vector column!";
+            return response;
+        }
+
+        // selected columns
+        vector<Column> columns;
+        if (sql->columns.size() == 1 && sql->columns[0].col_name == "*")
+        {
+            BuildAllCols(table, columns);
+        }
+        else if (op->CheckColsExists(table, sql->columns))
+        {
+            columns = sql->columns;
+        }
+        else
+        {
+            response->information = "Select column not exist!";
+            return response;
+        }
+
+        // parse query vector as the range column, normalized if the column is normalized
+        default_length_size dimension = table->columns.column_length_array[range_offset];
+        bool normalize = (table->columns.column_option_array[range_offset] & COLUMN_OPTION_NORMALIZE) != 0;
+        Value query_value(sql->range_vector);
+        if (!query_value.InitVectorValue(dimension, ELEMENT_FP64, normalize))
+        {
+            response->information = "Query vector can not be parsed, or its dimension is not " + std::to_string(dimension);
+            return response;
+        }
+        vector<double> query(dimension);
+        query_value.GetVectorValue(query.data());
+
+        // tags of the records passing all conditions
+        TagBitmap filter;
+        if (!sql->compare_vector.empty() && !BuildConditionFilter(db, table, sql->compare_vector, filter, response->information))
+        {
+            return response;
+        }
+
+        // serialize each batch of results once it is found
+        string records_data;
+        RangeCollector collector(sql->range_radius, [&](const vector<SearchResult>& batch)
+        {
+            records_data += SerializeSearchResults(db, table, columns, batch);
+        }, sql->compare_vector.empty() ? nullptr : &filter);
+        op->RangeSearch(db, table, range_offset, query.data(), collector);
+
+        response->sql_state = SqlState::SUCCESS;
+        response->information = SerializeRowsHeader(columns) + "distance | ";
+        response->information += "\n";
+        response->information += records_data;
+
+        return response;
+    }
+
+    /**
+     * Load the selected values of the records found by a vector search, and serialize them in the order of results,
+     * the last value of each row is distance.
+     * @param results: results of the search, the id of a result is the tag of its record.
+     * @param query_no: number of the query in a batch, which is the first value of each row, -1 if not a batch.
+     * @return a string representing the serialized rows
+     */
+    string SerializeSearchResults(DB* db, ColumnTable* table, const vector<Column>& columns, const vector<SearchResult>& results, int query_no = -1)
+    {
+        set<default_long_int> tags;
+        for (const SearchResult& item : results)
+        {
+            tags.insert(item.id);
+        }
+        vector<map<default_long_int, Value*> > cols_values(columns.size());
+        for (size_t i = 0; i < columns.size(); i++)
+        {
+            default_address_type column_offset;
+            FindColumnOffset(table, columns[i].col_name, column_offset);
+            op->LoadValuesByTags(db, table, column_offset, tags, cols_values[i]);
+        }
+
+        vector<Row*> rows;
+        vector<Value*> distances;
+        Value query_value(query_no);
+        for (const SearchResult& item : results)
+        {
+            Row* row = new Row(item.id, {});
+            if (query_no >= 0)
+            {
+                row->values.push_back(&query_value);
+            }
+            for (auto& col_values : cols_values)
+            {
+                row->values.push_back(col_values[item.id]);
+            }
+            distances.push_back(new Value((float) item.distance));
+            row->values.push_back(distances.back());
+            rows.push_back(row);
+        }
+        string records_data = SerializeData(rows);
+
+        // free memory
+        for (auto& col_values : cols_values)
+        {
+            for (auto& item : col_values)
+            {
+                delete item.second;
+            }
+        }
+        for (Value* distance : distances)
+        {
+            delete distance;
+        }
+        for (Row* row : rows)
+        {
+            delete row;
+        }
+        return records_data;
+    }
+
+    /**
+     * Build the bitmap of tags of the records passing all conditions, each condition is checked by one scan of
+     * its column.
+     * @param information set to the reason if a condition is wrong.
+     * @return True if the bitmap is built, false if a condition column does not exist or can not be compared.
+     */
+    bool BuildConditionFilter(DB* db, ColumnTable* table, vector<CompareCondition>& conditions, TagBitmap& filter, string& information)
+    {
+        for (size_t i = 0; i < conditions.size(); i++)
+        {
+            default_address_type column_offset;
+            if (!FindColumnOffset(table, conditions[i].col.col_name, column_offset))
+            {
+                information = "Condition column not exist!";
+                return false;
+            }
+            ValueType value_type = GetEnumType(table->columns.column_type_array[column_offset]);
+            if (value_type == VECTOR_T)
+            {
+                information = "Condition column " + conditions[i].col.col_name + " can not be a vector column!";
+                return false;
+            }
+
+            Value compare_value(conditions[i].compare_value);
+            if (!compare_value.InitValue(value_type))
+            {
+                information = "Condition value " + conditions[i].compare_value + " can not be compared with column " + conditions[i].col.col_name + "!";
+                return false;
+            }
+            TagBitmap condition_tags;
+            op->FilterTags(db, table, column_offset, conditions[i].condition, &compare_value, condition_tags);
+            if (i == 0)
+            {
+                filter = condition_tags;
+            }
+            else
+            {
+                filter.IntersectWith(condition_tags);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Find the offset of a column in table by its name.
+     * @return True if the column is found, false otherwise.
+     */
+    bool FindColumnOffset(ColumnTable* table, string col_name, default_address_type& column_offset)
+    {
+        for (default_amount_type i = 0; i < table->column_size; i++)
+        {
+            if (table->columns.column_name_array[i] == col_name)
+            {
+                column_offset = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
     /**
      * Get the value type of a column based on its name.
      * 
@@ -14,6 +14,7 @@
 #include <sstream>
 
 #include "../../meta/value.h"
+#include "../../meta/element_type.h"
 #include "../../config.h"
 #include "../sql_struct.h"
 
@@ -53,40 +54,65 @@ public:
         // example sql : 
         // CREATE TABLE table_name ;
         // CREATE TABLE table_name (col_name1 col_type , col_name2 col_type2 ... );
+        // vector column type : VECTOR(length) , VECTOR(length, element_type) , and both can be followed by NORMALIZE
 
         // set table_name;
         table_name = tokens[2].value;
 
         // deserialize column data
-        Column* cache_column = nullptr;
-        for (int i = 4; i < tokens.size(); i++)
+        int token_flag = 4;
+        while (token_flag < tokens.size())
         {
             // if find ), then break
-            if (tokens[i].type == TokenType::OPERATOR_T && tokens[i].value == ")")
+            if (tokens[token_flag].type == TokenType::OPERATOR_T && tokens[token_flag].value == ")")
             {
                 break;
             }
             // skip ,
-            if (tokens[i].type == TokenType::OPERATOR_T && tokens[i].value == ",")
+            if (tokens[token_flag].type == TokenType::OPERATOR_T && tokens[token_flag].value == ",")
             {
+                token_flag++;
                 continue;
             }
-            // build one new column object, and set it's col_name, value_type and col_length
-            if (cache_column == nullptr)
-            {   
-                // first value is col_name
-                cache_column = new Column();
-                cache_column->col_name = tokens[i].value;
+
+            // build one new column object, first value is col_name, second value is value_type
+            Column column;
+            column.col_name = tokens[token_flag].value;
+            column.value_type = GetValueTypeFromStr(tokens[token_flag + 1].value);
+            token_flag += 2;
+
+            if (column.value_type != VECTOR_T)
+            {
+                column.col_length = GetValueTypeLength(column.value_type);
+                columns.push_back(column);
+                continue;
             }
-            else
+
+            // ( length
+            column.col_length = std::stoi(tokens[token_flag + 1].value);
+            token_flag += 2;
+
+            // , element_type
+            if (tokens[token_flag].type == TokenType::OPERATOR_T && tokens[token_flag].value == ",")
             {
-                // second value is value_type
-                cache_column->value_type = GetValueTypeFromStr(tokens[i].value);
-                columns.push_back(*cache_column);
+                if (!ElementTypeUtil::GetElementTypeFromStr(tokens[token_flag + 1].value, column.element_type))
+                {
+                    throw std::runtime_error("Sql wrong, unknown vector element type: " + tokens[token_flag + 1].value);
+                }
+                token_flag += 2;
+            }
 
-                // then set pointer to null, means the next column will begin
-                cache_column = nullptr;
+            // skip )
+            token_flag++;
+
+            // NORMALIZE
+            if (token_flag < tokens.size() && tokens[token_flag].type == TokenType::KEYWORD_T && tokens[token_flag].value == "NORMALIZE")
+            {
+                column.option |= COLUMN_OPTION_NORMALIZE;
+                token_flag++;
             }
+
+            columns.push_back(column);
         }
     }
 };
@@ -164,6 +190,13 @@ public:
     // map<string, Column*> column_map;
     vector<CompareCondition> compare_vector;
     vector<Operation> operation_vector;
+    string order_column;            // vector column of ORDER BY col <-> [..], empty if not order by distance
+    string order_vector;            // raw vector literal, parsed when the column is known
+    vector<string> order_vectors;   // raw vector literals of a batch of queries ORDER BY col <-> [[..], [..]], empty if only one query
+    default_long_int limit = 0;     // k of LIMIT k
+    string range_column;            // vector column of WHERE DISTANCE(col, [..]) < r, empty if not a range search
+    string range_vector;            // raw vector literal, parsed when the column is known
+    double range_radius = 0;        // r of DISTANCE(col, [..]) < r
 
 public:
     // extract information from tokens
@@ -171,6 +204,9 @@ public:
     {
         // SELECT * FROM table1;
         // SELECT a, b FROM table1 where c > 0 AND d = 1;
+        // SELECT a, b FROM table1 ORDER BY emb <-> [0.1, 0.2] LIMIT 10;
+        // SELECT a, b FROM table1 ORDER BY emb <-> [[0.1, 0.2], [0.3, 0.4]] LIMIT 10;
+        // SELECT a, b FROM table1 WHERE DISTANCE(emb, [0.1, 0.2]) < 0.5 AND c > 0;
 
         // set select col, begin from offset 1
         int token_flag = 1;
@@ -226,6 +262,54 @@ public:
                 break;
             }
 
+            // try match 9 tokens one time: WHERE DISTANCE ( col_name , vector ) < radius
+            if (
+                tokens[token_flag].value == "WHERE"
+                && token_flag + 8 < tokens.size()
+                && tokens[token_flag + 1].type == KEYWORD_T && tokens[token_flag + 1].value == "DISTANCE"
+                && tokens[token_flag + 2].value == "("
+                && tokens[token_flag + 3].type == IDENTIFIER_T
+                && tokens[token_flag + 4].value == ","
+                && tokens[token_flag + 5].type == VECTOR_LITERAL_T
+                && tokens[token_flag + 6].value == ")"
+                && tokens[token_flag + 7].value == "<"
+                && tokens[token_flag + 8].type == NUMBER_T
+                )
+            {
+                range_radius = std::stod(tokens[token_flag + 8].value);
+                if (range_radius <= 0)
+                {
+                    throw std::runtime_error("Sql wrong, radius of DISTANCE must be positive");
+                }
+                range_column = tokens[token_flag + 3].value;
+                range_vector = tokens[token_flag + 5].value;
+
+                token_flag += 9;
+                continue;
+            }
+
+            // try match 4 tokens one time behind a range condition: AND col_name comparator value, as the first condition
+            if (
+                !range_column.empty() && pre_compare == nullptr && pre_op == nullptr
+                && tokens[token_flag].value == "AND"
+                && tokens[token_flag + 1].type == IDENTIFIER_T 
+                && tokens[token_flag + 2].type == OPERATOR_T 
+                && (tokens[token_flag + 3].type == NUMBER_T || tokens[token_flag + 3].type == STRING_T)
+                ) 
+            {
+                CompareCondition new_compare;
+                Column compare_column; compare_column.col_name = tokens[token_flag + 1].value;
+                new_compare.col = std::move(compare_column);
+                new_compare.condition = SwitchComparator(tokens[token_flag + 2].value);
+                new_compare.compare_value = tokens[token_flag + 3].value;
+
+                compare_vector.push_back(std::move(new_compare));
+                pre_compare = &new_compare;
+
+                token_flag += 4;
+                continue;
+            }
+
             // try match 4/5 tokens one time: "AND"/"OR" col_name comparator value
             if (tokens[token_flag].type == TokenType::KEYWORD_T && (tokens[token_flag].value == "AND" || tokens[token_flag].value == "OR"))
             {
@@ -342,6 +426,34 @@ public:
                 continue;
             }
 
+            // try match 9 tokens one time: ORDER BY col_name < - > vector LIMIT k
+            if (
+                tokens[token_flag].value == "ORDER"
+                && token_flag + 8 < tokens.size()
+                && tokens[token_flag + 1].value == "BY"
+                && tokens[token_flag + 2].type == IDENTIFIER_T 
+                && tokens[token_flag + 3].value + tokens[token_flag + 4].value + tokens[token_flag + 5].value == "<->"
+                && tokens[token_flag + 6].type == VECTOR_LITERAL_T
+                && tokens[token_flag + 7].value == "LIMIT"
+                && tokens[token_flag + 8].type == NUMBER_T
+                )
+            {
+                if (tokens[token_flag + 8].value.find('.') != string::npos || std::stoll(tokens[token_flag + 8].value) <= 0)
+                {
+                    throw std::runtime_error("Sql wrong, LIMIT must be a positive integer");
+                }
+                order_column = tokens[token_flag + 2].value;
+                order_vector = tokens[token_flag + 6].value;
+                limit = std::stoll(tokens[token_flag + 8].value);
+                if (!SplitVectorBatch(order_vector, order_vectors))
+                {
+                    throw std::runtime_error("Sql wrong, query vectors of a batch must be like [[..], [..]]");
+                }
+
+                token_flag += 9;
+                continue;
+            }
+
             // can not match any type of condition, break
             break;
         }
@@ -352,6 +464,45 @@ public:
             throw std::runtime_error("Sql wrong, not end with ; or can not be parsed");
         }   
     }
+
+private:
+    /**
+     * Split a batch literal [[..], [..]] into the literals of its vectors, a literal of one vector keeps vectors empty.
+     * @return false if the literal is a batch but not made of vector literals split by ','.
+     */
+    static bool SplitVectorBatch(const string& literal, vector<string>& vectors)
+    {
+        size_t first = literal.find_first_not_of(" \t\n", 1);
+        if (first == string::npos || literal[first] != '[')
+        {
+            return true;
+        }
+        bool need_vector = true;
+        for (size_t i = 1; i + 1 < literal.size(); i++)
+        {
+            char c = literal[i];
+            if (isspace(c))
+            {
+                continue;
+            }
+            if (need_vector && c == '[')
+            {
+                size_t end = literal.find(']', i);
+                vectors.push_back(literal.substr(i, end - i + 1));
+                i = end;
+                need_vector = false;
+            }
+            else if (!need_vector && c == ',')
+            {
+                need_vector = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !need_vector;
+    }
 };
 // TODO:Select using join
 // struct SelectFromTableWithJoinSql
@@ -370,6 +521,78 @@ public:
     }
 };
 
+// CREATE INDEX index_name ON table_name (col_name) USING HNSW;
+// CREATE INDEX index_name ON table_name (col_name) USING HNSW WITH (M = 16, EF_CONSTRUCTION = 200, EF_SEARCH = 64);
+class CreateIndexSql
+{
+public:
+    string index_name;
+    string table_name;
+    string col_name;
+    string index_type;                  // upper case, such as HNSW
+    map<string, int> parameters;        // parameters in WITH (...), names are upper case
+
+public:
+    // extract information from tokens
+    CreateIndexSql(vector<Token> tokens)
+    {
+        index_name = tokens[2].value;
+        table_name = tokens[4].value;
+        col_name = tokens[6].value;
+        index_type = ToUpper(tokens[9].value);
+
+        int token_flag = 10;
+        if (tokens[token_flag].type == TokenType::KEYWORD_T && tokens[token_flag].value == "WITH")
+        {
+            // skip WITH (
+            token_flag += 2;
+            while (true)
+            {
+                // try match 3 tokens one time: name = value
+                if (!(
+                    token_flag + 3 < tokens.size()
+                    && tokens[token_flag].type == IDENTIFIER_T
+                    && tokens[token_flag + 1].value == "="
+                    && tokens[token_flag + 2].type == NUMBER_T
+                    && tokens[token_flag + 2].value.find('.') == string::npos
+                    ))
+                {
+                    throw std::runtime_error("Sql wrong, index parameter must be like name = integer");
+                }
+                parameters[ToUpper(tokens[token_flag].value)] = std::stoi(tokens[token_flag + 2].value);
+                token_flag += 3;
+
+                if (tokens[token_flag].value == ",")
+                {
+                    token_flag++;
+                    continue;
+                }
+                if (tokens[token_flag].value == ")")
+                {
+                    token_flag++;
+                    break;
+                }
+                throw std::runtime_error("Sql wrong, index parameters must be closed by )");
+            }
+        }
+
+        // check sql has been parsed end
+        if (!(token_flag == tokens.size() - 1 && tokens[token_flag].type == TokenType::OPERATOR_T && tokens[token_flag].value == ";"))
+        {
+            throw std::runtime_error("Sql wrong, not end with ; or can not be parsed");
+        }
+    }
+
+    static string ToUpper(string value)
+    {
+        for (char& c : value)
+        {
+            c = toupper(c);
+        }
+        return value;
+    }
+};
+
 struct DropDatabaseSql
 {
 public:
@@ -400,6 +623,7 @@ public:
     DropDatabaseSql* drop_database_sql;
     DropTableSql* drop_table_sql;
     SelectFromOneTableSql* select_from_one_table_sql;
+    CreateIndexSql* create_index_sql;
     // SelectFromTableWithJoinSql* select_from_table_with_join_sql;
     
 public:
@@ -421,6 +645,9 @@ public:
         case SELECT_FROM_ONE_TABLE_NODE:
             delete select_from_one_table_sql;
             break;
+        case CREATE_INDEX_NODE:
+            delete create_index_sql;
+            break;
         // TODO: more sql support is on designing
         default:
             break;
@@ -444,6 +671,9 @@ public:
             case NodeType::SELECT_FROM_ONE_TABLE_NODE:
                 select_from_one_table_sql = static_cast<SelectFromOneTableSql*>(data);
                 break;
+            case NodeType::CREATE_INDEX_NODE:
+                create_index_sql = static_cast<CreateIndexSql*>(data);
+                break;
             default:
                 throw std::runtime_error("can not init AST!");
         }
@@ -496,12 +726,33 @@ public:
                     ss << column.col_name << ", ";
                 }
                 ss << " FROM " << select_from_one_table_sql->table_name;
+                if (!select_from_one_table_sql->range_column.empty()) {
+                    ss << " WHERE DISTANCE(" << select_from_one_table_sql->range_column << ", " << select_from_one_table_sql->range_vector << ") < " << select_from_one_table_sql->range_radius;
+                }
                 if (!select_from_one_table_sql->compare_vector.empty()) {
                     ss << " WHERE ";
                     for (const auto& condition : select_from_one_table_sql->compare_vector) {
                         ss << condition.col.col_name << " " << condition.condition << " " << condition.compare_value << " ";
                     }
                 }
+                if (!select_from_one_table_sql->order_column.empty()) {
+                    ss << " ORDER BY " << select_from_one_table_sql->order_column << " <-> " << select_from_one_table_sql->order_vector;
+                    ss << " LIMIT " << select_from_one_table_sql->limit;
+                }
+                break;
+            }
+            case CREATE_INDEX_NODE:
+            {
+                ss << "CREATE INDEX " << create_index_sql->index_name << " ON " << create_index_sql->table_name;
+                ss << " (" << create_index_sql->col_name << ") USING " << create_index_sql->index_type;
+                if (!create_index_sql->parameters.empty()) {
+                    ss << " WITH (";
+                    for (const auto& parameter : create_index_sql->parameters) {
+                        ss << parameter.first << " = " << parameter.second << ", ";
+                    }
+                    ss << ")";
+                }
+                ss << ";";
                 break;
             }
             // TODO: more sql support is on designing
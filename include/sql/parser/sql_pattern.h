@@ -96,11 +96,19 @@ public:
                     )
                     return false;
                 } break;
-                case STRING_T: {    // as same as the NUMBER_T
+                case STRING_T: {    // as same as the NUMBER_T, and a vector literal is also a VALUE
                     if (
                         input_tokens[begin_check_offset + template_check_offset].type != NUMBER_T 
                         && 
                         input_tokens[begin_check_offset + template_check_offset].type != STRING_T
+                        && 
+                        input_tokens[begin_check_offset + template_check_offset].type != VECTOR_LITERAL_T
+                    )
+                    return false;
+                } break;
+                case VECTOR_LITERAL_T: {    // only a vector literal, such as the query vector of ORDER BY
+                    if (
+                        input_tokens[begin_check_offset + template_check_offset].type != VECTOR_LITERAL_T
                     )
                     return false;
                 } break;
@@ -116,6 +124,12 @@ public:
     // mainly used to check support data type (types are defined as KEYWORD)
     bool RangeCheck(vector<Token> input_tokens, int begin_check_offset)
     {
+        if (begin_check_offset >= input_tokens.size())
+        {
+            match_length = 0;
+            return false;
+        }
+
         // int template_check_offset = 0;
         // try match tokens_template
         for (Token token : tokens_template)
@@ -125,7 +139,7 @@ public:
                 case KEYWORD_T: {    // to KEY_WORD, must check the KEY_WORD value, such as SELECT, CREATE
                     if (
                         input_tokens[begin_check_offset].type == KEYWORD_T 
-                        || 
+                        && 
                         input_tokens[begin_check_offset].value == token.value
                         ) 
                     {
@@ -164,11 +178,13 @@ public:
                         return true;
                     }
                 } break;
-                case STRING_T: {    // as same as the NUMBER_T
+                case STRING_T: {    // as same as the NUMBER_T, and a vector literal is also a VALUE
                     if (
                         input_tokens[begin_check_offset].type == NUMBER_T 
                         ||
                         input_tokens[begin_check_offset].type == STRING_T
+                        ||
+                        input_tokens[begin_check_offset].type == VECTOR_LITERAL_T
                         )
                     {
                         match_length = 1;
@@ -265,7 +281,14 @@ TokenPattern DATABASE(1, {Token(KEYWORD_T, "DATABASE")});
 TokenPattern TABLE(1, {Token(KEYWORD_T, "TABLE")});
 TokenPattern VALUES(1, {Token(KEYWORD_T, "VALUES")});
 TokenPattern LEFT_BRACKET(1, {Token(OPERATOR_T, "(")});
-TokenPattern VALUE_TYPE(4, {Token(KEYWORD_T, "INT"), Token(KEYWORD_T, "FLOAT"), Token(KEYWORD_T, "VCHAR"), Token(KEYWORD_T, "VECTOR")}, true);
+TokenPattern VECTOR_TYPE(4, {Token(KEYWORD_T, "VECTOR"), Token(OPERATOR_T, "("), Token(NUMBER_T, ""), Token(OPERATOR_T, ")")}); // VECTOR(768)
+TokenPattern VECTOR_TYPE_WITH_ELEMENT(6, {Token(KEYWORD_T, "VECTOR"), Token(OPERATOR_T, "("), Token(NUMBER_T, ""), Token(OPERATOR_T, ","), Token(IDENTIFIER_T, ""), Token(OPERATOR_T, ")")}); // VECTOR(768, FP16)
+TokenPattern NORMALIZE_OPTION(1, {Token(KEYWORD_T, "NORMALIZE")});
+vector<TokenPattern> NORMALIZED_VECTOR_TYPE_V({NORMALIZE_OPTION});
+TokenPattern NORMALIZED_VECTOR_TYPE(4, {Token(KEYWORD_T, "VECTOR"), Token(OPERATOR_T, "("), Token(NUMBER_T, ""), Token(OPERATOR_T, ")")}, false, NORMALIZED_VECTOR_TYPE_V); // VECTOR(768) NORMALIZE
+TokenPattern NORMALIZED_VECTOR_TYPE_WITH_ELEMENT(6, {Token(KEYWORD_T, "VECTOR"), Token(OPERATOR_T, "("), Token(NUMBER_T, ""), Token(OPERATOR_T, ","), Token(IDENTIFIER_T, ""), Token(OPERATOR_T, ")")}, false, NORMALIZED_VECTOR_TYPE_V); // VECTOR(768, FP16) NORMALIZE
+vector<TokenPattern> VECTOR_TYPE_V({NORMALIZED_VECTOR_TYPE_WITH_ELEMENT, NORMALIZED_VECTOR_TYPE, VECTOR_TYPE_WITH_ELEMENT, VECTOR_TYPE}); // longest first
+TokenPattern VALUE_TYPE(3, {Token(KEYWORD_T, "INT"), Token(KEYWORD_T, "FLOAT"), Token(KEYWORD_T, "VCHAR")}, true, VECTOR_TYPE_V);
 vector<TokenPattern> NEXT_COLUMN_VALUE_V({VALUE_TYPE});
 TokenPattern NEXT_COLUMN(2, {Token(OPERATOR_T, ","), Token(IDENTIFIER_T, "")}, false, NEXT_COLUMN_VALUE_V); // , ID DATA_TYPE
 TokenPattern RIGHT_BRACKET(1, {Token(OPERATOR_T, ")")});
@@ -286,12 +309,24 @@ TokenPattern OPERATOR(2, {Token(KEYWORD_T, "AND"), Token(KEYWORD_T, "OR")}, true
 
 vector<TokenPattern> CONDITION_V({WHERE, ID, COMPARER, VALUE}); // WHERE ID >/</=/!= VALUE
 TokenPattern CONDITION(0, {}, false, CONDITION_V); // ID >/</=/!= VALUE
+TokenPattern RANGE_CONDITION(9, {Token(KEYWORD_T, "WHERE"), Token(KEYWORD_T, "DISTANCE"), Token(OPERATOR_T, "("), Token(IDENTIFIER_T, ""), Token(OPERATOR_T, ","), Token(VECTOR_LITERAL_T, ""), Token(OPERATOR_T, ")"), Token(OPERATOR_T, "<"), Token(NUMBER_T, "")}); // WHERE DISTANCE(ID, [..]) < VALUE
 vector<TokenPattern> NEXT_CONDITION_V({OPERATOR, ID, COMPARER, VALUE}); // ADN/OR ID >/</=/!= VALUE
 TokenPattern NEXT_CONDITION(0, {}, false, NEXT_CONDITION_V); // ADN/OR ID >/</=/!= VALUE
 
+TokenPattern LIMIT(2, {Token(KEYWORD_T, "LIMIT"), Token(NUMBER_T, "")}); // LIMIT k
+vector<TokenPattern> NEAREST_ORDER_V({LIMIT});
+TokenPattern NEAREST_ORDER(7, {Token(KEYWORD_T, "ORDER"), Token(KEYWORD_T, "BY"), Token(IDENTIFIER_T, ""), Token(OPERATOR_T, "<"), Token(OPERATOR_T, "-"), Token(OPERATOR_T, ">"), Token(VECTOR_LITERAL_T, "")}, false, NEAREST_ORDER_V); // ORDER BY ID <-> [..] LIMIT k
+
 // DELETE SQL
 TokenPattern DELETE(1, {Token(KEYWORD_T, "DELETE")});
 
+// CREATE INDEX SQL
+TokenPattern INDEX(1, {Token(KEYWORD_T, "INDEX")});
+TokenPattern ON(1, {Token(KEYWORD_T, "ON")});
+TokenPattern USING(2, {Token(KEYWORD_T, "USING"), Token(IDENTIFIER_T, "")}); // USING HNSW
+TokenPattern INDEX_PARAM(5, {Token(KEYWORD_T, "WITH"), Token(OPERATOR_T, "("), Token(IDENTIFIER_T, ""), Token(OPERATOR_T, "="), Token(NUMBER_T, "")}); // WITH ( ID = VALUE
+TokenPattern NEXT_INDEX_PARAM(4, {Token(OPERATOR_T, ","), Token(IDENTIFIER_T, ""), Token(OPERATOR_T, "="), Token(NUMBER_T, "")}); // , ID = VALUE
+
 
 
 // belows are sql patterns:
@@ -308,14 +343,19 @@ vector<bool> CREATE_TABLE_SQL_PATTERN_NEC({true, true, true, true, true, true, f
 vector<TokenPattern> INSERT_INTO_SQL_PATTERN({INSERT, INTO, ID, LEFT_BRACKET, ID, NEXT_ID, RIGHT_BRACKET, VALUES, LEFT_BRACKET, VALUE, NEXT_VALUE, RIGHT_BRACKET, SEMICOLON});
 vector<bool> INSERT_INTO_SQL_PATTERN_NEC({true, true, true, true, true, false, true, true, true, true, false, true, true});
 
-// SELECT ID NEXT_ID FROM ID WHERE ID >/</=/!= VALUE AND/OR ID >/</= VALUE;
-vector<TokenPattern>  SELECT_FROM_ONE_TABLE_SQL_PATTERN({SELECT, FIRST_COL, NEXT_ID, FROM, ID, CONDITION, NEXT_CONDITION, SEMICOLON});
-vector<bool>  SELECT_FROM_ONE_TABLE_SQL_PATTERN_NEC({true, true, false, true, true, false, false, true});
+// SELECT ID NEXT_ID FROM ID WHERE ID >/</=/!= VALUE AND/OR ID >/</= VALUE ORDER BY ID <-> [..] LIMIT k;
+// SELECT ID NEXT_ID FROM ID WHERE DISTANCE(ID, [..]) < VALUE AND ID >/</= VALUE;
+vector<TokenPattern>  SELECT_FROM_ONE_TABLE_SQL_PATTERN({SELECT, FIRST_COL, NEXT_ID, FROM, ID, RANGE_CONDITION, CONDITION, NEXT_CONDITION, NEAREST_ORDER, SEMICOLON});
+vector<bool>  SELECT_FROM_ONE_TABLE_SQL_PATTERN_NEC({true, true, false, true, true, false, false, false, false, true});
 
 // DELETE FROM ID WHERE ID >/</=/!= VALUE AND ID >/</= VALUE;
 vector<TokenPattern> DELETE_FROM_SQL_PATTERN({DELETE, FROM, ID, CONDITION, NEXT_CONDITION, SEMICOLON});
 vector<bool>  DELETE_FROM_SQL_PATTERN_NEC({true, true, true, false, false, false});
 
+// CREATE INDEX ID ON ID (ID) USING ID WITH (ID = VALUE NEXT_INDEX_PARAM) ;
+vector<TokenPattern> CREATE_INDEX_SQL_PATTERN({CREATE, INDEX, ID, ON, ID, LEFT_BRACKET, ID, RIGHT_BRACKET, USING, INDEX_PARAM, NEXT_INDEX_PARAM, RIGHT_BRACKET, SEMICOLON});
+vector<bool> CREATE_INDEX_SQL_PATTERN_NEC({true, true, true, true, true, true, true, true, true, false, false, false, true});
+
 // SELECT ID NEXT_ID FROM ID INNER JOIN ID ON ID = ID WHERE ID >/</=/ VALUE
 
 
@@ -384,6 +424,7 @@ SqlPatternMatcher CREATE_TABLE(CREATE_TABLE_SQL_PATTERN, CREATE_TABLE_SQL_PATTER
 SqlPatternMatcher INSERT_INTO_TABLE(INSERT_INTO_SQL_PATTERN, INSERT_INTO_SQL_PATTERN_NEC);
 SqlPatternMatcher SELECT_FROM_ONE_TABLE(SELECT_FROM_ONE_TABLE_SQL_PATTERN, SELECT_FROM_ONE_TABLE_SQL_PATTERN_NEC);
 SqlPatternMatcher DELETE_FROM_TABLE(DELETE_FROM_SQL_PATTERN, DELETE_FROM_SQL_PATTERN_NEC);
+SqlPatternMatcher CREATE_INDEX(CREATE_INDEX_SQL_PATTERN, CREATE_INDEX_SQL_PATTERN_NEC);
 
 // store all match tool for using
 vector<SqlPatternMatcher> ALL_PATTERNS(
@@ -392,7 +433,8 @@ vector<SqlPatternMatcher> ALL_PATTERNS(
         CREATE_TABLE, 
         INSERT_INTO_TABLE,
         SELECT_FROM_ONE_TABLE,
-        DELETE_FROM_TABLE
+        DELETE_FROM_TABLE,
+        CREATE_INDEX
     }
 );
 vector<NodeType> ALL_PATTERNS_NODE_TYPE(
@@ -401,7 +443,8 @@ vector<NodeType> ALL_PATTERNS_NODE_TYPE(
         CREATE_TABLE_NODE, 
         INSERT_INTO_TABLE_NODE,
         SELECT_FROM_ONE_TABLE_NODE,
-        DELETE_FROM_TABLE_NODE
+        DELETE_FROM_TABLE_NODE,
+        CREATE_INDEX_NODE
     }
 );
 
@@ -437,6 +480,10 @@ public:
             sql = new DeleteFromTableSql(tokens);
             ast = new AST(DELETE_FROM_TABLE_NODE, sql);
             break;
+        case CREATE_INDEX_NODE:
+            sql = new CreateIndexSql(tokens);
+            ast = new AST(CREATE_INDEX_NODE, sql);
+            break;
         // TODO: more sql support is on designing
 
         case UNSUPPORT_NODE:
@@ -18,6 +18,7 @@ enum TokenType {
    OPERATOR_T,
    NUMBER_T,
    STRING_T,
+   VECTOR_LITERAL_T,    // such as [0.1, -0.2, 0.3]
    UNKNOWN_T,
    ERROR_T
 };
@@ -33,8 +34,11 @@ static const std::string KEY_WORDS[] = {
     "SELECT", "FROM", "WHERE", "INSERT", "INTO", "VALUES", "CREATE", "TABLE", "DROP", // support base key word
     "UPDATE", "SET", "DELETE", "ALTER", "ADD", "COLUMN", 
     "AND", "OR", "NOT",  // support operator
-    "IN", "LIKE", "JOIN", "ON", "ORDER", "BY", "GROUP", "HAVING",
+    "IN", "LIKE", "JOIN", "ON", "ORDER", "BY", "GROUP", "HAVING", "LIMIT",
+    "DISTANCE",  // support vector function
     "INT", "FLOAT", "VCHAR", "VECTOR",  // support data type
+    "NORMALIZE",  // support column option
+    "INDEX", "USING", "WITH",  // support index
     "DATABASE"
 };
 
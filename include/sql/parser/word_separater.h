@@ -88,6 +88,30 @@ std::vector<Token> Tokenize(const std::string& sql)
                 return tokens;
             }
         } 
+        else if (sql[i] == '[') 
+        {
+            // keep the whole vector literal as one token, numbers in it are parsed when the column is known,
+            // a batch of vectors such as [[1, 2], [3, 4]] is also one token
+            std::string vector_literal;
+            int depth = 0;
+            while (i < sql.length()) 
+            {
+                depth += sql[i] == '[' ? 1 : sql[i] == ']' ? -1 : 0;
+                vector_literal += sql[i++];
+                if (depth == 0)
+                {
+                    break;
+                }
+            }
+            if (depth == 0) 
+            {
+                tokens.push_back(Token(VECTOR_LITERAL_T, vector_literal));
+            } else 
+            {
+                tokens.clear();
+                return tokens;
+            }
+        } 
         else if (ispunct(sql[i])) 
         {
             std::string op;
@@ -115,6 +139,7 @@ void PrintTokens(const std::vector<Token>& tokens) {
            case OPERATOR_T: type = "OPERATOR"; break;
            case NUMBER_T: type = "NUMBER_T"; break;
            case STRING_T: type = "STRING_T"; break;
+           case VECTOR_LITERAL_T: type = "VECTOR_LITERAL_T"; break;
            case ERROR_T: type = "ERROR"; break;
            default: type = "UNKNOWN"; break;
        }
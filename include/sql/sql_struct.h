@@ -90,6 +90,8 @@ enum NodeType {
     SELECT_FROM_ONE_TABLE_NODE,
     DROP_DATABASE_NODE,
     DROP_TABLE_NODE,
+    DELETE_FROM_TABLE_NODE,
+    CREATE_INDEX_NODE,
 
     UNSUPPORT_NODE
 };
@@ -99,7 +101,13 @@ enum IndexType
     NONE_INDEX,
     B_PLUS_TREE,
     UNIQUE,
-    VECTOR_INDEX_1, // this type of index will not been finished in 0.0.1 version
+    HNSW_INDEX,     // approximate nearest neighbor index of vector column, see index/hnsw_index.h
+    IVF_FLAT_INDEX, // inverted file index of vector column, posting lists are stored in blocks, see index/ivf_flat_index.h
+    PQ_INDEX,       // product quantization codes of vector column kept in memory, see index/pq_index.h
+    IVF_PQ_INDEX,   // inverted file index storing product quantization codes, see index/ivf_pq_index.h
+    SQ8_INDEX,      // 8-bit scalar quantization codes of vector column kept in memory, see index/sq_index.h
+    SQ4_INDEX,      // 4-bit scalar quantization codes, see index/sq_index.h
+    DISKANN_INDEX,  // vamana graph index whose nodes are stored in blocks, see index/diskann_index.h
 };
 
 struct DataBase
@@ -111,7 +119,9 @@ struct Column
 {
     string col_name;
     ValueType value_type;
-    int col_length;
+    int col_length;                                     // dimension if it is a vector column
+    vector_element_type element_type = ELEMENT_FP32;    // only used by vector column
+    default_enum_type option = COLUMN_OPTION_NONE;      // bit flags of column_option
 };
 
 struct Index
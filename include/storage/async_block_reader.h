@@ -0,0 +1,529 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : async_block_reader.h
+// since : 2024-09-10
+// desc  : Read a batch of blocks together. Reads of a batch are submitted to
+// an io_uring ring at once and completed by the kernel in any order, so the
+// disk sees all of them instead of one read after another. The ring is driven
+// by the raw system calls, no library is needed. When io_uring can not be set
+// up (old kernel, forbidden by seccomp), reads of a batch are spread over a
+// small pool of threads doing pread. The caller waits until the whole batch is
+// read, blocks after the end of file are read as 0.
+
+#ifndef VDBMS_STORAGE_ASYNC_BLOCK_READER_H_
+#define VDBMS_STORAGE_ASYNC_BLOCK_READER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// linux/fs.h included by linux/io_uring.h has a BLOCK_SIZE of its own
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#pragma push_macro("BLOCK_SIZE")
+#undef BLOCK_SIZE
+#include <linux/io_uring.h>
+#undef BLOCK_SIZE
+#pragma pop_macro("BLOCK_SIZE")
+#define VDBMS_HAS_IO_URING 1
+#endif
+
+#include "../config.h"
+#include "file_descriptor_cache.h"
+
+namespace tiny_v_dbms {
+
+// one block to read, data must have BLOCK_SIZE bytes
+struct BlockReadRequest
+{
+    std::string file_path;
+    default_address_type block_address;
+    char* data;
+};
+
+#ifdef VDBMS_HAS_IO_URING
+
+// a submission ring and a completion ring shared with the kernel
+class IoUringRing
+{
+
+public:
+
+    IoUringRing() : ring_fd(-1), sq_ring(nullptr), cq_ring(nullptr), sqes(nullptr), sq_ring_size(0), cq_ring_size(0), sqes_size(0)
+    {
+    }
+
+    ~IoUringRing()
+    {
+        if (sqes != nullptr)
+        {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ring != nullptr && cq_ring != sq_ring)
+        {
+            munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring != nullptr)
+        {
+            munmap(sq_ring, sq_ring_size);
+        }
+        if (ring_fd >= 0)
+        {
+            close(ring_fd);
+        }
+    }
+
+    IoUringRing(const IoUringRing&) = delete;
+    IoUringRing& operator=(const IoUringRing&) = delete;
+
+    // return false if io_uring is not supported
+    bool Init(unsigned entries)
+    {
+        memset(&params, 0, sizeof(params));
+        ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (ring_fd < 0)
+        {
+            return false;
+        }
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = (char*) mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED)
+        {
+            sq_ring = nullptr;
+            return false;
+        }
+        cq_ring = single_mmap ? sq_ring : (char*) mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED)
+        {
+            cq_ring = nullptr;
+            return false;
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe*) mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            sqes = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    unsigned Capacity() const
+    {
+        return params.sq_entries;
+    }
+
+    /**
+     * @brief Put a read into the submission ring, it is submitted by the next Enter.
+     * @param user_data returned by the completion of the read.
+     */
+    void PrepareReadv(int fd, const iovec* io_vector, off_t offset, uint64_t user_data)
+    {
+        unsigned* tail = (unsigned*) (sq_ring + params.sq_off.tail);
+        unsigned mask = *(unsigned*) (sq_ring + params.sq_off.ring_mask);
+        unsigned index = *tail & mask;
+
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(io_uring_sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t) io_vector;
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+
+        ((unsigned*) (sq_ring + params.sq_off.array))[index] = index;
+        __atomic_store_n(tail, *tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief Submit prepared reads and wait until at least wait_amount reads are completed.
+     * @return amount of submitted reads.
+     * @throws std::runtime_error If the reads can not be submitted.
+     */
+    unsigned Enter(unsigned submit_amount, unsigned wait_amount)
+    {
+        while (true)
+        {
+            long result = syscall(__NR_io_uring_enter, ring_fd, submit_amount, wait_amount, wait_amount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (result >= 0)
+            {
+                return result;
+            }
+            if (errno != EINTR && errno != EAGAIN)
+            {
+                throw std::runtime_error("Failed to submit reads: " + std::string(strerror(errno)));
+            }
+        }
+    }
+
+    // call with each completed read, return amount of them
+    unsigned ForEachCompletion(const std::function<void(uint64_t user_data, int result)>& on_completion)
+    {
+        unsigned* head = (unsigned*) (cq_ring + params.cq_off.head);
+        unsigned tail = __atomic_load_n((unsigned*) (cq_ring + params.cq_off.tail), __ATOMIC_ACQUIRE);
+        unsigned mask = *(unsigned*) (cq_ring + params.cq_off.ring_mask);
+        io_uring_cqe* cqes = (io_uring_cqe*) (cq_ring + params.cq_off.cqes);
+
+        unsigned amount = 0;
+        unsigned now = *head;
+        for (; now != tail; now++, amount++)
+        {
+            on_completion(cqes[now & mask].user_data, cqes[now & mask].res);
+        }
+        __atomic_store_n(head, now, __ATOMIC_RELEASE);
+        return amount;
+    }
+
+private:
+    int ring_fd;
+    io_uring_params params;
+    char* sq_ring;
+    char* cq_ring;
+    io_uring_sqe* sqes;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+};
+
+#endif
+
+class AsyncBlockReader
+{
+
+public:
+
+    /**
+     * @param try_io_uring use io_uring if the kernel supports it, otherwise the pool of threads is always used.
+     */
+    AsyncBlockReader(bool try_io_uring = true) : io_uring_enabled(false), stopping(false)
+    {
+#ifdef VDBMS_HAS_IO_URING
+        if (try_io_uring)
+        {
+            std::unique_ptr<IoUringRing> ring(new IoUringRing());
+            if (ring->Init(ASYNC_READ_QUEUE_DEPTH))
+            {
+                idle_rings.push_back(std::move(ring));
+                io_uring_enabled = true;
+            }
+        }
+#endif
+    }
+
+    virtual ~AsyncBlockReader()
+    {
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            stopping = true;
+        }
+        tasks_cv.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    AsyncBlockReader(const AsyncBlockReader&) = delete;
+    AsyncBlockReader& operator=(const AsyncBlockReader&) = delete;
+
+    bool IsIoUringEnabled() const
+    {
+        return io_uring_enabled;
+    }
+
+    /**
+     * @brief Read all blocks of requests, return after all of them are read. Each thread reading a batch uses a ring
+     * of its own, so batches of different threads do not wait for each other.
+     * @throws std::runtime_error If a file can not be opened or read, no read is still running when it is thrown.
+     */
+    void ReadBatch(const std::vector<BlockReadRequest>& requests)
+    {
+        if (requests.empty())
+        {
+            return;
+        }
+
+        // descriptors are kept until the whole batch is read
+        std::map<std::string, std::shared_ptr<FileDescriptor> > descriptors;
+        std::vector<FileDescriptor*> request_descriptors;
+        for (const BlockReadRequest& request : requests)
+        {
+            std::shared_ptr<FileDescriptor>& descriptor = descriptors[request.file_path];
+            if (descriptor == nullptr)
+            {
+                descriptor = FileDescriptorCache::GetInstance().Get(request.file_path);
+            }
+            request_descriptors.push_back(descriptor.get());
+        }
+
+#ifdef VDBMS_HAS_IO_URING
+        if (io_uring_enabled)
+        {
+            // a ring failing to submit may still have prepared reads, it is closed rather than reused
+            std::unique_ptr<IoUringRing> ring = TakeRing();
+            if (ReadByRing(*ring, requests, request_descriptors))
+            {
+                ReturnRing(std::move(ring));
+            }
+            return;
+        }
+#endif
+        ReadByThreads(requests, request_descriptors);
+    }
+
+protected:
+
+#ifdef VDBMS_HAS_IO_URING
+
+    // submit prepared reads of a ring and wait for completions, see IoUringRing::Enter
+    virtual unsigned Submit(IoUringRing& ring, unsigned submit_amount, unsigned wait_amount)
+    {
+        return ring.Enter(submit_amount, wait_amount);
+    }
+
+#endif
+
+private:
+    bool io_uring_enabled;
+
+#ifdef VDBMS_HAS_IO_URING
+    std::vector<std::unique_ptr<IoUringRing> > idle_rings;
+    std::mutex rings_mutex;
+#endif
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_cv;
+    bool stopping;
+
+#ifdef VDBMS_HAS_IO_URING
+
+    std::unique_ptr<IoUringRing> TakeRing()
+    {
+        {
+            std::unique_lock<std::mutex> lock(rings_mutex);
+            if (!idle_rings.empty())
+            {
+                std::unique_ptr<IoUringRing> ring = std::move(idle_rings.back());
+                idle_rings.pop_back();
+                return ring;
+            }
+        }
+        std::unique_ptr<IoUringRing> ring(new IoUringRing());
+        if (!ring->Init(ASYNC_READ_QUEUE_DEPTH))
+        {
+            throw std::runtime_error("Failed to set up io_uring: " + std::string(strerror(errno)));
+        }
+        return ring;
+    }
+
+    void ReturnRing(std::unique_ptr<IoUringRing> ring)
+    {
+        std::unique_lock<std::mutex> lock(rings_mutex);
+        idle_rings.push_back(std::move(ring));
+    }
+
+    /**
+     * @brief Read requests by a ring, at most Capacity reads are in the ring, a short read is submitted again for
+     * its rest. If the reads can not be submitted, the reads in flight are waited for, as the kernel still writes
+     * into their blocks, then the blocks not read yet are read by threads.
+     * @return false if the ring failed to submit, it must not be reused.
+     * @throws std::runtime_error If a block can not be read, no read is still running when it is thrown.
+     */
+    bool ReadByRing(IoUringRing& ring, const std::vector<BlockReadRequest>& requests, const std::vector<FileDescriptor*>& request_descriptors)
+    {
+        std::vector<size_t> read_bytes(requests.size(), 0);
+        std::vector<bool> done(requests.size(), false);
+        std::vector<iovec> io_vectors(requests.size());
+        std::vector<size_t> waiting;
+        for (size_t i = requests.size(); i > 0; i--)
+        {
+            waiting.push_back(i - 1);
+        }
+
+        unsigned running = 0;
+        unsigned prepared = 0;
+        bool submit_failed = false;
+        std::string error;
+        while ((error.empty() && !submit_failed && !waiting.empty()) || running > 0 || (!submit_failed && prepared > 0))
+        {
+            while (error.empty() && !submit_failed && !waiting.empty() && running + prepared < ring.Capacity())
+            {
+                size_t i = waiting.back();
+                waiting.pop_back();
+                io_vectors[i].iov_base = requests[i].data + read_bytes[i];
+                io_vectors[i].iov_len = BLOCK_SIZE - read_bytes[i];
+                ring.PrepareReadv(request_descriptors[i]->Get(), &io_vectors[i], (off_t) requests[i].block_address * BLOCK_SIZE + read_bytes[i], i);
+                prepared++;
+            }
+
+            try
+            {
+                unsigned submitted = Submit(ring, submit_failed ? 0 : prepared, 1);
+                prepared -= submitted;
+                running += submitted;
+            }
+            catch (const std::runtime_error&)
+            {
+                // only wait for the reads in flight from now on, a failed wait is tried again after reaping
+                if (submit_failed)
+                {
+                    std::this_thread::yield();
+                }
+                submit_failed = true;
+            }
+
+            running -= ring.ForEachCompletion([&](uint64_t i, int result) {
+                if (result == -EINTR || result == -EAGAIN)
+                {
+                    waiting.push_back(i);
+                }
+                else if (result < 0)
+                {
+                    error = strerror(-result);
+                }
+                else if (result == 0)
+                {
+                    // after the end of file
+                    memset(requests[i].data + read_bytes[i], 0, BLOCK_SIZE - read_bytes[i]);
+                    done[i] = true;
+                }
+                else
+                {
+                    read_bytes[i] += result;
+                    if (read_bytes[i] < BLOCK_SIZE)
+                    {
+                        waiting.push_back(i);
+                    }
+                    else
+                    {
+                        done[i] = true;
+                    }
+                }
+            });
+        }
+
+        if (!error.empty())
+        {
+            throw std::runtime_error("Failed to read file: " + error);
+        }
+        if (!submit_failed)
+        {
+            return true;
+        }
+
+        std::vector<BlockReadRequest> rest_requests;
+        std::vector<FileDescriptor*> rest_descriptors;
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            if (!done[i])
+            {
+                rest_requests.push_back(requests[i]);
+                rest_descriptors.push_back(request_descriptors[i]);
+            }
+        }
+        ReadByThreads(rest_requests, rest_descriptors);
+        return false;
+    }
+
+#endif
+
+    void ReadByThreads(const std::vector<BlockReadRequest>& requests, const std::vector<FileDescriptor*>& request_descriptors)
+    {
+        StartWorkers();
+
+        size_t remain = requests.size();
+        std::exception_ptr error;
+        std::mutex batch_mutex;
+        std::condition_variable batch_cv;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            for (size_t i = 0; i < requests.size(); i++)
+            {
+                tasks.push_back([&, i]() {
+                    std::exception_ptr read_error;
+                    try
+                    {
+                        request_descriptors[i]->ReadAt(requests[i].data, BLOCK_SIZE, (off_t) requests[i].block_address * BLOCK_SIZE);
+                    }
+                    catch (...)
+                    {
+                        read_error = std::current_exception();
+                    }
+                    std::unique_lock<std::mutex> batch_lock(batch_mutex);
+                    if (read_error != nullptr && error == nullptr)
+                    {
+                        error = read_error;
+                    }
+                    if (--remain == 0)
+                    {
+                        batch_cv.notify_one();
+                    }
+                });
+            }
+        }
+        tasks_cv.notify_all();
+
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        batch_cv.wait(lock, [&]() { return remain == 0; });
+        if (error != nullptr)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // workers are started by the first batch read by threads
+    void StartWorkers()
+    {
+        std::unique_lock<std::mutex> lock(tasks_mutex);
+        while (workers.size() < ASYNC_READ_THREAD_AMOUNT)
+        {
+            workers.emplace_back([this]() {
+                while (true)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(tasks_mutex);
+                        tasks_cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (tasks.empty())
+                        {
+                            return;
+                        }
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_STORAGE_ASYNC_BLOCK_READER_H_
@@ -0,0 +1,217 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : block_directory.h
+// since : 2024-09-10
+// desc  : Addresses of the data blocks of each column of a table, in the order
+// of their chain, with the tag of the oldest record of each block. Blocks of a
+// column are linked by next_block_pointer, so block i is reached only after
+// reading blocks 0..i-1; with the directory, a scan knows all addresses ahead
+// and loads them by batches, and the block of a tag is found by a binary search
+// without reading other blocks.
+//
+// Records are only appended to the last block of a column, and a block is
+// never removed, so an entry does not change after it is added. The directory
+// is stored in a file next to the table header file, one entry is appended to
+// the file when a block is linked to a column.
+
+#ifndef VDBMS_STORAGE_BLOCK_DIRECTORY_H_
+#define VDBMS_STORAGE_BLOCK_DIRECTORY_H_
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "file_descriptor_cache.h"
+
+namespace tiny_v_dbms {
+
+struct DirectoryEntry
+{
+    default_address_type block_address;
+    default_long_int first_tag;         // tag of the oldest record in block
+};
+
+class BlockDirectory
+{
+
+public:
+
+    // one entry in file: column offset, block address, first tag
+    static const size_t ENTRY_LENGTH = sizeof(default_amount_type) + sizeof(default_address_type) + sizeof(default_long_int);
+
+    /**
+     * @param file_path the directory file of the table.
+     * @param column_size amount of columns of the table.
+     */
+    BlockDirectory(const std::string& file_path, default_amount_type column_size)
+        : file_path(file_path), columns(column_size), entry_amount(0)
+    {
+    }
+
+    /**
+     * @brief Load entries from the directory file, a part of entry at the end of file (not written completely) is dropped.
+     * @return false if the file does not exist, the directory is left empty.
+     * @throws std::runtime_error If the file can not be read.
+     */
+    bool Load()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        struct stat file_stat;
+        if (stat(file_path.c_str(), &file_stat) != 0)
+        {
+            return false;
+        }
+
+        default_long_int amount = file_stat.st_size / ENTRY_LENGTH;
+        std::vector<char> buffer(amount * ENTRY_LENGTH);
+        GetDescriptor()->ReadAt(buffer.data(), buffer.size(), 0);
+
+        for (std::vector<DirectoryEntry>& entries : columns)
+        {
+            entries.clear();
+        }
+        for (default_long_int i = 0; i < amount; i++)
+        {
+            default_amount_type column_offset;
+            DirectoryEntry entry;
+            const char* data = buffer.data() + i * ENTRY_LENGTH;
+            memcpy(&column_offset, data, sizeof(default_amount_type));
+            memcpy(&entry.block_address, data + sizeof(default_amount_type), sizeof(default_address_type));
+            memcpy(&entry.first_tag, data + sizeof(default_amount_type) + sizeof(default_address_type), sizeof(default_long_int));
+            if (column_offset >= 0 && column_offset < (default_amount_type) columns.size())
+            {
+                columns[column_offset].push_back(entry);
+            }
+        }
+        entry_amount = amount;
+        return true;
+    }
+
+    /**
+     * @brief Clear the directory and its file, called when the table is created.
+     * @throws std::runtime_error If the file can not be created.
+     */
+    void Reset()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (ftruncate(GetDescriptor()->Get(), 0) != 0)
+        {
+            throw std::runtime_error("Failed to clear block directory file: " + file_path);
+        }
+        for (std::vector<DirectoryEntry>& entries : columns)
+        {
+            entries.clear();
+        }
+        entry_amount = 0;
+    }
+
+    /**
+     * @brief Add the block linked to the end of a column, and append it to the file.
+     * Callers adding blocks to one column must be serialized, such as by holding the last block of column.
+     * @param first_tag tag of the first record inserted into block.
+     * @throws std::runtime_error If the file can not be written.
+     */
+    void Append(default_amount_type column_offset, default_address_type block_address, default_long_int first_tag)
+    {
+        char data[ENTRY_LENGTH];
+        memcpy(data, &column_offset, sizeof(default_amount_type));
+        memcpy(data + sizeof(default_amount_type), &block_address, sizeof(default_address_type));
+        memcpy(data + sizeof(default_amount_type) + sizeof(default_address_type), &first_tag, sizeof(default_long_int));
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        GetDescriptor()->WriteAt(data, ENTRY_LENGTH, (off_t) (entry_amount * ENTRY_LENGTH));
+        entry_amount++;
+        columns[column_offset].push_back(DirectoryEntry{block_address, first_tag});
+    }
+
+    /**
+     * @brief Add blocks linked to the end of a column in order, they are appended to the file by one write.
+     * @throws std::runtime_error If the file can not be written.
+     */
+    void Append(default_amount_type column_offset, const std::vector<DirectoryEntry>& entries)
+    {
+        if (entries.empty())
+        {
+            return;
+        }
+        std::vector<char> data(entries.size() * ENTRY_LENGTH);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            char* entry_data = data.data() + i * ENTRY_LENGTH;
+            memcpy(entry_data, &column_offset, sizeof(default_amount_type));
+            memcpy(entry_data + sizeof(default_amount_type), &entries[i].block_address, sizeof(default_address_type));
+            memcpy(entry_data + sizeof(default_amount_type) + sizeof(default_address_type), &entries[i].first_tag, sizeof(default_long_int));
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        GetDescriptor()->WriteAt(data.data(), data.size(), (off_t) (entry_amount * ENTRY_LENGTH));
+        entry_amount += entries.size();
+        columns[column_offset].insert(columns[column_offset].end(), entries.begin(), entries.end());
+    }
+
+    // blocks of a column in the directory
+    default_long_int GetBlockAmount(default_amount_type column_offset)
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return columns[column_offset].size();
+    }
+
+    /**
+     * @brief The last block of a column, where records are appended. The column must have blocks.
+     */
+    DirectoryEntry GetLastEntry(default_amount_type column_offset)
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return columns[column_offset].back();
+    }
+
+    /**
+     * @brief Copy the entries of a column, blocks added later are not in the copy, but records may still be
+     * inserted into the last block of the copy.
+     */
+    std::vector<DirectoryEntry> GetEntries(default_amount_type column_offset)
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return columns[column_offset];
+    }
+
+    /**
+     * @brief Find the block of a tag in the entries of a column.
+     * @param entries entries of column, in the order of chain.
+     * @return position of the last block whose first tag is not after tag, the tag may be after the records of the
+     * last block. The size of entries if there is no such block.
+     */
+    static default_long_int FindBlock(const std::vector<DirectoryEntry>& entries, default_long_int tag)
+    {
+        std::vector<DirectoryEntry>::const_iterator it = std::upper_bound(entries.begin(), entries.end(), tag,
+            [](default_long_int value, const DirectoryEntry& entry) { return value < entry.first_tag; });
+        if (it == entries.begin())
+        {
+            return entries.size();
+        }
+        return (it - entries.begin()) - 1;
+    }
+
+private:
+    std::string file_path;
+    std::vector<std::vector<DirectoryEntry> > columns;
+    default_long_int entry_amount;          // entries in file, of all columns
+    std::shared_mutex mutex;
+
+    std::shared_ptr<FileDescriptor> GetDescriptor()
+    {
+        return FileDescriptorCache::GetInstance().Get(file_path, true);
+    }
+};
+
+}
+
+#endif // VDBMS_STORAGE_BLOCK_DIRECTORY_H_
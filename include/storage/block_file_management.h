@@ -2,7 +2,9 @@
 //
 // file  : block_file_management.h
 // since : 2024-07-22
-// desc  : Read or write file using block as unit.
+// desc  : Read or write file using block as unit. Blocks of table header and
+// data files are read and written by pread / pwrite on descriptors kept open
+// by FileDescriptorCache, fstream is only used by the stream functions.
 
 #ifndef VDBMS_STORAGE_BLOCK_FILE_MANAGEMENT_H_
 #define VDBMS_STORAGE_BLOCK_FILE_MANAGEMENT_H_
@@ -19,6 +21,7 @@
 #include "../meta/block/data_block.h"
 #include "../meta/block/table_block.h"
 #include "../config.h"
+#include "file_descriptor_cache.h"
 
 namespace tiny_v_dbms {
 
@@ -30,12 +33,15 @@ class BlockFileManagement
 {
 public:
 
+    // amount of whole blocks in file, 0 if the file does not exist
     default_address_type GetFileBlocksAmount(string file_uri)
     {
-        fstream file_stream;
-        file_stream.open(file_uri, std::ios::in | std::ios::out);
-        file_stream.seekg(0, std::ios::end);
-        return file_stream.tellg() / BLOCK_SIZE;
+        struct stat file_stat;
+        if (stat(file_uri.c_str(), &file_stat) != 0)
+        {
+            return 0;
+        }
+        return file_stat.st_size / BLOCK_SIZE;
     }
 
     /**
@@ -177,10 +183,14 @@ public:
 
     default_address_type GetNewBlockAddress(string file_uri)
     {
-        fstream stream;
-        OpenFileWithoutCheck(file_uri, stream);
-        stream.seekg(0, std::ios::end); // seek to the end of the file
-        size_t length = stream.tellg();
+        // the file is created if it does not exist
+        struct stat file_stat;
+        if (stat(file_uri.c_str(), &file_stat) != 0)
+        {
+            FileDescriptorCache::GetInstance().Get(file_uri, true);
+            return 0;
+        }
+        size_t length = file_stat.st_size;
         default_address_type used_header = length % BLOCK_SIZE;
         if (used_header == 0)
         {
@@ -231,11 +241,9 @@ public:
     */
     void ReadOneTableBlock(string table_file_uri, default_address_type offset, TableBlock& new_block)
     {
-        fstream file_stream;
-        OpenTableFile(table_file_uri, file_stream);    // open table header file, like "test.tvdbb"
-        ReadFromFile(file_stream, offset, new_block.data);
+        CheckSuffix(table_file_uri, TABLE_FILE_SUFFIX);    // table header file, like "test.tvdbb"
+        ReadBlock(table_file_uri, offset, new_block.data);
         new_block.DeserializeFromBuffer(new_block.data);
-        file_stream.close();
     }
 
     /**
@@ -246,39 +254,64 @@ public:
     */
     void ReadOneDataBlock(string data_file_uri, default_address_type offset, DataBlock& new_block)
     {
-        fstream file_stream;
-        OpenDataFile(data_file_uri, file_stream);    // open table header file, like "test.data"
-        ReadFromFile(file_stream, offset, new_block.data);
+        CheckSuffix(data_file_uri, TABLE_DATA_FILE_SUFFIX);    // table data file, like "test.data"
+        ReadBlock(data_file_uri, offset, new_block.data);
         new_block.DeserializeFromBuffer(new_block.data);
-        file_stream.close();
+    }
+
+    void ReadOneDataBlock(string data_file_uri, default_address_type offset, char* data)
+    {
+        CheckSuffix(data_file_uri, TABLE_DATA_FILE_SUFFIX);
+        ReadBlock(data_file_uri, offset, data);
+    }
+
+    void ReadOneTableBlock(string table_file_uri, default_address_type offset, char* data)
+    {
+        CheckSuffix(table_file_uri, TABLE_FILE_SUFFIX);
+        ReadBlock(table_file_uri, offset, data);
     }
 
     void WriteBackTableBlock(string table_file_uri, default_address_type offset, TableBlock& block)
     {
-        fstream file_stream;
-        OpenTableFile(table_file_uri, file_stream);   // open table header file, like "test.tvdbb"   
-        WriteBackBlock(file_stream, offset, block.data);
-        file_stream.close();
+        CheckSuffix(table_file_uri, TABLE_FILE_SUFFIX);
+        WriteBlock(table_file_uri, offset, block.data);
     }
 
     void WriteBackDataBlock(string data_file_uri, default_address_type offset, DataBlock& block)
     {
         block.Serialize();
-        fstream file_stream;
-        OpenDataFile(data_file_uri, file_stream);    // open data file, like "test.data"   
-        WriteBackBlock(file_stream, offset, block.data);
-        file_stream.close();
+        CheckSuffix(data_file_uri, TABLE_DATA_FILE_SUFFIX);
+        WriteBlock(data_file_uri, offset, block.data);
     }
     
     void WriteBackDataBlock(string data_file_uri, default_address_type offset, char* data)
     {
-        fstream file_stream;
-        OpenDataFile(data_file_uri, file_stream);    // open data file, like "test.data"   
-        WriteBackBlock(file_stream, offset, data);
-        file_stream.close();
+        CheckSuffix(data_file_uri, TABLE_DATA_FILE_SUFFIX);
+        WriteBlock(data_file_uri, offset, data);
     }
+
 private:
 
+    void CheckSuffix(const string& file_path, const string& suffix)
+    {
+        size_t dot = file_path.find_last_of(".");
+        if (dot == string::npos || file_path.substr(dot) != suffix) {
+            throw std::runtime_error("Invalid file suffix. Expected:" + suffix + " but found: " + (dot == string::npos ? string() : file_path.substr(dot)));
+        }
+    }
+
+    // read one block by its offset, the cached descriptor of file is used by all threads
+    void ReadBlock(const string& file_path, default_address_type block_address, char* data)
+    {
+        std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(file_path);
+        descriptor->ReadAt(data, BLOCK_SIZE, (off_t) block_address * BLOCK_SIZE);
+    }
+
+    void WriteBlock(const string& file_path, default_address_type block_address, const char* data)
+    {
+        std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(file_path);
+        descriptor->WriteAt(data, BLOCK_SIZE, (off_t) block_address * BLOCK_SIZE);
+    }
 };
 
 
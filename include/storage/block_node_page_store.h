@@ -0,0 +1,154 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : block_node_page_store.h
+// since : 2024-09-10
+// desc  : Nodes of a disk graph index stored in data blocks of the buffer pool,
+// one block is one page. All pages of one index share a data file of their own
+// (like a table), and only the addresses of pages are kept in memory. Node s of
+// a page is the s-th record inserted into its block. A batch of nodes is read
+// by loading all of their pages together by LockWatcher, so pages missing in
+// buffer pool are read from disk at the same time. Pages stay pinned while the
+// batch is read.
+
+#ifndef VDBMS_STORAGE_BLOCK_NODE_PAGE_STORE_H_
+#define VDBMS_STORAGE_BLOCK_NODE_PAGE_STORE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/block/data_block.h"
+#include "../index/node_page_store.h"
+#include "./memory/lock_watcher.h"
+
+namespace tiny_v_dbms {
+
+class BlockNodePageStore : public NodePageStore
+{
+
+public:
+
+    /**
+     * @param lw lock watcher to load blocks, not owned.
+     * @param db_name db of the index.
+     * @param file_name name of the data file of pages, used as a table name by lock watcher.
+     */
+    BlockNodePageStore(LockWatcher* lw, std::string db_name, std::string file_name)
+        : lw(lw), db_name(db_name), file_name(file_name)
+    {
+    }
+
+    // the data file is cleared, so old nodes are dropped
+    void Reset(default_length_size node_length) override
+    {
+        std::lock_guard<std::mutex> lock(pages_mutex);
+        SetNodeLength(node_length);
+        std::ofstream(lw->cal_url_util->GetTableDataFile(db_name, file_name), std::ios::binary | std::ios::trunc).close();
+        page_addresses.clear();
+        page_reads = 0;
+    }
+
+    // new blocks get addresses from the file length, so writes are serialized
+    void Write(default_long_int node_no, const char* node) override
+    {
+        std::lock_guard<std::mutex> lock(pages_mutex);
+        default_long_int page_no = node_no / nodes_per_page;
+        default_length_size slot = node_no % nodes_per_page;
+        DataBlock block;
+        if (page_no == page_addresses.size())
+        {
+            if (slot != 0)
+            {
+                throw std::runtime_error("node " + std::to_string(node_no) + " is written before the nodes ahead of it");
+            }
+            default_address_type address = lw->CreateNewBlock(db_name, file_name, block);
+            block.InitBlock(node_length);
+            block.InsertData((char*) node, node_length);
+            lw->ReleaseWritingBlock(db_name, file_name, address, block);
+            page_addresses.push_back(address);
+            return;
+        }
+
+        lw->LoadBlockForWrite(db_name, file_name, page_addresses[page_no], block);
+        if (slot == block.field_data_nums)
+        {
+            block.InsertData((char*) node, node_length);
+        }
+        else if (slot < block.field_data_nums)
+        {
+            memcpy(block.data + BLOCK_SIZE - (slot + 1) * node_length, node, node_length);
+        }
+        else
+        {
+            lw->ReleaseWritingBlock(db_name, file_name, page_addresses[page_no], block);
+            throw std::runtime_error("node " + std::to_string(node_no) + " is written before the nodes ahead of it");
+        }
+        lw->ReleaseWritingBlock(db_name, file_name, page_addresses[page_no], block);
+    }
+
+    // pages are loaded together, then released after their nodes are read
+    void Read(const std::vector<default_long_int>& node_nos, const std::function<void(default_long_int, const char*)>& read_node) override
+    {
+        std::vector<default_long_int> page_nos;
+        for (default_long_int node_no : node_nos)
+        {
+            page_nos.push_back(node_no / nodes_per_page);
+        }
+        std::sort(page_nos.begin(), page_nos.end());
+        page_nos.erase(std::unique(page_nos.begin(), page_nos.end()), page_nos.end());
+
+        std::vector<default_address_type> addresses;
+        pages_mutex.lock();
+        for (default_long_int page_no : page_nos)
+        {
+            addresses.push_back(page_addresses[page_no]);
+        }
+        pages_mutex.unlock();
+
+        page_reads += page_nos.size();
+
+        // the pages loaded are cut short if buffer pool has not enough free slots, the rest are loaded next
+        std::vector<DataBlock> blocks;
+        for (size_t begin = 0; begin < page_nos.size(); begin += blocks.size())
+        {
+            std::vector<default_address_type> batch_addresses(addresses.begin() + begin, addresses.end());
+            lw->LoadBlocksForRead(db_name, file_name, batch_addresses, blocks);
+
+            for (default_long_int node_no : node_nos)
+            {
+                size_t i = std::lower_bound(page_nos.begin(), page_nos.end(), node_no / nodes_per_page) - page_nos.begin();
+                if (i >= begin && i < begin + blocks.size())
+                {
+                    read_node(node_no, blocks[i - begin].data + BLOCK_SIZE - (node_no % nodes_per_page + 1) * node_length);
+                }
+            }
+
+            for (size_t i = 0; i < blocks.size(); i++)
+            {
+                lw->ReleaseReadingBlock(db_name, file_name, batch_addresses[i], blocks[i]);
+            }
+        }
+    }
+
+    default_long_int GetPageReadAmount() const override
+    {
+        return page_reads;
+    }
+
+private:
+    LockWatcher* lw;
+    std::string db_name;
+    std::string file_name;
+
+    std::vector<default_address_type> page_addresses;
+    std::atomic<default_long_int> page_reads{0};
+    std::mutex pages_mutex;
+};
+
+}
+
+#endif // VDBMS_STORAGE_BLOCK_NODE_PAGE_STORE_H_
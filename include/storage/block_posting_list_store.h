@@ -0,0 +1,168 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : block_posting_list_store.h
+// since : 2024-09-10
+// desc  : Posting lists stored in data blocks of the buffer pool. All lists of
+// one index share a data file of their own (like a table), and each list is a
+// chain of blocks, so probing a list only reads its own blocks. Blocks are
+// loaded by LockWatcher, batch by batch, and stay pinned while one batch is
+// scanned. Heads and tails of the chains are kept in memory.
+
+#ifndef VDBMS_STORAGE_BLOCK_POSTING_LIST_STORE_H_
+#define VDBMS_STORAGE_BLOCK_POSTING_LIST_STORE_H_
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "../meta/block/data_block.h"
+#include "../index/posting_list_store.h"
+#include "./memory/lock_watcher.h"
+
+namespace tiny_v_dbms {
+
+class BlockPostingListStore : public PostingListStore
+{
+
+public:
+
+    /**
+     * @param lw lock watcher to load blocks, not owned.
+     * @param db_name db of the index.
+     * @param file_name name of the data file of lists, used as a table name by lock watcher.
+     */
+    BlockPostingListStore(LockWatcher* lw, std::string db_name, std::string file_name)
+        : lw(lw), db_name(db_name), file_name(file_name), posting_length(0)
+    {
+    }
+
+    // the data file is cleared, so old lists are dropped
+    void Reset(default_amount_type list_amount, default_length_size posting_length) override
+    {
+        std::lock_guard<std::mutex> lock(lists_mutex);
+        if (!DataBlock::CanContain(posting_length))
+        {
+            throw std::runtime_error("posting of length " + std::to_string(posting_length) + " can not be stored in one block");
+        }
+        this->posting_length = posting_length;
+        std::ofstream(lw->cal_url_util->GetTableDataFile(db_name, file_name), std::ios::binary | std::ios::trunc).close();
+
+        list_heads.assign(list_amount, 0x0);
+        list_tails.assign(list_amount, 0x0);
+        list_sizes.assign(list_amount, 0);
+    }
+
+    // new blocks get addresses from the file length, so appends of all lists are serialized
+    void Append(default_amount_type list_no, const char* posting) override
+    {
+        std::lock_guard<std::mutex> lock(lists_mutex);
+
+        DataBlock block;
+        if (list_sizes[list_no] > 0)
+        {
+            lw->LoadBlockForWrite(db_name, file_name, list_tails[list_no], block);
+            if (block.HaveSpace(posting_length))
+            {
+                block.InsertData((char*) posting, posting_length);
+                lw->ReleaseWritingBlock(db_name, file_name, list_tails[list_no], block);
+                list_sizes[list_no]++;
+                return;
+            }
+        }
+
+        // write the new block before linking it, so a scanning chain never points to an unwritten block
+        DataBlock new_block;
+        default_address_type new_block_address = lw->CreateNewBlock(db_name, file_name, new_block);
+        new_block.InitBlock(posting_length);
+        new_block.InsertData((char*) posting, posting_length);
+        lw->ReleaseWritingBlock(db_name, file_name, new_block_address, new_block);
+
+        if (list_sizes[list_no] > 0)
+        {
+            block.next_block_pointer = new_block_address;
+            lw->ReleaseWritingBlock(db_name, file_name, list_tails[list_no], block);
+        }
+        else
+        {
+            list_heads[list_no] = new_block_address;
+        }
+        list_tails[list_no] = new_block_address;
+        list_sizes[list_no]++;
+    }
+
+    void Scan(const std::vector<default_amount_type>& list_nos, const std::function<void(const std::vector<VectorRun>&)>& scan_batch) override
+    {
+        // only the chains existing now are scanned, later appends are not waited for
+        std::vector<default_address_type> heads;
+        lists_mutex.lock();
+        for (default_amount_type list_no : list_nos)
+        {
+            if (list_sizes[list_no] > 0)
+            {
+                heads.push_back(list_heads[list_no]);
+            }
+        }
+        lists_mutex.unlock();
+
+        std::vector<default_address_type> batch_addresses;
+        std::vector<DataBlock> batch_blocks;
+        std::vector<VectorRun> runs;
+        size_t next_list = 0;
+        bool has_next_block = false;
+        default_address_type block_address = 0x0;
+        while (has_next_block || next_list < heads.size())
+        {
+            // load and pin one batch of blocks, which may belong to many lists
+            while ((has_next_block || next_list < heads.size()) && batch_blocks.size() < SEARCH_BATCH_BLOCK_AMOUNT)
+            {
+                if (!has_next_block)
+                {
+                    block_address = heads[next_list++];
+                }
+                DataBlock block;
+                lw->LoadBlockForRead(db_name, file_name, block_address, block);
+                if (block.field_data_nums > 0)
+                {
+                    runs.push_back(VectorRun{block.data + block.last_record_start_address, (default_long_int) block.field_data_nums, 0});
+                }
+                batch_addresses.push_back(block_address);
+                batch_blocks.push_back(block);
+                has_next_block = block.next_block_pointer != 0x0;
+                block_address = block.next_block_pointer;
+            }
+
+            scan_batch(runs);
+
+            for (size_t i = 0; i < batch_blocks.size(); i++)
+            {
+                lw->ReleaseReadingBlock(db_name, file_name, batch_addresses[i], batch_blocks[i]);
+            }
+            batch_addresses.clear();
+            batch_blocks.clear();
+            runs.clear();
+        }
+    }
+
+    default_long_int GetListSize(default_amount_type list_no) override
+    {
+        std::lock_guard<std::mutex> lock(lists_mutex);
+        return list_sizes[list_no];
+    }
+
+private:
+    LockWatcher* lw;
+    std::string db_name;
+    std::string file_name;
+    default_length_size posting_length;
+
+    std::vector<default_address_type> list_heads;
+    std::vector<default_address_type> list_tails;
+    std::vector<default_long_int> list_sizes;
+    std::mutex lists_mutex;
+};
+
+}
+
+#endif // VDBMS_STORAGE_BLOCK_POSTING_LIST_STORE_H_
@@ -0,0 +1,136 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : chain_read_ahead.h
+// since : 2024-09-10
+// desc  : Read ahead for a scan along a block chain. The address of the next
+// block is only known after a block is read, but blocks of a chain are
+// appended to the end of the data file, so they follow each other forward in
+// the file with the blocks of other columns between them. The region of file
+// where the next blocks of the chain should be is asked from the kernel in
+// background (posix_fadvise WILLNEED), while the scan works on the blocks it
+// has, so many reads are on the way instead of one.
+//
+// The window covers depth blocks of the chain, its length in file is depth
+// times the average gap between neighbor blocks of the chain. When the scan
+// enters the last window, the next window is read. The depth doubles when a
+// window is read and when the scan gets past the end of the window, as a fast
+// scan consumes windows sooner, and it is reset when the chain jumps back.
+
+#ifndef VDBMS_STORAGE_CHAIN_READ_AHEAD_H_
+#define VDBMS_STORAGE_CHAIN_READ_AHEAD_H_
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "../config.h"
+#include "file_descriptor_cache.h"
+
+namespace tiny_v_dbms {
+
+class ChainReadAhead
+{
+
+public:
+
+    /**
+     * @param file_path the data file of the chain.
+     * @throws std::runtime_error If the file can not be opened.
+     */
+    ChainReadAhead(const std::string& file_path)
+        : descriptor(FileDescriptorCache::GetInstance().Get(file_path)), stride(0), depth(READ_AHEAD_MIN_DEPTH),
+        window_begin(0), window_mark(0), window_end(0), read_ahead_blocks(0)
+    {
+    }
+
+    /**
+     * @brief Called when the scan knows the next block of the chain, before it works on the block at address,
+     * so the read ahead goes on while the scan is busy.
+     * @param address the block read last.
+     * @param next_address the next block of the chain, 0x0 at the end of chain.
+     */
+    void Advance(default_address_type address, default_address_type next_address)
+    {
+        if (next_address == 0x0)
+        {
+            return;
+        }
+        if (next_address <= address)
+        {
+            // the chain does not go forward in file, the region after it is not of the chain
+            depth = READ_AHEAD_MIN_DEPTH;
+            window_begin = window_mark = window_end = 0;
+            return;
+        }
+
+        double gap = next_address - address;
+        stride = stride == 0 ? gap : (stride * 3 + gap) / 4;
+
+        if (window_end == 0 || next_address < window_begin)
+        {
+            depth = READ_AHEAD_MIN_DEPTH;
+            ReadWindow(next_address, true);
+        }
+        else if (next_address >= window_end)
+        {
+            // the scan is faster than the read ahead
+            depth = std::min(depth * 2, (default_amount_type) READ_AHEAD_MAX_DEPTH);
+            ReadWindow(next_address, true);
+        }
+        else if (next_address >= window_mark)
+        {
+            depth = std::min(depth * 2, (default_amount_type) READ_AHEAD_MAX_DEPTH);
+            ReadWindow(window_end, false);
+        }
+    }
+
+    // blocks of chain read ahead by the next window
+    default_amount_type GetDepth() const
+    {
+        return depth;
+    }
+
+    // blocks of file asked to be read ahead
+    default_long_int GetReadAheadBlocks() const
+    {
+        return read_ahead_blocks;
+    }
+
+    // blocks [begin, end) of file are read ahead
+    default_address_type GetWindowBegin() const
+    {
+        return window_begin;
+    }
+
+    default_address_type GetWindowEnd() const
+    {
+        return window_end;
+    }
+
+private:
+    std::shared_ptr<FileDescriptor> descriptor;
+    double stride;                          // average gap of addresses between neighbor blocks of the chain
+    default_amount_type depth;
+    default_address_type window_begin;
+    default_address_type window_mark;       // first block of the last window
+    default_address_type window_end;
+    default_long_int read_ahead_blocks;
+
+    // restart begins a new region of read ahead, otherwise the window follows the last one
+    void ReadWindow(default_address_type from, bool restart)
+    {
+        default_address_type length = std::max<default_address_type>(1, (default_address_type) (depth * stride + 0.5));
+        descriptor->WillNeed((off_t) from * BLOCK_SIZE, (size_t) length * BLOCK_SIZE);
+        if (restart)
+        {
+            window_begin = from;
+        }
+        window_mark = from;
+        window_end = from + length;
+        read_ahead_blocks += length;
+    }
+};
+
+}
+
+#endif // VDBMS_STORAGE_CHAIN_READ_AHEAD_H_
@@ -0,0 +1,218 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : file_descriptor_cache.h
+// since : 2024-09-10
+// desc  : Keep the files read and written by block opened. A file is opened
+// once and its descriptor is shared by all threads, blocks are read and written
+// by pread / pwrite at their own offset, so no seek pointer is shared and no
+// file is opened or closed for one block. At most FILE_DESCRIPTOR_CACHE_CAPACITY
+// files stay open, the least recently used one is closed after its last user
+// releases it.
+
+#ifndef VDBMS_STORAGE_FILE_DESCRIPTOR_CACHE_H_
+#define VDBMS_STORAGE_FILE_DESCRIPTOR_CACHE_H_
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../config.h"
+
+namespace tiny_v_dbms {
+
+class FileDescriptor
+{
+
+public:
+
+    FileDescriptor(int fd) : fd(fd), last_use(0)
+    {
+    }
+
+    ~FileDescriptor()
+    {
+        close(fd);
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int Get() const
+    {
+        return fd;
+    }
+
+    /**
+     * @brief Read length bytes at offset, bytes after the end of file are read as 0.
+     * @throws std::runtime_error If the file can not be read.
+     */
+    void ReadAt(char* data, size_t length, off_t offset) const
+    {
+        size_t done = 0;
+        while (done < length)
+        {
+            ssize_t amount = pread(fd, data + done, length - done, offset + done);
+            if (amount < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (amount < 0)
+            {
+                throw std::runtime_error("Failed to read file: " + std::string(strerror(errno)));
+            }
+            if (amount == 0)
+            {
+                memset(data + done, 0, length - done);
+                return;
+            }
+            done += amount;
+        }
+    }
+
+    /**
+     * @brief Write length bytes at offset, the file grows if offset is after its end.
+     * @throws std::runtime_error If the file can not be written.
+     */
+    void WriteAt(const char* data, size_t length, off_t offset) const
+    {
+        size_t done = 0;
+        while (done < length)
+        {
+            ssize_t amount = pwrite(fd, data + done, length - done, offset + done);
+            if (amount < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (amount <= 0)
+            {
+                throw std::runtime_error("Failed to write file: " + std::string(strerror(errno)));
+            }
+            done += amount;
+        }
+    }
+
+    /**
+     * @brief Tell the kernel bytes at offset will be read soon, they are read into page cache in background.
+     * It is only a hint, errors are ignored.
+     */
+    void WillNeed(off_t offset, size_t length) const
+    {
+        posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+    }
+
+private:
+    int fd;
+    std::atomic<uint64_t> last_use;     // tick of the cache when it is got last time
+
+    friend class FileDescriptorCache;
+};
+
+class FileDescriptorCache
+{
+
+public:
+
+    // the cache shared by all users of block files
+    static FileDescriptorCache& GetInstance()
+    {
+        static FileDescriptorCache instance;
+        return instance;
+    }
+
+    /**
+     * @brief Get the opened descriptor of a file, open it if it is not in cache.
+     * @param create create the file if it does not exist.
+     * @throws std::runtime_error If the file can not be opened.
+     */
+    std::shared_ptr<FileDescriptor> Get(const std::string& file_path, bool create = false)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto iter = descriptors.find(file_path);
+            if (iter != descriptors.end())
+            {
+                iter->second->last_use = ++tick;
+                return iter->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto iter = descriptors.find(file_path);
+        if (iter != descriptors.end())
+        {
+            iter->second->last_use = ++tick;
+            return iter->second;
+        }
+
+        int fd = open(file_path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+        if (descriptors.size() >= FILE_DESCRIPTOR_CACHE_CAPACITY)
+        {
+            EvictLeastRecentlyUsed();
+        }
+        std::shared_ptr<FileDescriptor> descriptor = std::make_shared<FileDescriptor>(fd);
+        descriptor->last_use = ++tick;
+        descriptors[file_path] = descriptor;
+        return descriptor;
+    }
+
+    /**
+     * @brief Close the descriptor of a file once its users release it, called when the file is removed or replaced,
+     * so that the next Get opens the new file.
+     */
+    void Forget(const std::string& file_path)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        descriptors.erase(file_path);
+    }
+
+    // amount of files kept opened
+    size_t Size()
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return descriptors.size();
+    }
+
+private:
+
+    std::map<std::string, std::shared_ptr<FileDescriptor> > descriptors;
+    std::atomic<uint64_t> tick;
+    std::shared_mutex mutex;
+
+    FileDescriptorCache() : tick(0)
+    {
+    }
+
+    void EvictLeastRecentlyUsed()
+    {
+        auto oldest = descriptors.begin();
+        for (auto iter = descriptors.begin(); iter != descriptors.end(); iter++)
+        {
+            if (iter->second->last_use < oldest->second->last_use)
+            {
+                oldest = iter;
+            }
+        }
+        if (oldest != descriptors.end())
+        {
+            descriptors.erase(oldest);
+        }
+    }
+};
+
+}
+
+#endif // VDBMS_STORAGE_FILE_DESCRIPTOR_CACHE_H_
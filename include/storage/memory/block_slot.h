@@ -7,6 +7,8 @@
 #ifndef VDBMS_STORAGE_MEMORY_BLOCK_SLOT_H_
 #define VDBMS_STORAGE_MEMORY_BLOCK_SLOT_H_
 
+#include <new>
+#include <cstring>
 #include <string>
 #include <mutex>
 #include <shared_mutex>
@@ -39,7 +41,8 @@ struct BlockSlot
     // information about replace
     bool in_use;
     bool is_dirty;
-    int user_amount;
+    int user_amount;        // threads pinning the slot, including those waiting for its lock
+    bool loaded;            // false while the block is being read from disk, or if reading it failed
 
     // tools for cocurrent contro
     std::shared_mutex read_or_write_mutex;
@@ -47,14 +50,15 @@ struct BlockSlot
     // std::mutex update_struct_mutex; // used for thread waiting or awaken
     // std::condition_variable update_struct_cv;
 
-    BlockSlot()
+    BlockSlot() : in_use(false), is_dirty(false), user_amount(0), loaded(false)
     {
-        data = new char[BLOCK_SIZE];
+        // aligned, so vector records viewed in place keep the alignment of their offset in block
+        data = new (std::align_val_t(BLOCK_ALIGNMENT)) char[BLOCK_SIZE];
     }
 
     ~BlockSlot()
     {
-        delete[] data;
+        operator delete[](data, std::align_val_t(BLOCK_ALIGNMENT));
         read_or_write_mutex.unlock();
     }
 
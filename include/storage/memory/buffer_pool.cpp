@@ -9,7 +9,7 @@
 namespace tiny_v_dbms {
 
 
-BufferPool::BufferPool(std::vector<BlockSlot*>* slots) : slots(slots)
+BufferPool::BufferPool(std::vector<BlockSlot*>* slots) : slots(slots), release_times(0), no_space_failure_times(0)
 {
     replacer = new Replacer();
 }
@@ -63,14 +63,25 @@ std::list<BlockSlot*> BufferPool::FreeSpace()
     return free_list;
 }
 
-void BufferPool::WaitForSpace()
+uint64_t BufferPool::GetReleaseTimes()
 {
     std::unique_lock<std::mutex> lock(no_space_mutex);
-    no_space_cv.wait(lock);
+    return release_times;
+}
+
+void BufferPool::WaitForSpace(uint64_t release_times)
+{
+    // a slot released between the failed try and this wait has changed the counter, so it is not missed
+    std::unique_lock<std::mutex> lock(no_space_mutex);
+    no_space_cv.wait(lock, [&]() { return this->release_times != release_times; });
 }
 
 void BufferPool::WakeUpWaitingThread()
 {
+    {
+        std::unique_lock<std::mutex> lock(no_space_mutex);
+        release_times++;
+    }
     no_space_cv.notify_all();
 }
 
@@ -7,6 +7,7 @@
 #ifndef VDBMS_STORAGE_MEMORY_BUFFER_POOL_H_
 #define VDBMS_STORAGE_MEMORY_BUFFER_POOL_H_
 
+#include <cstdint>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
@@ -25,6 +26,7 @@ private:
     std::mutex slots_mutex;
     std::mutex no_space_mutex;
     std::condition_variable no_space_cv;
+    uint64_t release_times;             // times slots are released, guarded by no_space_mutex
 
     std::mutex no_space_failure_times_mutex;
     int no_space_failure_times;
@@ -44,10 +46,13 @@ public:
     // this function will notify all threads waiting for space, and they will compete for space again.
     std::list<BlockSlot*> FreeSpace();
 
-    // make now thread wait for space.
-    void WaitForSpace();
+    // times slots are released, got before trying to get a free slot, and passed to WaitForSpace if it fails.
+    uint64_t GetReleaseTimes();
 
-    // wake up all thread waiting for space, make them try allocate slot again.
+    // make now thread wait for space, until a slot is released after release_times were got.
+    void WaitForSpace(uint64_t release_times);
+
+    // count a release and wake up all thread waiting for space, make them try allocate slot again.
     void WakeUpWaitingThread();
 };
 
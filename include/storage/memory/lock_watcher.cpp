@@ -23,7 +23,7 @@ LockWatcher::LockWatcher(default_amount_type slots_amount)
     cal_url_util = new CalFileUrlUtil();
     buffer_pool = new BufferPool(&slots);
     bfmm = new BlockFileManagement();
-    cal_url_util = new CalFileUrlUtil();
+    async_reader = new AsyncBlockReader();
 }
 
 LockWatcher::~LockWatcher()
@@ -38,183 +38,165 @@ LockWatcher::~LockWatcher()
     delete cal_url_util;
     delete buffer_pool;
     delete bfmm;
-    delete cal_url_util;
+    delete async_reader;
 }
 
 void LockWatcher::LoadBlockForRead(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block)
 {
     SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
+    BlockSlot* slot = AcquireSlot(sign, false, [&](char* data) {
+        bfmm->ReadOneDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, data);
+    });
 
-    // firstly check in map
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {   
-        slots_map[sign]->read_or_write_mutex.lock_shared();
-
-        slots_map[sign]->in_use = true;
-        slots_map[sign]->user_amount++;
-        block.data = slots_map[sign]->data;
-        block.DeserializeFromBuffer(block.data);
-
-        return;
-    }
-
-    BlockSlot* slot;
-    // get one free slot
-    while (!buffer_pool->GetFreeSlot(slot))
-    {
-        slots_map_mutex.unlock();
-        buffer_pool->WaitForSpace();
-        slots_map_mutex.lock();
-    }
-
-    // update slot information
-    slot->read_or_write_mutex.lock_shared();
-    slot->in_use = true;
-    slot->user_amount++;
-
-    // update map
-    slots_map[sign] = slot;
-    // set pointer
     block.data = slot->data;
-    // load data
-    bfmm->ReadOneDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, block);
-
-    slots_map_mutex.unlock();
+    block.DeserializeFromBuffer(block.data);
 }   
 
 void LockWatcher::LoadBlockForWrite(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block)
 {
     SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
-    BlockSlot* slot;
-
-    // firstly check in map
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {   
-        slots_map[sign]->read_or_write_mutex.lock();
-
-        slot = slots_map[sign];
-        slot->in_use = true;
-        slot->user_amount = 1;
-        block.data = slot->data;
-        block.DeserializeFromBuffer(block.data);
-
-        return;
-    }
-
-    // get one free slot
-    while (!buffer_pool->GetFreeSlot(slot))
-    {
-        slots_map_mutex.unlock();
-        buffer_pool->WaitForSpace();
-        slots_map_mutex.lock();
-    }
-
-    // update slot information
-    slot->read_or_write_mutex.lock();
-    slot->in_use = true;
-    slot->user_amount = 1;
+    BlockSlot* slot = AcquireSlot(sign, true, [&](char* data) {
+        bfmm->ReadOneDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, data);
+    });
 
-    // update map
-    slots_map[sign] = slot;
-    // set pointer
     block.data = slot->data;
-    // load data
-    bfmm->ReadOneDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, block);
-
-    slots_map_mutex.unlock();
+    block.DeserializeFromBuffer(block.data);
 }
 
 void LockWatcher::LoadBlockForRead(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block)
 {
     SlotSign sign = slot_tool->GetSign(db_name, table_name + ".header", offset);
-    BlockSlot* slot;
-    
-    // firstly check in map
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {   
-        slot = slots_map[sign];
-        slot->read_or_write_mutex.lock_shared();
-
-        slot->in_use = true;
-        slot->user_amount++;
-        block.data = slot->data;
-        
-        block.DeserializeFromBuffer(block.data);
-
-        return;
-    }
-
-    // get one free slot
-    while (!buffer_pool->GetFreeSlot(slot))
-    {
-        slots_map_mutex.unlock();
-        buffer_pool->WaitForSpace();
-        slots_map_mutex.lock();
-    }
+    BlockSlot* slot = AcquireSlot(sign, false, [&](char* data) {
+        bfmm->ReadOneTableBlock(cal_url_util->GetTableHeaderFile(db_name), offset, data);
+    });
 
-    // update slot information
-    slot->read_or_write_mutex.lock_shared();
-    slot->in_use = true;
-    slot->user_amount++;
-
-    // update map
-    slots_map[sign] = slot;
-    // set pointer
     block.data = slot->data;
-    // load data
-    bfmm->ReadOneTableBlock(cal_url_util->GetTableHeaderFile(db_name), offset, block);
-
-    slots_map_mutex.unlock();
+    block.DeserializeFromBuffer(block.data);
 }   
 
 void LockWatcher::LoadBlockForWrite(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block)
 {
     SlotSign sign = slot_tool->GetSign(db_name, table_name + ".header", offset);
-    BlockSlot* slot;
+    BlockSlot* slot = AcquireSlot(sign, true, [&](char* data) {
+        bfmm->ReadOneTableBlock(cal_url_util->GetTableHeaderFile(db_name), offset, data);
+    });
 
-    // firstly check in map
-    slots_map_mutex.lock();
+    block.data = slot->data;
+    block.DeserializeFromBuffer(block.data);
+}
 
-    if (slots_map.find(sign) != slots_map.end())
-    {   
-        slots_map[sign]->read_or_write_mutex.lock();
+/**
+ * @brief Load many data blocks of one file for reading. Slots of missing blocks are reserved first, then their
+ * reads are submitted together by the async reader, so they are read at the same time instead of one by one.
+ * Only the first block waits for a free slot, the batch is cut at the first block getting none, so a batch
+ * never waits for space while holding slots, and two batches larger than the free slots do not wait for each other.
+ * Each loaded block must be released by ReleaseReadingBlock.
+ * @param blocks resized to the amount of loaded blocks, at least one if offsets is not empty, blocks[i] is the
+ * block at offsets[i]. The caller loads the rest of offsets by another call.
+ * @throws std::runtime_error If a block can not be read, or buffer pool has no space, no block is pinned then.
+ */
+void LockWatcher::LoadBlocksForRead(std::string db_name, std::string table_name, const std::vector<default_address_type>& offsets, std::vector<DataBlock>& blocks)
+{
+    std::string data_file = cal_url_util->GetTableDataFile(db_name, table_name);
+    std::vector<SlotSign> signs;
+    std::vector<BlockSlot*> batch_slots;
+    std::vector<bool> reserved_slots;
+    std::vector<BlockReadRequest> requests;
 
-        slot = slots_map[sign];
-        slot->in_use = true;
-        slot->user_amount = 1;
-        block.data = slot->data;
-        block.DeserializeFromBuffer(block.data);
+    slots_map_mutex.lock();
+    try
+    {
+        for (default_address_type offset : offsets)
+        {
+            bool reserved;
+            SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
+            BlockSlot* slot = ReserveSlot(sign, reserved, batch_slots.empty());
+            if (slot == nullptr)
+            {
+                break;
+            }
+            signs.push_back(sign);
+            batch_slots.push_back(slot);
+            reserved_slots.push_back(reserved);
+            if (reserved)
+            {
+                requests.push_back(BlockReadRequest{data_file, offset, slot->data});
+            }
+        }
+    }
+    catch (...)
+    {
+        // buffer pool gives up, reserved slots are not loaded, so they are dropped
+        for (size_t i = 0; i < batch_slots.size(); i++)
+        {
+            if (reserved_slots[i])
+            {
+                batch_slots[i]->read_or_write_mutex.unlock();
+                slots_map.erase(signs[i]);
+            }
+            UnpinSlot(signs[i], batch_slots[i]);
+        }
+        slots_map_mutex.unlock();
+        throw;
+    }
+    slots_map_mutex.unlock();
 
-        return;
+    bool read_failed = false;
+    try
+    {
+        async_reader->ReadBatch(requests);
+    }
+    catch (...)
+    {
+        read_failed = true;
     }
 
-    // get one free slot
-    while (!buffer_pool->GetFreeSlot(slot))
+    // publish the loaded blocks before waiting for others, a block may be twice in offsets
+    for (size_t i = 0; i < batch_slots.size(); i++)
     {
-        slots_map_mutex.unlock();
-        buffer_pool->WaitForSpace();
-        slots_map_mutex.lock();
+        if (reserved_slots[i])
+        {
+            batch_slots[i]->loaded = !read_failed;
+            batch_slots[i]->read_or_write_mutex.unlock();
+        }
     }
 
-    // update slot information
-    slot->read_or_write_mutex.lock();
-    slot->in_use = true;
-    slot->user_amount = 1;
+    std::vector<bool> locked(batch_slots.size(), false);
+    bool all_loaded = !read_failed;
+    for (size_t i = 0; i < batch_slots.size() && all_loaded; i++)
+    {
+        locked[i] = LockPinnedSlot(batch_slots[i], false);
+        all_loaded = locked[i];
+    }
 
-    // update map
-    slots_map[sign] = slot;
-    // set pointer
-    block.data = slot->data;
-    // load data
-    bfmm->ReadOneTableBlock(cal_url_util->GetTableHeaderFile(db_name), offset, block);
+    if (!all_loaded)
+    {
+        for (size_t i = 0; i < batch_slots.size(); i++)
+        {
+            if (locked[i])
+            {
+                batch_slots[i]->read_or_write_mutex.unlock_shared();
+            }
+        }
+        slots_map_mutex.lock();
+        for (size_t i = 0; i < batch_slots.size(); i++)
+        {
+            if (reserved_slots[i] && read_failed)
+            {
+                slots_map.erase(signs[i]);
+            }
+            UnpinSlot(signs[i], batch_slots[i]);
+        }
+        slots_map_mutex.unlock();
+        throw std::runtime_error("Failed to load blocks of " + table_name);
+    }
 
-    slots_map_mutex.unlock();
+    blocks.resize(batch_slots.size());
+    for (size_t i = 0; i < batch_slots.size(); i++)
+    {
+        blocks[i].data = batch_slots[i]->data;
+        blocks[i].DeserializeFromBuffer(blocks[i].data);
+    }
 }
 
 bool LockWatcher::UpgradeLock(std::string db_name, std::string table_name, default_address_type offset)
@@ -227,50 +209,12 @@ bool LockWatcher::UpgradeLock(std::string db_name, std::string table_name, defau
  */
 void LockWatcher::ReleaseReadingBlock(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block)
 {   
-    SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
-
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {
-        BlockSlot* slot = slots_map[sign];
-        slot->user_amount--;
-        if (slot->user_amount == 0)
-        {
-            slot->in_use = false;
-        } 
-
-        // remove from map
-        slots_map.erase(sign);
-        // release lock
-        slot->read_or_write_mutex.unlock_shared();
-    }
-
-    slots_map_mutex.unlock();
+    ReleaseSlot(slot_tool->GetSign(db_name, table_name, offset), false, nullptr);
 }
 
 void LockWatcher::ReleaseReadingBlock(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block)
 {   
-    SlotSign sign = slot_tool->GetSign(db_name, table_name + ".header", offset);
-
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {
-        BlockSlot* slot = slots_map[sign];
-        slot->user_amount--;
-        if (slot->user_amount == 0)
-        {
-            slot->in_use = false;
-        } 
-
-        // remove from map
-        slots_map.erase(sign);
-        // release lock
-        slot->read_or_write_mutex.unlock_shared();
-    }
-
-    slots_map_mutex.unlock();
+    ReleaseSlot(slot_tool->GetSign(db_name, table_name + ".header", offset), false, nullptr);
 }
 
 void LockWatcher::ReleaseWritingBlock(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block)
@@ -278,26 +222,19 @@ void LockWatcher::ReleaseWritingBlock(std::string db_name, std::string table_nam
     block.Serialize();
 
     // flush to disk
-    SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
-
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {
-        BlockSlot* slot = slots_map[sign];
-        // flush to disk
-        bfmm->WriteBackDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, slots_map[sign]->data);
-        
-        // use buffer pool to realse slot
-        buffer_pool->ReleaseSlot(slot);
-
-        // remove from map
-        slots_map.erase(sign);
-        // release lock
-        slot->read_or_write_mutex.unlock();
-    }
+    ReleaseSlot(slot_tool->GetSign(db_name, table_name, offset), true, [&](char* data) {
+        bfmm->WriteBackDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, data);
+    });
+}
 
-    slots_map_mutex.unlock();
+/**
+ * @brief Write a block locked for writing to disk and keep holding it, so a change is on disk before something
+ * depending on it is written.
+ */
+void LockWatcher::FlushWritingBlock(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block)
+{
+    block.Serialize();
+    bfmm->WriteBackDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, block.data);
 }
 
 void LockWatcher::ReleaseWritingBlock(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block)
@@ -305,26 +242,9 @@ void LockWatcher::ReleaseWritingBlock(std::string db_name, std::string table_nam
     block.SerializeHeader();
 
     // flush to disk
-    SlotSign sign = slot_tool->GetSign(db_name, table_name + ".header", offset);
-
-    slots_map_mutex.lock();
-
-    if (slots_map.find(sign) != slots_map.end())
-    {
-        BlockSlot* slot = slots_map[sign];
-        // flush to disk
+    ReleaseSlot(slot_tool->GetSign(db_name, table_name + ".header", offset), true, [&](char* data) {
         bfmm->WriteBackTableBlock(cal_url_util->GetTableHeaderFile(db_name), offset, block);
-        
-        // use buffer pool to realse slot
-        buffer_pool->ReleaseSlot(slot);
-
-        // remove from map
-        slots_map.erase(sign);
-        // release lock
-        slot->read_or_write_mutex.unlock();
-    }
-
-    slots_map_mutex.unlock();
+    });
 }
 
 default_address_type LockWatcher::CreateNewBlock(std::string db_name, std::string table_name, DataBlock& block)
@@ -338,17 +258,20 @@ default_address_type LockWatcher::CreateNewBlock(std::string db_name, std::strin
     SlotSign sign = slot_tool->GetSign(db_name, table_name, new_block_offset);
 
     // get one free slot
+    uint64_t release_times = buffer_pool->GetReleaseTimes();
     while (!buffer_pool->GetFreeSlot(slot))
     {
         slots_map_mutex.unlock();
-        buffer_pool->WaitForSpace();
+        buffer_pool->WaitForSpace(release_times);
         slots_map_mutex.lock();
+        release_times = buffer_pool->GetReleaseTimes();
     }
 
     // update slot information
-    slot->read_or_write_mutex.lock();
+    LockFreeSlot(slot);
     slot->in_use = true;
-    slot->user_amount++;
+    slot->user_amount = 1;
+    slot->loaded = true;
     slot->Clear();
 
     // update map
@@ -374,17 +297,20 @@ default_address_type LockWatcher::CreateNewBlock(std::string db_name, std::strin
     SlotSign sign = slot_tool->GetSign(db_name, table_name+ ".header", new_block_offset);
 
     // get one free slot
+    uint64_t release_times = buffer_pool->GetReleaseTimes();
     while (!buffer_pool->GetFreeSlot(slot))
     {
         slots_map_mutex.unlock();
-        buffer_pool->WaitForSpace();
+        buffer_pool->WaitForSpace(release_times);
         slots_map_mutex.lock();
+        release_times = buffer_pool->GetReleaseTimes();
     }
 
     // update slot information
-    slot->read_or_write_mutex.lock();
+    LockFreeSlot(slot);
     slot->in_use = true;
-    slot->user_amount++;
+    slot->user_amount = 1;
+    slot->loaded = true;
     slot->Clear();
 
     // update map
@@ -400,4 +326,251 @@ default_address_type LockWatcher::CreateNewBlock(std::string db_name, std::strin
     return new_block_offset;
 }
 
-}
\ No newline at end of file
+/**
+ * @brief Keep a data block in buffer pool without locking it, until UnpinBlock, so it is not read from disk again
+ * by later loads. Pinning a block held by this thread only counts the pin.
+ * @throws std::runtime_error If the block can not be loaded.
+ */
+void LockWatcher::PinBlock(std::string db_name, std::string table_name, default_address_type offset)
+{
+    SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
+    slots_map_mutex.lock();
+    auto iter = slots_map.find(sign);
+    if (iter != slots_map.end())
+    {
+        iter->second->in_use = true;
+        iter->second->user_amount++;
+        slots_map_mutex.unlock();
+        return;
+    }
+    slots_map_mutex.unlock();
+
+    BlockSlot* slot = AcquireSlot(sign, false, [&](char* data) {
+        bfmm->ReadOneDataBlock(cal_url_util->GetTableDataFile(db_name, table_name), offset, data);
+    });
+    slot->read_or_write_mutex.unlock_shared();
+}
+
+/**
+ * @brief Drop the pin got by PinBlock.
+ */
+void LockWatcher::UnpinBlock(std::string db_name, std::string table_name, default_address_type offset)
+{
+    SlotSign sign = slot_tool->GetSign(db_name, table_name, offset);
+    slots_map_mutex.lock();
+    auto iter = slots_map.find(sign);
+    if (iter != slots_map.end())
+    {
+        UnpinSlot(sign, iter->second);
+    }
+    slots_map_mutex.unlock();
+}
+
+/**
+ * @brief Pin the slot of a block and lock it. If the block is not in buffer pool, a slot is reserved for it and
+ * load reads the block into the slot, slots_map_mutex is not held while reading or waiting for the lock.
+ * @throws std::runtime_error If the block can not be loaded.
+ */
+BlockSlot* LockWatcher::AcquireSlot(const SlotSign& sign, bool for_write, const std::function<void(char*)>& load)
+{
+    slots_map_mutex.lock();
+    bool reserved;
+    BlockSlot* slot;
+    try
+    {
+        slot = ReserveSlot(sign, reserved);
+    }
+    catch (...)
+    {
+        slots_map_mutex.unlock();
+        throw;
+    }
+    slots_map_mutex.unlock();
+
+    if (!reserved)
+    {
+        if (!LockPinnedSlot(slot, for_write))
+        {
+            slots_map_mutex.lock();
+            UnpinSlot(sign, slot);
+            slots_map_mutex.unlock();
+            throw std::runtime_error("Failed to load block of " + sign.table_name);
+        }
+        return slot;
+    }
+
+    try
+    {
+        load(slot->data);
+    }
+    catch (...)
+    {
+        // threads waiting for the slot find it not loaded, later ones read the block again by a new slot
+        slot->read_or_write_mutex.unlock();
+        slots_map_mutex.lock();
+        slots_map.erase(sign);
+        UnpinSlot(sign, slot);
+        slots_map_mutex.unlock();
+        throw;
+    }
+    slot->loaded = true;
+
+    if (!for_write)
+    {
+        slot->read_or_write_mutex.unlock();
+        slot->read_or_write_mutex.lock_shared();
+    }
+    return slot;
+}
+
+/**
+ * @brief Pin the slot of a block in the map, or reserve a free slot for it. A reserved slot is locked for writing
+ * and not loaded, the caller loads it. Called with slots_map_mutex locked, it is unlocked while waiting for space.
+ * @param reserved set true if a new slot is reserved.
+ * @param wait wait for a free slot, or return nullptr if there is none.
+ * @throws std::runtime_error If buffer pool gives up getting a free slot, slots_map_mutex is still locked then.
+ */
+BlockSlot* LockWatcher::ReserveSlot(const SlotSign& sign, bool& reserved, bool wait)
+{
+    BlockSlot* slot;
+    while (true)
+    {
+        auto iter = slots_map.find(sign);
+        if (iter != slots_map.end())
+        {
+            slot = iter->second;
+            slot->in_use = true;
+            slot->user_amount++;
+            reserved = false;
+            return slot;
+        }
+
+        // get one free slot
+        uint64_t release_times = buffer_pool->GetReleaseTimes();
+        if (buffer_pool->GetFreeSlot(slot))
+        {
+            break;
+        }
+        if (!wait)
+        {
+            return nullptr;
+        }
+        slots_map_mutex.unlock();
+        buffer_pool->WaitForSpace(release_times);
+        slots_map_mutex.lock();
+    }
+
+    // update slot information, no thread pins a free slot so its lock is free
+    LockFreeSlot(slot);
+    slot->in_use = true;
+    slot->user_amount = 1;
+    slot->loaded = false;
+
+    // update map
+    slots_map[sign] = slot;
+    reserved = true;
+    return slot;
+}
+
+/**
+ * @brief Lock a slot got from buffer pool for writing. Called with slots_map_mutex locked, the lock of a free slot
+ * is never held, so it is got without waiting.
+ */
+void LockWatcher::LockFreeSlot(BlockSlot* slot)
+{
+    if (!slot->read_or_write_mutex.try_lock())
+    {
+        throw std::runtime_error("Free slot of buffer pool is still locked!");
+    }
+}
+
+/**
+ * @brief Lock a pinned slot, wait until its block is loaded.
+ * @return false if loading the block failed, the slot is not locked then.
+ */
+bool LockWatcher::LockPinnedSlot(BlockSlot* slot, bool for_write)
+{
+    if (for_write)
+    {
+        slot->read_or_write_mutex.lock();
+    }
+    else
+    {
+        slot->read_or_write_mutex.lock_shared();
+    }
+
+    if (slot->loaded)
+    {
+        return true;
+    }
+
+    if (for_write)
+    {
+        slot->read_or_write_mutex.unlock();
+    }
+    else
+    {
+        slot->read_or_write_mutex.unlock_shared();
+    }
+    return false;
+}
+
+/**
+ * @brief Drop one pin of a slot, the slot is removed from map and freed when no thread pins it.
+ * Called with slots_map_mutex locked.
+ */
+void LockWatcher::UnpinSlot(const SlotSign& sign, BlockSlot* slot)
+{
+    slot->user_amount--;
+    if (slot->user_amount > 0)
+    {
+        return;
+    }
+
+    auto iter = slots_map.find(sign);
+    if (iter != slots_map.end() && iter->second == slot)
+    {
+        slots_map.erase(iter);
+    }
+    buffer_pool->ReleaseSlot(slot);
+    buffer_pool->WakeUpWaitingThread();
+}
+
+/**
+ * @brief Unlock and unpin the slot of a block.
+ * @param write_back writes the block to disk before unlocking, nullptr if not needed. It is called without
+ * slots_map_mutex, the slot is still locked so the block is not changed.
+ */
+void LockWatcher::ReleaseSlot(const SlotSign& sign, bool for_write, const std::function<void(char*)>& write_back)
+{
+    // the slot is pinned by this thread, so it stays in map
+    slots_map_mutex.lock();
+    auto iter = slots_map.find(sign);
+    BlockSlot* slot = iter == slots_map.end() ? nullptr : iter->second;
+    slots_map_mutex.unlock();
+    if (slot == nullptr)
+    {
+        return;
+    }
+
+    if (write_back != nullptr)
+    {
+        write_back(slot->data);
+    }
+
+    // release lock, the slot is not reused before it is unpinned
+    if (for_write)
+    {
+        slot->read_or_write_mutex.unlock();
+    }
+    else
+    {
+        slot->read_or_write_mutex.unlock_shared();
+    }
+
+    slots_map_mutex.lock();
+    UnpinSlot(sign, slot);
+    slots_map_mutex.unlock();
+}
+
+}
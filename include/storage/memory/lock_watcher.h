@@ -2,11 +2,18 @@
 //
 // file  : lock_watcher.h
 // since : 2024-08-15
-// desc  : TODO.
+// desc  : Pin blocks of files in slots of the buffer pool and lock them for
+// reading or writing. slots_map_mutex only guards the map from block to slot
+// and the pins of slots, it is never held while a block is read or written,
+// or while waiting for the lock of a slot. A block missing in buffer pool gets
+// a slot which is locked for writing and put into the map before reading, so
+// other threads wanting the same block pin that slot and wait on its lock
+// until it is loaded.
 
 #ifndef VDBMS_STORAGE_MEMORY_LOCK_WATCHER_H_
 #define VDBMS_STORAGE_MEMORY_LOCK_WATCHER_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <map>
@@ -15,6 +22,7 @@
 #include "./buffer_pool.h"
 #include "./block_slot.h"
 #include "../block_file_management.h"
+#include "../async_block_reader.h"
 #include "../../config.h"
 #include "../../utils/cal_file_url_util.h"
 
@@ -26,12 +34,20 @@ class LockWatcher
 private:
     BufferPool* buffer_pool;
     BlockFileManagement* bfmm;
+    AsyncBlockReader* async_reader;
 
     SlotTool* slot_tool;
 
     std::vector<BlockSlot*> slots;
     std::map<SlotSign, BlockSlot*> slots_map;
     std::mutex slots_map_mutex;
+
+    BlockSlot* AcquireSlot(const SlotSign& sign, bool for_write, const std::function<void(char*)>& load);
+    BlockSlot* ReserveSlot(const SlotSign& sign, bool& reserved, bool wait = true);
+    void LockFreeSlot(BlockSlot* slot);
+    bool LockPinnedSlot(BlockSlot* slot, bool for_write);
+    void UnpinSlot(const SlotSign& sign, BlockSlot* slot);
+    void ReleaseSlot(const SlotSign& sign, bool for_write, const std::function<void(char*)>& write_back);
     
 public:
     CalFileUrlUtil* cal_url_util;
@@ -46,6 +62,8 @@ public:
 
     void LoadBlockForRead(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block);
 
+    void LoadBlocksForRead(std::string db_name, std::string table_name, const std::vector<default_address_type>& offsets, std::vector<DataBlock>& blocks);
+
     void LoadBlockForWrite(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block);
 
     bool UpgradeLock(std::string db_name, std::string table_name, default_address_type offset);
@@ -54,10 +72,14 @@ public:
     void ReleaseReadingBlock(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block);
 
     void ReleaseWritingBlock(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block);
+    void FlushWritingBlock(std::string db_name, std::string table_name, default_address_type offset, DataBlock& block);
     void ReleaseWritingBlock(std::string db_name, std::string table_name, default_address_type offset, TableBlock& block);
 
     default_address_type CreateNewBlock(std::string db_name, std::string table_name, DataBlock& block);
     default_address_type CreateNewBlock(std::string db_name, std::string table_name, TableBlock& block);
+
+    void PinBlock(std::string db_name, std::string table_name, default_address_type offset);
+    void UnpinBlock(std::string db_name, std::string table_name, default_address_type offset);
 };
 
 }
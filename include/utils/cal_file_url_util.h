@@ -102,6 +102,18 @@ public:
         // install/db_name/tables/data/table_name.data
         return GetDefaultTablePath(db_name) + "/" + DEFAULT_TABLE_DATA_FOLDER + "/" + table_name + TABLE_DATA_FILE_SUFFIX;
     }
+
+    string GetIndexFile(string db_name, string table_name, string column_name)
+    {
+        // install/db_name/tables/data/table_name.column_name.index
+        return GetDefaultTablePath(db_name) + "/" + DEFAULT_TABLE_DATA_FOLDER + "/" + table_name + "." + column_name + INDEX_FILE_SUFFIX;
+    }
+
+    string GetBlockDirectoryFile(string db_name, string table_name)
+    {
+        // install/db_name/tables/table_name.dir
+        return GetDefaultTablePath(db_name) + "/" + table_name + BLOCK_DIRECTORY_FILE_SUFFIX;
+    }
 };
 
 }
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : cpu_feature_util.h
+// since : 2024-09-02
+// desc  : This is a util to detect which simd instruction sets the running cpu
+// supports. The result is detected once by cpuid and cached, so the distance
+// kernels can be chosen at startup.
+
+#ifndef UTILS_CPU_FEATURE_UTIL_H_
+#define UTILS_CPU_FEATURE_UTIL_H_
+
+#include <cstdlib>
+#include <string>
+
+namespace tiny_v_dbms {
+
+// the simd level used by distance kernels, a higher level contains all lower levels
+enum SimdLevel
+{
+    SCALAR_LEVEL,
+    SSE_LEVEL,      // sse2
+    AVX2_LEVEL,     // avx2 + fma
+    AVX512_LEVEL    // avx512f
+};
+
+struct CpuFeature
+{
+    bool sse2 = false;
+    bool ssse3 = false;         // byte shuffle, used by pq fast scan
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool f16c = false;          // half float conversion, used by fp16 element kernels
+    bool popcnt = false;
+    bool avx512vpopcntdq = false;   // popcount on 64 bit lanes of zmm, used by hamming distance
+};
+
+class CpuFeatureUtil
+{
+
+public:
+
+    /**
+     * @brief Get the features of the running cpu, detected only once.
+     * @return The cached cpu feature.
+     */
+    static const CpuFeature& GetFeature()
+    {
+        static CpuFeature feature = DetectFeature();
+        return feature;
+    }
+
+    /**
+     * @brief Get the highest simd level can be used on the running cpu.
+     * The level can be limited by env TVDBMS_SIMD_LEVEL (scalar, sse, avx2, avx512),
+     * this is useful when comparing kernels or running on a machine with bad avx512 frequency.
+     * @return The simd level.
+     */
+    static SimdLevel GetSimdLevel()
+    {
+        static SimdLevel level = DetectSimdLevel();
+        return level;
+    }
+
+    static const char* GetSimdLevelName(SimdLevel level)
+    {
+        switch (level)
+        {
+            case SSE_LEVEL:
+                return "sse";
+            case AVX2_LEVEL:
+                return "avx2";
+            case AVX512_LEVEL:
+                return "avx512";
+            default:
+                return "scalar";
+        }
+    }
+
+private:
+
+    static CpuFeature DetectFeature()
+    {
+        CpuFeature feature;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        feature.sse2 = __builtin_cpu_supports("sse2");
+        feature.ssse3 = __builtin_cpu_supports("ssse3");
+        feature.avx2 = __builtin_cpu_supports("avx2");
+        feature.fma = __builtin_cpu_supports("fma");
+        feature.avx512f = __builtin_cpu_supports("avx512f");
+        feature.f16c = __builtin_cpu_supports("f16c");
+        feature.popcnt = __builtin_cpu_supports("popcnt");
+        feature.avx512vpopcntdq = __builtin_cpu_supports("avx512vpopcntdq");
+#endif
+        return feature;
+    }
+
+    static SimdLevel DetectSimdLevel()
+    {
+        const CpuFeature& feature = GetFeature();
+
+        SimdLevel level = SCALAR_LEVEL;
+        if (feature.sse2)
+        {
+            level = SSE_LEVEL;
+        }
+        if (feature.avx2 && feature.fma)
+        {
+            level = AVX2_LEVEL;
+        }
+        if (feature.avx512f && level == AVX2_LEVEL)
+        {
+            level = AVX512_LEVEL;
+        }
+
+        // user can only lower the level, never raise it higher than cpu supports
+        const char* limit = std::getenv("TVDBMS_SIMD_LEVEL");
+        if (limit != nullptr)
+        {
+            std::string limit_str(limit);
+            SimdLevel limit_level = level;
+            if (limit_str == "scalar")
+                limit_level = SCALAR_LEVEL;
+            else if (limit_str == "sse")
+                limit_level = SSE_LEVEL;
+            else if (limit_str == "avx2")
+                limit_level = AVX2_LEVEL;
+
+            if (limit_level < level)
+            {
+                level = limit_level;
+            }
+        }
+
+        return level;
+    }
+};
+
+}
+
+#endif // UTILS_CPU_FEATURE_UTIL_H_
@@ -0,0 +1,55 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : vector_normalize_util.h
+// since : 2024-09-05
+// desc  : This is a util to l2 normalize vectors. Columns with the NORMALIZE
+// option store normalized vectors, so cosine distance on them is only an inner
+// product, and no norm needs to be calculated while searching.
+
+#ifndef UTILS_VECTOR_NORMALIZE_UTIL_H_
+#define UTILS_VECTOR_NORMALIZE_UTIL_H_
+
+#include <cmath>
+
+#include "../config.h"
+#include "../distance/kernel/kernel_dispatcher.h"
+
+namespace tiny_v_dbms {
+
+class VectorNormalizeUtil
+{
+
+public:
+
+    // get the l2 norm of a vector
+    static double Norm(const double* data, default_length_size length)
+    {
+        return std::sqrt(KernelDispatcher::GetKernels().inner_product(data, data, length));
+    }
+
+    /**
+     * @brief Normalize the vector in place, so its l2 norm is 1.
+     * @param data vector data.
+     * @param length length of the vector.
+     * @return False if the vector is a zero vector, it can not be normalized and is not changed.
+     */
+    static bool Normalize(double* data, default_length_size length)
+    {
+        double norm = Norm(data, length);
+        if (norm == 0)
+        {
+            return false;
+        }
+
+        double scale = 1.0 / norm;
+        for (default_length_size i = 0; i < length; i++)
+        {
+            data[i] *= scale;
+        }
+        return true;
+    }
+};
+
+}
+
+#endif // UTILS_VECTOR_NORMALIZE_UTIL_H_
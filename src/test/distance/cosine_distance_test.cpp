@@ -0,0 +1,32 @@
+#include <iostream>
+#include "../../../include/distance/cosine_distance.h"
+
+#define TestDistance CosineDistance<double>
+
+using namespace tiny_v_dbms;
+
+int main() {
+    double data[5] = {5, 4, 3, 2, 1};
+    BASE_VECTOR first_vector(data, 5);
+
+    double second_data[5] = {1, 2, 1, 4, 5};
+    BASE_VECTOR second_vector(second_data, 5);
+
+    std::cout << "test begin" << std::endl;
+
+    TestDistance test_object;
+    double result = test_object.Cal(first_vector, second_vector);
+
+    std::cout << "result" << result << std::endl;
+
+    // normalize on insert, then cosine is only an inner product
+    VectorNormalizeUtil::Normalize(data, 5);
+    VectorNormalizeUtil::Normalize(second_data, 5);
+    BASE_VECTOR first_normalized(data, 5);
+    BASE_VECTOR second_normalized(second_data, 5);
+
+    TestDistance normalized_object(true);
+    std::cout << "normalized result" << normalized_object.Cal(first_normalized, second_normalized) << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : element_kernel_test.cpp
+// since : 2024-09-07
+// desc  : check mixed precision kernels of each element type get the same result as decoding the stored vectors, and show the cost.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/distance/mixed_precision_query.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    // conversion of special values
+    bool convert_right = ElementTypeUtil::HalfToFloat(ElementTypeUtil::FloatToHalf(1.0f)) == 1.0f
+        && ElementTypeUtil::HalfToFloat(ElementTypeUtil::FloatToHalf(-0.5f)) == -0.5f
+        && ElementTypeUtil::HalfToFloat(ElementTypeUtil::FloatToHalf(65504.0f)) == 65504.0f
+        && std::isinf(ElementTypeUtil::HalfToFloat(ElementTypeUtil::FloatToHalf(1e6f)))
+        && ElementTypeUtil::HalfToFloat(ElementTypeUtil::FloatToHalf(5.9604645e-8f)) == 5.9604645e-8f
+        && ElementTypeUtil::BFloat16ToFloat(ElementTypeUtil::FloatToBFloat16(1.5f)) == 1.5f;
+    std::cout << "convert check: " << (convert_right ? "pass" : "fail") << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    const vector_element_type types[] = {ELEMENT_FP32, ELEMENT_FP16, ELEMENT_BF16, ELEMENT_INT8};
+    bool all_right = true;
+    for (vector_element_type type : types)
+    {
+        for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+        {
+            ElementKernelTable table = ElementKernelDispatcher::BuildKernelTable(type, SimdLevel(level));
+            for (int length = 1; length <= 100; length++)
+            {
+                // int8 stores integers
+                double scale = type == ELEMENT_INT8 ? 100 : 1;
+                std::vector<double> query(length), values(length), decoded(length);
+                for (int i = 0; i < length; i++)
+                {
+                    query[i] = random_value(random_engine) * scale;
+                    values[i] = random_value(random_engine) * scale;
+                }
+                std::vector<char> stored(length * ElementTypeUtil::GetElementSize(type));
+                ElementTypeUtil::Encode(values.data(), length, type, stored.data());
+                ElementTypeUtil::Decode(stored.data(), length, type, decoded.data());
+
+                std::vector<float> query_fp32(query.begin(), query.end());
+                double l2_expect = 0, ip_expect = 0;
+                for (int i = 0; i < length; i++)
+                {
+                    l2_expect += (query_fp32[i] - decoded[i]) * (query_fp32[i] - decoded[i]);
+                    ip_expect += query_fp32[i] * decoded[i];
+                }
+                double l2_result = table.l2_sqr(query_fp32.data(), stored.data(), length);
+                double ip_result = table.inner_product(query_fp32.data(), stored.data(), length);
+                // early abandon gets the full distance under a larger threshold, and stops over a smaller one
+                double full_result = table.l2_sqr_early_abandon(query_fp32.data(), stored.data(), length, l2_result * 2 + 1);
+                double stopped_result = table.l2_sqr_early_abandon(query_fp32.data(), stored.data(), length, l2_result / 2);
+                double tolerance = 1e-4 * scale * scale * length;
+                if (std::fabs(l2_expect - l2_result) > tolerance || std::fabs(ip_expect - ip_result) > tolerance
+                    || std::fabs(full_result - l2_result) > tolerance || (l2_result > 0 && stopped_result <= l2_result / 2))
+                {
+                    std::cout << "wrong result, type " << ElementTypeUtil::GetElementTypeName(type) << " level " << CpuFeatureUtil::GetSimdLevelName(table.level) << " length " << length << std::endl;
+                    all_right = false;
+                }
+            }
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // scan 20000 vectors of 768 dimension stored as each element type
+    int length = 768;
+    int amount = 20000;
+    std::vector<double> query(length), values(amount * length);
+    for (int i = 0; i < length; i++)
+    {
+        query[i] = random_value(random_engine);
+    }
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        values[i] = random_value(random_engine);
+    }
+    std::vector<double> results(amount);
+    const vector_element_type all_types[] = {ELEMENT_FP64, ELEMENT_FP32, ELEMENT_FP16, ELEMENT_BF16, ELEMENT_INT8};
+    for (vector_element_type type : all_types)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), length, type);
+        std::vector<char> stored(amount * mixed_query.GetStoredLength());
+        ElementTypeUtil::Encode(values.data(), amount * length, type, stored.data());
+
+        auto begin = std::chrono::steady_clock::now();
+        mixed_query.L2SqrBatch(stored.data(), amount, mixed_query.GetStoredLength(), results.data());
+        auto end = std::chrono::steady_clock::now();
+        std::cout << ElementTypeUtil::GetElementTypeName(type) << " vectors per block: " << BLOCK_SIZE / mixed_query.GetStoredLength()
+            << ", scan cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us (" << results[0] << ")" << std::endl;
+    }
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : fixed_dimension_kernel_test.cpp
+// since : 2024-09-03
+// desc  : check the kernels specialized on dimension get the same result as the generic kernels, and show the cost.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/distance/euclidean_distance.h"
+#include "../../../include/distance/inner_product.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    const DistanceKernelTable& generic_table = KernelDispatcher::GetKernels();
+
+    bool all_right = true;
+    int dimensions[] = {96, 128, 384, 768, 1536, 100};
+    for (int dimension : dimensions)
+    {
+        std::vector<double> first(dimension), second(dimension);
+        for (int i = 0; i < dimension; i++)
+        {
+            first[i] = random_value(random_engine);
+            second[i] = random_value(random_engine);
+        }
+
+        const DistanceKernelTable& table = DimensionKernelRegistry::GetKernels(dimension);
+        if (table.dimension != (DimensionKernelRegistry::IsSpecialized(dimension) ? dimension : 0))
+        {
+            std::cout << "wrong kernels chosen, dimension " << dimension << std::endl;
+            all_right = false;
+        }
+
+        double l2_expect = generic_table.l2_sqr(first.data(), second.data(), dimension);
+        double ip_expect = generic_table.inner_product(first.data(), second.data(), dimension);
+
+        BASE_VECTOR first_vector(first.data(), dimension);
+        BASE_VECTOR second_vector(second.data(), dimension);
+        EuclideanDistance<double> euclidean(dimension);
+        InnerProduct<double> inner_product(dimension);
+        if (std::fabs(euclidean.Cal(first_vector, second_vector) - std::sqrt(l2_expect)) > 1e-9
+            || std::fabs(inner_product.Cal(first_vector, second_vector) - ip_expect) > 1e-9)
+        {
+            std::cout << "wrong result, dimension " << dimension << std::endl;
+            all_right = false;
+        }
+
+        double batch_results[2];
+        std::vector<double> vectors(first);
+        vectors.insert(vectors.end(), second.begin(), second.end());
+        euclidean.CalBatch(second_vector, vectors.data(), 2, batch_results);
+        if (std::fabs(batch_results[0] - std::sqrt(l2_expect)) > 1e-9 || std::fabs(batch_results[1]) > 1e-9)
+        {
+            std::cout << "wrong batch result, dimension " << dimension << std::endl;
+            all_right = false;
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // cost of generic and fixed kernels on 768 dimension
+    int length = 768;
+    int rounds = 200000;
+    std::vector<double> first(length), second(length);
+    for (int i = 0; i < length; i++)
+    {
+        first[i] = random_value(random_engine);
+        second[i] = random_value(random_engine);
+    }
+    BASE_VECTOR first_vector(first.data(), length);
+    BASE_VECTOR second_vector(second.data(), length);
+    EuclideanDistance<double> generic_distance;
+    FixedEuclideanDistance<double, 768> fixed_distance;
+
+    double sum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        sum += generic_distance.Cal(first_vector, second_vector);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        sum += fixed_distance.Cal(first_vector, second_vector);
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "generic cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(middle - begin).count() << " ms" << std::endl;
+    std::cout << "fixed 768 cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - middle).count() << " ms (" << sum << ")" << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : gemm_kernel_test.cpp
+// since : 2024-09-10
+// desc  : check every tile kernel supported by this cpu gets the distances of all query and vector pairs, with tails
+// of queries, vectors and dimensions, and show the cost against comparing queries one by one.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/distance/kernel/gemm_kernel.h"
+#include "../../../include/distance/kernel/element_kernel.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+    std::cout << "cpu simd level: " << CpuFeatureUtil::GetSimdLevelName(CpuFeatureUtil::GetSimdLevel()) << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<float> random_value(-1.0f, 1.0f);
+
+    // amounts not a multiple of the micro kernel, lengths with and without a tail of 8
+    bool all_right = true;
+    for (default_length_size length : {1, 7, 8, 33, 128})
+    {
+        for (default_amount_type query_amount : {1, 3, 4, 9})
+        {
+            default_long_int vector_amount = 11;
+            default_length_size vector_stride = length + 3;
+            std::vector<float> queries(query_amount * length), vectors(vector_amount * vector_stride);
+            for (float& value : queries)
+            {
+                value = random_value(random_engine);
+            }
+            for (float& value : vectors)
+            {
+                value = random_value(random_engine);
+            }
+
+            std::vector<float> results(query_amount * vector_amount);
+            for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+            {
+                GemmKernel::ChooseKernel(SimdLevel(level))(queries.data(), query_amount, vectors.data(), vector_amount, vector_stride, length, results.data());
+                for (default_amount_type q = 0; q < query_amount; q++)
+                {
+                    for (default_long_int v = 0; v < vector_amount; v++)
+                    {
+                        double expect = 0;
+                        for (default_length_size d = 0; d < length; d++)
+                        {
+                            double diff = queries[q * length + d] - vectors[v * vector_stride + d];
+                            expect += diff * diff;
+                        }
+                        if (std::fabs(results[q * vector_amount + v] - expect) > 1e-4 * (1 + expect))
+                        {
+                            std::cout << "wrong result, level " << CpuFeatureUtil::GetSimdLevelName(SimdLevel(level)) << " length " << length
+                                << " query " << q << " vector " << v << std::endl;
+                            all_right = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // 64 queries against 128 vectors of 128 dimensions, as a tile of flat index
+    default_length_size length = 128;
+    default_amount_type query_amount = 64;
+    default_long_int vector_amount = 128;
+    std::vector<float> queries(query_amount * length), vectors(vector_amount * length);
+    for (float& value : queries)
+    {
+        value = random_value(random_engine);
+    }
+    for (float& value : vectors)
+    {
+        value = random_value(random_engine);
+    }
+    std::vector<float> results(query_amount * vector_amount);
+    std::vector<double> one_results(vector_amount);
+    int repeat = 200;
+
+    const ElementKernelTable& element_kernels = ElementKernelDispatcher::GetKernels(ELEMENT_FP32);
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++)
+    {
+        for (default_amount_type q = 0; q < query_amount; q++)
+        {
+            element_kernels.l2_sqr_batch(queries.data() + q * length, (const char*) vectors.data(), length, vector_amount, length * sizeof(float), one_results.data());
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "one by one cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+
+    begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++)
+    {
+        GemmKernel::GetKernel()(queries.data(), query_amount, vectors.data(), vector_amount, length, length, results.data());
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "tile cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : hamming_distance_test.cpp
+// since : 2024-09-06
+// desc  : check every hamming kernel supported by this cpu, and show the cost.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../../../include/distance/hamming_distance.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    // 1, 0, 1, 1 vs 1, 1, 0, 1
+    double first_data[4] = {0.5, -0.2, 0.1, 0.9};
+    double second_data[4] = {0.3, 0.4, -0.1, 0.2};
+    BinaryVector first_vector = BinaryVector::Quantize(first_data, 4);
+    BinaryVector second_vector = BinaryVector::Quantize(second_data, 4);
+
+    HammingDistance<int> test_object;
+    std::cout << "result" << test_object.Cal(first_vector, second_vector) << std::endl;
+
+    // check all levels against the plain bit count
+    std::mt19937_64 random_engine(7);
+    bool all_right = true;
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        DistanceKernelTable table = KernelDispatcher::BuildKernelTable(SimdLevel(level));
+        for (int dimension = 1; dimension <= 1100; dimension += 37)
+        {
+            BinaryVector query(dimension), candidate(dimension);
+            for (int i = 0; i < dimension; i++)
+            {
+                query.Set(i, random_engine() & 1);
+                candidate.Set(i, random_engine() & 1);
+            }
+            int expect = 0;
+            for (int i = 0; i < dimension; i++)
+            {
+                expect += query.Get(i) != candidate.Get(i);
+            }
+            default_length_size result;
+            table.hamming_batch(query.GetData(), candidate.GetData(), query.GetDataLength(), 1, query.GetDataLength(), &result);
+            if (table.hamming(query.GetData(), candidate.GetData(), query.GetDataLength()) != expect || result != expect)
+            {
+                std::cout << "wrong result, level " << CpuFeatureUtil::GetSimdLevelName(table.level) << " dimension " << dimension << std::endl;
+                all_right = false;
+            }
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // cost of 1024 bits vectors
+    int word_length = BinaryVector::CalWordLength(1024);
+    int amount = 100000;
+    std::vector<uint64_t> vectors(amount * word_length);
+    for (size_t i = 0; i < vectors.size(); i++)
+    {
+        vectors[i] = random_engine();
+    }
+    std::vector<default_length_size> results(amount);
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        DistanceKernelTable table = KernelDispatcher::BuildKernelTable(SimdLevel(level));
+        long long sum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < 20; i++)
+        {
+            table.hamming_batch(vectors.data(), vectors.data(), word_length, amount, word_length, results.data());
+            sum += results[i];
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << CpuFeatureUtil::GetSimdLevelName(table.level) << " hamming cost: "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms (" << sum << ")" << std::endl;
+    }
+
+    std::cout << "test end" << std::endl;
+}
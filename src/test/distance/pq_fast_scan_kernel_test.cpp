@@ -0,0 +1,135 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : pq_fast_scan_kernel_test.cpp
+// since : 2024-09-10
+// desc  : check every pq fast scan kernel supported by this cpu gets the same result as the scalar kernel, check
+// quantized distances are close to float adc distances, and show the cost against adc of byte codes.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/distance/kernel/pq_fast_scan_kernel.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+    std::cout << "cpu simd level: " << CpuFeatureUtil::GetSimdLevelName(CpuFeatureUtil::GetSimdLevel()) << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<float> random_value(0.0f, 4.0f);
+    const default_long_int block_amount = PqFastScanKernel::BLOCK_VECTOR_AMOUNT;
+
+    // odd and even m, m = 1 has no full avx2 loop
+    bool all_right = true;
+    bool close = true;
+    for (default_amount_type m : {1, 2, 7, 8, 16, 33, 64})
+    {
+        std::vector<uint8_t> codes(block_amount * m);
+        std::vector<uint8_t> block(PqFastScanKernel::GetBlockLength(m), 0);
+        for (default_long_int i = 0; i < block_amount; i++)
+        {
+            for (default_amount_type j = 0; j < m; j++)
+            {
+                codes[i * m + j] = random_engine() % 16;
+            }
+            PqFastScanKernel::PackCode(codes.data() + i * m, m, i, block.data());
+        }
+        std::vector<float> table(m * 16);
+        for (float& value : table)
+        {
+            value = random_value(random_engine);
+        }
+        QuantizedDistanceTable quantized_table;
+        PqFastScanKernel::QuantizeTable(table.data(), m, quantized_table);
+
+        uint16_t expect[32], results[32];
+        PqFastScanKernel::ScanBlockScalar(block.data(), quantized_table.table.data(), m, expect);
+        for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+        {
+            PqFastScanKernel::ChooseKernel(SimdLevel(level))(block.data(), quantized_table.table.data(), m, results);
+            for (default_long_int i = 0; i < block_amount; i++)
+            {
+                if (results[i] != expect[i])
+                {
+                    std::cout << "wrong result, level " << CpuFeatureUtil::GetSimdLevelName(SimdLevel(level)) << " m " << m << std::endl;
+                    all_right = false;
+                    break;
+                }
+            }
+        }
+
+        // each sub table loses at most half a quantization step
+        for (default_long_int i = 0; i < block_amount; i++)
+        {
+            double exact = 0;
+            for (default_amount_type j = 0; j < m; j++)
+            {
+                exact += table[j * 16 + codes[i * m + j]];
+            }
+            double approximate = quantized_table.bias + expect[i] / quantized_table.scale;
+            close = close && std::fabs(exact - approximate) <= 0.5 * m / quantized_table.scale + 1e-4;
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+    std::cout << "quantization check: " << (close ? "pass" : "fail") << std::endl;
+
+    // scan 1M codes of m = 32
+    default_amount_type m = 32;
+    default_long_int amount = 1 << 20;
+    std::vector<uint8_t> byte_codes(amount * m);
+    std::vector<uint8_t> blocks(amount / block_amount * PqFastScanKernel::GetBlockLength(m), 0);
+    for (default_long_int i = 0; i < amount; i++)
+    {
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            byte_codes[i * m + j] = random_engine() % 16;
+        }
+        PqFastScanKernel::PackCode(byte_codes.data() + i * m, m, i % block_amount, blocks.data() + i / block_amount * PqFastScanKernel::GetBlockLength(m));
+    }
+    std::vector<float> table(m * 16);
+    for (float& value : table)
+    {
+        value = random_value(random_engine);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    double adc_sum = 0;
+    for (default_long_int i = 0; i < amount; i++)
+    {
+        double distance = 0;
+        for (default_amount_type j = 0; j < m; j++)
+        {
+            distance += table[j * 16 + byte_codes[i * m + j]];
+        }
+        adc_sum += distance;
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "byte code adc cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        PqFastScanKernelFunction kernel = PqFastScanKernel::ChooseKernel(SimdLevel(level));
+        QuantizedDistanceTable quantized_table;
+        uint16_t results[32];
+        double sum = 0;
+        begin = std::chrono::steady_clock::now();
+        PqFastScanKernel::QuantizeTable(table.data(), m, quantized_table);
+        for (default_long_int b = 0; b < amount / block_amount; b++)
+        {
+            kernel(blocks.data() + b * PqFastScanKernel::GetBlockLength(m), quantized_table.table.data(), m, results);
+            for (default_long_int i = 0; i < block_amount; i++)
+            {
+                sum += results[i];
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        double fast_sum = quantized_table.bias * amount + sum / quantized_table.scale;
+        std::cout << CpuFeatureUtil::GetSimdLevelName(SimdLevel(level)) << " fast scan cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()
+            << " us, mean distance " << fast_sum / amount << " (adc " << adc_sum / amount << ")" << std::endl;
+    }
+
+    std::cout << "test end" << std::endl;
+}
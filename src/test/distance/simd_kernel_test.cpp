@@ -0,0 +1,150 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : simd_kernel_test.cpp
+// since : 2024-09-02
+// desc  : check every simd kernel supported by this cpu gets the same result as the scalar kernel, and show the cost.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/distance/kernel/kernel_dispatcher.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+    std::cout << "cpu simd level: " << CpuFeatureUtil::GetSimdLevelName(CpuFeatureUtil::GetSimdLevel()) << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    DistanceKernelTable scalar_table = KernelDispatcher::BuildKernelTable(SCALAR_LEVEL);
+
+    // check result on different length, include lengths which need tail loop
+    bool all_right = true;
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        DistanceKernelTable table = KernelDispatcher::BuildKernelTable(SimdLevel(level));
+        for (int length = 1; length <= 130; length++)
+        {
+            std::vector<double> first(length), second(length);
+            for (int i = 0; i < length; i++)
+            {
+                first[i] = random_value(random_engine);
+                second[i] = random_value(random_engine);
+            }
+
+            double l2_expect = scalar_table.l2_sqr(first.data(), second.data(), length);
+            double ip_expect = scalar_table.inner_product(first.data(), second.data(), length);
+            double l2_result = table.l2_sqr(first.data(), second.data(), length);
+            double ip_result = table.inner_product(first.data(), second.data(), length);
+            // a threshold larger than distance must get the full distance, a smaller one must get a value larger than it
+            double abandon_full = table.l2_sqr_early_abandon(first.data(), second.data(), length, l2_expect + 1);
+            double abandon_stop = table.l2_sqr_early_abandon(first.data(), second.data(), length, l2_expect / 2);
+            if (std::fabs(l2_expect - abandon_full) > 1e-9 || abandon_stop <= l2_expect / 2)
+            {
+                std::cout << "wrong early abandon result, level " << CpuFeatureUtil::GetSimdLevelName(table.level) << " length " << length << std::endl;
+                all_right = false;
+            }
+            if (std::fabs(l2_expect - l2_result) > 1e-9 || std::fabs(ip_expect - ip_result) > 1e-9)
+            {
+                std::cout << "wrong result, level " << CpuFeatureUtil::GetSimdLevelName(table.level) << " length " << length << std::endl;
+                all_right = false;
+            }
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // check batch kernels, vectors are stored with a gap to test stride
+    bool batch_right = true;
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        DistanceKernelTable table = KernelDispatcher::BuildKernelTable(SimdLevel(level));
+        for (int length = 1; length <= 40; length++)
+        {
+            int stride = length + 3;
+            for (int amount = 0; amount <= 9; amount++)
+            {
+                std::vector<double> query(length), vectors(amount * stride + 1);
+                for (int i = 0; i < length; i++)
+                {
+                    query[i] = random_value(random_engine);
+                }
+                for (size_t i = 0; i < vectors.size(); i++)
+                {
+                    vectors[i] = random_value(random_engine);
+                }
+
+                std::vector<double> l2_results(amount), ip_results(amount);
+                table.l2_sqr_batch(query.data(), vectors.data(), length, amount, stride, l2_results.data());
+                table.inner_product_batch(query.data(), vectors.data(), length, amount, stride, ip_results.data());
+                for (int row = 0; row < amount; row++)
+                {
+                    double l2_expect = scalar_table.l2_sqr(query.data(), vectors.data() + row * stride, length);
+                    double ip_expect = scalar_table.inner_product(query.data(), vectors.data() + row * stride, length);
+                    if (std::fabs(l2_expect - l2_results[row]) > 1e-9 || std::fabs(ip_expect - ip_results[row]) > 1e-9)
+                    {
+                        std::cout << "wrong batch result, level " << CpuFeatureUtil::GetSimdLevelName(table.level) << " length " << length << " amount " << amount << std::endl;
+                        batch_right = false;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "batch check: " << (batch_right ? "pass" : "fail") << std::endl;
+
+    // cost of each level on 768 dimension
+    int length = 768;
+    int rounds = 200000;
+    std::vector<double> first(length), second(length);
+    for (int i = 0; i < length; i++)
+    {
+        first[i] = random_value(random_engine);
+        second[i] = random_value(random_engine);
+    }
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        DistanceKernelTable table = KernelDispatcher::BuildKernelTable(SimdLevel(level));
+        double sum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++)
+        {
+            sum += table.l2_sqr(first.data(), second.data(), length);
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << CpuFeatureUtil::GetSimdLevelName(table.level) << " l2 cost: "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms (" << sum << ")" << std::endl;
+    }
+
+    // one to many: calling single kernel for each vector vs batch kernel
+    int amount = 1024;
+    std::vector<double> vectors(amount * length);
+    for (size_t i = 0; i < vectors.size(); i++)
+    {
+        vectors[i] = random_value(random_engine);
+    }
+    std::vector<double> results(amount);
+    const DistanceKernelTable& table = KernelDispatcher::GetKernels();
+    double single_sum = 0, batch_sum = 0;
+    auto single_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200; i++)
+    {
+        for (int row = 0; row < amount; row++)
+        {
+            single_sum += table.l2_sqr(first.data(), vectors.data() + row * length, length);
+        }
+    }
+    auto single_end = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200; i++)
+    {
+        table.l2_sqr_batch(first.data(), vectors.data(), length, amount, length, results.data());
+        batch_sum += results[i % amount];
+    }
+    auto batch_end = std::chrono::steady_clock::now();
+    std::cout << "one by one l2 cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(single_end - single_begin).count() << " ms (" << single_sum << ")" << std::endl;
+    std::cout << "batch l2 cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(batch_end - single_end).count() << " ms (" << batch_sum << ")" << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
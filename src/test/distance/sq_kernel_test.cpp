@@ -0,0 +1,87 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : sq_kernel_test.cpp
+// since : 2024-09-10
+// desc  : check every sq kernel supported by this cpu gets the same result as the scalar kernel, include lengths
+// which need tail loop and codes and queries at the ends of their ranges, and show the cost.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../../../include/distance/kernel/sq_kernel.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+    std::cout << "cpu simd level: " << CpuFeatureUtil::GetSimdLevelName(CpuFeatureUtil::GetSimdLevel()) << std::endl;
+
+    std::mt19937 random_engine(7);
+    SqKernelTable scalar_table = SqKernel::BuildKernelTable(SCALAR_LEVEL);
+
+    bool all_right = true;
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        SqKernelTable table = SqKernel::BuildKernelTable(SimdLevel(level));
+        for (default_length_size length = 1; length <= 130; length++)
+        {
+            // 3 codes, the last one is all 255 with a query of all -128
+            std::vector<uint8_t> codes(length * 3);
+            std::vector<int8_t> query(length), query_high(length);
+            for (default_length_size i = 0; i < length; i++)
+            {
+                codes[i] = random_engine() % 256;
+                codes[length + i] = random_engine() % 256;
+                codes[2 * length + i] = 255;
+                query[i] = length % 7 == 0 ? -128 : (int8_t) (random_engine() % 256);
+                query_high[i] = length % 7 == 0 ? -128 : (int8_t) (random_engine() % 256);
+            }
+
+            int32_t expect[3], results[3];
+            scalar_table.sq8_dot_batch(codes.data(), length, 3, query.data(), length, expect);
+            table.sq8_dot_batch(codes.data(), length, 3, query.data(), length, results);
+            for (int i = 0; i < 3; i++)
+            {
+                all_right = all_right && expect[i] == results[i];
+            }
+            scalar_table.sq4_dot_batch(codes.data(), length, 3, query.data(), query_high.data(), length, expect);
+            table.sq4_dot_batch(codes.data(), length, 3, query.data(), query_high.data(), length, results);
+            for (int i = 0; i < 3; i++)
+            {
+                all_right = all_right && expect[i] == results[i];
+            }
+            if (!all_right)
+            {
+                std::cout << "wrong result, level " << CpuFeatureUtil::GetSimdLevelName(table.level) << " length " << length << std::endl;
+                break;
+            }
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // 100000 codes of 768 dimensions
+    default_length_size length = 768;
+    default_long_int amount = 100000;
+    std::vector<uint8_t> codes(amount * length);
+    std::vector<int8_t> query(length);
+    for (uint8_t& code : codes)
+    {
+        code = random_engine() % 256;
+    }
+    for (int8_t& item : query)
+    {
+        item = (int8_t) (random_engine() % 256);
+    }
+    std::vector<int32_t> results(amount);
+    for (int level = SCALAR_LEVEL; level <= CpuFeatureUtil::GetSimdLevel(); level++)
+    {
+        SqKernelTable table = SqKernel::BuildKernelTable(SimdLevel(level));
+        auto begin = std::chrono::steady_clock::now();
+        table.sq8_dot_batch(codes.data(), length, amount, query.data(), length, results.data());
+        auto end = std::chrono::steady_clock::now();
+        std::cout << CpuFeatureUtil::GetSimdLevelName(table.level) << " sq8 cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+    }
+
+    std::cout << "test end" << std::endl;
+}
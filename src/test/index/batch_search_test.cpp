@@ -0,0 +1,120 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : batch_search_test.cpp
+// since : 2024-09-10
+// desc  : search many queries together by flat index, check results are the same as searching queries one by one
+// for each element type, and show the cost of both.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+#include "../../../include/meta/element_type.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    int dimension = 100;
+    int amount = 10000;
+    int query_amount = 200;
+    int k = 10;
+    std::vector<double> values((size_t) amount * dimension);
+    for (double& value : values)
+    {
+        value = random_value(random_engine);
+    }
+    std::vector<std::vector<double> > queries(query_amount, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        for (double& value : query)
+        {
+            value = random_value(random_engine);
+        }
+    }
+
+    bool all_right = true;
+    for (vector_element_type element_type : {ELEMENT_FP32, ELEMENT_FP16, ELEMENT_INT8, ELEMENT_FP64})
+    {
+        // runs of 37 records, a tile of vectors spans runs
+        default_length_size record_length = dimension * ElementTypeUtil::GetElementSize(element_type);
+        std::vector<char> records((size_t) amount * record_length);
+        for (default_long_int row = 0; row < amount; row++)
+        {
+            ElementTypeUtil::Encode(values.data() + row * dimension, dimension, element_type, records.data() + row * record_length);
+        }
+        std::vector<VectorRun> runs;
+        for (default_long_int row = 0; row < amount; row += 37)
+        {
+            runs.push_back(VectorRun{records.data() + row * record_length, std::min<default_long_int>(37, amount - row), row});
+        }
+
+        std::vector<MixedPrecisionQuery> mixed_queries;
+        for (auto& query : queries)
+        {
+            mixed_queries.emplace_back(query.data(), dimension, element_type);
+        }
+
+        FlatIndex index(dimension);
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<TopKCollector> one_collectors(query_amount, TopKCollector(k));
+        for (int q = 0; q < query_amount; q++)
+        {
+            index.Search(mixed_queries[q], runs, record_length, one_collectors[q]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        long one_cost = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+
+        begin = std::chrono::steady_clock::now();
+        std::vector<TopKCollector> batch_collectors(query_amount, TopKCollector(k));
+        index.BatchSearch(mixed_queries, runs, record_length, batch_collectors);
+        end = std::chrono::steady_clock::now();
+        long batch_cost = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+        std::cout << ElementTypeUtil::GetElementTypeName(element_type) << " one by one cost: " << one_cost << " us, batch cost: " << batch_cost << " us" << std::endl;
+
+        for (int q = 0; q < query_amount; q++)
+        {
+            std::vector<SearchResult> one_results = one_collectors[q].GetSortedResults();
+            std::vector<SearchResult> batch_results = batch_collectors[q].GetSortedResults();
+            bool same = one_results.size() == batch_results.size();
+            for (size_t i = 0; same && i < one_results.size(); i++)
+            {
+                same = one_results[i].id == batch_results[i].id && std::fabs(one_results[i].distance - batch_results[i].distance) <= 1e-4 * one_results[i].distance;
+            }
+            if (!same)
+            {
+                std::cout << "wrong result, " << ElementTypeUtil::GetElementTypeName(element_type) << " query " << q << std::endl;
+                all_right = false;
+                break;
+            }
+        }
+    }
+    std::cout << "batch check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // a filter of each query is kept
+    TagBitmap even;
+    for (default_long_int tag = 0; tag < amount; tag += 2)
+    {
+        even.Add(tag);
+    }
+    even.Extend(amount);
+    std::vector<float> fp32_values(values.begin(), values.end());
+    std::vector<VectorRun> runs{VectorRun{(const char*) fp32_values.data(), (size_t) amount, 0}};
+    std::vector<MixedPrecisionQuery> mixed_queries{MixedPrecisionQuery(queries[0].data(), dimension, ELEMENT_FP32), MixedPrecisionQuery(queries[1].data(), dimension, ELEMENT_FP32)};
+    std::vector<TopKCollector> collectors{TopKCollector(k, &even), TopKCollector(k)};
+    FlatIndex(dimension).BatchSearch(mixed_queries, runs, dimension * sizeof(float), collectors);
+    bool filter_right = collectors[0].Size() == k && collectors[1].Size() == k;
+    for (const SearchResult& result : collectors[0].GetSortedResults())
+    {
+        filter_right = filter_right && result.id % 2 == 0;
+    }
+    std::cout << "filter check: " << (filter_right ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
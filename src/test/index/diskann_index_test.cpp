@@ -0,0 +1,167 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : diskann_index_test.cpp
+// since : 2024-09-10
+// desc  : check recall of diskann index against flat index, and that a search only reads a few pages of nodes,
+// check vectors inserted after building are found, and wrong parameters are refused.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/kmeans.h"
+#include "../../../include/index/diskann_index.h"
+
+using namespace tiny_v_dbms;
+
+double Recall(const std::vector<SearchResult>& expect, const std::vector<SearchResult>& results)
+{
+    std::set<default_long_int> expect_ids;
+    for (const SearchResult& item : expect)
+    {
+        expect_ids.insert(item.id);
+    }
+    int hit = 0;
+    for (const SearchResult& item : results)
+    {
+        hit += expect_ids.count(item.id);
+    }
+    return (double) hit / expect.size();
+}
+
+double AverageRecall(const DiskAnnIndex& index, const std::vector<std::vector<double> >& queries, const std::vector<VectorRun>& runs,
+    default_length_size dimension, default_long_int k)
+{
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+        TopKCollector flat_collector(k);
+        flat_index.Search(mixed_query, runs, dimension * sizeof(float), flat_collector);
+        TopKCollector collector(k);
+        index.Search(mixed_query, std::vector<VectorRun>(), dimension * sizeof(float), collector);
+        recall += Recall(flat_collector.GetSortedResults(), collector.GetSortedResults());
+    }
+    return recall / queries.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    // vectors around 100 random centers, stored as fp32 records in runs of 100 records
+    int dimension = 64;
+    int amount = 10000;
+    int query_amount = 100;
+    int k = 10;
+    std::vector<std::vector<double> > cluster_centers(100, std::vector<double>(dimension));
+    for (auto& center : cluster_centers)
+    {
+        for (double& value : center)
+        {
+            value = random_value(random_engine);
+        }
+    }
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (int row = 0; row < amount; row++)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            vectors[(size_t) row * dimension + i] = center[i] + noise(random_engine);
+        }
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+
+    std::vector<std::vector<double> > queries(query_amount, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            query[i] = center[i] + noise(random_engine);
+        }
+    }
+
+    // build from all records, a search reads a few pages only
+    auto begin = std::chrono::steady_clock::now();
+    DiskAnnIndex index(dimension, ELEMENT_FP32);
+    TrainingSampler sampler(dimension, ELEMENT_FP32, index.GetTrainingSampleAmount());
+    sampler.Offer(runs, record_length);
+    index.Train(sampler.GetSamples());
+    index.Add(runs, record_length);
+    index.FinishBuild();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "diskann build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+    default_long_int page_reads = index.GetStore()->GetPageReadAmount();
+    default_long_int page_amount = (amount + index.GetStore()->GetNodesPerPage() - 1) / index.GetStore()->GetNodesPerPage();
+    begin = std::chrono::steady_clock::now();
+    double recall = AverageRecall(index, queries, runs, dimension, k);
+    end = std::chrono::steady_clock::now();
+    double pages_per_query = (double) (index.GetStore()->GetPageReadAmount() - page_reads) / query_amount;
+    std::cout << "diskann recall@" << k << ": " << recall << ", " << pages_per_query << " of " << page_amount << " pages read, cost "
+        << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / query_amount << " us per query" << std::endl;
+    std::cout << "build check: " << (index.Size() == (default_long_int) amount && index.GetIndexType() == DISKANN && recall >= 0.9
+        && pages_per_query < page_amount / 4 ? "pass" : "fail") << std::endl;
+
+    // build from 90% records, then insert the others one by one
+    DiskAnnIndex insert_index(dimension, ELEMENT_FP32);
+    insert_index.Train(sampler.GetSamples());
+    insert_index.Add(std::vector<VectorRun>(runs.begin(), runs.begin() + runs.size() * 9 / 10), record_length);
+    insert_index.FinishBuild();
+    begin = std::chrono::steady_clock::now();
+    for (default_long_int row = amount * 9 / 10; row < (default_long_int) amount; row++)
+    {
+        insert_index.Add(std::vector<VectorRun>{VectorRun{(const char*) (vectors.data() + row * dimension), 1, row}}, record_length);
+    }
+    end = std::chrono::steady_clock::now();
+    double insert_recall = AverageRecall(insert_index, queries, runs, dimension, k);
+    std::cout << "diskann recall@" << k << " after inserting " << amount / 10 << " vectors: " << insert_recall << ", insert cost "
+        << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / (amount / 10) << " us per vector" << std::endl;
+    std::cout << "insert check: " << (insert_index.Size() == (default_long_int) amount && insert_recall >= 0.9 ? "pass" : "fail") << std::endl;
+
+    // dimension must be a multiple of m, r must be positive, and adding before training is refused
+    bool refused = false;
+    try
+    {
+        DiskAnnIndex wrong_index(dimension, ELEMENT_FP32, 32, 64, 4, 64, 7);
+    }
+    catch (const std::runtime_error& e)
+    {
+        refused = true;
+    }
+    bool r_refused = false;
+    try
+    {
+        DiskAnnIndex wrong_index(dimension, ELEMENT_FP32, 0);
+    }
+    catch (const std::runtime_error& e)
+    {
+        r_refused = true;
+    }
+    DiskAnnIndex untrained_index(dimension, ELEMENT_FP32);
+    bool untrained_refused = false;
+    try
+    {
+        untrained_index.Add(runs, record_length);
+    }
+    catch (const std::runtime_error& e)
+    {
+        untrained_refused = true;
+    }
+    std::cout << "parameter check: " << (refused && r_refused && untrained_refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : filtered_search_test.cpp
+// since : 2024-09-10
+// desc  : search indexes with a tag bitmap, check only records in the bitmap are returned, and recall against
+// flat index restricted to the same records, from a half to a hundredth of records passing the filter.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/tag_bitmap.h"
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/hnsw_index.h"
+#include "../../../include/index/ivf_flat_index.h"
+#include "../../../include/index/diskann_index.h"
+#include "../../../include/index/kmeans.h"
+
+using namespace tiny_v_dbms;
+
+/**
+ * @return Average recall of index against flat index, or -1 if a result is out of filter.
+ */
+double FilteredRecall(const BasicIndex& index, const std::vector<std::vector<double> >& queries, const std::vector<VectorRun>& runs,
+    default_length_size dimension, default_long_int k, const TagBitmap& filter)
+{
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+        TopKCollector flat_collector(k, &filter);
+        flat_index.Search(mixed_query, runs, dimension * sizeof(float), flat_collector);
+        TopKCollector collector(k, &filter);
+        index.Search(mixed_query, std::vector<VectorRun>(), dimension * sizeof(float), collector);
+
+        std::set<default_long_int> expect_ids;
+        for (const SearchResult& item : flat_collector.GetSortedResults())
+        {
+            expect_ids.insert(item.id);
+        }
+        int hit = 0;
+        for (const SearchResult& item : collector.GetSortedResults())
+        {
+            if (!filter.Contains(item.id))
+            {
+                return -1;
+            }
+            hit += expect_ids.count(item.id);
+        }
+        recall += (double) hit / expect_ids.size();
+    }
+    return recall / queries.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    int dimension = 32;
+    int amount = 5000;
+    int k = 10;
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (float& value : vectors)
+    {
+        value = random_value(random_engine);
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+    std::vector<std::vector<double> > queries(50, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        for (double& value : query)
+        {
+            value = random_value(random_engine);
+        }
+    }
+
+    // bitmap keeps tags and the amount of tags it is taken from
+    TagBitmap even, small;
+    for (default_long_int tag = 0; tag < 200; tag += 2)
+    {
+        even.Add(tag);
+    }
+    even.Extend(200);
+    small.Add(4);
+    small.Add(130);
+    small.Add(131);
+    small.Add(131);
+    std::vector<default_long_int> small_tags = small.GetTags();
+    bool bitmap_right = even.Count() == 100 && even.GetSelectivity() == 0.5 && small.Count() == 3 && small_tags.size() == 3
+        && small_tags[0] == 4 && small_tags[2] == 131;
+    small.IntersectWith(even);
+    bitmap_right = bitmap_right && small.Count() == 2 && small.Contains(130) && !small.Contains(131) && small.GetTagAmount() == 200;
+    std::cout << "bitmap check: " << (bitmap_right ? "pass" : "fail") << std::endl;
+
+    HnswIndex hnsw_index(dimension, ELEMENT_FP32, 16, 100, 64);
+    hnsw_index.Add(runs, record_length);
+
+    IvfFlatIndex ivf_index(dimension, ELEMENT_FP32, 64, 16);
+    TrainingSampler ivf_sampler(dimension, ELEMENT_FP32, ivf_index.GetTrainingSampleAmount());
+    ivf_sampler.Offer(runs, record_length);
+    ivf_index.Train(ivf_sampler.GetSamples());
+    ivf_index.Add(runs, record_length);
+
+    DiskAnnIndex diskann_index(dimension, ELEMENT_FP32);
+    TrainingSampler diskann_sampler(dimension, ELEMENT_FP32, diskann_index.GetTrainingSampleAmount());
+    diskann_sampler.Offer(runs, record_length);
+    diskann_index.Train(diskann_sampler.GetSamples());
+    diskann_index.Add(runs, record_length);
+    diskann_index.FinishBuild();
+
+    // records pass a filter of selectivity 1 / ratio at random, like a condition such as category = 0
+    bool all_right = true;
+    for (int ratio : {2, 10, 100})
+    {
+        TagBitmap filter;
+        for (default_long_int tag = 0; tag < (default_long_int) amount; tag++)
+        {
+            if (random_engine() % ratio == 0)
+            {
+                filter.Add(tag);
+            }
+        }
+        filter.Extend(amount);
+
+        auto begin = std::chrono::steady_clock::now();
+        double hnsw_recall = FilteredRecall(hnsw_index, queries, runs, dimension, k, filter);
+        auto end = std::chrono::steady_clock::now();
+        double ivf_recall = FilteredRecall(ivf_index, queries, runs, dimension, k, filter);
+        double diskann_recall = FilteredRecall(diskann_index, queries, runs, dimension, k, filter);
+        std::cout << "selectivity " << filter.GetSelectivity() << ", recall@" << k << " hnsw: " << hnsw_recall << " ("
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / (long) queries.size() << " us per query)"
+            << ", ivf_flat: " << ivf_recall << ", diskann: " << diskann_recall << std::endl;
+        all_right = all_right && hnsw_recall >= 0.9 && ivf_recall >= 0.7 && diskann_recall >= 0.9;
+    }
+    std::cout << "filter check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // an empty filter finds nothing
+    TagBitmap empty_filter;
+    empty_filter.Extend(amount);
+    MixedPrecisionQuery mixed_query(queries[0].data(), dimension, ELEMENT_FP32);
+    TopKCollector hnsw_collector(k, &empty_filter), ivf_collector(k, &empty_filter);
+    hnsw_index.Search(mixed_query, std::vector<VectorRun>(), record_length, hnsw_collector);
+    ivf_index.Search(mixed_query, std::vector<VectorRun>(), record_length, ivf_collector);
+    std::cout << "empty check: " << (hnsw_collector.Size() == 0 && ivf_collector.Size() == 0 ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : flat_index_test.cpp
+// since : 2024-09-04
+// desc  : check top k search of flat index gets the same result as sorting all distances, and show the cost.
+// Runs searched by many threads must get the same result too, and fp32 records must stop early.
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    int dimension = 768;
+    int amount = 20000;
+    int k = 10;
+    std::vector<double> vectors(amount * dimension), query(dimension);
+    for (size_t i = 0; i < vectors.size(); i++)
+    {
+        vectors[i] = random_value(random_engine);
+    }
+    for (int i = 0; i < dimension; i++)
+    {
+        query[i] = random_value(random_engine);
+    }
+
+    // sort all full euclidean distances
+    auto begin = std::chrono::steady_clock::now();
+    const DistanceKernelTable& generic_table = KernelDispatcher::GetKernels();
+    std::vector<SearchResult> expect(amount);
+    for (int row = 0; row < amount; row++)
+    {
+        expect[row] = SearchResult{(default_long_int) row, std::sqrt(generic_table.l2_sqr(query.data(), vectors.data() + row * dimension, dimension))};
+    }
+    std::partial_sort(expect.begin(), expect.begin() + k, expect.end(), [](const SearchResult& left, const SearchResult& right) {
+        return left.distance < right.distance;
+    });
+    auto middle = std::chrono::steady_clock::now();
+
+    FlatIndex index(dimension);
+    std::vector<SearchResult> results = index.Search(query.data(), vectors.data(), amount, dimension, k);
+    auto end = std::chrono::steady_clock::now();
+
+    bool all_right = results.size() == (size_t) k;
+    for (int i = 0; all_right && i < k; i++)
+    {
+        if (results[i].id != expect[i].id || std::fabs(results[i].distance - expect[i].distance) > 1e-9)
+        {
+            std::cout << "wrong result at " << i << std::endl;
+            all_right = false;
+        }
+    }
+    std::cout << "result check: " << (all_right ? "pass" : "fail") << std::endl;
+    std::cout << "full distance cost: " << std::chrono::duration_cast<std::chrono::microseconds>(middle - begin).count() << " us" << std::endl;
+    std::cout << "early abandon cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count() << " us" << std::endl;
+
+    // k larger than amount
+    std::vector<SearchResult> all_results = index.Search(query.data(), vectors.data(), 3, dimension, 5);
+    std::cout << "small amount check: " << (all_results.size() == 3 ? "pass" : "fail") << std::endl;
+
+    // runs scanned by many threads, as blocks of a column
+    default_long_int run_length = 100;
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += run_length)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), std::min<default_long_int>(run_length, amount - row), row});
+    }
+    FlatIndex parallel_index(dimension, 4);
+    MixedPrecisionQuery fp64_query(query.data(), dimension, ELEMENT_FP64);
+    TopKCollector parallel_collector(k);
+    parallel_index.Search(fp64_query, runs, dimension * sizeof(double), parallel_collector);
+    std::vector<SearchResult> parallel_results = FlatIndex::FinishResults(parallel_collector);
+    bool parallel_right = parallel_results.size() == (size_t) k;
+    for (int i = 0; parallel_right && i < k; i++)
+    {
+        parallel_right = parallel_results[i].id == expect[i].id && std::fabs(parallel_results[i].distance - expect[i].distance) < 1e-9;
+    }
+    std::cout << "parallel check: " << (parallel_right ? "pass" : "fail") << std::endl;
+
+    // fp32 records, many threads get the same result as one thread
+    std::vector<float> fp32_vectors(vectors.begin(), vectors.end());
+    std::vector<VectorRun> fp32_runs;
+    for (default_long_int row = 0; row < amount; row += run_length)
+    {
+        fp32_runs.push_back(VectorRun{(const char*) (fp32_vectors.data() + row * dimension), std::min<default_long_int>(run_length, amount - row), row});
+    }
+    MixedPrecisionQuery fp32_query(query.data(), dimension, ELEMENT_FP32);
+    TopKCollector single_collector(k), many_collector(k);
+    FlatIndex(dimension, 1).Search(fp32_query, fp32_runs, dimension * sizeof(float), single_collector);
+    parallel_index.Search(fp32_query, fp32_runs, dimension * sizeof(float), many_collector);
+    std::vector<SearchResult> single_results = single_collector.GetSortedResults(), many_results = many_collector.GetSortedResults();
+    bool fp32_right = single_results.size() == (size_t) k && many_results.size() == (size_t) k;
+    for (int i = 0; fp32_right && i < k; i++)
+    {
+        fp32_right = single_results[i].id == many_results[i].id && single_results[i].id == expect[i].id;
+    }
+    std::cout << "fp32 parallel check: " << (fp32_right ? "pass" : "fail") << std::endl;
+
+    // fp32 records stop early: a record farther than the k-th best returns a partial sum over the threshold,
+    // a nearer one gets its full distance
+    double threshold = expect[k - 1].distance * expect[k - 1].distance;
+    default_long_int abandoned = 0;
+    bool abandon_right = true;
+    for (int row = 0; abandon_right && row < amount; row++)
+    {
+        const char* record = (const char*) (fp32_vectors.data() + row * dimension);
+        double full = fp32_query.L2Sqr(record);
+        double partial = fp32_query.L2SqrWithThreshold(record, threshold);
+        abandon_right = full > threshold ? partial > threshold : std::fabs(partial - full) <= 1e-6 * full;
+        abandoned += partial < full ? 1 : 0;
+    }
+    abandon_right = abandon_right && abandoned > 0;
+    std::cout << "fp32 early abandon check: " << (abandon_right ? "pass" : "fail") << " (" << abandoned << " of " << amount << " stopped early)" << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : hnsw_index_test.cpp
+// since : 2024-09-09
+// desc  : check recall of hnsw index against flat index, build it by many threads
+// and by one thread, and show the search cost of both indexes.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/hnsw_index.h"
+
+using namespace tiny_v_dbms;
+
+double Recall(const std::vector<SearchResult>& expect, const std::vector<SearchResult>& results)
+{
+    std::set<default_long_int> expect_ids;
+    for (const SearchResult& item : expect)
+    {
+        expect_ids.insert(item.id);
+    }
+    int hit = 0;
+    for (const SearchResult& item : results)
+    {
+        hit += expect_ids.count(item.id);
+    }
+    return (double) hit / expect.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    int dimension = 128;
+    int amount = 10000;
+    int query_amount = 100;
+    int k = 10;
+
+    // stored as fp32 records, in runs of 100 records as blocks of a column
+    std::vector<double> values(dimension);
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (size_t i = 0; i < vectors.size(); i++)
+    {
+        vectors[i] = random_value(random_engine);
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+
+    std::vector<std::vector<double> > queries(query_amount, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        for (double& value : query)
+        {
+            value = random_value(random_engine);
+        }
+    }
+
+    // build by many threads
+    auto begin = std::chrono::steady_clock::now();
+    HnswIndex index(dimension, ELEMENT_FP32, 16, 200, 200);
+    index.SetBuildThreadAmount(4);
+    index.Add(runs, record_length);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+    std::cout << "size check: " << (index.Size() == (default_long_int) amount ? "pass" : "fail") << std::endl;
+
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    long long flat_cost = 0, hnsw_cost = 0;
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+
+        auto flat_begin = std::chrono::steady_clock::now();
+        TopKCollector flat_collector(k);
+        flat_index.Search(mixed_query, runs, record_length, flat_collector);
+        auto flat_end = std::chrono::steady_clock::now();
+
+        TopKCollector hnsw_collector(k);
+        index.Search(mixed_query, std::vector<VectorRun>(), record_length, hnsw_collector);
+        auto hnsw_end = std::chrono::steady_clock::now();
+
+        recall += Recall(flat_collector.GetSortedResults(), hnsw_collector.GetSortedResults());
+        flat_cost += std::chrono::duration_cast<std::chrono::microseconds>(flat_end - flat_begin).count();
+        hnsw_cost += std::chrono::duration_cast<std::chrono::microseconds>(hnsw_end - flat_end).count();
+    }
+    recall /= query_amount;
+    std::cout << "recall@" << k << ": " << recall << std::endl;
+    std::cout << "recall check: " << (recall >= 0.9 ? "pass" : "fail") << std::endl;
+    std::cout << "flat search cost: " << flat_cost / query_amount << " us per query" << std::endl;
+    std::cout << "hnsw search cost: " << hnsw_cost / query_amount << " us per query" << std::endl;
+
+    // insert one by one, starting from a small capacity to grow many times
+    HnswIndex single_index(dimension, ELEMENT_FP32, 8, 100, 100, 16);
+    for (int row = 0; row < 2000; row++)
+    {
+        single_index.Insert((const char*) (vectors.data() + (size_t) row * dimension), row);
+    }
+    bool self_found = true;
+    for (int row = 0; row < 2000; row += 97)
+    {
+        for (int i = 0; i < dimension; i++)
+        {
+            values[i] = vectors[(size_t) row * dimension + i];
+        }
+        TopKCollector collector(1);
+        single_index.Search(MixedPrecisionQuery(values.data(), dimension, ELEMENT_FP32), std::vector<VectorRun>(), record_length, collector);
+        self_found = self_found && collector.Size() == 1 && collector.GetSortedResults()[0].id == (default_long_int) row;
+    }
+    std::cout << "grow check: " << (single_index.Size() == 2000 && self_found ? "pass" : "fail") << std::endl;
+
+    // wrong parameters are refused
+    bool refused = false;
+    try
+    {
+        HnswIndex wrong_index(dimension, ELEMENT_FP32, 1);
+    }
+    catch (const std::runtime_error& e)
+    {
+        refused = true;
+    }
+    std::cout << "parameter check: " << (refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : index_file_test.cpp
+// since : 2024-09-10
+// desc  : save an hnsw index into an index file and load it back by mapping the file, check the loaded index gets
+// the same results, keeps inserting, and that broken files are refused. Show the cost of loading and rebuilding.
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "../../../include/index/hnsw_index.h"
+
+using namespace tiny_v_dbms;
+
+bool SameResults(const HnswIndex& index, const HnswIndex& loaded_index, const std::vector<std::vector<double> >& queries, default_length_size dimension)
+{
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+        TopKCollector collector(10), loaded_collector(10);
+        index.Search(mixed_query, std::vector<VectorRun>(), dimension * sizeof(float), collector);
+        loaded_index.Search(mixed_query, std::vector<VectorRun>(), dimension * sizeof(float), loaded_collector);
+        std::vector<SearchResult> results = collector.GetSortedResults();
+        std::vector<SearchResult> loaded_results = loaded_collector.GetSortedResults();
+        if (results.size() != loaded_results.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            if (results[i].id != loaded_results[i].id || results[i].distance != loaded_results[i].distance)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LoadRefused(const std::string& file_path)
+{
+    try
+    {
+        default_long_int next_id;
+        delete HnswIndex::Load(file_path, next_id);
+    }
+    catch (const std::runtime_error& e)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    int dimension = 64;
+    int amount = 20000;
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (float& value : vectors)
+    {
+        value = random_value(random_engine);
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    std::vector<std::vector<double> > queries(100, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        for (double& value : query)
+        {
+            value = random_value(random_engine);
+        }
+    }
+
+    // build from the first half
+    std::vector<VectorRun> first_half(runs.begin(), runs.begin() + runs.size() / 2);
+    auto begin = std::chrono::steady_clock::now();
+    HnswIndex index(dimension, ELEMENT_FP32, 16, 100, 64);
+    index.Add(first_half, dimension * sizeof(float));
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+    std::string file_path = "index_file_test.index";
+    begin = std::chrono::steady_clock::now();
+    bool saved = index.Save(file_path);
+    end = std::chrono::steady_clock::now();
+    std::cout << "save cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+    default_long_int next_id = 0;
+    begin = std::chrono::steady_clock::now();
+    HnswIndex* loaded_index = HnswIndex::Load(file_path, next_id);
+    end = std::chrono::steady_clock::now();
+    std::cout << "load cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+    std::cout << "load check: " << (saved && next_id == (default_long_int) amount / 2 && loaded_index->Size() == index.Size()
+        && loaded_index->GetM() == index.GetM() && loaded_index->GetEfSearch() == index.GetEfSearch()
+        && SameResults(index, *loaded_index, queries, dimension) ? "pass" : "fail") << std::endl;
+
+    // inserting grows the loaded index out of the mapped file, inserted vectors are found by themselves
+    std::vector<VectorRun> second_half(runs.begin() + runs.size() / 2, runs.end());
+    loaded_index->Add(second_half, dimension * sizeof(float));
+    bool found = true;
+    for (default_long_int row = amount / 2; row < (default_long_int) amount; row += 100)
+    {
+        std::vector<double> query(vectors.begin() + row * dimension, vectors.begin() + (row + 1) * dimension);
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+        TopKCollector collector(1);
+        loaded_index->Search(mixed_query, std::vector<VectorRun>(), dimension * sizeof(float), collector);
+        found = found && collector.GetSortedResults()[0].id == row;
+    }
+    std::cout << "insert check: " << (loaded_index->Size() == (default_long_int) amount && found ? "pass" : "fail") << std::endl;
+    delete loaded_index;
+
+    // a file of another index type, version, or cut short is refused
+    HnswIndex empty_index(dimension, ELEMENT_FP32);
+    bool empty_right = empty_index.Save(file_path);
+    loaded_index = HnswIndex::Load(file_path, next_id);
+    empty_right = empty_right && loaded_index->Size() == 0 && next_id == 0;
+    loaded_index->Add(first_half, dimension * sizeof(float));
+    empty_right = empty_right && loaded_index->Size() == (default_long_int) amount / 2;
+    delete loaded_index;
+
+    index.Save(file_path);
+    std::vector<char> content;
+    {
+        std::ifstream file(file_path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::vector<char> broken = content;
+    broken[8] = 2;          // version
+    std::ofstream(file_path, std::ios::binary | std::ios::trunc).write(broken.data(), broken.size());
+    bool version_refused = LoadRefused(file_path);
+    std::ofstream(file_path, std::ios::binary | std::ios::trunc).write(content.data(), content.size() / 2);
+    bool short_refused = LoadRefused(file_path);
+    std::remove(file_path.c_str());
+    bool missing_refused = LoadRefused(file_path);
+    std::cout << "refuse check: " << (empty_right && version_refused && short_refused && missing_refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,211 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : ivf_flat_index_test.cpp
+// since : 2024-09-10
+// desc  : check k-means finds separated clusters, check recall of ivf flat index
+// against flat index, also with the default parameters, and probing all lists
+// must get the same result as flat.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/ivf_flat_index.h"
+
+using namespace tiny_v_dbms;
+
+double Recall(const std::vector<SearchResult>& expect, const std::vector<SearchResult>& results)
+{
+    std::set<default_long_int> expect_ids;
+    for (const SearchResult& item : expect)
+    {
+        expect_ids.insert(item.id);
+    }
+    int hit = 0;
+    for (const SearchResult& item : results)
+    {
+        hit += expect_ids.count(item.id);
+    }
+    return (double) hit / expect.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    // k-means on 4 separated clusters of 2-d points
+    std::vector<float> points;
+    float centers[4][2] = {{-5, -5}, {-5, 5}, {5, -5}, {5, 5}};
+    for (int i = 0; i < 400; i++)
+    {
+        points.push_back(centers[i % 4][0] + noise(random_engine));
+        points.push_back(centers[i % 4][1] + noise(random_engine));
+    }
+    KMeans kmeans(2, 4);
+    kmeans.Train(points);
+    bool kmeans_check = true;
+    for (int c = 0; c < 4; c++)
+    {
+        const float* centroid = kmeans.GetCentroid(kmeans.Assign(centers[c]));
+        kmeans_check = kmeans_check && std::fabs(centroid[0] - centers[c][0]) < 0.1 && std::fabs(centroid[1] - centers[c][1]) < 0.1;
+    }
+    std::cout << "k-means check: " << (kmeans_check ? "pass" : "fail") << std::endl;
+
+    // vectors around 100 random centers, stored as fp32 records in runs of 100 records
+    int dimension = 64;
+    int amount = 10000;
+    int query_amount = 100;
+    int k = 10;
+    std::vector<std::vector<double> > cluster_centers(100, std::vector<double>(dimension));
+    for (auto& center : cluster_centers)
+    {
+        for (double& value : center)
+        {
+            value = random_value(random_engine);
+        }
+    }
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (int row = 0; row < amount; row++)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            vectors[(size_t) row * dimension + i] = center[i] + noise(random_engine);
+        }
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+
+    std::vector<std::vector<double> > queries(query_amount, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            query[i] = center[i] + noise(random_engine);
+        }
+    }
+
+    // train by a sample, then add all
+    auto begin = std::chrono::steady_clock::now();
+    IvfFlatIndex index(dimension, ELEMENT_FP32, 100, 8);
+    TrainingSampler sampler(dimension, ELEMENT_FP32, index.GetTrainingSampleAmount());
+    sampler.Offer(runs, record_length);
+    index.Train(sampler.GetSamples());
+    index.Add(runs, record_length);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+    default_long_int posting_amount = 0;
+    for (default_amount_type list_no = 0; list_no < index.GetNlist(); list_no++)
+    {
+        posting_amount += index.GetStore()->GetListSize(list_no);
+    }
+    std::cout << "size check: " << (sampler.GetSeenAmount() == (default_long_int) amount && posting_amount == (default_long_int) amount ? "pass" : "fail") << std::endl;
+
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    long long flat_cost = 0, ivf_cost = 0;
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+
+        auto flat_begin = std::chrono::steady_clock::now();
+        TopKCollector flat_collector(k);
+        flat_index.Search(mixed_query, runs, record_length, flat_collector);
+        auto flat_end = std::chrono::steady_clock::now();
+
+        TopKCollector ivf_collector(k);
+        index.Search(mixed_query, std::vector<VectorRun>(), record_length, ivf_collector);
+        auto ivf_end = std::chrono::steady_clock::now();
+
+        recall += Recall(flat_collector.GetSortedResults(), ivf_collector.GetSortedResults());
+        flat_cost += std::chrono::duration_cast<std::chrono::microseconds>(flat_end - flat_begin).count();
+        ivf_cost += std::chrono::duration_cast<std::chrono::microseconds>(ivf_end - flat_end).count();
+    }
+    recall /= query_amount;
+    std::cout << "recall@" << k << " (nprobe " << index.GetNprobe() << "): " << recall << std::endl;
+    std::cout << "recall check: " << (recall >= 0.9 ? "pass" : "fail") << std::endl;
+    std::cout << "flat search cost: " << flat_cost / query_amount << " us per query" << std::endl;
+    std::cout << "ivf search cost: " << ivf_cost / query_amount << " us per query" << std::endl;
+
+    // probing all lists is a flat scan
+    index.SetNprobe(index.GetNlist());
+    bool exact = true;
+    for (int q = 0; q < 10; q++)
+    {
+        MixedPrecisionQuery mixed_query(queries[q].data(), dimension, ELEMENT_FP32);
+        TopKCollector flat_collector(k), ivf_collector(k);
+        flat_index.Search(mixed_query, runs, record_length, flat_collector);
+        index.Search(mixed_query, std::vector<VectorRun>(), record_length, ivf_collector);
+        std::vector<SearchResult> expect = flat_collector.GetSortedResults(), results = ivf_collector.GetSortedResults();
+        for (int i = 0; i < k; i++)
+        {
+            exact = exact && expect[i].id == results[i].id && std::fabs(expect[i].distance - results[i].distance) < 1e-9;
+        }
+    }
+    std::cout << "all lists check: " << (exact ? "pass" : "fail") << std::endl;
+
+    // default parameters on uniform vectors without clusters, near records are spread over many lists
+    int uniform_dimension = 8;
+    int uniform_amount = 3000;
+    std::vector<float> uniform_vectors((size_t) uniform_amount * uniform_dimension);
+    for (float& value : uniform_vectors)
+    {
+        value = random_value(random_engine);
+    }
+    std::vector<VectorRun> uniform_runs;
+    for (default_long_int row = 0; row < (default_long_int) uniform_amount; row += 100)
+    {
+        uniform_runs.push_back(VectorRun{(const char*) (uniform_vectors.data() + row * uniform_dimension), 100, row});
+    }
+    default_length_size uniform_record_length = uniform_dimension * sizeof(float);
+    IvfFlatIndex default_index(uniform_dimension, ELEMENT_FP32);
+    TrainingSampler uniform_sampler(uniform_dimension, ELEMENT_FP32, default_index.GetTrainingSampleAmount());
+    uniform_sampler.Offer(uniform_runs, uniform_record_length);
+    default_index.Train(uniform_sampler.GetSamples());
+    default_index.Add(uniform_runs, uniform_record_length);
+    FlatIndex uniform_flat_index(uniform_dimension);
+    double default_recall = 0;
+    for (int q = 0; q < query_amount; q++)
+    {
+        std::vector<double> query(uniform_dimension);
+        for (double& value : query)
+        {
+            value = random_value(random_engine);
+        }
+        MixedPrecisionQuery mixed_query(query.data(), uniform_dimension, ELEMENT_FP32);
+        TopKCollector flat_collector(k), ivf_collector(k);
+        uniform_flat_index.Search(mixed_query, uniform_runs, uniform_record_length, flat_collector);
+        default_index.Search(mixed_query, std::vector<VectorRun>(), uniform_record_length, ivf_collector);
+        default_recall += Recall(flat_collector.GetSortedResults(), ivf_collector.GetSortedResults());
+    }
+    default_recall /= query_amount;
+    std::cout << "default recall@" << k << " (nlist " << default_index.GetNlist() << ", nprobe " << default_index.GetNprobe() << "): " << default_recall << std::endl;
+    std::cout << "default recall check: " << (default_index.GetNprobe() == IvfFlatIndex::GetDefaultNprobe(default_index.GetNlist()) && default_recall >= 0.9 ? "pass" : "fail") << std::endl;
+
+    // adding before training is refused
+    IvfFlatIndex untrained_index(dimension, ELEMENT_FP32, 16);
+    bool refused = false;
+    try
+    {
+        untrained_index.Add(runs, record_length);
+    }
+    catch (const std::runtime_error& e)
+    {
+        refused = true;
+    }
+    std::cout << "train check: " << (refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : pq_index_test.cpp
+// since : 2024-09-10
+// desc  : check adc distances of product quantizer are close to exact distances,
+// check recall of pq and ivf pq index against flat index, with and without
+// reranking candidates by exact distances.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/pq_index.h"
+#include "../../../include/index/ivf_pq_index.h"
+
+using namespace tiny_v_dbms;
+
+double Recall(const std::vector<SearchResult>& expect, const std::vector<SearchResult>& results)
+{
+    std::set<default_long_int> expect_ids;
+    for (const SearchResult& item : expect)
+    {
+        expect_ids.insert(item.id);
+    }
+    int hit = 0;
+    for (const SearchResult& item : results)
+    {
+        hit += expect_ids.count(item.id);
+    }
+    return (double) hit / expect.size();
+}
+
+// search by index, rerank its candidates by exact distances of vectors like the operator does
+std::vector<SearchResult> SearchWithRerank(const BasicIndex& index, const MixedPrecisionQuery& query, const std::vector<float>& vectors,
+    default_length_size dimension, default_long_int k)
+{
+    default_long_int rerank_amount = index.GetRerankAmount(k);
+    TopKCollector candidates(rerank_amount > k ? rerank_amount : k);
+    index.Search(query, std::vector<VectorRun>(), dimension * sizeof(float), candidates);
+    if (rerank_amount <= k)
+    {
+        return candidates.GetSortedResults();
+    }
+    TopKCollector collector(k);
+    for (const SearchResult& candidate : candidates.GetSortedResults())
+    {
+        collector.Insert(candidate.id, query.L2Sqr((const char*) (vectors.data() + candidate.id * dimension)));
+    }
+    return collector.GetSortedResults();
+}
+
+double AverageRecall(const BasicIndex& index, const std::vector<std::vector<double> >& queries, const std::vector<VectorRun>& runs,
+    const std::vector<float>& vectors, default_length_size dimension, default_long_int k)
+{
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+        TopKCollector flat_collector(k);
+        flat_index.Search(mixed_query, runs, dimension * sizeof(float), flat_collector);
+        recall += Recall(flat_collector.GetSortedResults(), SearchWithRerank(index, mixed_query, vectors, dimension, k));
+    }
+    return recall / queries.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    // vectors around 100 random centers, stored as fp32 records in runs of 100 records
+    int dimension = 64;
+    int amount = 10000;
+    int query_amount = 100;
+    int k = 10;
+    std::vector<std::vector<double> > cluster_centers(100, std::vector<double>(dimension));
+    for (auto& center : cluster_centers)
+    {
+        for (double& value : center)
+        {
+            value = random_value(random_engine);
+        }
+    }
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (int row = 0; row < amount; row++)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            vectors[(size_t) row * dimension + i] = center[i] + noise(random_engine);
+        }
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+
+    std::vector<std::vector<double> > queries(query_amount, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            query[i] = center[i] + noise(random_engine);
+        }
+    }
+
+    // adc distance of a code is the exact distance to its decoded vector
+    ProductQuantizer pq(dimension, 16);
+    TrainingSampler pq_sampler(dimension, ELEMENT_FP32, 256 * 32);
+    pq_sampler.Offer(runs, record_length);
+    pq.Train(pq_sampler.GetSamples());
+    std::vector<float> query_fp32(queries[0].begin(), queries[0].end());
+    std::vector<float> table(pq.GetM() * pq.GetKsub());
+    pq.ComputeDistanceTable(query_fp32.data(), table.data());
+    std::vector<uint8_t> code(pq.GetCodeLength());
+    std::vector<float> decoded(dimension);
+    bool adc_check = true;
+    double error = 0, norm = 0;
+    for (int row = 0; row < 100; row++)
+    {
+        const float* vector = vectors.data() + (size_t) row * dimension;
+        pq.Encode(vector, code.data());
+        pq.Decode(code.data(), decoded.data());
+        double decoded_distance = 0;
+        for (int i = 0; i < dimension; i++)
+        {
+            decoded_distance += (query_fp32[i] - decoded[i]) * (query_fp32[i] - decoded[i]);
+            error += (vector[i] - decoded[i]) * (vector[i] - decoded[i]);
+            norm += vector[i] * vector[i];
+        }
+        adc_check = adc_check && std::fabs(pq.AdcDistance(table.data(), code.data()) - decoded_distance) < 1e-3;
+    }
+    std::cout << "relative encoding error: " << error / norm << std::endl;
+    std::cout << "adc check: " << (adc_check && error / norm < 0.1 ? "pass" : "fail") << std::endl;
+
+    // pq index, each vector is 16 bytes instead of 256
+    auto begin = std::chrono::steady_clock::now();
+    PqIndex pq_index(dimension, ELEMENT_FP32, 16);
+    TrainingSampler sampler(dimension, ELEMENT_FP32, pq_index.GetTrainingSampleAmount());
+    sampler.Offer(runs, record_length);
+    pq_index.Train(sampler.GetSamples());
+    pq_index.Add(runs, record_length);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "pq build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+    std::cout << "pq size check: " << (pq_index.Size() == (default_long_int) amount ? "pass" : "fail") << std::endl;
+
+    double recall = AverageRecall(pq_index, queries, runs, vectors, dimension, k);
+    std::cout << "pq recall@" << k << ": " << recall << std::endl;
+    PqIndex rerank_pq_index(dimension, ELEMENT_FP32, 16, 10);
+    rerank_pq_index.Train(sampler.GetSamples());
+    rerank_pq_index.Add(runs, record_length);
+    double rerank_recall = AverageRecall(rerank_pq_index, queries, runs, vectors, dimension, k);
+    std::cout << "pq recall@" << k << " (rerank 10k): " << rerank_recall << std::endl;
+    std::cout << "pq recall check: " << (rerank_recall >= 0.95 && rerank_recall > recall ? "pass" : "fail") << std::endl;
+
+    // ivf pq index, residuals are encoded
+    begin = std::chrono::steady_clock::now();
+    IvfPqIndex ivf_pq_index(dimension, ELEMENT_FP32, 100, 8, 16, 10);
+    TrainingSampler ivf_sampler(dimension, ELEMENT_FP32, ivf_pq_index.GetTrainingSampleAmount());
+    ivf_sampler.Offer(runs, record_length);
+    ivf_pq_index.Train(ivf_sampler.GetSamples());
+    ivf_pq_index.Add(runs, record_length);
+    end = std::chrono::steady_clock::now();
+    std::cout << "ivf pq build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+    default_long_int posting_amount = 0;
+    for (default_amount_type list_no = 0; list_no < ivf_pq_index.GetNlist(); list_no++)
+    {
+        posting_amount += ivf_pq_index.GetStore()->GetListSize(list_no);
+    }
+    std::cout << "ivf pq size check: " << (posting_amount == (default_long_int) amount && ivf_pq_index.GetPostingLength() == 8 + 16 ? "pass" : "fail") << std::endl;
+
+    recall = AverageRecall(ivf_pq_index, queries, runs, vectors, dimension, k);
+    std::cout << "ivf pq recall@" << k << " (nprobe " << ivf_pq_index.GetNprobe() << ", rerank 10k): " << recall << std::endl;
+    std::cout << "ivf pq recall check: " << (recall >= 0.9 ? "pass" : "fail") << std::endl;
+
+    // 4-bit codes of 32 sub quantizers have the same size as 8-bit codes of 16, scanned by fast scan
+    PqIndex fast_pq_index(dimension, ELEMENT_FP32, 32, 10, 4);
+    TrainingSampler fast_sampler(dimension, ELEMENT_FP32, fast_pq_index.GetTrainingSampleAmount());
+    fast_sampler.Offer(runs, record_length);
+    fast_pq_index.Train(fast_sampler.GetSamples());
+    fast_pq_index.Add(runs, record_length);
+    begin = std::chrono::steady_clock::now();
+    double fast_recall = AverageRecall(fast_pq_index, queries, runs, vectors, dimension, k);
+    end = std::chrono::steady_clock::now();
+    std::cout << "4-bit pq recall@" << k << " (rerank 10k): " << fast_recall << ", cost "
+        << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / query_amount << " us per query" << std::endl;
+
+    IvfPqIndex fast_ivf_pq_index(dimension, ELEMENT_FP32, 100, 8, 32, 10, 4);
+    TrainingSampler fast_ivf_sampler(dimension, ELEMENT_FP32, fast_ivf_pq_index.GetTrainingSampleAmount());
+    fast_ivf_sampler.Offer(runs, record_length);
+    fast_ivf_pq_index.Train(fast_ivf_sampler.GetSamples());
+    fast_ivf_pq_index.Add(runs, record_length);
+    double fast_ivf_recall = AverageRecall(fast_ivf_pq_index, queries, runs, vectors, dimension, k);
+    std::cout << "4-bit ivf pq recall@" << k << " (nprobe " << fast_ivf_pq_index.GetNprobe() << ", rerank 10k): " << fast_ivf_recall << std::endl;
+    std::cout << "fast scan check: " << (fast_pq_index.Size() == (default_long_int) amount && fast_ivf_pq_index.Size() == (default_long_int) amount
+        && fast_recall >= 0.95 && fast_ivf_recall >= 0.9 ? "pass" : "fail") << std::endl;
+
+    // dimension must be a multiple of m, and adding before training is refused
+    bool refused = false;
+    try
+    {
+        PqIndex wrong_index(dimension, ELEMENT_FP32, 10);
+    }
+    catch (const std::runtime_error& e)
+    {
+        refused = true;
+    }
+    IvfPqIndex untrained_index(dimension, ELEMENT_FP32, 16);
+    bool untrained_refused = false;
+    try
+    {
+        untrained_index.Add(runs, record_length);
+    }
+    catch (const std::runtime_error& e)
+    {
+        untrained_refused = true;
+    }
+    std::cout << "parameter check: " << (refused && untrained_refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : range_search_test.cpp
+// since : 2024-09-10
+// desc  : search all records in a radius by indexes, check results are in the radius, not repeated, emitted by
+// batches no larger than the batch size, and recall against the exact records in the radius, with and without filter.
+
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/range_collector.h"
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/hnsw_index.h"
+#include "../../../include/index/ivf_flat_index.h"
+#include "../../../include/index/diskann_index.h"
+#include "../../../include/index/kmeans.h"
+
+using namespace tiny_v_dbms;
+
+/**
+ * @brief Runs are only used by flat index, other indexes keep their own vectors.
+ * @return Average recall of index against the exact records in radius, or -1 if a result is wrong.
+ */
+double RangeRecall(const BasicIndex& index, const std::vector<std::vector<double> >& queries, const std::vector<double>& radiuses,
+    const std::vector<VectorRun>& runs, default_length_size dimension, const TagBitmap* filter)
+{
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        MixedPrecisionQuery mixed_query(queries[q].data(), dimension, ELEMENT_FP32);
+        std::set<default_long_int> expect_ids;
+        RangeCollector flat_collector(radiuses[q], [&](const std::vector<SearchResult>& batch)
+        {
+            for (const SearchResult& item : batch)
+            {
+                expect_ids.insert(item.id);
+            }
+        }, filter);
+        flat_index.RangeSearch(mixed_query, runs, dimension * sizeof(float), flat_collector);
+        flat_collector.Flush();
+
+        std::set<default_long_int> ids;
+        bool right = true;
+        default_long_int batch_size = 16;
+        RangeCollector collector(radiuses[q], [&](const std::vector<SearchResult>& batch)
+        {
+            right = right && !batch.empty() && (default_long_int) batch.size() <= batch_size;
+            for (const SearchResult& item : batch)
+            {
+                right = right && item.distance < radiuses[q] && ids.insert(item.id).second && (filter == nullptr || filter->Contains(item.id));
+            }
+        }, filter, batch_size);
+        if (!index.RangeSearch(mixed_query, runs, dimension * sizeof(float), collector))
+        {
+            return -1;
+        }
+        collector.Flush();
+        if (!right || (default_long_int) ids.size() != collector.Size())
+        {
+            return -1;
+        }
+
+        int hit = 0;
+        for (default_long_int id : ids)
+        {
+            hit += expect_ids.count(id);
+        }
+        recall += expect_ids.empty() ? 1 : (double) hit / expect_ids.size();
+    }
+    return recall / queries.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+
+    int dimension = 32;
+    int amount = 5000;
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (float& value : vectors)
+    {
+        value = random_value(random_engine);
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+
+    // queries are records moved a little, the radius of each query keeps about 100 records in it
+    std::vector<std::vector<double> > queries(20, std::vector<double>(dimension));
+    std::vector<double> radiuses;
+    for (auto& query : queries)
+    {
+        default_long_int row = random_engine() % amount;
+        for (int d = 0; d < dimension; d++)
+        {
+            query[d] = vectors[row * dimension + d] + random_value(random_engine) * 0.1;
+        }
+        std::vector<double> distances;
+        for (default_long_int other = 0; other < amount; other++)
+        {
+            double distance = 0;
+            for (int d = 0; d < dimension; d++)
+            {
+                distance += (query[d] - vectors[other * dimension + d]) * (query[d] - vectors[other * dimension + d]);
+            }
+            distances.push_back(std::sqrt(distance));
+        }
+        std::sort(distances.begin(), distances.end());
+        radiuses.push_back((distances[99] + distances[100]) / 2);
+    }
+
+    // flat index finds exactly the records in radius
+    FlatIndex flat_index(dimension);
+    double flat_recall = RangeRecall(flat_index, queries, radiuses, runs, dimension, nullptr);
+    default_long_int flat_amount = 0;
+    MixedPrecisionQuery mixed_query(queries[0].data(), dimension, ELEMENT_FP32);
+    RangeCollector flat_collector(radiuses[0], [&](const std::vector<SearchResult>& batch)
+    {
+        flat_amount += batch.size();
+    });
+    flat_index.RangeSearch(mixed_query, runs, record_length, flat_collector);
+    flat_collector.Flush();
+    std::cout << "flat check: " << (flat_recall == 1 && flat_amount == 100 && flat_collector.Size() == 100 ? "pass" : "fail") << std::endl;
+
+    HnswIndex hnsw_index(dimension, ELEMENT_FP32, 16, 100, 64);
+    hnsw_index.Add(runs, record_length);
+
+    IvfFlatIndex ivf_index(dimension, ELEMENT_FP32, 64, 16);
+    TrainingSampler ivf_sampler(dimension, ELEMENT_FP32, ivf_index.GetTrainingSampleAmount());
+    ivf_sampler.Offer(runs, record_length);
+    ivf_index.Train(ivf_sampler.GetSamples());
+    ivf_index.Add(runs, record_length);
+
+    DiskAnnIndex diskann_index(dimension, ELEMENT_FP32);
+    TrainingSampler diskann_sampler(dimension, ELEMENT_FP32, diskann_index.GetTrainingSampleAmount());
+    diskann_sampler.Offer(runs, record_length);
+    diskann_index.Train(diskann_sampler.GetSamples());
+    diskann_index.Add(runs, record_length);
+    diskann_index.FinishBuild();
+
+    // half of records pass the filter
+    TagBitmap filter;
+    for (default_long_int tag = 0; tag < (default_long_int) amount; tag += 2)
+    {
+        filter.Add(tag);
+    }
+    filter.Extend(amount);
+
+    bool all_right = true;
+    for (const TagBitmap* search_filter : {(const TagBitmap*) nullptr, (const TagBitmap*) &filter})
+    {
+        double hnsw_recall = RangeRecall(hnsw_index, queries, radiuses, runs, dimension, search_filter);
+        double ivf_recall = RangeRecall(ivf_index, queries, radiuses, runs, dimension, search_filter);
+        double diskann_recall = RangeRecall(diskann_index, queries, radiuses, runs, dimension, search_filter);
+        std::cout << (search_filter == nullptr ? "no filter" : "half filter") << ", range recall hnsw: " << hnsw_recall
+            << ", ivf_flat: " << ivf_recall << ", diskann: " << diskann_recall << std::endl;
+        all_right = all_right && hnsw_recall >= 0.9 && ivf_recall >= 0.6 && diskann_recall >= 0.9;
+    }
+    std::cout << "range check: " << (all_right ? "pass" : "fail") << std::endl;
+
+    // nothing is in a tiny radius far from all records
+    std::vector<double> far_query(dimension, 10.0);
+    MixedPrecisionQuery far_mixed_query(far_query.data(), dimension, ELEMENT_FP32);
+    RangeCollector hnsw_collector(0.1, [](const std::vector<SearchResult>&) {});
+    RangeCollector ivf_collector(0.1, [](const std::vector<SearchResult>&) {});
+    hnsw_index.RangeSearch(far_mixed_query, std::vector<VectorRun>(), record_length, hnsw_collector);
+    ivf_index.RangeSearch(far_mixed_query, std::vector<VectorRun>(), record_length, ivf_collector);
+    std::cout << "empty check: " << (hnsw_collector.Size() == 0 && ivf_collector.Size() == 0 ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : sq_index_test.cpp
+// since : 2024-09-10
+// desc  : check distances of scalar quantizer are close to exact distances of decoded vectors, check recall of
+// sq8 and sq4 index against flat index, with and without reranking candidates by exact distances.
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../../include/index/flat_index.h"
+#include "../../../include/index/kmeans.h"
+#include "../../../include/index/sq_index.h"
+
+using namespace tiny_v_dbms;
+
+double Recall(const std::vector<SearchResult>& expect, const std::vector<SearchResult>& results)
+{
+    std::set<default_long_int> expect_ids;
+    for (const SearchResult& item : expect)
+    {
+        expect_ids.insert(item.id);
+    }
+    int hit = 0;
+    for (const SearchResult& item : results)
+    {
+        hit += expect_ids.count(item.id);
+    }
+    return (double) hit / expect.size();
+}
+
+// search by index, rerank its candidates by exact distances of vectors like the operator does
+double AverageRecall(const SqIndex& index, const std::vector<std::vector<double> >& queries, const std::vector<VectorRun>& runs,
+    const std::vector<float>& vectors, default_length_size dimension, default_long_int k)
+{
+    FlatIndex flat_index(dimension);
+    double recall = 0;
+    for (auto& query : queries)
+    {
+        MixedPrecisionQuery mixed_query(query.data(), dimension, ELEMENT_FP32);
+        TopKCollector flat_collector(k);
+        flat_index.Search(mixed_query, runs, dimension * sizeof(float), flat_collector);
+
+        default_long_int rerank_amount = index.GetRerankAmount(k);
+        TopKCollector candidates(rerank_amount > k ? rerank_amount : k);
+        index.Search(mixed_query, std::vector<VectorRun>(), dimension * sizeof(float), candidates);
+        std::vector<SearchResult> results = candidates.GetSortedResults();
+        if (rerank_amount > k)
+        {
+            TopKCollector collector(k);
+            for (const SearchResult& candidate : results)
+            {
+                collector.Insert(candidate.id, mixed_query.L2Sqr((const char*) (vectors.data() + candidate.id * dimension)));
+            }
+            results = collector.GetSortedResults();
+        }
+        recall += Recall(flat_collector.GetSortedResults(), results);
+    }
+    return recall / queries.size();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::mt19937 random_engine(7);
+    std::uniform_real_distribution<double> random_value(-1.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    // vectors around 100 random centers, stored as fp32 records in runs of 100 records
+    int dimension = 64;
+    int amount = 10000;
+    int query_amount = 100;
+    int k = 10;
+    std::vector<std::vector<double> > cluster_centers(100, std::vector<double>(dimension));
+    for (auto& center : cluster_centers)
+    {
+        for (double& value : center)
+        {
+            value = random_value(random_engine);
+        }
+    }
+    std::vector<float> vectors((size_t) amount * dimension);
+    for (int row = 0; row < amount; row++)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            vectors[(size_t) row * dimension + i] = center[i] + noise(random_engine);
+        }
+    }
+    std::vector<VectorRun> runs;
+    for (default_long_int row = 0; row < amount; row += 100)
+    {
+        runs.push_back(VectorRun{(const char*) (vectors.data() + row * dimension), 100, row});
+    }
+    default_length_size record_length = dimension * sizeof(float);
+
+    std::vector<std::vector<double> > queries(query_amount, std::vector<double>(dimension));
+    for (auto& query : queries)
+    {
+        const std::vector<double>& center = cluster_centers[random_engine() % cluster_centers.size()];
+        for (int i = 0; i < dimension; i++)
+        {
+            query[i] = center[i] + noise(random_engine);
+        }
+    }
+
+    // integer distance is close to the exact distance to the decoded vector, odd dimension tests the last sq4 byte
+    bool distance_check = true;
+    for (default_amount_type nbits : {8, 4})
+    {
+        for (default_length_size sq_dimension : {dimension, dimension - 1})
+        {
+            ScalarQuantizer sq(sq_dimension, nbits);
+            std::vector<float> samples;
+            for (int row = 0; row < 1000; row++)
+            {
+                samples.insert(samples.end(), vectors.begin() + row * dimension, vectors.begin() + row * dimension + sq_dimension);
+            }
+            sq.Train(samples);
+            std::vector<float> query_fp32(queries[0].begin(), queries[0].begin() + sq_dimension);
+            SqQuery sq_query;
+            sq.PrepareQuery(query_fp32.data(), sq_query);
+            std::vector<uint8_t> code(sq.GetCodeLength());
+            std::vector<float> decoded(sq_dimension);
+            for (int row = 0; row < 100; row++)
+            {
+                sq.Encode(samples.data() + row * sq_dimension, code.data());
+                sq.Decode(code.data(), decoded.data());
+                double exact = 0;
+                for (default_length_size i = 0; i < sq_dimension; i++)
+                {
+                    exact += (query_fp32[i] - decoded[i]) * (query_fp32[i] - decoded[i]);
+                }
+                int32_t dot = nbits == 8 ? SqKernel::Sq8DotScalar(code.data(), sq_query.query_low.data(), sq.GetCodeLength())
+                    : SqKernel::Sq4DotScalar(code.data(), sq_query.query_low.data(), sq_query.query_high.data(), sq.GetCodeLength());
+                double distance = sq.GetDistance(sq_query, dot, sq.GetCodeNorm(code.data()));
+                // the error of int8 query is absolute, it does not shrink with the distance
+                distance_check = distance_check && std::fabs(distance - exact) < 0.002 * (exact + sq_query.norm);
+            }
+        }
+    }
+    std::cout << "distance check: " << (distance_check ? "pass" : "fail") << std::endl;
+
+    for (default_amount_type nbits : {8, 4})
+    {
+        auto begin = std::chrono::steady_clock::now();
+        SqIndex index(dimension, ELEMENT_FP32, nbits);
+        TrainingSampler sampler(dimension, ELEMENT_FP32, index.GetTrainingSampleAmount());
+        sampler.Offer(runs, record_length);
+        index.Train(sampler.GetSamples());
+        index.Add(runs, record_length);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "sq" << nbits << " build cost: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+        begin = std::chrono::steady_clock::now();
+        double recall = AverageRecall(index, queries, runs, vectors, dimension, k);
+        end = std::chrono::steady_clock::now();
+        std::cout << "sq" << nbits << " recall@" << k << ": " << recall << ", cost "
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / query_amount << " us per query" << std::endl;
+
+        SqIndex rerank_index(dimension, ELEMENT_FP32, nbits, 4);
+        rerank_index.Train(sampler.GetSamples());
+        rerank_index.Add(runs, record_length);
+        double rerank_recall = AverageRecall(rerank_index, queries, runs, vectors, dimension, k);
+        std::cout << "sq" << nbits << " recall@" << k << " (rerank 4k): " << rerank_recall << std::endl;
+        bool recall_right = nbits == 8 ? recall >= 0.9 && rerank_recall >= 0.99 : rerank_recall >= 0.95;
+        std::cout << "sq" << nbits << " check: " << (index.Size() == (default_long_int) amount && index.GetIndexType() == (nbits == 8 ? SQ8 : SQ4)
+            && recall_right ? "pass" : "fail") << std::endl;
+    }
+
+    // nbits must be 8 or 4, and adding before training is refused
+    bool refused = false;
+    try
+    {
+        SqIndex wrong_index(dimension, ELEMENT_FP32, 6);
+    }
+    catch (const std::runtime_error& e)
+    {
+        refused = true;
+    }
+    SqIndex untrained_index(dimension, ELEMENT_FP32);
+    bool untrained_refused = false;
+    try
+    {
+        untrained_index.Add(runs, record_length);
+    }
+    catch (const std::runtime_error& e)
+    {
+        untrained_refused = true;
+    }
+    std::cout << "parameter check: " << (refused && untrained_refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : column_table_test.cpp
+// since : 2024-09-10
+// desc  : serialize table headers, check a header of the current version is read back, and a header of version 0
+// (written without version, column options and element types) is read with default options and written back in
+// its own layout.
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include "../../../include/meta/table/column_table.h"
+
+using namespace tiny_v_dbms;
+
+ColumnTable MakeTable()
+{
+    ColumnTable table(2);
+    table.table_name = "items";
+    table.table_type = 0;
+    table.columns.column_name_array[0] = "id";
+    table.columns.column_name_array[1] = "emb";
+    table.columns.column_type_array[0] = 1;
+    table.columns.column_type_array[1] = 6;
+    table.columns.column_length_array[0] = 4;
+    table.columns.column_length_array[1] = 8;
+    table.columns.column_index_type_array[0] = 0;
+    table.columns.column_index_type_array[1] = 0;
+    table.columns.column_storage_address_array[0] = 0;
+    table.columns.column_storage_address_array[1] = 1;
+    table.columns.column_option_array[1] = COLUMN_OPTION_NORMALIZE;
+    table.columns.column_element_type_array[1] = ELEMENT_FP16;
+    return table;
+}
+
+// the layout written before header versions
+std::vector<char> SerializeVersionZero(ColumnTable& table)
+{
+    std::vector<char> buffer;
+    auto append = [&](const void* data, size_t length) {
+        buffer.insert(buffer.end(), (const char*) data, (const char*) data + length);
+    };
+    default_length_size name_size = table.table_name.size();
+    append(&name_size, sizeof(name_size));
+    append(table.table_name.c_str(), name_size);
+    append(&table.table_type, sizeof(table.table_type));
+    append(&table.column_size, sizeof(table.column_size));
+    for (default_amount_type i = 0; i < table.column_size; i++)
+    {
+        default_length_size column_name_size = table.columns.column_name_array[i].size();
+        append(&column_name_size, sizeof(column_name_size));
+        append(table.columns.column_name_array[i].c_str(), column_name_size);
+    }
+    for (default_amount_type i = 0; i < table.column_size; i++)
+    {
+        append(&table.columns.column_type_array[i], sizeof(default_enum_type));
+    }
+    for (default_amount_type i = 0; i < table.column_size; i++)
+    {
+        append(&table.columns.column_length_array[i], sizeof(default_length_size));
+    }
+    for (default_amount_type i = 0; i < table.column_size; i++)
+    {
+        append(&table.columns.column_index_type_array[i], sizeof(default_enum_type));
+    }
+    for (default_amount_type i = 0; i < table.column_size; i++)
+    {
+        append(&table.columns.column_storage_address_array[i], sizeof(default_address_type));
+    }
+    return buffer;
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    ColumnTable table = MakeTable();
+    std::vector<char> buffer(table.GetLength() + 16, 0);
+    default_length_size written = table.Serialize(buffer.data(), 16);
+    ColumnTable current;
+    current.Deserialize(buffer.data(), 16);
+    bool current_right = written == table.GetLength() && current.header_version == TABLE_HEADER_VERSION
+        && current.table_name == "items" && current.column_size == 2 && current.columns.column_name_array[1] == "emb"
+        && current.columns.column_storage_address_array[1] == 1 && current.columns.column_option_array[1] == COLUMN_OPTION_NORMALIZE
+        && current.columns.column_element_type_array[0] == ELEMENT_FP32 && current.columns.column_element_type_array[1] == ELEMENT_FP16;
+    std::cout << "current version check: " << (current_right ? "pass" : "fail") << std::endl;
+
+    std::vector<char> old_buffer = SerializeVersionZero(table);
+    ColumnTable old;
+    old.Deserialize(old_buffer.data(), 0);
+    bool old_right = old.header_version == 0 && old.table_name == "items" && old.column_size == 2
+        && old.columns.column_name_array[0] == "id" && old.columns.column_length_array[1] == 8
+        && old.columns.column_storage_address_array[1] == 1 && old.columns.column_option_array[1] == COLUMN_OPTION_NONE
+        && old.columns.column_element_type_array[1] == ELEMENT_FP32;
+    std::cout << "version 0 check: " << (old_right ? "pass" : "fail") << std::endl;
+
+    // a header updated in place keeps its layout and length
+    old.columns.column_index_type_array[1] = 1;
+    std::vector<char> rewritten(old_buffer.size(), 0);
+    bool rewrite_right = old.GetLength() == (default_length_size) old_buffer.size()
+        && old.Serialize(rewritten.data(), 0) == (default_length_size) old_buffer.size();
+    ColumnTable reread;
+    reread.Deserialize(rewritten.data(), 0);
+    rewrite_right = rewrite_right && reread.header_version == 0 && reread.columns.column_index_type_array[1] == 1;
+    std::cout << "version 0 rewrite check: " << (rewrite_right ? "pass" : "fail") << std::endl;
+
+    // a header of a newer version is refused
+    default_length_size newer = -(TABLE_HEADER_VERSION + 1);
+    memcpy(buffer.data() + 16, &newer, sizeof(newer));
+    bool refused = false;
+    try
+    {
+        ColumnTable newer_table;
+        newer_table.Deserialize(buffer.data(), 16);
+    }
+    catch (const std::runtime_error& e)
+    {
+        refused = true;
+    }
+    std::cout << "newer version check: " << (refused ? "pass" : "fail") << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "../../../include/meta/vector_view.h"
+#include "../../../include/meta/block/data_block.h"
+#include "../../../include/storage/memory/block_slot.h"
+#include "../../../include/distance/euclidean_distance.h"
+#include "../../../include/distance/squared_euclidean_distance.h"
+
+using namespace tiny_v_dbms;
+
+#define DIMENSION 128
+
+int main() {
+
+    std::cout << "test begin" << std::endl;
+
+    // fill one block of buffer pool with vector records
+    BlockSlot slot;
+    DataBlock block;
+    block.data = slot.data;
+    block.InitBlock(DIMENSION * sizeof(double));
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    double values[DIMENSION];
+    while (block.HaveSpace(DIMENSION * sizeof(double))) {
+        for (int i = 0; i < DIMENSION; i++) {
+            values[i] = distribution(generator);
+        }
+        block.InsertData((char*) values, DIMENSION * sizeof(double));
+    }
+    int record_amount = block.field_data_nums;
+    std::cout << "records in block: " << record_amount << std::endl;
+
+    double query_data[DIMENSION];
+    for (int i = 0; i < DIMENSION; i++) {
+        query_data[i] = distribution(generator);
+    }
+    BASE_VECTOR query(query_data, DIMENSION);
+
+    // views point into the block, check alignment and results against copied vectors
+    EuclideanDistance<double> distance(DIMENSION);
+    bool aligned = true;
+    bool same = true;
+    for (int row = 0; row < record_amount; row++) {
+        BASE_VECTOR_VIEW view = BASE_VECTOR_VIEW::FromBlock(slot.data, block.last_record_start_address + row * block.field_length, DIMENSION);
+        aligned = aligned && view.IsAligned(64);
+
+        BASE_VECTOR copied(view.GetData(), DIMENSION);
+        same = same && std::fabs(distance.Cal(query, view) - distance.Cal(query, copied)) < 1e-9;
+    }
+    std::cout << "aligned check: " << (aligned ? "pass" : "fail") << std::endl;
+    std::cout << "result check: " << (same ? "pass" : "fail") << std::endl;
+
+    SquaredEuclideanDistance<double> squared_distance;
+    BASE_VECTOR_VIEW first_view = BASE_VECTOR_VIEW::FromBlock(slot.data, block.last_record_start_address, DIMENSION);
+    double exact = squared_distance.Cal(query.GetView(), first_view);
+    std::cout << "threshold check: " << (squared_distance.CalWithThreshold(query.GetView(), first_view, exact + 1) == exact ? "pass" : "fail") << std::endl;
+
+    // cost of reading every record as a new vector vs as a view
+    const int rounds = 20000;
+    double sum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (int row = 0; row < record_amount; row++) {
+            BASE_VECTOR copied((const double*) (slot.data + block.last_record_start_address + row * block.field_length), DIMENSION);
+            sum += distance.Cal(query, copied);
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (int row = 0; row < record_amount; row++) {
+            sum += distance.Cal(query, BASE_VECTOR_VIEW::FromBlock(slot.data, block.last_record_start_address + row * block.field_length, DIMENSION));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "copy cost: " << std::chrono::duration_cast<std::chrono::microseconds>(middle - begin).count() << "us" << std::endl;
+    std::cout << "view cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count() << "us" << std::endl;
+    std::cout << "checksum " << sum << std::endl;
+
+    std::cout << "test end" << std::endl;
+}
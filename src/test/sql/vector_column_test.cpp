@@ -0,0 +1,140 @@
+#include <iostream>
+#include <cmath>
+
+#include "../../../include/sql/parser/parser.h"
+#include "../../../include/meta/block/data_block.h"
+#include "../../../include/storage/memory/block_slot.h"
+#include "../../../include/meta/vector_view.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+
+    std::cout << "test begin" << std::endl;
+
+    Parser parser;
+
+    // create table with vector columns
+    AST* create_ast = parser.BuildAST("CREATE TABLE items (id INT, emb VECTOR(4), small VECTOR(4, FP16) NORMALIZE);");
+    bool create_check = create_ast != nullptr && create_ast->GetType() == CREATE_TABLE_NODE;
+    if (create_check) {
+        vector<Column>& columns = create_ast->create_table_sql->columns;
+        create_check = columns.size() == 3
+            && columns[0].value_type == INT_T
+            && columns[1].value_type == VECTOR_T && columns[1].col_length == 4 && columns[1].element_type == ELEMENT_FP32 && columns[1].option == COLUMN_OPTION_NONE
+            && columns[2].value_type == VECTOR_T && columns[2].col_length == 4 && columns[2].element_type == ELEMENT_FP16 && columns[2].option == COLUMN_OPTION_NORMALIZE;
+    }
+    std::cout << "create check: " << (create_check ? "pass" : "fail") << std::endl;
+
+    // insert with vector literals
+    AST* insert_ast = parser.BuildAST("INSERT INTO items (id, emb, small) VALUES (1, [0.5, -1.25, 3e-1, 2], [3, 0, 0, 4]);");
+    bool insert_check = insert_ast != nullptr && insert_ast->GetType() == INSERT_INTO_TABLE_NODE
+        && insert_ast->insert_into_table_sql->values.size() == 3
+        && insert_ast->insert_into_table_sql->values[1].raw_value == "[0.5, -1.25, 3e-1, 2]";
+    std::cout << "insert check: " << (insert_check ? "pass" : "fail") << std::endl;
+
+    // order by distance to a vector literal
+    AST* select_ast = parser.BuildAST("SELECT id FROM items ORDER BY emb <-> [0.5, 1, 0, 2] LIMIT 3;");
+    AST* wrong_limit_ast = parser.BuildAST("SELECT id FROM items ORDER BY emb <-> [0.5, 1, 0, 2];");
+    bool select_check = select_ast != nullptr && select_ast->GetType() == SELECT_FROM_ONE_TABLE_NODE
+        && select_ast->select_from_one_table_sql->order_column == "emb"
+        && select_ast->select_from_one_table_sql->order_vector == "[0.5, 1, 0, 2]"
+        && select_ast->select_from_one_table_sql->limit == 3
+        && wrong_limit_ast == nullptr;
+    std::cout << "order by distance check: " << (select_check ? "pass" : "fail") << std::endl;
+    delete select_ast;
+
+    // a batch of query vectors is one literal
+    AST* batch_ast = parser.BuildAST("SELECT id FROM items ORDER BY emb <-> [[0.5, 1, 0, 2], [1, 2, 3, 4] , [0, 0, 0, 1]] LIMIT 2;");
+    bool batch_check = batch_ast != nullptr && batch_ast->select_from_one_table_sql->order_column == "emb"
+        && batch_ast->select_from_one_table_sql->order_vectors.size() == 3
+        && batch_ast->select_from_one_table_sql->order_vectors[1] == "[1, 2, 3, 4]"
+        && batch_ast->select_from_one_table_sql->limit == 2
+        && parser.BuildAST("SELECT id FROM items ORDER BY emb <-> [[0.5, 1, 0, 2] LIMIT 2;") == nullptr;
+    std::cout << "batch order by distance check: " << (batch_check ? "pass" : "fail") << std::endl;
+    delete batch_ast;
+
+    // distance to a vector literal less than a radius, with other conditions
+    AST* range_ast = parser.BuildAST("SELECT id FROM items WHERE DISTANCE(emb, [0.5, 1, 0, 2]) < 0.75 AND id > 3;");
+    AST* wrong_radius_ast = parser.BuildAST("SELECT id FROM items WHERE DISTANCE(emb, [0.5, 1, 0, 2]) > 0.75;");
+    bool range_check = range_ast != nullptr && range_ast->GetType() == SELECT_FROM_ONE_TABLE_NODE
+        && range_ast->select_from_one_table_sql->range_column == "emb"
+        && range_ast->select_from_one_table_sql->range_vector == "[0.5, 1, 0, 2]"
+        && range_ast->select_from_one_table_sql->range_radius == 0.75
+        && range_ast->select_from_one_table_sql->compare_vector.size() == 1
+        && range_ast->select_from_one_table_sql->compare_vector[0].col.col_name == "id"
+        && wrong_radius_ast == nullptr;
+    std::cout << "distance range check: " << (range_check ? "pass" : "fail") << std::endl;
+    delete range_ast;
+
+    // create hnsw index, parameters are optional
+    AST* index_ast = parser.BuildAST("CREATE INDEX emb_index ON items (emb) USING hnsw WITH (M = 8, ef_search = 100);");
+    AST* default_index_ast = parser.BuildAST("CREATE INDEX emb_index ON items (emb) USING HNSW;");
+    bool index_check = index_ast != nullptr && index_ast->GetType() == CREATE_INDEX_NODE
+        && index_ast->create_index_sql->index_name == "emb_index"
+        && index_ast->create_index_sql->table_name == "items"
+        && index_ast->create_index_sql->col_name == "emb"
+        && index_ast->create_index_sql->index_type == "HNSW"
+        && index_ast->create_index_sql->parameters.size() == 2
+        && index_ast->create_index_sql->parameters["M"] == 8
+        && index_ast->create_index_sql->parameters["EF_SEARCH"] == 100
+        && default_index_ast != nullptr && default_index_ast->create_index_sql->parameters.empty();
+    std::cout << "create index check: " << (index_check ? "pass" : "fail") << std::endl;
+    delete index_ast;
+    delete default_index_ast;
+
+    // init vector values as the column, wrong dimension is refused
+    Value emb = insert_ast->insert_into_table_sql->values[1];
+    Value small = insert_ast->insert_into_table_sql->values[2];
+    Value wrong_dimension(string("[1, 2, 3]"));
+    Value wrong_literal(string("[1, a, 3, 4]"));
+    bool init_check = emb.InitVectorValue(4, ELEMENT_FP32, false)
+        && small.InitVectorValue(4, ELEMENT_FP16, true)
+        && !wrong_dimension.InitVectorValue(4, ELEMENT_FP32, false)
+        && !wrong_literal.InitVectorValue(4, ELEMENT_FP32, false)
+        && emb.GetValueLength() == Value::GetVectorValueLength(4, ELEMENT_FP32)
+        && emb.GetValueLength() % VECTOR_ALIGNMENT == 0;
+    std::cout << "init check: " << (init_check ? "pass" : "fail") << std::endl;
+    std::cout << "emb: " << emb.ToString() << std::endl;
+    std::cout << "small (normalized): " << small.ToString() << std::endl;
+
+    // store fixed length records in a block, and read them back without parsing
+    BlockSlot slot;
+    DataBlock block;
+    block.data = slot.data;
+    block.InitBlock(emb.GetValueLength());
+    char* record = new char[emb.GetValueLength()];
+    emb.Serialize(record, 0);
+    int record_amount = 0;
+    while (block.HaveSpace(emb.GetValueLength())) {
+        block.InsertData(record, emb.GetValueLength());
+        record_amount++;
+    }
+    delete[] record;
+
+    bool read_check = true;
+    double expected[4] = {0.5, -1.25, 0.3, 2};
+    for (int row = 0; row < record_amount; row++) {
+        default_address_type address = block.last_record_start_address + row * block.field_length;
+        Value* stored = SerializeVectorValueFromBuffer(block.data, address, 4, ELEMENT_FP32);
+        double values[4];
+        stored->GetVectorValue(values);
+        for (int i = 0; i < 4; i++) {
+            read_check = read_check && std::fabs(values[i] - expected[i]) < 1e-6;
+        }
+        delete stored;
+
+        // fp32 records can also be read in place
+        VectorView<int, float> view = VectorView<int, float>::FromBlock(block.data, address, 4);
+        read_check = read_check && view.IsAligned(VECTOR_ALIGNMENT) && view.Get(1) == -1.25f;
+    }
+    std::cout << "records in block: " << record_amount << std::endl;
+    std::cout << "read check: " << (read_check ? "pass" : "fail") << std::endl;
+
+    std::cout << "too long check: " << (!DataBlock::CanContain(Value::GetVectorValueLength(768, ELEMENT_FP64)) && DataBlock::CanContain(Value::GetVectorValueLength(768, ELEMENT_FP32)) ? "pass" : "fail") << std::endl;
+
+    delete create_ast;
+    delete insert_ast;
+
+    std::cout << "test end" << std::endl;
+}
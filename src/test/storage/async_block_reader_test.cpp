@@ -0,0 +1,192 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : async_block_reader_test.cpp
+// since : 2024-09-10
+// desc  : read batches of blocks by io_uring and by the pool of threads, from many threads at the same time, check
+// every block, and show the cost against reading the blocks of a batch one by one. A submit failing while reads
+// are in flight must still read the whole batch.
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../../../include/storage/async_block_reader.h"
+
+using namespace tiny_v_dbms;
+
+#ifdef VDBMS_HAS_IO_URING
+
+// fails the submit of the fail_at-th call submitting reads
+class FailingSubmitReader : public AsyncBlockReader
+{
+
+public:
+
+    FailingSubmitReader(int fail_at) : fail_at(fail_at), submit_calls(0)
+    {
+    }
+
+    int fail_at;
+    int submit_calls;
+
+protected:
+
+    unsigned Submit(IoUringRing& ring, unsigned submit_amount, unsigned wait_amount) override
+    {
+        if (submit_amount > 0 && ++submit_calls == fail_at)
+        {
+            throw std::runtime_error("injected submit failure");
+        }
+        return AsyncBlockReader::Submit(ring, submit_amount, wait_amount);
+    }
+};
+
+#endif
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::string data_file = "async_block_reader_test.data";
+    std::remove(data_file.c_str());
+    FileDescriptorCache::GetInstance().Forget(data_file);
+
+    // each byte of a block is its address
+    int block_amount = 1024;
+    std::vector<char> block(BLOCK_SIZE);
+    {
+        std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(data_file, true);
+        for (int i = 0; i < block_amount; i++)
+        {
+            memset(block.data(), i % 256, BLOCK_SIZE);
+            descriptor->WriteAt(block.data(), BLOCK_SIZE, (off_t) i * BLOCK_SIZE);
+        }
+    }
+
+    std::mt19937 random_engine(7);
+    std::vector<default_address_type> addresses;
+    for (int i = 0; i < 200; i++)
+    {
+        addresses.push_back(random_engine() % block_amount);
+    }
+    addresses.push_back(block_amount + 3);     // after the end of file
+
+    for (bool try_io_uring : {true, false})
+    {
+        AsyncBlockReader reader(try_io_uring);
+        std::string name = reader.IsIoUringEnabled() ? "io_uring" : "threads";
+        if (try_io_uring && !reader.IsIoUringEnabled())
+        {
+            std::cout << "io_uring is not supported, threads are used" << std::endl;
+        }
+
+        // 4 threads read the batch at the same time
+        std::vector<int> wrong(4, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&, t]() {
+                std::vector<char> buffer(addresses.size() * BLOCK_SIZE, 1);
+                std::vector<BlockReadRequest> requests;
+                for (size_t i = 0; i < addresses.size(); i++)
+                {
+                    requests.push_back(BlockReadRequest{data_file, addresses[i], buffer.data() + i * BLOCK_SIZE});
+                }
+                reader.ReadBatch(requests);
+                for (size_t i = 0; i < addresses.size(); i++)
+                {
+                    char expect = addresses[i] < (default_address_type) block_amount ? addresses[i] % 256 : 0;
+                    for (int b = 0; b < BLOCK_SIZE; b++)
+                    {
+                        if (buffer[i * BLOCK_SIZE + b] != expect)
+                        {
+                            wrong[t]++;
+                            break;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        std::cout << name << " read check: " << (wrong[0] + wrong[1] + wrong[2] + wrong[3] == 0 ? "pass" : "fail") << std::endl;
+
+        // a missing file is reported, and the reader still works after it
+        bool refused = false;
+        try
+        {
+            reader.ReadBatch({BlockReadRequest{"async_block_reader_test_missing.data", 0, block.data()}});
+        }
+        catch (const std::runtime_error&)
+        {
+            refused = true;
+        }
+        reader.ReadBatch({BlockReadRequest{data_file, 5, block.data()}});
+        std::cout << name << " error check: " << (refused && block[0] == 5 ? "pass" : "fail") << std::endl;
+
+        int repeat = 20;
+        std::vector<char> buffer(addresses.size() * BLOCK_SIZE);
+        std::vector<BlockReadRequest> requests;
+        for (size_t i = 0; i < addresses.size(); i++)
+        {
+            requests.push_back(BlockReadRequest{data_file, addresses[i], buffer.data() + i * BLOCK_SIZE});
+        }
+        auto begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; r++)
+        {
+            reader.ReadBatch(requests);
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << name << " batch cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+    }
+
+#ifdef VDBMS_HAS_IO_URING
+    // the second submit fails while the reads of the first one are in flight, the rest are read by threads
+    {
+        FailingSubmitReader reader(2);
+        if (reader.IsIoUringEnabled())
+        {
+            std::vector<char> buffer(addresses.size() * BLOCK_SIZE, 1);
+            std::vector<BlockReadRequest> requests;
+            for (size_t i = 0; i < addresses.size(); i++)
+            {
+                requests.push_back(BlockReadRequest{data_file, addresses[i], buffer.data() + i * BLOCK_SIZE});
+            }
+            reader.ReadBatch(requests);
+            int wrong = 0;
+            for (size_t i = 0; i < addresses.size(); i++)
+            {
+                char expect = addresses[i] < (default_address_type) block_amount ? addresses[i] % 256 : 0;
+                wrong += std::count(buffer.begin() + i * BLOCK_SIZE, buffer.begin() + (i + 1) * BLOCK_SIZE, expect) != BLOCK_SIZE;
+            }
+
+            // a new ring is used by the next batch
+            reader.ReadBatch({BlockReadRequest{data_file, 7, block.data()}});
+            std::cout << "broken submit check: " << (reader.submit_calls >= 2 && wrong == 0 && block[0] == 7 ? "pass" : "fail") << std::endl;
+        }
+    }
+#endif
+
+    // blocks of the batch read one by one
+    std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(data_file);
+    std::vector<char> buffer(addresses.size() * BLOCK_SIZE);
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < 20; r++)
+    {
+        for (size_t i = 0; i < addresses.size(); i++)
+        {
+            descriptor->ReadAt(buffer.data() + i * BLOCK_SIZE, BLOCK_SIZE, (off_t) addresses[i] * BLOCK_SIZE);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "one by one cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+
+    FileDescriptorCache::GetInstance().Forget(data_file);
+    std::remove(data_file.c_str());
+    std::cout << "test end" << std::endl;
+}
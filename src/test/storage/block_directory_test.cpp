@@ -0,0 +1,105 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : block_directory_test.cpp
+// since : 2024-09-10
+// desc  : append blocks of three columns to a directory, check they are loaded back from file in order, an entry
+// written partly at the end of file is dropped, and the block of each tag is found.
+
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include "../../../include/storage/block_directory.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::string file_path = "block_directory_test.dir";
+    std::remove(file_path.c_str());
+    FileDescriptorCache::GetInstance().Forget(file_path);
+
+    // column i has block_amount blocks at address block * 3 + i, each holds (block % 5) + 1 records
+    default_amount_type column_size = 3;
+    default_long_int block_amount = 1000;
+    {
+        BlockDirectory directory(file_path, column_size);
+        if (directory.Load())
+        {
+            std::cout << "load missing file check: fail" << std::endl;
+        }
+        else
+        {
+            std::cout << "load missing file check: pass" << std::endl;
+        }
+
+        directory.Reset();
+        std::vector<default_long_int> tag_offsets(column_size, 0);
+        for (default_long_int block = 0; block < block_amount; block++)
+        {
+            for (default_amount_type i = 0; i < column_size; i++)
+            {
+                directory.Append(i, block * 3 + i, tag_offsets[i]);
+                tag_offsets[i] += block % 5 + 1;
+            }
+        }
+    }
+
+    BlockDirectory directory(file_path, column_size);
+    bool loaded_right = directory.Load();
+    for (default_amount_type i = 0; i < column_size && loaded_right; i++)
+    {
+        std::vector<DirectoryEntry> entries = directory.GetEntries(i);
+        loaded_right = entries.size() == block_amount;
+        default_long_int tag_offset = 0;
+        for (default_long_int block = 0; block < entries.size() && loaded_right; block++)
+        {
+            loaded_right = entries[block].block_address == (default_address_type) (block * 3 + i) && entries[block].first_tag == tag_offset;
+            tag_offset += block % 5 + 1;
+        }
+    }
+    std::cout << "load check: " << (loaded_right ? "pass" : "fail") << std::endl;
+
+    // the block of a tag holds it, records after the last block are found in the last block
+    std::vector<DirectoryEntry> entries = directory.GetEntries(1);
+    bool found_right = BlockDirectory::FindBlock(std::vector<DirectoryEntry>(), 0) == 0;
+    default_long_int tag = 0;
+    for (default_long_int block = 0; block < block_amount && found_right; block++)
+    {
+        for (default_long_int record = 0; record < block % 5 + 1 && found_right; record++)
+        {
+            found_right = BlockDirectory::FindBlock(entries, tag) == block;
+            tag++;
+        }
+    }
+    found_right = found_right && BlockDirectory::FindBlock(entries, tag + 10) == block_amount - 1;
+    std::cout << "find block check: " << (found_right ? "pass" : "fail") << std::endl;
+
+    // a block appended after loading is kept, a half written entry after it is dropped
+    directory.Append(2, 9999, 12345);
+    {
+        std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(file_path);
+        char half_entry[BlockDirectory::ENTRY_LENGTH / 2] = {0};
+        descriptor->WriteAt(half_entry, sizeof(half_entry), (off_t) ((column_size * block_amount + 1) * BlockDirectory::ENTRY_LENGTH));
+    }
+    BlockDirectory reloaded(file_path, column_size);
+    reloaded.Load();
+    bool partial_right = reloaded.GetBlockAmount(2) == block_amount + 1 && reloaded.GetEntries(2).back().block_address == 9999
+        && reloaded.GetEntries(2).back().first_tag == 12345 && reloaded.GetBlockAmount(0) == block_amount;
+    reloaded.Append(0, 8888, 54321);
+    BlockDirectory appended(file_path, column_size);
+    appended.Load();
+    partial_right = partial_right && appended.GetBlockAmount(0) == block_amount + 1 && appended.GetEntries(0).back().block_address == 8888
+        && appended.GetBlockAmount(2) == block_amount + 1;
+    std::cout << "partial entry check: " << (partial_right ? "pass" : "fail") << std::endl;
+
+    appended.Reset();
+    BlockDirectory cleared(file_path, column_size);
+    bool reset_right = cleared.Load() && cleared.GetBlockAmount(0) == 0 && cleared.GetBlockAmount(1) == 0;
+    std::cout << "reset check: " << (reset_right ? "pass" : "fail") << std::endl;
+
+    std::remove(file_path.c_str());
+    FileDescriptorCache::GetInstance().Forget(file_path);
+
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : block_file_management_test.cpp
+// since : 2024-09-10
+// desc  : write and read data blocks by cached descriptors, from many threads at the same time, and show the cost
+// against opening the file by fstream for each block.
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "../../../include/storage/block_file_management.h"
+
+using namespace tiny_v_dbms;
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::string data_file = "block_file_management_test.data";
+    std::remove(data_file.c_str());
+    FileDescriptorCache::GetInstance().Forget(data_file);
+
+    BlockFileManagement management;
+    int block_amount = 256;
+
+    // a new file is created and gets address 0, each written block takes the next address
+    bool address_right = management.GetNewBlockAddress(data_file) == 0 && management.GetFileBlocksAmount(data_file) == 0;
+    std::vector<char> block(BLOCK_SIZE);
+    for (int i = 0; i < block_amount; i++)
+    {
+        memset(block.data(), i % 256, BLOCK_SIZE);
+        management.WriteBackDataBlock(data_file, i, block.data());
+    }
+    address_right = address_right && management.GetNewBlockAddress(data_file) == (default_address_type) block_amount
+        && management.GetFileBlocksAmount(data_file) == (default_address_type) block_amount;
+    std::cout << "address check: " << (address_right ? "pass" : "fail") << std::endl;
+
+    // 4 threads read all blocks by the same descriptor
+    std::vector<int> wrong(4, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t]() {
+            std::vector<char> buffer(BLOCK_SIZE);
+            DataBlock data_block;
+            data_block.data = buffer.data();
+            for (int i = 0; i < block_amount; i++)
+            {
+                int address = (i * 7 + t * 13) % block_amount;
+                management.ReadOneDataBlock(data_file, address, data_block);
+                for (int b = 0; b < BLOCK_SIZE; b++)
+                {
+                    if ((unsigned char) data_block.data[b] != address % 256)
+                    {
+                        wrong[t]++;
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    bool read_right = wrong[0] + wrong[1] + wrong[2] + wrong[3] == 0 && FileDescriptorCache::GetInstance().Size() == 1;
+    std::cout << "concurrent read check: " << (read_right ? "pass" : "fail") << std::endl;
+
+    // a block after the end of file is read as zeros
+    DataBlock after_end;
+    after_end.data = block.data();
+    memset(after_end.data, 1, BLOCK_SIZE);
+    management.ReadOneDataBlock(data_file, block_amount + 10, after_end);
+    bool zero = true;
+    for (int b = 0; b < BLOCK_SIZE; b++)
+    {
+        zero = zero && after_end.data[b] == 0;
+    }
+    std::cout << "end of file check: " << (zero ? "pass" : "fail") << std::endl;
+
+    // a wrong suffix is still refused
+    bool refused = false;
+    try
+    {
+        management.ReadOneDataBlock("block_file_management_test.tvdbb", 0, after_end);
+    }
+    catch (const std::runtime_error&)
+    {
+        refused = true;
+    }
+    std::cout << "suffix check: " << (refused ? "pass" : "fail") << std::endl;
+
+    int repeat = 20;
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++)
+    {
+        for (int i = 0; i < block_amount; i++)
+        {
+            std::fstream stream;
+            stream.open(data_file, std::ios::in | std::ios::out | std::ios::binary);
+            stream.seekg((size_t) i * BLOCK_SIZE);
+            stream.read(block.data(), BLOCK_SIZE);
+            stream.close();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "fstream per block cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+
+    DataBlock data_block;
+    data_block.data = block.data();
+    begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++)
+    {
+        for (int i = 0; i < block_amount; i++)
+        {
+            management.ReadOneDataBlock(data_file, i, data_block);
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "cached descriptor cost: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << std::endl;
+
+    FileDescriptorCache::GetInstance().Forget(data_file);
+    std::remove(data_file.c_str());
+    std::cout << "test end" << std::endl;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : chain_read_ahead_test.cpp
+// since : 2024-09-10
+// desc  : follow a chain whose blocks are every third block of a file, as a column of a table with three columns,
+// check the windows read ahead cover the next blocks of chain and the depth grows and is reset, and show the cost of
+// scanning the chain from disk with and without read ahead.
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include "../../../include/storage/chain_read_ahead.h"
+
+using namespace tiny_v_dbms;
+
+// scan the chain, each block is read when it is needed, like a filter does
+long Scan(const std::string& data_file, default_address_type block_amount, bool read_ahead)
+{
+    std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(data_file);
+    posix_fadvise(descriptor->Get(), 0, 0, POSIX_FADV_DONTNEED);
+    std::vector<char> block(BLOCK_SIZE);
+    ChainReadAhead chain_read_ahead(data_file);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (default_address_type address = 0; address < block_amount; address += 3)
+    {
+        descriptor->ReadAt(block.data(), BLOCK_SIZE, (off_t) address * BLOCK_SIZE);
+        if (read_ahead)
+        {
+            chain_read_ahead.Advance(address, address + 3 < block_amount ? address + 3 : 0x0);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::string data_file = "chain_read_ahead_test.data";
+    std::remove(data_file.c_str());
+    FileDescriptorCache::GetInstance().Forget(data_file);
+
+    default_address_type block_amount = 12288;
+    {
+        std::shared_ptr<FileDescriptor> descriptor = FileDescriptorCache::GetInstance().Get(data_file, true);
+        std::vector<char> block(BLOCK_SIZE, 1);
+        for (default_address_type address = 0; address < block_amount; address++)
+        {
+            descriptor->WriteAt(block.data(), BLOCK_SIZE, (off_t) address * BLOCK_SIZE);
+        }
+        fsync(descriptor->Get());
+    }
+
+    // after the first window, every next block is in the windows read ahead
+    ChainReadAhead chain_read_ahead(data_file);
+    bool window_right = true;
+    for (default_address_type address = 0; address + 3 < 3000; address += 3)
+    {
+        chain_read_ahead.Advance(address, address + 3);
+        window_right = window_right && address + 3 >= chain_read_ahead.GetWindowBegin() && address + 3 < chain_read_ahead.GetWindowEnd();
+    }
+    bool depth_right = chain_read_ahead.GetDepth() == READ_AHEAD_MAX_DEPTH;
+    // no block is read ahead twice, the read ahead is at most two windows after the scan
+    bool amount_right = chain_read_ahead.GetReadAheadBlocks() <= 3000 + 2 * 3 * READ_AHEAD_MAX_DEPTH;
+    std::cout << "window check: " << (window_right && depth_right && amount_right ? "pass" : "fail") << std::endl;
+
+    // a jump back resets the depth, the end of chain does nothing
+    chain_read_ahead.Advance(3000, 30);
+    bool reset_right = chain_read_ahead.GetDepth() == READ_AHEAD_MIN_DEPTH && chain_read_ahead.GetWindowEnd() == 0;
+    chain_read_ahead.Advance(30, 33);
+    reset_right = reset_right && chain_read_ahead.GetWindowBegin() == 33 && chain_read_ahead.GetWindowEnd() == 33 + 3 * READ_AHEAD_MIN_DEPTH;
+    chain_read_ahead.Advance(33, 0x0);
+    reset_right = reset_right && chain_read_ahead.GetWindowEnd() == 33 + 3 * READ_AHEAD_MIN_DEPTH;
+    std::cout << "reset check: " << (reset_right ? "pass" : "fail") << std::endl;
+
+    long without_cost = Scan(data_file, block_amount, false);
+    long with_cost = Scan(data_file, block_amount, true);
+    std::cout << "scan without read ahead cost: " << without_cost << " us, with read ahead cost: " << with_cost << " us" << std::endl;
+
+    FileDescriptorCache::GetInstance().Forget(data_file);
+    std::remove(data_file.c_str());
+    std::cout << "test end" << std::endl;
+}
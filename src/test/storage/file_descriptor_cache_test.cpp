@@ -0,0 +1,54 @@
+// Copyright (c) 2024 by dingning
+//
+// file  : file_descriptor_cache_test.cpp
+// since : 2024-09-10
+// desc  : re-create a file read by the descriptor cache, by removing it and by the rename of an index file, and
+// check it is read back through the cache with its new bytes instead of those of the replaced file.
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "../../../include/storage/file_descriptor_cache.h"
+#include "../../../include/index/index_file.h"
+
+using namespace tiny_v_dbms;
+
+std::string ReadThroughCache(const std::string& file_path, size_t length)
+{
+    std::string data(length, '\0');
+    FileDescriptorCache::GetInstance().Get(file_path)->ReadAt(&data[0], length, 0);
+    return data;
+}
+
+int main() {
+    std::cout << "test begin" << std::endl;
+
+    std::string data_file = "file_descriptor_cache_test.data";
+    std::remove(data_file.c_str());
+    FileDescriptorCache::GetInstance().Forget(data_file);
+
+    std::string old_data = "old bytes";
+    FileDescriptorCache::GetInstance().Get(data_file, true)->WriteAt(old_data.data(), old_data.size(), 0);
+    std::cout << "read check: " << (ReadThroughCache(data_file, old_data.size()) == old_data ? "pass" : "fail") << std::endl;
+
+    // removed and created again, the cached descriptor still reads the removed file until it is forgotten
+    std::string new_data = "new bytes";
+    std::remove(data_file.c_str());
+    std::ofstream(data_file, std::ios::binary).write(new_data.data(), new_data.size());
+    bool stale = ReadThroughCache(data_file, old_data.size()) == old_data;
+    FileDescriptorCache::GetInstance().Forget(data_file);
+    bool recreated = ReadThroughCache(data_file, new_data.size()) == new_data;
+    std::cout << "re-create check: " << (stale && recreated ? "pass" : "fail") << std::endl;
+
+    // an index file written to the same path replaces it by rename, and forgets the descriptor itself
+    IndexFileWriter writer(HNSW, 8, ELEMENT_FP32, 0);
+    writer.Write(data_file);
+    bool renamed = ReadThroughCache(data_file, sizeof(IndexFile::MAGIC)) == std::string(IndexFile::MAGIC, sizeof(IndexFile::MAGIC));
+    std::cout << "rename check: " << (renamed ? "pass" : "fail") << std::endl;
+
+    FileDescriptorCache::GetInstance().Forget(data_file);
+    std::remove(data_file.c_str());
+    std::cout << "test end" << std::endl;
+}